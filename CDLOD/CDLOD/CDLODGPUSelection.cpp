@@ -0,0 +1,217 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Data layouts and helpers for doing the LOD selection in a compute
+// shader, and a CPU version of the same traversal.
+//////////////////////////////////////////////////////////////////////
+
+#include "CDLODGPUSelection.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace {
+// The shader's entry arrays are laid out right after the header.
+static_assert(sizeof(CDLODGPUSelection::WorkHeader) % sizeof(glm::uvec4) == 0, "WorkHeader must keep uvec4 alignment");
+// The shader's command array has a 20 byte stride, and the counts follow it.
+static_assert(offsetof(CDLODGPUSelection::IndirectData, DrawCounts) ==
+                  CDLODGPUSelection::c_batchCount * 5 * sizeof(uint32_t),
+              "IndirectData must match the std430 layout");
+
+struct QueueEntry {
+    int X;
+    int Y;
+    unsigned char InsidePlaneMask;
+    bool InNextRange;
+};
+
+bool compare_nodes(const CDLODQuadTree::SelectedNode &a, const CDLODQuadTree::SelectedNode &b) {
+    return std::make_tuple(a.LODLevel, a.Y, a.X) < std::make_tuple(b.LODLevel, b.Y, b.X);
+}
+}  // namespace
+
+//
+void CDLODGPUSelection::GetNodeData(const CDLODQuadTree &quadTree, uint32_t *nodes) {
+    assert(IsSupported(quadTree));
+    for (size_t i = 0; i < quadTree.m_minMaxZ.size(); i++)
+        nodes[i] = quadTree.m_minMaxZ[i].MinZ | (static_cast<uint32_t>(quadTree.m_minMaxZ[i].MaxZ) << 16);
+}
+//
+size_t CDLODGPUSelection::GetWorkBufferSize(int maxSelectionCount) {
+    return sizeof(WorkHeader) + (2 * GetMaxQueueCount(maxSelectionCount) + maxSelectionCount) * sizeof(glm::uvec4);
+}
+//
+void CDLODGPUSelection::GetPerFrameData(const CDLODQuadTree::LODSelection &selection, const VkGridMesh &gridMesh,
+                                        int maxSelectionCount, PerFrameData &data) {
+    const CDLODQuadTree *quadTree = selection.m_quadTree;
+    assert(quadTree != NULL && IsSupported(*quadTree));
+    const MapDimensions &mapDims = quadTree->m_desc.MapDims;
+    const int LODLevelCount = quadTree->m_desc.LODLevelCount;
+
+    data = {};
+    for (int i = 0; i < 6; i++) data.frustumPlanes[i] = selection.m_frustumPlanes[i];
+    data.observerPos = glm::vec4(selection.m_observerPos, 1.0f);
+    data.mapMin = {mapDims.MinX, mapDims.MinY, mapDims.MinZ, 0.0f};
+    data.mapSize = {mapDims.SizeX, mapDims.SizeY, mapDims.SizeZ, 0.0f};
+    data.data0 = {quadTree->m_rasterSizeX, quadTree->m_rasterSizeY, LODLevelCount, quadTree->m_topNodeSize};
+    data.data1 = {quadTree->m_topNodeCountX, quadTree->m_topNodeCountY, maxSelectionCount,
+                  GetMaxQueueCount(maxSelectionCount)};
+    for (int level = 0; level < LODLevelCount; level++) {
+        data.levels[level] = {quadTree->m_levelOffsets[level], quadTree->m_levelNodeCountX[level],
+                              quadTree->m_levelNodeCountY[level], 0};
+        data.lodRanges[level].x = selection.m_visibilityRanges[level];
+    }
+    data.indices = {static_cast<uint32_t>(gridMesh.GetNumIndiciesPerQuadrant()),
+                    static_cast<uint32_t>(gridMesh.GetIndexEndTL()), static_cast<uint32_t>(gridMesh.GetIndexEndTR()),
+                    static_cast<uint32_t>(gridMesh.GetIndexEndBL())};
+}
+//
+int CDLODGPUSelection::GetDispatchCount(const CDLODQuadTree &quadTree, PassType pass, int level, int maxSelectionCount) {
+    int invocationCount = 1;
+    switch (pass) {
+        case PT_Clear:
+        case PT_Layout:
+            return 1;
+        case PT_Seed:
+            invocationCount = quadTree.m_topNodeCountX * quadTree.m_topNodeCountY;
+            break;
+        case PT_Traverse:
+            assert(level >= 0 && level < quadTree.m_desc.LODLevelCount);
+            invocationCount = (std::min)(quadTree.m_levelNodeCountX[level] * quadTree.m_levelNodeCountY[level],
+                                         GetMaxQueueCount(maxSelectionCount));
+            break;
+        case PT_Write:
+            invocationCount = maxSelectionCount;
+            break;
+    }
+    return (invocationCount + c_localSize - 1) / c_localSize;
+}
+//
+void CDLODGPUSelection::Select(const CDLODQuadTree &quadTree, CDLODQuadTree::LODSelection *selectionObj) {
+    assert(IsSupported(quadTree));
+    typedef CDLODQuadTree::Node Node;
+
+    quadTree.LODSelectRanges(selectionObj);
+
+    Node::LODSelectInfo lodSelInfo;
+    lodSelInfo.RasterSizeX = quadTree.m_rasterSizeX;
+    lodSelInfo.RasterSizeY = quadTree.m_rasterSizeY;
+    lodSelInfo.MapDims = quadTree.m_desc.MapDims;
+    lodSelInfo.SelectionCount = 0;
+    lodSelInfo.SelectionObj = selectionObj;
+    lodSelInfo.StopAtLevel = quadTree.m_desc.LODLevelCount - 1;
+
+    const int maxQueueCount = GetMaxQueueCount(selectionObj->m_maxSelectionCount);
+    std::vector<QueueEntry> queue, nextQueue;
+    queue.reserve(maxQueueCount);
+    nextQueue.reserve(maxQueueCount);
+    const auto enqueue = [maxQueueCount](std::vector<QueueEntry> &q, int x, int y, const Node::LODSelectTest &test) {
+        if (static_cast<int>(q.size()) < maxQueueCount) q.push_back({x, y, test.InsidePlaneMask, test.InNextRange});
+    };
+
+    // PT_Seed
+    for (int y = 0; y < quadTree.m_topNodeCountY; y++)
+        for (int x = 0; x < quadTree.m_topNodeCountX; x++) {
+            AABB boundingBox;
+            quadTree.GetNodeAABB(0, x, y, boundingBox);
+            Node::LODSelectTest test;
+            CDLODQuadTree::LODSelectTestNodes(lodSelInfo, 0, &boundingBox, 1, 0, &test);
+            if (test.FrustumIt != IT_Outside && test.InRange) enqueue(queue, x, y, test);
+        }
+
+    // PT_Traverse
+    for (int level = 0; level <= lodSelInfo.StopAtLevel && !queue.empty(); level++) {
+        nextQueue.clear();
+        for (const QueueEntry &entry : queue) {
+            unsigned int quadrantMask = 0xF;  // TL, TR, BL, BR
+
+            if (level != lodSelInfo.StopAtLevel && entry.InNextRange) {
+                AABB subBoxes[4];
+                int subIndices[4];
+                int subCount = 0;
+                for (int i = 0; i < 4; i++) {
+                    const int cx = 2 * entry.X + (i & 1), cy = 2 * entry.Y + (i >> 1);
+                    if (!quadTree.HasNode(level + 1, cx, cy)) continue;
+                    quadTree.GetNodeAABB(level + 1, cx, cy, subBoxes[subCount]);
+                    subIndices[subCount++] = i;
+                }
+
+                Node::LODSelectTest subTests[4];
+                CDLODQuadTree::LODSelectTestNodes(lodSelInfo, level + 1, subBoxes, subCount, entry.InsidePlaneMask,
+                                                  subTests);
+                for (int k = 0; k < subCount; k++) {
+                    // Out of frustum, or in range so the child (or its children) draws it. Out of range is ours to draw.
+                    const int i = subIndices[k];
+                    if (subTests[k].FrustumIt == IT_Outside) {
+                        quadrantMask &= ~(1u << i);
+                    } else if (subTests[k].InRange) {
+                        quadrantMask &= ~(1u << i);
+                        enqueue(nextQueue, 2 * entry.X + (i & 1), 2 * entry.Y + (i >> 1), subTests[k]);
+                    }
+                }
+            }
+
+            if (quadrantMask != 0 && lodSelInfo.SelectionCount < selectionObj->m_maxSelectionCount) {
+                const int size = quadTree.m_topNodeSize >> level;
+                const CDLODQuadTree::MinMaxZ &minMaxZ = quadTree.GetMinMaxZ(level, entry.X, entry.Y);
+                selectionObj->m_selectionBuffer[lodSelInfo.SelectionCount] = CDLODQuadTree::SelectedNode(
+                    entry.X * size, entry.Y * size, (unsigned short)size, minMaxZ.MinZ, minMaxZ.MaxZ,
+                    lodSelInfo.StopAtLevel - level, (quadrantMask & 1) != 0, (quadrantMask & 2) != 0,
+                    (quadrantMask & 4) != 0, (quadrantMask & 8) != 0);
+                selectionObj->m_selectionBuffer[lodSelInfo.SelectionCount].MinDistToCamera = 0;
+                lodSelInfo.SelectionCount++;
+            }
+        }
+        std::swap(queue, nextQueue);
+    }
+
+    selectionObj->m_selectionCount = lodSelInfo.SelectionCount;
+    selectionObj->m_maxSelectedLODLevel = 0;
+    selectionObj->m_minSelectedLODLevel = CDLODQuadTree::c_maxLODLevels;
+    for (int i = 0; i < lodSelInfo.SelectionCount; i++) {
+        const int LODLevel = selectionObj->m_selectionBuffer[i].LODLevel;
+        selectionObj->m_minSelectedLODLevel = (std::min)(selectionObj->m_minSelectedLODLevel, LODLevel);
+        selectionObj->m_maxSelectedLODLevel = (std::max)(selectionObj->m_maxSelectedLODLevel, LODLevel);
+    }
+}
+//
+int CDLODGPUSelection::ReadSelection(const CDLODQuadTree &quadTree, const void *workBuffer, int maxSelectionCount,
+                                     CDLODQuadTree::SelectedNode *nodes) {
+    const WorkHeader *header = static_cast<const WorkHeader *>(workBuffer);
+    const glm::uvec4 *selected =
+        reinterpret_cast<const glm::uvec4 *>(header + 1) + 2 * GetMaxQueueCount(maxSelectionCount);
+    const int count = (std::min)(static_cast<int>(header->SelectedCount), maxSelectionCount);
+
+    for (int i = 0; i < count; i++) {
+        const glm::uvec4 &entry = selected[i];
+        const int level = static_cast<int>(entry.z);
+        const int size = quadTree.m_topNodeSize >> level;
+        const CDLODQuadTree::MinMaxZ &minMaxZ = quadTree.GetMinMaxZ(level, entry.x, entry.y);
+        nodes[i] = CDLODQuadTree::SelectedNode(entry.x * size, entry.y * size, (unsigned short)size, minMaxZ.MinZ,
+                                               minMaxZ.MaxZ, quadTree.m_desc.LODLevelCount - 1 - level,
+                                               (entry.w & 1) != 0, (entry.w & 2) != 0, (entry.w & 4) != 0,
+                                               (entry.w & 8) != 0);
+        nodes[i].MinDistToCamera = 0;
+    }
+    return count;
+}
+//
+bool CDLODGPUSelection::IsSameSelection(const CDLODQuadTree::SelectedNode *a, int countA,
+                                        const CDLODQuadTree::SelectedNode *b, int countB) {
+    if (countA != countB) return false;
+
+    std::vector<CDLODQuadTree::SelectedNode> sortedA(a, a + countA), sortedB(b, b + countB);
+    std::sort(sortedA.begin(), sortedA.end(), compare_nodes);
+    std::sort(sortedB.begin(), sortedB.end(), compare_nodes);
+    for (int i = 0; i < countA; i++) {
+        const CDLODQuadTree::SelectedNode &na = sortedA[i], &nb = sortedB[i];
+        if (na.X != nb.X || na.Y != nb.Y || na.Size != nb.Size || na.LODLevel != nb.LODLevel || na.TL != nb.TL ||
+            na.TR != nb.TR || na.BL != nb.BL || na.BR != nb.BR)
+            return false;
+    }
+    return true;
+}
+//
@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Data layouts and helpers for doing the LOD selection in a compute
+// shader, and a CPU version of the same traversal.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _CDLOD_GPU_SELECTION_H_
+#define _CDLOD_GPU_SELECTION_H_
+
+#include <stdint.h>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "CDLODQuadTree.h"
+#include "CDLODRenderer.h"
+
+//////////////////////////////////////////////////////////////////////////
+// GPU LOD selection
+//
+// The same selection as CDLODQuadTree::LODSelect (implicit storage only), done breadth first so it can run in a compute
+// shader (Guppy: shaders/cdlod/comp.cdlod.select.glsl). The node min/max heights are uploaded once (GetNodeData). Every
+// frame only PerFrameData changes, and the passes below are dispatched in order with a compute barrier in between:
+//
+//  PT_Clear     one workgroup, zeroes the counters in WorkHeader
+//  PT_Seed      one invocation per top level node, queues the ones that are visible and in range
+//  PT_Traverse  once per tree level (PushConstant::Level, top first), one invocation per queued node. Tests the node's
+//               children like LODSelectImplicit, queues the ones in range for the next level, and selects the node if
+//               any of its quadrants is left to draw
+//  PT_Layout    one invocation, lays the batches out like CDLODRenderer::MakeInstanceBatches and writes the indirect
+//               draws of the batches that have instances (IndirectData)
+//  PT_Write     one invocation per selected node, writes its instances (CDLODInstanceBatches::PerInstanceData)
+//
+// The indirect draws are then read by CDLODRenderer::Render (CDLODRendererBatchInfo::RenderData::indirectBuffer). The
+// order of the nodes within a batch is whatever the atomics made it. Only the node heights are written by the host, the
+// other buffers are only written by the passes. CH
+//////////////////////////////////////////////////////////////////////////
+class CDLODGPUSelection {
+   public:
+    // Invocations per workgroup of every pass (local_size_x in the shader).
+    static const int c_localSize = 64;
+    // One indirect draw per LOD level and quadrant run, in the order of CDLODInstanceBatches::Batches.
+    static const int c_batchCount = CDLODQuadTree::c_maxLODLevels * CDLODInstanceBatches::c_quadrantRunCount;
+
+    enum PassType {
+        PT_Clear,
+        PT_Seed,
+        PT_Traverse,
+        PT_Layout,
+        PT_Write,
+    };
+
+    struct PushConstant {
+        uint32_t Pass;   // PassType
+        uint32_t Level;  // tree level of PT_Traverse
+    };
+
+    // std140 uniform
+    struct PerFrameData {
+        glm::vec4 frustumPlanes[6];
+        glm::vec4 observerPos;  // .xyz
+        glm::vec4 mapMin;       // .x (MinX), .y (MinY), .z (MinZ)
+        glm::vec4 mapSize;      // .x (SizeX), .y (SizeY), .z (SizeZ)
+        glm::ivec4 data0;       // .x (raster size x), .y (raster size y), .z (LOD level count), .w (top node size)
+        glm::ivec4 data1;       // .x (top node count x), .y (top node count y), .z (max selection count)
+                                // .w (max queue count)
+        glm::ivec4 levels[CDLODQuadTree::c_maxLODLevels];     // .x (node data offset), .y (node count x), .z (node count y)
+        glm::vec4 lodRanges[CDLODQuadTree::c_maxLODLevels];   // .x (visibility range), by tree level (0 is the top)
+        glm::uvec4 indices;  // .x (indices per quadrant), .y (first index of TR), .z (of BL), .w (of BR). TL is at 0.
+    };
+
+    // std430 storage buffer. The node entries (uvec4) follow it: two queues of GetMaxQueueCount that the tree levels take
+    // turns writing, then GetMaxSelectionCount selected nodes. A queued node is (x, y, level, inside plane mask | in next
+    // range << 8), and a selected node is (x, y, level, quadrant mask (TL 1, TR 2, BL 4, BR 8)).
+    struct WorkHeader {
+        uint32_t QueueCounts[16];  // by tree level; can go past the max queue count (the rest are dropped)
+        uint32_t SelectedCount;    // can go past the max selection count (the rest are dropped)
+        uint32_t Pad[3];
+        uint32_t BatchCounts[c_batchCount];
+        uint32_t BatchCursors[c_batchCount];  // PT_Write
+    };
+
+    // std430 storage buffer of the indirect draws. PT_Layout packs the draws of a LOD level that have instances to the
+    // front of its c_quadrantRunCount commands, and zeroes the rest, so the level can be drawn with one
+    // vkCmdDrawIndexedIndirectCount (DrawCounts), or with a draw per command where that isn't supported.
+    struct IndirectData {
+        vk::DrawIndexedIndirectCommand Commands[c_batchCount];
+        uint32_t DrawCounts[CDLODQuadTree::c_maxLODLevels];  // by LOD level
+    };
+
+    static bool IsSupported(const CDLODQuadTree& quadTree) { return quadTree.m_desc.ImplicitStorage; }
+
+    // Node min/max heights (MinZ | MaxZ << 16) of every level, which is what PerFrameData::levels points into.
+    static int GetNodeCount(const CDLODQuadTree& quadTree) { return static_cast<int>(quadTree.m_minMaxZ.size()); }
+    static void GetNodeData(const CDLODQuadTree& quadTree, uint32_t* nodes);
+
+    // Nodes that can be queued for a single tree level. When a level queues more, its children draw as holes, much like
+    // when LODSelect runs out of selection buffer.
+    static int GetMaxQueueCount(int maxSelectionCount) { return maxSelectionCount; }
+    static size_t GetWorkBufferSize(int maxSelectionCount);
+
+    // "selection" has to have its ranges made already (CDLODQuadTree::LODSelectRanges). "gridMesh" is the mesh that is
+    // drawn.
+    static void GetPerFrameData(const CDLODQuadTree::LODSelection& selection, const VkGridMesh& gridMesh,
+                                int maxSelectionCount, PerFrameData& data);
+    // Workgroup count of a pass.
+    static int GetDispatchCount(const CDLODQuadTree& quadTree, PassType pass, int level, int maxSelectionCount);
+
+    // The traversal of the compute passes on the CPU, as a reference for the GPU results and to compare with LODSelect.
+    // The selection stats other than the LOD level min/max are not made.
+    static void Select(const CDLODQuadTree& quadTree, CDLODQuadTree::LODSelection* selectionObj);
+    // Selected node entries of a work buffer read back from the GPU.
+    static int ReadSelection(const CDLODQuadTree& quadTree, const void* workBuffer, int maxSelectionCount,
+                             CDLODQuadTree::SelectedNode* nodes);
+    // True if both have the same nodes with the same quadrants, in any order.
+    static bool IsSameSelection(const CDLODQuadTree::SelectedNode* a, int countA, const CDLODQuadTree::SelectedNode* b,
+                                int countB);
+};
+
+#endif  // _CDLOD_GPU_SELECTION_H_
@@ -7,6 +7,21 @@
 
 #include "CDLODQuadTree.h"
 
+#include <Common/Parallel.h>
+#include <algorithm>
+#include <chrono>
+
+// CDLOD_QUADTREE_SCALAR (CMake option) forces the scalar paths, so they can be tested on machines with SSE2/NEON. CH
+#if defined(CDLOD_QUADTREE_SCALAR)
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CDLOD_QUADTREE_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+// vaddvq_u32, vdivq_f32 and vsqrtq_f32 are AArch64 only, so 32 bit ARM uses the scalar path.
+#include <arm_neon.h>
+#define CDLOD_QUADTREE_NEON 1
+#endif
+
 // CH
 #define DEBUG_PRINT false
 #if DEBUG_PRINT
@@ -44,6 +59,97 @@ void logEnd() {}
 }  // namespace
 #endif
 
+namespace {
+// For helpers::parallelFor. The debug log is written from Node::Create, so that runs on one thread. CH
+inline uint32_t getThreadCount(const int threadCount) {
+    return DEBUG_PRINT ? 1u : static_cast<uint32_t>((std::max)(threadCount, 0));
+}
+
+// Four float lanes for LODSelectTestNodes. Every path does the same IEEE operations per lane, so the results match
+// bit for bit. CH
+#if CDLOD_QUADTREE_SSE2
+typedef __m128 Float4;
+typedef __m128 Mask4;
+inline Float4 load4(const float *p) { return _mm_load_ps(p); }
+inline void store4(float *p, Float4 a) { _mm_store_ps(p, a); }
+inline Float4 set4(float v) { return _mm_set1_ps(v); }
+inline Float4 add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 div4(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+inline Float4 max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+inline Float4 min4(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 abs4(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline Float4 sqrt4(Float4 a) { return _mm_sqrt_ps(a); }
+inline Mask4 less4(Float4 a, Float4 b) { return _mm_cmplt_ps(a, b); }
+inline Mask4 lessEqual4(Float4 a, Float4 b) { return _mm_cmple_ps(a, b); }
+inline Mask4 or4(Mask4 a, Mask4 b) { return _mm_or_ps(a, b); }
+inline Mask4 and4(Mask4 a, Mask4 b) { return _mm_and_ps(a, b); }
+inline int bits4(Mask4 m) { return _mm_movemask_ps(m); }
+#elif CDLOD_QUADTREE_NEON
+typedef float32x4_t Float4;
+typedef uint32x4_t Mask4;
+inline Float4 load4(const float *p) { return vld1q_f32(p); }
+inline void store4(float *p, Float4 a) { vst1q_f32(p, a); }
+inline Float4 set4(float v) { return vdupq_n_f32(v); }
+inline Float4 add4(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 sub4(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 mul4(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 div4(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+inline Float4 max4(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+inline Float4 min4(Float4 a, Float4 b) { return vminq_f32(a, b); }
+inline Float4 abs4(Float4 a) { return vabsq_f32(a); }
+inline Float4 sqrt4(Float4 a) { return vsqrtq_f32(a); }
+inline Mask4 less4(Float4 a, Float4 b) { return vcltq_f32(a, b); }
+inline Mask4 lessEqual4(Float4 a, Float4 b) { return vcleq_f32(a, b); }
+inline Mask4 or4(Mask4 a, Mask4 b) { return vorrq_u32(a, b); }
+inline Mask4 and4(Mask4 a, Mask4 b) { return vandq_u32(a, b); }
+inline int bits4(Mask4 m) {
+    const uint32_t laneBits[4] = {1, 2, 4, 8};
+    return static_cast<int>(vaddvq_u32(vandq_u32(m, vld1q_u32(laneBits))));
+}
+#else
+struct Float4 {
+    float v[4];
+};
+typedef int Mask4;  // one bit per lane
+template <typename TOp>
+inline Float4 map4(Float4 a, Float4 b, TOp op) {
+    for (int i = 0; i < 4; i++) a.v[i] = op(a.v[i], b.v[i]);
+    return a;
+}
+template <typename TOp>
+inline Mask4 compare4(Float4 a, Float4 b, TOp op) {
+    Mask4 m = 0;
+    for (int i = 0; i < 4; i++) m |= op(a.v[i], b.v[i]) ? (1 << i) : 0;
+    return m;
+}
+inline Float4 load4(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store4(float *p, Float4 a) {
+    for (int i = 0; i < 4; i++) p[i] = a.v[i];
+}
+inline Float4 set4(float v) { return {{v, v, v, v}}; }
+inline Float4 add4(Float4 a, Float4 b) { return map4(a, b, [](float x, float y) { return x + y; }); }
+inline Float4 sub4(Float4 a, Float4 b) { return map4(a, b, [](float x, float y) { return x - y; }); }
+inline Float4 mul4(Float4 a, Float4 b) { return map4(a, b, [](float x, float y) { return x * y; }); }
+inline Float4 div4(Float4 a, Float4 b) { return map4(a, b, [](float x, float y) { return x / y; }); }
+inline Float4 max4(Float4 a, Float4 b) { return map4(a, b, [](float x, float y) { return (x > y) ? x : y; }); }
+inline Float4 min4(Float4 a, Float4 b) { return map4(a, b, [](float x, float y) { return (x < y) ? x : y; }); }
+inline Float4 abs4(Float4 a) { return map4(a, a, [](float x, float) { return fabsf(x); }); }
+inline Float4 sqrt4(Float4 a) { return map4(a, a, [](float x, float) { return sqrtf(x); }); }
+inline Mask4 less4(Float4 a, Float4 b) { return compare4(a, b, [](float x, float y) { return x < y; }); }
+inline Mask4 lessEqual4(Float4 a, Float4 b) { return compare4(a, b, [](float x, float y) { return x <= y; }); }
+inline Mask4 or4(Mask4 a, Mask4 b) { return a | b; }
+inline Mask4 and4(Mask4 a, Mask4 b) { return a & b; }
+inline int bits4(Mask4 m) { return m; }
+#endif
+
+// glm::dot(plane, glm::vec4(point, 1)) without GLM_FORCE_INTRINSICS: (x * px + y * py) + (z * pz + pw)
+inline Float4 planeDistance4(Float4 px, Float4 py, Float4 pz, Float4 pw, Float4 x, Float4 y, Float4 z) {
+    return add4(add4(mul4(px, x), mul4(py, y)), add4(mul4(pz, z), pw));
+}
+}  // namespace
+
 CDLODQuadTree::CDLODQuadTree() {
     m_allNodesBuffer = NULL;
     m_topLevelNodes = NULL;
@@ -210,33 +316,75 @@ bool CDLODQuadTree::Create(const CreateDesc &desc) {
     }
     //////////////////////////////////////////////////////////////////////////
 
+    m_topNodeCountX = (m_rasterSizeX - 1) / m_topNodeSize + 1;
+    m_topNodeCountY = (m_rasterSizeY - 1) / m_topNodeSize + 1;
+
+    CreateLevels();
+
+    if (m_desc.ImplicitStorage) {
+        CreateImplicit();
+        m_allNodesCount = totalNodeCount;
+        assert(static_cast<int>(m_minMaxZ.size()) == totalNodeCount);
+
+        int sizeInMemory =
+            static_cast<int>(m_minMaxZ.size() * sizeof(MinMaxZ) + m_leafCornerZ.size() * sizeof(unsigned short));
+        printf("CDLODQuadTree created (implicit), size in memory: ~%.2fKb\n", sizeInMemory / 1024.0f);
+        return true;
+    }
+
     //////////////////////////////////////////////////////////////////////////
     // Initialize the tree memory, create tree nodes, and extract min/max Zs (heights)
     //
+    // The leaf heights are read from the heightmap up front in parallel (CreateLeaves), and then the top level nodes
+    // build their sub trees in parallel. Node::Create fills the buffer depth first, so each top level node's sub tree
+    // takes up a contiguous range of it. Giving each one the start of its range makes the buffer identical to building
+    // the nodes one after another. CH
+    //
+    const int leafLevel = m_desc.LODLevelCount - 1;
+    std::vector<MinMaxZ> leafMinMaxZ(m_levelNodeCountX[leafLevel] * m_levelNodeCountY[leafLevel]);
+    CreateLeaves(leafMinMaxZ.data());
+
+    std::vector<int> topNodeOffsets(m_topNodeCountX * m_topNodeCountY + 1);
+    for (int y = 0; y < m_topNodeCountY; y++) {
+        for (int x = 0; x < m_topNodeCountX; x++) {
+            // The nodes of each level that are inside this top level node.
+            int subTreeNodeCount = 0;
+            for (int level = 0; level < m_desc.LODLevelCount; level++) {
+                const int countX = (std::min)((x + 1) << level, m_levelNodeCountX[level]) - (x << level);
+                const int countY = (std::min)((y + 1) << level, m_levelNodeCountY[level]) - (y << level);
+                subTreeNodeCount += countX * countY;
+            }
+            const int index = y * m_topNodeCountX + x;
+            topNodeOffsets[index + 1] = topNodeOffsets[index] + subTreeNodeCount;
+        }
+    }
+    assert(topNodeOffsets.back() == totalNodeCount);
+
     m_allNodesBuffer = new Node[totalNodeCount];
-    int nodeCounter = 0;
     //
-    m_topNodeCountX = (m_rasterSizeX - 1) / m_topNodeSize + 1;
-    m_topNodeCountY = (m_rasterSizeY - 1) / m_topNodeSize + 1;
     logStart();                 // CH
     printInfo(totalNodeCount);  // CH
     m_topLevelNodes = new Node **[m_topNodeCountY];
-    for (int y = 0; y < m_topNodeCountY; y++) {
-        m_topLevelNodes[y] = new Node *[m_topNodeCountX];
-        log("\n");  // CH
-        for (int x = 0; x < m_topNodeCountX; x++) {
+    for (int y = 0; y < m_topNodeCountY; y++) m_topLevelNodes[y] = new Node *[m_topNodeCountX];
+    helpers::parallelFor(m_topNodeCountX * m_topNodeCountY, getThreadCount(m_desc.ThreadCount), [&](int begin, int end) {
+        for (int index = begin; index < end; index++) {
+            const int x = index % m_topNodeCountX, y = index / m_topNodeCountX;
+            int nodeCounter = topNodeOffsets[index];
             m_topLevelNodes[y][x] = &m_allNodesBuffer[nodeCounter];
             nodeCounter++;
 
             log("Main create loop: (x: %d, y: %d) offsets? (x: %d, y: %d) nodeCounter: %d\n", x, y, x * m_topNodeSize,
                 y * m_topNodeSize, nodeCounter);  // CH
-            m_topLevelNodes[y][x]->Create(x * m_topNodeSize, y * m_topNodeSize, m_topNodeSize, 0, m_desc, m_allNodesBuffer,
-                                          nodeCounter);
+            m_topLevelNodes[y][x]->Create(x * m_topNodeSize, y * m_topNodeSize, m_topNodeSize, 0, m_desc, *this,
+                                          leafMinMaxZ.data(), m_allNodesBuffer, nodeCounter);
+            assert(nodeCounter == topNodeOffsets[index + 1]);
         }
-    }
+    });
     logEnd();  // CH
-    m_allNodesCount = nodeCounter;
-    assert(nodeCounter == totalNodeCount);
+    m_allNodesCount = totalNodeCount;
+    // The leaves keep their own corner heights.
+    m_leafCornerZ.clear();
+    m_leafCornerZ.shrink_to_fit();
 
     int sizeInMemory = totalNodeCount * sizeof(Node);
     printf("CDLODQuadTree created, size in memory: ~%.2fKb\n", sizeInMemory / 1024.0f);
@@ -245,7 +393,8 @@ bool CDLODQuadTree::Create(const CreateDesc &desc) {
     return true;
 }
 //
-void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const CreateDesc &createDesc, Node *allNodesBuffer,
+void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const CreateDesc &createDesc,
+                                 const CDLODQuadTree &quadTree, const MinMaxZ *leafMinMaxZ, Node *allNodesBuffer,
                                  int &allNodesBufferLastIndex) {
     const auto printInfo = [&](char *type) {  // CH
 #if DEBUG_PRINT
@@ -293,10 +442,11 @@ void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const Create
         // Mark leaf node!
         Level |= 0x8000;
 
-        // Find min/max heights at this patch of terrain
-        int limitX = (std::min)(rasterSizeX, x + size + 1);
-        int limitY = (std::min)(rasterSizeY, y + size + 1);
-        createDesc.pHeightmap->GetAreaMinMaxZ(x, y, limitX - x, limitY - y, this->MinZ, this->MaxZ);
+        // Find min/max heights at this patch of terrain (read by CDLODQuadTree::CreateLeaves)
+        const int leafCountX = quadTree.m_levelNodeCountX[level];
+        const int leafX = x / size, leafY = y / size;
+        this->MinZ = leafMinMaxZ[leafY * leafCountX + leafX].MinZ;
+        this->MaxZ = leafMinMaxZ[leafY * leafCountX + leafX].MaxZ;
 
         //// Convert to world space...
         // this->WorldMinZ = createDesc.MapDims.MinZ + this->MinZ * createDesc.MapDims.SizeZ / 65535.0f;
@@ -310,22 +460,19 @@ void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const Create
             float *pBLZ = (float *)&this->SubBL;
             float *pBRZ = (float *)&this->SubBR;
 
-            limitX = (std::min)(rasterSizeX - 1, x + size);
-            limitY = (std::min)(rasterSizeY - 1, y + size);
-            *pTLZ = createDesc.MapDims.MinZ + createDesc.pHeightmap->GetHeightAt(x, y) * createDesc.MapDims.SizeZ / 65535.0f;
-            *pTRZ = createDesc.MapDims.MinZ +
-                    createDesc.pHeightmap->GetHeightAt(limitX, y) * createDesc.MapDims.SizeZ / 65535.0f;
-            *pBLZ = createDesc.MapDims.MinZ +
-                    createDesc.pHeightmap->GetHeightAt(x, limitY) * createDesc.MapDims.SizeZ / 65535.0f;
-            *pBRZ = createDesc.MapDims.MinZ +
-                    createDesc.pHeightmap->GetHeightAt(limitX, limitY) * createDesc.MapDims.SizeZ / 65535.0f;
+            const unsigned short *cornerZ = &quadTree.m_leafCornerZ[leafY * (leafCountX + 1) + leafX];
+            *pTLZ = createDesc.MapDims.MinZ + cornerZ[0] * createDesc.MapDims.SizeZ / 65535.0f;
+            *pTRZ = createDesc.MapDims.MinZ + cornerZ[1] * createDesc.MapDims.SizeZ / 65535.0f;
+            *pBLZ = createDesc.MapDims.MinZ + cornerZ[leafCountX + 1] * createDesc.MapDims.SizeZ / 65535.0f;
+            *pBRZ = createDesc.MapDims.MinZ + cornerZ[leafCountX + 2] * createDesc.MapDims.SizeZ / 65535.0f;
         }
         printInfo("-LEAF-");  // CH
     } else {
         int subSize = size / 2;
 
         this->SubTL = &allNodesBuffer[allNodesBufferLastIndex++];
-        this->SubTL->Create(x, y, subSize, level + 1, createDesc, allNodesBuffer, allNodesBufferLastIndex);
+        this->SubTL->Create(x, y, subSize, level + 1, createDesc, quadTree, leafMinMaxZ, allNodesBuffer,
+                            allNodesBufferLastIndex);
         this->MinZ = this->SubTL->MinZ;
         this->MaxZ = this->SubTL->MaxZ;
         // this->WorldMinZ = this->SubTL->WorldMinZ;
@@ -333,7 +480,8 @@ void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const Create
 
         if ((x + subSize) < rasterSizeX) {
             this->SubTR = &allNodesBuffer[allNodesBufferLastIndex++];
-            this->SubTR->Create(x + subSize, y, subSize, level + 1, createDesc, allNodesBuffer, allNodesBufferLastIndex);
+            this->SubTR->Create(x + subSize, y, subSize, level + 1, createDesc, quadTree, leafMinMaxZ, allNodesBuffer,
+                                allNodesBufferLastIndex);
             this->MinZ = (std::min)(this->MinZ, this->SubTR->MinZ);
             this->MaxZ = (std::max)(this->MaxZ, this->SubTR->MaxZ);
             // this->WorldMinZ = (std::min)( this->WorldMinZ, this->SubTR->WorldMinZ );
@@ -342,7 +490,8 @@ void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const Create
 
         if ((y + subSize) < rasterSizeY) {
             this->SubBL = &allNodesBuffer[allNodesBufferLastIndex++];
-            this->SubBL->Create(x, y + subSize, subSize, level + 1, createDesc, allNodesBuffer, allNodesBufferLastIndex);
+            this->SubBL->Create(x, y + subSize, subSize, level + 1, createDesc, quadTree, leafMinMaxZ, allNodesBuffer,
+                                allNodesBufferLastIndex);
             this->MinZ = (std::min)(this->MinZ, this->SubBL->MinZ);
             this->MaxZ = (std::max)(this->MaxZ, this->SubBL->MaxZ);
             // this->WorldMinZ = (std::min)( this->WorldMinZ, this->SubBL->WorldMinZ );
@@ -351,8 +500,8 @@ void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const Create
 
         if (((x + subSize) < rasterSizeX) && ((y + subSize) < rasterSizeY)) {
             this->SubBR = &allNodesBuffer[allNodesBufferLastIndex++];
-            this->SubBR->Create(x + subSize, y + subSize, subSize, level + 1, createDesc, allNodesBuffer,
-                                allNodesBufferLastIndex);
+            this->SubBR->Create(x + subSize, y + subSize, subSize, level + 1, createDesc, quadTree, leafMinMaxZ,
+                                allNodesBuffer, allNodesBufferLastIndex);
             this->MinZ = (std::min)(this->MinZ, this->SubBR->MinZ);
             this->MaxZ = (std::max)(this->MaxZ, this->SubBR->MaxZ);
             // this->WorldMinZ = (std::min)( this->WorldMinZ, this->SubBR->WorldMinZ );
@@ -362,6 +511,141 @@ void CDLODQuadTree::Node::Create(int x, int y, int size, int level, const Create
     }
 }
 
+void CDLODQuadTree::CreateLevels() {
+    assert((m_topNodeSize >> (m_desc.LODLevelCount - 1)) == m_desc.LeafRenderNodeSize);
+    int nodeCount = 0;
+    for (int level = 0; level < m_desc.LODLevelCount; level++) {
+        const int size = m_topNodeSize >> level;
+        m_levelNodeCountX[level] = (m_rasterSizeX - 1) / size + 1;
+        m_levelNodeCountY[level] = (m_rasterSizeY - 1) / size + 1;
+        m_levelOffsets[level] = nodeCount;
+        nodeCount += m_levelNodeCountX[level] * m_levelNodeCountY[level];
+    }
+}
+
+void HeightmapMinMaxRow(const unsigned short *pRow, int count, unsigned short &minZ, unsigned short &maxZ) {
+    int i = 0;
+#if CDLOD_QUADTREE_SSE2
+    if (count >= 8) {
+        // SSE2 only has signed 16 bit min/max, so flip the sign bit to make unsigned order signed order.
+        const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+        __m128i vMin = _mm_set1_epi16(0x7FFF), vMax = _mm_set1_epi16(static_cast<short>(0x8000));
+        for (; i + 8 <= count; i += 8) {
+            const __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pRow + i)), bias);
+            vMin = _mm_min_epi16(vMin, v);
+            vMax = _mm_max_epi16(vMax, v);
+        }
+        // Reduce the 8 lanes.
+        vMin = _mm_min_epi16(vMin, _mm_srli_si128(vMin, 8));
+        vMax = _mm_max_epi16(vMax, _mm_srli_si128(vMax, 8));
+        vMin = _mm_min_epi16(vMin, _mm_srli_si128(vMin, 4));
+        vMax = _mm_max_epi16(vMax, _mm_srli_si128(vMax, 4));
+        vMin = _mm_min_epi16(vMin, _mm_srli_si128(vMin, 2));
+        vMax = _mm_max_epi16(vMax, _mm_srli_si128(vMax, 2));
+        minZ = (std::min)(minZ, static_cast<unsigned short>(_mm_extract_epi16(vMin, 0) ^ 0x8000));
+        maxZ = (std::max)(maxZ, static_cast<unsigned short>(_mm_extract_epi16(vMax, 0) ^ 0x8000));
+    }
+#elif CDLOD_QUADTREE_NEON
+    if (count >= 8) {
+        uint16x8_t vMin = vdupq_n_u16(0xFFFF), vMax = vdupq_n_u16(0);
+        for (; i + 8 <= count; i += 8) {
+            const uint16x8_t v = vld1q_u16(pRow + i);
+            vMin = vminq_u16(vMin, v);
+            vMax = vmaxq_u16(vMax, v);
+        }
+        minZ = (std::min)(minZ, static_cast<unsigned short>(vminvq_u16(vMin)));
+        maxZ = (std::max)(maxZ, static_cast<unsigned short>(vmaxvq_u16(vMax)));
+    }
+#endif
+    for (; i < count; i++) {
+        minZ = (std::min)(minZ, pRow[i]);
+        maxZ = (std::max)(maxZ, pRow[i]);
+    }
+}
+
+void CDLODQuadTree::CreateLeaves(MinMaxZ *leafMinMaxZ) {
+    const int leafLevel = m_desc.LODLevelCount - 1;
+    const int leafSize = m_desc.LeafRenderNodeSize;
+    const int leafCountX = m_levelNodeCountX[leafLevel];
+    const int leafCountY = m_levelNodeCountY[leafLevel];
+    // Leaves per block when the rows are read (IHeightmapSource::GetRow). A block's rows span a few heightmap tiles at
+    // most, so a paging source keeps hitting the same tiles.
+    const int blockSize = (std::max)(1, 256 / leafSize);
+
+    // Leaf min/max heights come from the heightmap (same area as Node::Create), a range of rows per thread. A source that
+    // stores rows is read a block of leaves at a time and each leaf's part of the rows is reduced with SIMD. Otherwise
+    // every leaf is a GetAreaMinMaxZ call.
+    helpers::parallelFor(leafCountY, getThreadCount(m_desc.ThreadCount), [&](int begin, int end) {
+        std::vector<unsigned short> row(blockSize * leafSize + 1);
+        for (int y = begin; y < end; y++) {
+            const int Y = y * leafSize;
+            const int limitY = (std::min)(m_rasterSizeY, Y + leafSize + 1);
+            MinMaxZ *pLeaves = &leafMinMaxZ[y * leafCountX];
+
+            for (int blockX = 0; blockX < leafCountX; blockX += blockSize) {
+                const int blockEnd = (std::min)(leafCountX, blockX + blockSize);
+                const int blockFromX = blockX * leafSize;
+                const int blockLimitX = (std::min)(m_rasterSizeX, blockEnd * leafSize + 1);
+
+                for (int x = blockX; x < blockEnd; x++) pLeaves[x] = {65535, 0};
+                bool hasRows = true;
+                for (int j = Y; j < limitY; j++) {
+                    hasRows = m_desc.pHeightmap->GetRow(blockFromX, j, blockLimitX - blockFromX, row.data());
+                    if (!hasRows) break;
+                    for (int x = blockX; x < blockEnd; x++) {
+                        const int X = x * leafSize;
+                        const int limitX = (std::min)(m_rasterSizeX, X + leafSize + 1);
+                        HeightmapMinMaxRow(row.data() + (X - blockFromX), limitX - X, pLeaves[x].MinZ, pLeaves[x].MaxZ);
+                    }
+                }
+                if (hasRows) continue;
+
+                for (int x = blockX; x < blockEnd; x++) {
+                    const int X = x * leafSize;
+                    const int limitX = (std::min)(m_rasterSizeX, X + leafSize + 1);
+                    m_desc.pHeightmap->GetAreaMinMaxZ(X, Y, limitX - X, limitY - Y, pLeaves[x].MinZ, pLeaves[x].MaxZ);
+                }
+            }
+        }
+    });
+
+    // Leaf corner heights (clamped to the raster the same way as Node::Create).
+    m_leafCornerZ.resize((leafCountX + 1) * (leafCountY + 1));
+    helpers::parallelFor(leafCountY + 1, getThreadCount(m_desc.ThreadCount), [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            for (int x = 0; x <= leafCountX; x++) {
+                m_leafCornerZ[y * (leafCountX + 1) + x] = m_desc.pHeightmap->GetHeightAt(
+                    (std::min)(m_rasterSizeX - 1, x * leafSize), (std::min)(m_rasterSizeY - 1, y * leafSize));
+            }
+        }
+    });
+}
+
+void CDLODQuadTree::CreateImplicit() {
+    const int leafLevel = m_desc.LODLevelCount - 1;
+    m_minMaxZ.resize(m_levelOffsets[leafLevel] + m_levelNodeCountX[leafLevel] * m_levelNodeCountY[leafLevel]);
+    CreateLeaves(&m_minMaxZ[m_levelOffsets[leafLevel]]);
+
+    // The rest of the levels from the bottom up, a range of rows per thread. The first child always exists.
+    for (int level = leafLevel - 1; level >= 0; level--) {
+        helpers::parallelFor(m_levelNodeCountY[level], getThreadCount(m_desc.ThreadCount), [&](int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                for (int x = 0; x < m_levelNodeCountX[level]; x++) {
+                    MinMaxZ minMaxZ = GetMinMaxZ(level + 1, 2 * x, 2 * y);
+                    for (int i = 1; i < 4; i++) {
+                        const int cx = 2 * x + (i & 1), cy = 2 * y + (i >> 1);
+                        if (!HasNode(level + 1, cx, cy)) continue;
+                        const MinMaxZ &child = GetMinMaxZ(level + 1, cx, cy);
+                        minMaxZ.MinZ = (std::min)(minMaxZ.MinZ, child.MinZ);
+                        minMaxZ.MaxZ = (std::max)(minMaxZ.MaxZ, child.MaxZ);
+                    }
+                    m_minMaxZ[m_levelOffsets[level] + y * m_levelNodeCountX[level] + x] = minMaxZ;
+                }
+            }
+        });
+    }
+}
+
 void CDLODQuadTree::Node::DebugDrawAABB(unsigned int penColor, const CDLODQuadTree &quadTree) const {
     assert(false);
     AABB boundingBox;
@@ -370,41 +654,39 @@ void CDLODQuadTree::Node::DebugDrawAABB(unsigned int penColor, const CDLODQuadTr
 }
 
 CDLODQuadTree::Node::LODSelectResult CDLODQuadTree::Node::LODSelect(LODSelectInfo &lodSelectInfo,
-                                                                    bool parentCompletelyInFrustum) const {
-    AABB boundingBox;
-    GetAABB(boundingBox, lodSelectInfo.RasterSizeX, lodSelectInfo.RasterSizeY, lodSelectInfo.MapDims);
+                                                                    const LODSelectTest &test) const {
+    AABB boundingBox = test.BoundingBox;
 
-    // glm::vec3 boundingSphereCenter;
-    // float       boundingSphereRadiusSq;
-    // GetBSphere( boundingSphereCenter, boundingSphereRadiusSq, quadTree );
-
-    const glm::vec4 *frustumPlanes = lodSelectInfo.SelectionObj->m_frustumPlanes;
     const glm::vec3 &observerPos = lodSelectInfo.SelectionObj->m_observerPos;
     const int maxSelectionCount = lodSelectInfo.SelectionObj->m_maxSelectionCount;
-    float *lodRanges = lodSelectInfo.SelectionObj->m_visibilityRanges;
-
-    IntersectType frustumIt = (parentCompletelyInFrustum) ? (IT_Inside) : (boundingBox.TestInBoundingPlanes(frustumPlanes));
-    if (frustumIt == IT_Outside) return IT_OutOfFrustum;
 
-    float distanceLimit = lodRanges[this->GetLevel()];
-
-    if (!boundingBox.IntersectSphereSq(observerPos, distanceLimit * distanceLimit)) return IT_OutOfRange;
+    if (test.FrustumIt == IT_Outside) return IT_OutOfFrustum;
+    if (!test.InRange) return IT_OutOfRange;
 
     LODSelectResult SubTLSelRes = IT_Undefined;
     LODSelectResult SubTRSelRes = IT_Undefined;
     LODSelectResult SubBLSelRes = IT_Undefined;
     LODSelectResult SubBRSelRes = IT_Undefined;
 
-    if (this->GetLevel() != lodSelectInfo.StopAtLevel) {
-        float nextDistanceLimit = lodRanges[this->GetLevel() + 1];
-        if (boundingBox.IntersectSphereSq(observerPos, nextDistanceLimit * nextDistanceLimit)) {
-            bool weAreCompletelyInFrustum = frustumIt == IT_Inside;
-
-            if (SubTL != NULL) SubTLSelRes = this->SubTL->LODSelect(lodSelectInfo, weAreCompletelyInFrustum);
-            if (SubTR != NULL) SubTRSelRes = this->SubTR->LODSelect(lodSelectInfo, weAreCompletelyInFrustum);
-            if (SubBL != NULL) SubBLSelRes = this->SubBL->LODSelect(lodSelectInfo, weAreCompletelyInFrustum);
-            if (SubBR != NULL) SubBRSelRes = this->SubBR->LODSelect(lodSelectInfo, weAreCompletelyInFrustum);
+    if (this->GetLevel() != lodSelectInfo.StopAtLevel && test.InNextRange) {
+        // Test the children together, then recurse in the usual TL, TR, BL, BR order.
+        const Node *subNodes[4] = {SubTL, SubTR, SubBL, SubBR};
+        LODSelectResult *subSelRes[4] = {&SubTLSelRes, &SubTRSelRes, &SubBLSelRes, &SubBRSelRes};
+        AABB subBoxes[4];
+        int subIndices[4];
+        int subCount = 0;
+        for (int i = 0; i < 4; i++) {
+            if (subNodes[i] == NULL) continue;
+            subNodes[i]->GetAABB(subBoxes[subCount], lodSelectInfo.RasterSizeX, lodSelectInfo.RasterSizeY,
+                                 lodSelectInfo.MapDims);
+            subIndices[subCount++] = i;
         }
+
+        LODSelectTest subTests[4];
+        LODSelectTestNodes(lodSelectInfo, this->GetLevel() + 1, subBoxes, subCount, test.InsidePlaneMask, subTests);
+        lodSelectInfo.TestedNodeCount += subCount;
+        for (int i = 0; i < subCount; i++)
+            *subSelRes[subIndices[i]] = subNodes[subIndices[i]]->LODSelect(lodSelectInfo, subTests[i]);
     }
 
     // We don't want to select sub nodes that are invisible (out of frustum) or are selected;
@@ -452,9 +734,275 @@ CDLODQuadTree::Node::LODSelectResult CDLODQuadTree::Node::LODSelect(LODSelectInf
         return IT_OutOfFrustum;
 }
 
+// Same as Node::LODSelect for the implicit storage. With LODSelectInfo::Cache the node's LODSelectionCache entry is
+// reused or rewritten. CH
+CDLODQuadTree::Node::LODSelectResult CDLODQuadTree::LODSelectImplicit(Node::LODSelectInfo &lodSelectInfo, int level, int x,
+                                                                      int y, const Node::LODSelectTest &test) const {
+    AABB boundingBox = test.BoundingBox;
+
+    const glm::vec3 &observerPos = lodSelectInfo.SelectionObj->m_observerPos;
+    const int maxSelectionCount = lodSelectInfo.SelectionObj->m_maxSelectionCount;
+
+    if (test.FrustumIt == IT_Outside) return Node::IT_OutOfFrustum;
+    if (!test.InRange) return Node::IT_OutOfRange;
+
+    LODSelectionCache *cache = lodSelectInfo.Cache;
+    const int nodeIndex = GetNodeIndex(level, x, y);
+    Node::LODSelectResult result;
+    unsigned int childValidFrame = 0;
+    int childSelectionShift = 0;
+    if (cache != NULL && cache->Reuse(lodSelectInfo, nodeIndex, test, result, childValidFrame, childSelectionShift))
+        return result;
+
+    const int selectionStart = lodSelectInfo.SelectionCount;
+    float frustumBudget = FLT_MAX, rangeBudget = FLT_MAX;
+    bool visDistTooSmall = false;
+
+    // TL, TR, BL, BR
+    Node::LODSelectResult subSelRes[4] = {Node::IT_Undefined, Node::IT_Undefined, Node::IT_Undefined, Node::IT_Undefined};
+
+    if (level != lodSelectInfo.StopAtLevel && test.InNextRange) {
+        AABB subBoxes[4];
+        int subIndices[4];
+        int subCount = 0;
+        for (int i = 0; i < 4; i++) {
+            const int cx = 2 * x + (i & 1), cy = 2 * y + (i >> 1);
+            if (!HasNode(level + 1, cx, cy)) continue;
+            GetNodeAABB(level + 1, cx, cy, subBoxes[subCount]);
+            subIndices[subCount++] = i;
+        }
+
+        Node::LODSelectTest subTests[4];
+        bool subTested[4] = {true, true, true, true};
+        if (cache != NULL) {
+            // Only the children whose last test may not hold anymore. CH
+            AABB testBoxes[4];
+            int testIndices[4];
+            int testCount = 0;
+            for (int k = 0; k < subCount; k++) {
+                const int i = subIndices[k];
+                const int subIndex = GetNodeIndex(level + 1, 2 * x + (i & 1), 2 * y + (i >> 1));
+                subTested[k] = !cache->GetTest(subIndex, test.InsidePlaneMask, subTests[k]);
+                subTests[k].BoundingBox = subBoxes[k];
+                if (subTested[k]) {
+                    testBoxes[testCount] = subBoxes[k];
+                    testIndices[testCount++] = k;
+                }
+            }
+            Node::LODSelectTest tests[4];
+            LODSelectTestNodes(lodSelectInfo, level + 1, testBoxes, testCount, test.InsidePlaneMask, tests);
+            for (int t = 0; t < testCount; t++) subTests[testIndices[t]] = tests[t];
+            lodSelectInfo.TestedNodeCount += testCount;
+        } else {
+            LODSelectTestNodes(lodSelectInfo, level + 1, subBoxes, subCount, test.InsidePlaneMask, subTests);
+            lodSelectInfo.TestedNodeCount += subCount;
+        }
+
+        for (int k = 0; k < subCount; k++) {
+            const int i = subIndices[k];
+            const int cx = 2 * x + (i & 1), cy = 2 * y + (i >> 1);
+            if (cache != NULL) {
+                cache->m_validFrame = childValidFrame;
+                cache->m_selectionShift = childSelectionShift;
+            }
+            subSelRes[i] = LODSelectImplicit(lodSelectInfo, level + 1, cx, cy, subTests[k]);
+
+            if (cache != NULL) {
+                // After the child, which compares it with the test it was last evaluated with.
+                if (subTested[k]) cache->SetTest(GetNodeIndex(level + 1, cx, cy), test.InsidePlaneMask, subTests[k]);
+                frustumBudget = (std::min)(frustumBudget, subTests[k].FrustumSlack + cache->m_frustumMoved);
+                rangeBudget = (std::min)(rangeBudget, subTests[k].RangeSlack + cache->m_observerMoved);
+                // Only the children that got past their tests have an entry.
+                if (subTests[k].FrustumIt != IT_Outside && subTests[k].InRange) {
+                    const LODSelectionCache::Entry &sub = cache->m_entries[GetNodeIndex(level + 1, cx, cy)];
+                    frustumBudget = (std::min)(frustumBudget, sub.FrustumBudget);
+                    rangeBudget = (std::min)(rangeBudget, sub.RangeBudget);
+                    visDistTooSmall = visDistTooSmall || sub.VisDistTooSmall;
+                }
+            }
+        }
+    }
+
+    // We don't want to select sub nodes that are invisible (out of frustum) or are selected;
+    // (we DO want to select if they are out of range, since we are not)
+    bool bRemoveSub[4];
+    for (int i = 0; i < 4; i++)
+        bRemoveSub[i] = (subSelRes[i] == Node::IT_OutOfFrustum) || (subSelRes[i] == Node::IT_Selected);
+
+    result = Node::IT_OutOfFrustum;
+    assert(lodSelectInfo.SelectionCount < maxSelectionCount);
+    if (!(bRemoveSub[0] && bRemoveSub[1] && bRemoveSub[2] && bRemoveSub[3]) &&
+        (lodSelectInfo.SelectionCount < maxSelectionCount)) {
+        const int size = m_topNodeSize >> level;
+        const MinMaxZ &minMaxZ = GetMinMaxZ(level, x, y);
+        int LODLevel = lodSelectInfo.StopAtLevel - level;  // The LOD level is inverted here... CH
+        lodSelectInfo.SelectionObj->m_selectionBuffer[lodSelectInfo.SelectionCount++] =
+            SelectedNode(x * size, y * size, (unsigned short)size, minMaxZ.MinZ, minMaxZ.MaxZ, LODLevel, !bRemoveSub[0],
+                         !bRemoveSub[1], !bRemoveSub[2], !bRemoveSub[3]);
+
+        // This should be calculated somehow better, but brute force will work for now. The cache needs every subtree's
+        // answer, so it doesn't stop at the first one. CH
+        if (
+#ifndef _DEBUG
+            (!lodSelectInfo.SelectionObj->m_visDistTooSmall || cache != NULL) &&
+#endif
+            (level != 0)) {
+            float maxDistFromCam = sqrtf(boundingBox.MaxDistanceFromPointSq(observerPos));
+
+            float morphStartRange = lodSelectInfo.SelectionObj->m_morphStart[lodSelectInfo.StopAtLevel - level + 1];
+
+            if (maxDistFromCam > morphStartRange) {
+                lodSelectInfo.SelectionObj->m_visDistTooSmall = true;
+                visDistTooSmall = true;
+            }
+            if (cache != NULL)
+                rangeBudget = (std::min)(rangeBudget, fabsf(maxDistFromCam - morphStartRange) + cache->m_observerMoved);
+        }
+
+        result = Node::IT_Selected;
+    } else {
+        // if any of child nodes are selected, then return selected - otherwise all of them are out of frustum, so we're
+        // out of frustum too
+        for (int i = 0; i < 4; i++)
+            if (subSelRes[i] == Node::IT_Selected) result = Node::IT_Selected;
+    }
+
+    if (cache != NULL) {
+        LODSelectionCache::Entry &entry = cache->m_entries[nodeIndex];
+        entry.Frame = cache->m_frame;
+        entry.EvalFrame = cache->m_frame;
+        entry.SelectionStart = selectionStart;
+        entry.EvalSelectionStart = selectionStart;
+        entry.SelectionCount = lodSelectInfo.SelectionCount - selectionStart;
+        entry.FrustumBudget = frustumBudget;
+        entry.RangeBudget = rangeBudget;
+        entry.Result = static_cast<unsigned char>(result);
+        entry.VisDistTooSmall = visDistTooSmall;
+    }
+    return result;
+}
+
+// AABB::TestInBoundingPlanes and AABB::IntersectSphereSq for up to four boxes, one per lane. The float operations are
+// done in the same order as there. A plane that the parent is completely inside of is skipped, since the children are
+// inside of it too; a box that ends up inside all six planes is IT_Inside. CH
+void CDLODQuadTree::LODSelectTestNodes(const Node::LODSelectInfo &lodSelectInfo, int level, const AABB boxes[4],
+                                       int count, unsigned char parentInsidePlaneMask, Node::LODSelectTest tests[4]) {
+    assert(count >= 0 && count <= 4);
+    if (count == 0) return;
+
+    const LODSelection *selectionObj = lodSelectInfo.SelectionObj;
+    const glm::vec4 *frustumPlanes = selectionObj->m_frustumPlanes;
+    const glm::vec3 &observerPos = selectionObj->m_observerPos;
+    const float *lodRanges = selectionObj->m_visibilityRanges;
+
+    // Structure of arrays. Unused lanes repeat the last box and are ignored.
+    alignas(16) float minX[4], minY[4], minZ[4], maxX[4], maxY[4], maxZ[4];
+    for (int i = 0; i < 4; i++) {
+        const AABB &box = boxes[(std::min)(i, count - 1)];
+        minX[i] = box.Min.x, minY[i] = box.Min.y, minZ[i] = box.Min.z;
+        maxX[i] = box.Max.x, maxY[i] = box.Max.y, maxZ[i] = box.Max.z;
+    }
+    const Float4 x0 = load4(minX), y0 = load4(minY), z0 = load4(minZ);
+    const Float4 x1 = load4(maxX), y1 = load4(maxY), z1 = load4(maxZ);
+    const Float4 zero = set4(0.0f);
+
+    // Frustum
+    const Float4 half = set4(0.5f);
+    const Float4 cx = mul4(add4(x0, x1), half), cy = mul4(add4(y0, y1), half), cz = mul4(add4(z0, z1), half);
+    const Float4 sx = sub4(x1, x0), sy = sub4(y1, y0), sz = sub4(z1, z0);
+    // -size / 2 of the bounding sphere test
+    const Float4 size = sqrt4(add4(add4(mul4(sx, sx), mul4(sy, sy)), mul4(sz, sz)));
+    const Float4 negHalfSize = div4(mul4(size, set4(-1.0f)), set4(2.0f));
+
+    // Slack (LODSelectInfo::Cache): the smallest distance of anything above from its test's threshold.
+    const bool makeSlack = lodSelectInfo.Cache != NULL;
+    Float4 frustumSlack = set4(FLT_MAX);
+
+    Mask4 outside = less4(zero, zero);
+    int insidePlaneMask[4] = {parentInsidePlaneMask, parentInsidePlaneMask, parentInsidePlaneMask,
+                              parentInsidePlaneMask};
+    for (int p = 0; p < 6; p++) {
+        if (parentInsidePlaneMask & (1 << p)) continue;
+
+        const glm::vec4 &plane = frustumPlanes[p];
+        const Float4 px = set4(plane.x), py = set4(plane.y), pz = set4(plane.z), pw = set4(plane.w);
+
+        const Float4 centDist = planeDistance4(px, py, pz, pw, cx, cy, cz);
+        outside = or4(outside, less4(centDist, negHalfSize));
+
+        // 8 corners and the center
+        const Float4 dists[9] = {
+            planeDistance4(px, py, pz, pw, x0, y0, z0), planeDistance4(px, py, pz, pw, x1, y0, z0),
+            planeDistance4(px, py, pz, pw, x0, y1, z0), planeDistance4(px, py, pz, pw, x1, y1, z0),
+            planeDistance4(px, py, pz, pw, x0, y0, z1), planeDistance4(px, py, pz, pw, x1, y0, z1),
+            planeDistance4(px, py, pz, pw, x0, y1, z1), planeDistance4(px, py, pz, pw, x1, y1, z1),
+            centDist,
+        };
+        Mask4 anyOut = less4(dists[0], zero);
+        Mask4 allOut = anyOut;
+        for (int i = 1; i < 9; i++) {
+            const Mask4 out = less4(dists[i], zero);
+            anyOut = or4(anyOut, out);
+            allOut = and4(allOut, out);
+        }
+        outside = or4(outside, allOut);
+
+        const int inBits = ~bits4(anyOut);
+        for (int i = 0; i < 4; i++)
+            if (inBits & (1 << i)) insidePlaneMask[i] |= 1 << p;
+
+        if (makeSlack) {
+            Float4 slack = abs4(sub4(centDist, negHalfSize));
+            for (int i = 0; i < 9; i++) slack = min4(slack, abs4(dists[i]));
+            frustumSlack = min4(frustumSlack, slack);
+        }
+    }
+    const int outsideBits = bits4(outside);
+
+    // Range: squared distance from the observer to the box, as in AABB::MinDistanceFromPointSq
+    const Float4 ox = set4(observerPos.x), oy = set4(observerPos.y), oz = set4(observerPos.z);
+    const Float4 dx = max4(max4(sub4(x0, ox), sub4(ox, x1)), zero);
+    const Float4 dy = max4(max4(sub4(y0, oy), sub4(oy, y1)), zero);
+    const Float4 dz = max4(max4(sub4(z0, oz), sub4(oz, z1)), zero);
+    const Float4 distSq = add4(add4(mul4(dx, dx), mul4(dy, dy)), mul4(dz, dz));
+
+    const float range = lodRanges[level];
+    const int inRangeBits = bits4(lessEqual4(distSq, set4(range * range)));
+    int inNextRangeBits = 0;
+    if (level != lodSelectInfo.StopAtLevel) {
+        const float nextRange = lodRanges[level + 1];
+        inNextRangeBits = bits4(lessEqual4(distSq, set4(nextRange * nextRange)));
+    }
+
+    alignas(16) float frustumSlacks[4], rangeSlacks[4];
+    if (makeSlack) {
+        const Float4 dist = sqrt4(distSq);
+        Float4 rangeSlack = abs4(sub4(dist, set4(range)));
+        if (level != lodSelectInfo.StopAtLevel) rangeSlack = min4(rangeSlack, abs4(sub4(dist, set4(lodRanges[level + 1]))));
+        store4(frustumSlacks, frustumSlack);
+        store4(rangeSlacks, rangeSlack);
+    }
+
+    for (int i = 0; i < count; i++) {
+        Node::LODSelectTest &test = tests[i];
+        test.BoundingBox = boxes[i];
+        test.InsidePlaneMask = static_cast<unsigned char>(insidePlaneMask[i]);
+        if (outsideBits & (1 << i))
+            test.FrustumIt = IT_Outside;
+        else
+            test.FrustumIt = (test.InsidePlaneMask == 0x3F) ? IT_Inside : IT_Intersect;
+        test.InRange = (inRangeBits & (1 << i)) != 0;
+        test.InNextRange = (inNextRangeBits & (1 << i)) != 0;
+        test.FrustumSlack = makeSlack ? frustumSlacks[i] : 0.0f;
+        test.RangeSlack = makeSlack ? rangeSlacks[i] : 0.0f;
+    }
+}
+
 void CDLODQuadTree::Clean() {
     if (m_allNodesBuffer != NULL) delete[] m_allNodesBuffer;
     m_allNodesBuffer = NULL;
+    m_minMaxZ.clear();
+    m_leafCornerZ.clear();
 
     if (m_topLevelNodes != NULL) {
         for (int y = 0; y < m_topNodeCountY; y++) delete[] m_topLevelNodes[y];
@@ -465,6 +1013,7 @@ void CDLODQuadTree::Clean() {
 }
 
 void CDLODQuadTree::DebugDrawAllNodes() const {
+    if (m_allNodesBuffer == NULL) return;  // implicit storage
     for (int i = 0; i < m_allNodesCount; i++)
         if (m_allNodesBuffer[i].GetLevel() != 0) m_allNodesBuffer[i].DebugDrawAABB(0xFF00FF00, *this);
     for (int i = 0; i < m_allNodesCount; i++)
@@ -478,12 +1027,97 @@ int compare_closerFirst(const void *arg1, const void *arg2) {
     return a->MinDistToCamera > b->MinDistToCamera;
 }
 //
-void CDLODQuadTree::LODSelect(LODSelection *selectionObj) const {
+void CDLODQuadTree::LODSelect(LODSelection *selectionObj) const { LODSelectNodes(selectionObj, NULL); }
+//
+void CDLODQuadTree::LODSelectIncremental(LODSelection *selectionObj, LODSelectionCache *cache) const {
+    assert(cache != NULL);
+    LODSelectNodes(selectionObj, m_desc.ImplicitStorage ? cache : NULL);
+}
+//
+void CDLODQuadTree::LODSelectNodes(LODSelection *selectionObj, LODSelectionCache *cache) const {
 #ifdef MY_EXTENDED_STUFF
     Prof(DLODQuadTree_LODSelect);
 #endif
+    const auto startTime = std::chrono::steady_clock::now();
 
     const glm::vec3 &cameraPos = selectionObj->m_observerPos;
+    const int layerCount = m_desc.LODLevelCount;
+
+    LODSelectRanges(selectionObj);
+
+    Node::LODSelectInfo lodSelInfo;
+    lodSelInfo.RasterSizeX = m_rasterSizeX;
+    lodSelInfo.RasterSizeY = m_rasterSizeY;
+    lodSelInfo.MapDims = m_desc.MapDims;
+    lodSelInfo.SelectionCount = 0;
+    lodSelInfo.SelectionObj = selectionObj;
+    lodSelInfo.StopAtLevel = layerCount - 1;
+    lodSelInfo.TestedNodeCount = 0;
+    lodSelInfo.Cache = cache;
+
+    if (cache != NULL) cache->Begin(*this, *selectionObj);
+
+    for (int y = 0; y < m_topNodeCountY; y++)
+        for (int x = 0; x < m_topNodeCountX; x++) {
+            AABB boundingBox;
+            if (m_desc.ImplicitStorage)
+                GetNodeAABB(0, x, y, boundingBox);
+            else
+                m_topLevelNodes[y][x]->GetAABB(boundingBox, m_rasterSizeX, m_rasterSizeY, m_desc.MapDims);
+
+            Node::LODSelectTest test;
+            LODSelectTestNodes(lodSelInfo, 0, &boundingBox, 1, 0, &test);
+            lodSelInfo.TestedNodeCount++;
+            if (cache != NULL) {
+                cache->m_validFrame = cache->m_frame - 1;
+                cache->m_selectionShift = 0;
+            }
+            if (m_desc.ImplicitStorage)
+                LODSelectImplicit(lodSelInfo, 0, x, y, test);
+            else
+                m_topLevelNodes[y][x]->LODSelect(lodSelInfo, test);
+            if (cache != NULL) cache->SetTest(GetNodeIndex(0, x, y), 0, test);
+        }
+
+    selectionObj->m_maxSelectedLODLevel = 0;
+    selectionObj->m_minSelectedLODLevel = c_maxLODLevels;
+    for (int i = 0; i < c_maxLODLevels; i++) selectionObj->m_morphingCounts[i] = 0;
+
+    for (int i = 0; i < lodSelInfo.SelectionCount; i++) {
+        AABB naabb;
+        selectionObj->m_selectionBuffer[i].GetAABB(naabb, m_rasterSizeX, m_rasterSizeY, m_desc.MapDims);
+
+        // Stats only (CDLODRenderStats::MorphingQuads). CH
+        const int LODLevel = selectionObj->m_selectionBuffer[i].LODLevel;
+        const float morphStart = selectionObj->m_morphStart[LODLevel];
+        if (naabb.MaxDistanceFromPointSq(cameraPos) > morphStart * morphStart) selectionObj->m_morphingCounts[LODLevel]++;
+
+        if (selectionObj->m_sortByDistance)
+            selectionObj->m_selectionBuffer[i].MinDistToCamera = sqrtf(naabb.MinDistanceFromPointSq(cameraPos));
+        else
+            selectionObj->m_selectionBuffer[i].MinDistToCamera = 0;
+
+        selectionObj->m_minSelectedLODLevel =
+            (std::min)(selectionObj->m_minSelectedLODLevel, selectionObj->m_selectionBuffer[i].LODLevel);
+        selectionObj->m_maxSelectedLODLevel =
+            (std::max)(selectionObj->m_maxSelectedLODLevel, selectionObj->m_selectionBuffer[i].LODLevel);
+    }
+
+    selectionObj->m_selectionCount = lodSelInfo.SelectionCount;
+    selectionObj->m_testedNodeCount = lodSelInfo.TestedNodeCount;
+
+    // Before sorting; the cache's entries point into the selection in traversal order.
+    if (cache != NULL) cache->End(*selectionObj, lodSelInfo.SelectionCount);
+
+    if (selectionObj->m_sortByDistance)
+        qsort(selectionObj->m_selectionBuffer, selectionObj->m_selectionCount, sizeof(*selectionObj->m_selectionBuffer),
+              compare_closerFirst);
+
+    selectionObj->m_selectionTime =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+//
+void CDLODQuadTree::LODSelectRanges(LODSelection *selectionObj) const {
     const float visibilityDistance = selectionObj->m_visibilityDistance;
     const int layerCount = m_desc.LODLevelCount;
 
@@ -522,43 +1156,163 @@ void CDLODQuadTree::LODSelect(LODSelection *selectionObj) const {
 
         prevPos = selectionObj->m_morphStart[i];
     }
+}
+//
+float CDLODQuadTree::GetWorldRadius() const {
+    const MapDimensions &mapDims = m_desc.MapDims;
+    const glm::vec3 farCorner((std::max)(fabsf(mapDims.MinX), fabsf(mapDims.MaxX())),
+                              (std::max)(fabsf(mapDims.MinY), fabsf(mapDims.MaxY())),
+                              (std::max)(fabsf(mapDims.MinZ), fabsf(mapDims.MaxZ())));
+    return glm::length(farCorner);
+}
+//
+CDLODQuadTree::LODSelectionCache::LODSelectionCache()
+    : MaxMoveDistance(0.0f),
+      m_quadTree(NULL),
+      m_frame(0),
+      m_fullSelectionFrame(0),
+      m_valid(false),
+      m_observerPos(0.0f),
+      m_visibilityDistance(0.0f),
+      m_LODDistanceRatio(0.0f),
+      m_morphStartRatio(0.0f),
+      m_maxSelectionCount(0),
+      m_frustumMoved(0.0f),
+      m_observerMoved(0.0f),
+      m_frustumEpsilon(0.0f),
+      m_rangeEpsilon(0.0f),
+      m_validFrame(0),
+      m_selectionShift(0),
+      m_fullSelection(true),
+      m_reusedSelectionCount(0) {
+    for (int p = 0; p < 6; p++) m_frustumPlanes[p] = glm::vec4(0.0f);
+}
+//
+void CDLODQuadTree::LODSelectionCache::Begin(const CDLODQuadTree &quadTree, const LODSelection &selectionObj) {
+    const float worldRadius = quadTree.GetWorldRadius();
+
+    // A point of the map moves at most |n1 - n0| * worldRadius + |w1 - w0| relative to a plane (n, w), and the distance
+    // from the observer to anything moves at most as far as the observer.
+    const float observerMove = glm::length(selectionObj.m_observerPos - m_observerPos);
+    float frustumMove = 0.0f;
+    float planeScale = 0.0f;
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4 &plane = selectionObj.m_frustumPlanes[p];
+        const glm::vec4 delta = plane - m_frustumPlanes[p];
+        frustumMove = (std::max)(frustumMove, glm::length(glm::vec3(delta)) * worldRadius + fabsf(delta.w));
+        planeScale = (std::max)(planeScale, glm::length(glm::vec3(plane)) * worldRadius + fabsf(plane.w));
+    }
 
-    Node::LODSelectInfo lodSelInfo;
-    lodSelInfo.RasterSizeX = m_rasterSizeX;
-    lodSelInfo.RasterSizeY = m_rasterSizeY;
-    lodSelInfo.MapDims = m_desc.MapDims;
-    lodSelInfo.SelectionCount = 0;
-    lodSelInfo.SelectionObj = selectionObj;
-    lodSelInfo.StopAtLevel = layerCount - 1;
-
-    for (int y = 0; y < m_topNodeCountY; y++)
-        for (int x = 0; x < m_topNodeCountX; x++) {
-            m_topLevelNodes[y][x]->LODSelect(lodSelInfo, false);
-        }
-
-    selectionObj->m_maxSelectedLODLevel = 0;
-    selectionObj->m_minSelectedLODLevel = c_maxLODLevels;
+    // The tests' values are below these, and their float error is far below 1e-5 of them.
+    const float frustumScale = planeScale + worldRadius;
+    const float rangeScale = worldRadius + glm::length(selectionObj.m_observerPos) + selectionObj.m_visibilityDistance;
+    const float maxMove = (MaxMoveDistance > 0.0f) ? MaxMoveDistance : quadTree.GetLODLevelNodeDiagonalSize(0);
+
+    const bool sameTree = (m_quadTree == &quadTree) && (m_entries.size() == quadTree.m_minMaxZ.size());
+    const bool sameRanges = (m_visibilityDistance == selectionObj.m_visibilityDistance) &&
+                            (m_LODDistanceRatio == selectionObj.m_LODDistanceRatio) &&
+                            (m_morphStartRatio == selectionObj.m_morphStartRatio) &&
+                            (m_maxSelectionCount == selectionObj.m_maxSelectionCount);
+    // The totals are restarted before they get big enough to eat into the epsilons.
+    m_fullSelection = !m_valid || !sameTree || !sameRanges || (observerMove > maxMove) || (frustumMove > maxMove) ||
+                      (m_observerMoved + observerMove > rangeScale) || (m_frustumMoved + frustumMove > frustumScale);
+
+    if (!sameTree) {
+        m_quadTree = &quadTree;
+        m_entries.assign(quadTree.m_minMaxZ.size(), Entry());
+    }
+    if (m_fullSelection) {
+        m_observerMoved = 0.0f;
+        m_frustumMoved = 0.0f;
+    } else {
+        m_observerMoved += observerMove;
+        m_frustumMoved += frustumMove;
+    }
+    m_frustumEpsilon = frustumScale * 1e-5f;
+    m_rangeEpsilon = rangeScale * 1e-5f;
+    m_frame++;
+    if (m_fullSelection) m_fullSelectionFrame = m_frame;
+    m_reusedSelectionCount = 0;
+
+    m_observerPos = selectionObj.m_observerPos;
+    for (int p = 0; p < 6; p++) m_frustumPlanes[p] = selectionObj.m_frustumPlanes[p];
+    m_visibilityDistance = selectionObj.m_visibilityDistance;
+    m_LODDistanceRatio = selectionObj.m_LODDistanceRatio;
+    m_morphStartRatio = selectionObj.m_morphStartRatio;
+    m_maxSelectionCount = selectionObj.m_maxSelectionCount;
+}
+//
+void CDLODQuadTree::LODSelectionCache::End(const LODSelection &selectionObj, int selectionCount) {
+    m_selection.assign(selectionObj.m_selectionBuffer, selectionObj.m_selectionBuffer + selectionCount);
+    // A full selection buffer may have dropped nodes that the entries don't know about.
+    m_valid = selectionCount < selectionObj.m_maxSelectionCount;
+}
+//
+bool CDLODQuadTree::LODSelectionCache::GetTest(int nodeIndex, unsigned char parentInsidePlaneMask,
+                                               Node::LODSelectTest &test) const {
+    const Entry &entry = m_entries[nodeIndex];
+    if (m_fullSelection || entry.TestFrame < m_fullSelectionFrame ||
+        entry.TestParentInsidePlaneMask != parentInsidePlaneMask)
+        return false;
 
-    for (int i = 0; i < lodSelInfo.SelectionCount; i++) {
-        AABB naabb;
-        selectionObj->m_selectionBuffer[i].GetAABB(naabb, m_rasterSizeX, m_rasterSizeY, m_desc.MapDims);
+    test.FrustumSlack = entry.TestFrustumBudget - m_frustumMoved;
+    test.RangeSlack = entry.TestRangeBudget - m_observerMoved;
+    if (test.FrustumSlack <= m_frustumEpsilon || test.RangeSlack <= m_rangeEpsilon) return false;
 
-        if (selectionObj->m_sortByDistance)
-            selectionObj->m_selectionBuffer[i].MinDistToCamera = sqrtf(naabb.MinDistanceFromPointSq(cameraPos));
-        else
-            selectionObj->m_selectionBuffer[i].MinDistToCamera = 0;
+    test.FrustumIt = static_cast<IntersectType>(entry.FrustumIt);
+    test.InsidePlaneMask = entry.InsidePlaneMask;
+    test.InRange = entry.InRange;
+    test.InNextRange = entry.InNextRange;
+    return true;
+}
+//
+void CDLODQuadTree::LODSelectionCache::SetTest(int nodeIndex, unsigned char parentInsidePlaneMask,
+                                               const Node::LODSelectTest &test) {
+    Entry &entry = m_entries[nodeIndex];
+    entry.TestFrame = m_frame;
+    entry.TestFrustumBudget = test.FrustumSlack + m_frustumMoved;
+    entry.TestRangeBudget = test.RangeSlack + m_observerMoved;
+    entry.TestParentInsidePlaneMask = parentInsidePlaneMask;
+    entry.FrustumIt = static_cast<unsigned char>(test.FrustumIt);
+    entry.InsidePlaneMask = test.InsidePlaneMask;
+    entry.InRange = test.InRange;
+    entry.InNextRange = test.InNextRange;
+}
+//
+bool CDLODQuadTree::LODSelectionCache::Reuse(Node::LODSelectInfo &lodSelectInfo, int nodeIndex,
+                                             const Node::LODSelectTest &test, Node::LODSelectResult &result,
+                                             unsigned int &childValidFrame, int &childSelectionShift) {
+    Entry &entry = m_entries[nodeIndex];
+    // Not in the last selection, so neither are its children.
+    childValidFrame = m_frame - 1;
+    childSelectionShift = 0;
+    if (m_fullSelection || entry.Frame != m_validFrame) return false;
+
+    const int selectionStart = entry.SelectionStart + m_selectionShift;  // in m_selection
+    childValidFrame = entry.EvalFrame;
+    childSelectionShift = selectionStart - entry.EvalSelectionStart;
+
+    // The entry's test is the one it was evaluated or copied with.
+    if (entry.FrustumIt != test.FrustumIt || entry.InsidePlaneMask != test.InsidePlaneMask ||
+        entry.InRange != test.InRange || entry.InNextRange != test.InNextRange)
+        return false;
+    if (entry.FrustumBudget - m_frustumMoved <= m_frustumEpsilon || entry.RangeBudget - m_observerMoved <= m_rangeEpsilon)
+        return false;
 
-        selectionObj->m_minSelectedLODLevel =
-            (std::min)(selectionObj->m_minSelectedLODLevel, selectionObj->m_selectionBuffer[i].LODLevel);
-        selectionObj->m_maxSelectedLODLevel =
-            (std::max)(selectionObj->m_maxSelectedLODLevel, selectionObj->m_selectionBuffer[i].LODLevel);
-    }
+    LODSelection *selectionObj = lodSelectInfo.SelectionObj;
+    if (lodSelectInfo.SelectionCount + entry.SelectionCount > selectionObj->m_maxSelectionCount) return false;
 
-    selectionObj->m_selectionCount = lodSelInfo.SelectionCount;
+    // The subtree's selected nodes are contiguous, in the same order as if it were traversed again.
+    std::copy(m_selection.begin() + selectionStart, m_selection.begin() + selectionStart + entry.SelectionCount,
+              selectionObj->m_selectionBuffer + lodSelectInfo.SelectionCount);
+    entry.Frame = m_frame;
+    entry.SelectionStart = lodSelectInfo.SelectionCount;
+    lodSelectInfo.SelectionCount += entry.SelectionCount;
+    if (entry.VisDistTooSmall) selectionObj->m_visDistTooSmall = true;
+    m_reusedSelectionCount += entry.SelectionCount;
 
-    if (selectionObj->m_sortByDistance)
-        qsort(selectionObj->m_selectionBuffer, selectionObj->m_selectionCount, sizeof(*selectionObj->m_selectionBuffer),
-              compare_closerFirst);
+    result = static_cast<Node::LODSelectResult>(entry.Result);
+    return true;
 }
 //
 void CDLODQuadTree::Node::GetAreaMinMaxHeight(int fromX, int fromY, int toX, int toY, float &minZ, float &maxZ,
@@ -614,12 +1368,43 @@ void CDLODQuadTree::GetAreaMinMaxHeight(float fromX, float fromY, float sizeX, f
 
     for (int y = baseFromY; y <= baseToY; y++)
         for (int x = baseFromX; x <= baseToX; x++) {
-            m_topLevelNodes[y][x]->GetAreaMinMaxHeight(rasterFromX, rasterFromY, rasterToX, rasterToY, minZ, maxZ, *this);
+            if (m_desc.ImplicitStorage)
+                GetAreaMinMaxHeightImplicit(0, x, y, rasterFromX, rasterFromY, rasterToX, rasterToY, minZ, maxZ);
+            else
+                m_topLevelNodes[y][x]->GetAreaMinMaxHeight(rasterFromX, rasterFromY, rasterToX, rasterToY, minZ, maxZ,
+                                                           *this);
         }
 
     // GetCanvas3D()->DrawBox( glm::vec3(fromX, fromY, minZ), glm::vec3(fromX + sizeX, fromY + sizeY, maxZ), 0xFFFFFF00,
     // 0x10FFFF00 );
 }
+// Same as Node::GetAreaMinMaxHeight for the implicit storage. CH
+void CDLODQuadTree::GetAreaMinMaxHeightImplicit(int level, int x, int y, int fromX, int fromY, int toX, int toY, float &minZ,
+                                                float &maxZ) const {
+    const int size = m_topNodeSize >> level;
+    const int X = x * size;
+    const int Y = y * size;
+    if (((toX < X) || (toY < Y)) || ((fromX > (X + size)) || (fromY > (Y + size)))) {
+        // Completely outside
+        return;
+    }
+
+    if ((level == m_desc.LODLevelCount - 1) ||
+        (((fromX <= X) && (fromY <= Y)) && ((toX >= (X + size)) && (toY >= (Y + size))))) {
+        // Completely inside
+        const MinMaxZ &minMaxZ = GetMinMaxZ(level, x, y);
+        minZ = (std::min)(minZ, m_desc.MapDims.MinZ + minMaxZ.MinZ * m_desc.MapDims.SizeZ / 65535.0f);
+        maxZ = (std::max)(maxZ, m_desc.MapDims.MinZ + minMaxZ.MaxZ * m_desc.MapDims.SizeZ / 65535.0f);
+        return;
+    }
+
+    // Partially inside, partially outside
+    for (int i = 0; i < 4; i++) {
+        const int cx = 2 * x + (i & 1), cy = 2 * y + (i >> 1);
+        if (HasNode(level + 1, cx, cy))
+            GetAreaMinMaxHeightImplicit(level + 1, cx, cy, fromX, fromY, toX, toY, minZ, maxZ);
+    }
+}
 //
 void CDLODQuadTree::Node::FillSubNodes(Node *nodes[4], int &count) const {
     count = 0;
@@ -709,116 +1494,253 @@ bool IntersectTri(const glm::vec3 &_orig, const glm::vec3 &_dir, const glm::vec3
     return dist >= 0;
 }
 //
-bool CDLODQuadTree::Node::IntersectRay(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection, float maxDistance,
-                                       glm::vec3 &hitPoint, const CDLODQuadTree &quadTree) const {
-    AABB boundingBox;
-    GetAABB(boundingBox, quadTree.m_rasterSizeX, quadTree.m_rasterSizeY, quadTree.m_desc.MapDims);
-
-    float hitDistance = FLT_MAX;
-    if (!boundingBox.IntersectRay(rayOrigin, rayDirection, hitDistance)) return false;
-
-    if (hitDistance > maxDistance) return false;
+CDLODQuadTree::RayQuery::RayQuery(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance)
+    : Origin(origin), Direction(direction), HitDistance(maxDistance) {
+    const float EPSILON = 1e-5f;
+    for (int i = 0; i < 3; i++) {
+        Parallel[i] = fabsf(direction[i]) < EPSILON;
+        InvDirection[i] = Parallel[i] ? 0.0f : 1.0f / direction[i];
+    }
+}
+//
+bool CDLODQuadTree::RayQuery::IntersectAABB(const AABB &box, float &entry, float &exit) const {
+    float tmin = 0.0f;
+    float tmax = HitDistance;
+    for (int i = 0; i < 3; i++) {
+        if (Parallel[i]) {
+            if (Origin[i] < box.Min[i] || Origin[i] > box.Max[i]) return false;
+        } else {
+            float t1 = (box.Min[i] - Origin[i]) * InvDirection[i];
+            float t2 = (box.Max[i] - Origin[i]) * InvDirection[i];
+            if (t1 > t2) std::swap(t1, t2);
+            if (t1 > tmin) tmin = t1;
+            if (t2 < tmax) tmax = t2;
+            if (tmin > tmax) return false;
+        }
+    }
+    entry = tmin;
+    exit = tmax;
+    return true;
+}
+//
+int CDLODQuadTree::SortRayChildren(const RayQuery &ray, const AABB boxes[4], int count, int order[4], float entries[4]) {
+    int hitCount = 0;
+    for (int i = 0; i < count; i++) {
+        float entry, exit;
+        if (!ray.IntersectAABB(boxes[i], entry, exit)) continue;
+        // Insertion sort, at most four.
+        int j = hitCount++;
+        for (; j > 0 && entries[j - 1] > entry; j--) {
+            entries[j] = entries[j - 1];
+            order[j] = order[j - 1];
+        }
+        entries[j] = entry;
+        order[j] = i;
+    }
+    return hitCount;
+}
+//
+bool CDLODQuadTree::IntersectRayQuad(RayQuery &ray, const glm::vec3 &tl, const glm::vec3 &tr, const glm::vec3 &bl,
+                                     const glm::vec3 &br) {
+    float u0, v0, dist0;
+    float u1, v1, dist1;
+    bool t0 = IntersectTri(ray.Origin, ray.Direction, tl, tr, bl, u0, v0, dist0);
+    bool t1 = IntersectTri(ray.Origin, ray.Direction, tr, bl, br, u1, v1, dist1);
+    if (t0 && (dist0 > ray.HitDistance)) t0 = false;
+    if (t1 && (dist1 > ray.HitDistance)) t1 = false;
+
+    // No hits
+    if (!t0 && !t1) return false;
+
+    // Only 0 hits, or 0 is closer
+    ray.HitDistance = ((t0 && !t1) || ((t0 && t1) && (dist0 < dist1))) ? dist0 : dist1;
+    return true;
+}
+//
+bool CDLODQuadTree::IntersectRayLeaf(const AABB &box, int X, int Y, int size, const float cornerZ[4],
+                                     RayQuery &ray) const {
+    float entry, exit;
+    if (!ray.IntersectAABB(box, entry, exit)) return false;
+
+    if (!m_desc.ExactRayIntersection) {
+        // The simple two-triangle per leaf-quad approximation.
+        glm::vec3 tl(box.Min.x, box.Min.y, cornerZ[0]);
+        glm::vec3 tr(box.Max.x, box.Min.y, cornerZ[1]);
+        glm::vec3 bl(box.Min.x, box.Max.y, cornerZ[2]);
+        glm::vec3 br(box.Max.x, box.Max.y, cornerZ[3]);
+        return IntersectRayQuad(ray, tl, tr, bl, br);
+    }
 
-    // DebugDrawAABB( 0xFF0000FF, quadTree );
+    // 2D DDA over the raster cells the ray crosses inside the leaf, front to back. The first cell with a hit has the
+    // closest one, since a hit lies inside of its cell.
+    const MapDimensions &mapDims = m_desc.MapDims;
+    const auto worldX = [&](int x) { return mapDims.MinX + x * mapDims.SizeX / (float)(m_rasterSizeX - 1); };
+    const auto worldY = [&](int y) { return mapDims.MinY + y * mapDims.SizeY / (float)(m_rasterSizeY - 1); };
+    const auto worldZ = [&](int x, int y) {
+        return mapDims.MinZ + m_desc.pHeightmap->GetHeightAt(x, y) * mapDims.SizeZ / 65535.0f;
+    };
 
+    const int lastCellX = (std::min)(X + size, m_rasterSizeX - 1) - 1;
+    const int lastCellY = (std::min)(Y + size, m_rasterSizeY - 1) - 1;
+    if (lastCellX < X || lastCellY < Y) return false;
+
+    // Start in the cell the ray enters the leaf at.
+    const glm::vec3 start = ray.Origin + ray.Direction * entry;
+    int cx = static_cast<int>(floorf((start.x - mapDims.MinX) * (m_rasterSizeX - 1) / mapDims.SizeX));
+    int cy = static_cast<int>(floorf((start.y - mapDims.MinY) * (m_rasterSizeY - 1) / mapDims.SizeY));
+    cx = (std::max)(X, (std::min)(lastCellX, cx));
+    cy = (std::max)(Y, (std::min)(lastCellY, cy));
+
+    const int stepX = (ray.Direction.x >= 0.0f) ? 1 : -1;
+    const int stepY = (ray.Direction.y >= 0.0f) ? 1 : -1;
+    // Where the ray crosses the next cell boundary. Recomputed from the boundary every step, so nothing accumulates.
+    const auto nextX = [&]() {
+        return ray.Parallel[0] ? FLT_MAX : (worldX(cx + (stepX > 0)) - ray.Origin.x) * ray.InvDirection.x;
+    };
+    const auto nextY = [&]() {
+        return ray.Parallel[1] ? FLT_MAX : (worldY(cy + (stepY > 0)) - ray.Origin.y) * ray.InvDirection.y;
+    };
+    float tNextX = nextX();
+    float tNextY = nextY();
+
+    for (;;) {
+        const float x0 = worldX(cx), x1 = worldX(cx + 1);
+        const float y0 = worldY(cy), y1 = worldY(cy + 1);
+        glm::vec3 tl(x0, y0, worldZ(cx, cy));
+        glm::vec3 tr(x1, y0, worldZ(cx + 1, cy));
+        glm::vec3 bl(x0, y1, worldZ(cx, cy + 1));
+        glm::vec3 br(x1, y1, worldZ(cx + 1, cy + 1));
+        if (IntersectRayQuad(ray, tl, tr, bl, br)) return true;
+
+        if (tNextX < tNextY) {
+            if (tNextX > exit || tNextX > ray.HitDistance) return false;
+            cx += stepX;
+            if (cx < X || cx > lastCellX) return false;
+            tNextX = nextX();
+        } else {
+            if (tNextY > exit || tNextY > ray.HitDistance) return false;
+            cy += stepY;
+            if (cy < Y || cy > lastCellY) return false;
+            tNextY = nextY();
+        }
+    }
+}
+//
+bool CDLODQuadTree::Node::IntersectRay(RayQuery &ray, const CDLODQuadTree &quadTree) const {
     if (IsLeaf()) {
+        AABB boundingBox;
+        GetAABB(boundingBox, quadTree.m_rasterSizeX, quadTree.m_rasterSizeY, quadTree.m_desc.MapDims);
+
         // This is the place to place your custom heightmap subsection ray intersection.
         // Area that needs to be tested lays between this node's [X, Y] and [X + Size, Y + Size] in
-        // the source heightmap coordinates.
-
-        // Following is the simple two-triangle per leaf-quad approximation.
-
-        float *pTLZ = (float *)&this->SubTL;
-        float *pTRZ = (float *)&this->SubTR;
-        float *pBLZ = (float *)&this->SubBL;
-        float *pBRZ = (float *)&this->SubBR;
-
-        glm::vec3 tl(boundingBox.Min.x, boundingBox.Min.y, *pTLZ);
-        glm::vec3 tr(boundingBox.Max.x, boundingBox.Min.y, *pTRZ);
-        glm::vec3 bl(boundingBox.Min.x, boundingBox.Max.y, *pBLZ);
-        glm::vec3 br(boundingBox.Max.x, boundingBox.Max.y, *pBRZ);
-
-        // show these triangles!
-        // GetCanvas3D()->DrawTriangle( tl, tr, bl, 0xFF000000, 0x8000FF00 );
-        // GetCanvas3D()->DrawTriangle( tr, bl, br, 0xFF000000, 0x8000FF00 );
-
-        float u0, v0, dist0;
-        float u1, v1, dist1;
-        bool t0 = IntersectTri(rayOrigin, rayDirection, tl, tr, bl, u0, v0, dist0);
-        bool t1 = IntersectTri(rayOrigin, rayDirection, tr, bl, br, u1, v1, dist1);
-        if (t0 && (dist0 > maxDistance)) t0 = false;
-        if (t1 && (dist1 > maxDistance)) t1 = false;
-
-        // No hits
-        if (!t0 && !t1) return false;
-
-        // Only 0 hits, or 0 is closer
-        if ((t0 && !t1) || ((t0 && t1) && (dist0 < dist1))) {
-            hitPoint = rayOrigin + rayDirection * dist0;
-            return true;
-        }
-
-        hitPoint = rayOrigin + rayDirection * dist1;
-        return true;
+        // the source heightmap coordinates. (See CreateDesc::ExactRayIntersection) CH
+        const float cornerZ[4] = {*(float *)&this->SubTL, *(float *)&this->SubTR, *(float *)&this->SubBL,
+                                  *(float *)&this->SubBR};
+        return quadTree.IntersectRayLeaf(boundingBox, this->X, this->Y, this->Size, cornerZ, ray);
     }
 
     Node *subNodes[4];
     int subNodeCount;
     FillSubNodes(subNodes, subNodeCount);
 
-    float closestHitDist = FLT_MAX;
-    glm::vec3 closestHit = {};
-
-    for (int i = 0; i < subNodeCount; i++) {
-        glm::vec3 hit;
-        if (subNodes[i]->IntersectRay(rayOrigin, rayDirection, maxDistance, hit, quadTree)) {
-            glm::vec3 diff = hit - rayOrigin;
-            float dist = glm::length(diff);
-            assert(dist <= maxDistance);
-            if (dist < closestHitDist) {
-                closestHitDist = dist;
-                closestHit = hit;
-            }
-        }
-    }
+    AABB subBoxes[4];
+    for (int i = 0; i < subNodeCount; i++)
+        subNodes[i]->GetAABB(subBoxes[i], quadTree.m_rasterSizeX, quadTree.m_rasterSizeY, quadTree.m_desc.MapDims);
 
-    if (closestHitDist != FLT_MAX) {
-        hitPoint = closestHit;
+    int order[4];
+    float entries[4];
+    const int hitCount = SortRayChildren(ray, subBoxes, subNodeCount, order, entries);
 
-        // glm::vec3 vz( 0.5f, 0.5f, 200.0f );
-        // GetCanvas3D()->DrawBox( hitPoint, hitPoint + vz, 0xFF000000, 0x8000FF00 );
+    bool isHit = false;
+    for (int i = 0; i < hitCount; i++) {
+        if (entries[i] > ray.HitDistance) break;
+        if (subNodes[order[i]]->IntersectRay(ray, quadTree)) isHit = true;
+    }
+    return isHit;
+}
+// Same as Node::IntersectRay for the implicit storage. CH
+bool CDLODQuadTree::IntersectRayImplicit(int level, int x, int y, RayQuery &ray) const {
+    const int leafLevel = m_desc.LODLevelCount - 1;
+    if (level == leafLevel) {
+        AABB boundingBox;
+        GetNodeAABB(level, x, y, boundingBox);
+
+        const int cornerCountX = m_levelNodeCountX[leafLevel] + 1;
+        const auto cornerZ = [&](int cx, int cy) {
+            return m_desc.MapDims.MinZ + m_leafCornerZ[cy * cornerCountX + cx] * m_desc.MapDims.SizeZ / 65535.0f;
+        };
+        const float corners[4] = {cornerZ(x, y), cornerZ(x + 1, y), cornerZ(x, y + 1), cornerZ(x + 1, y + 1)};
+        const int size = m_topNodeSize >> level;
+        return IntersectRayLeaf(boundingBox, x * size, y * size, size, corners, ray);
+    }
 
-        return true;
+    AABB subBoxes[4];
+    int subCoords[4][2];
+    int subCount = 0;
+    for (int i = 0; i < 4; i++) {
+        const int cx = 2 * x + (i & 1), cy = 2 * y + (i >> 1);
+        if (!HasNode(level + 1, cx, cy)) continue;
+        GetNodeAABB(level + 1, cx, cy, subBoxes[subCount]);
+        subCoords[subCount][0] = cx;
+        subCoords[subCount][1] = cy;
+        subCount++;
     }
 
-    return false;
+    int order[4];
+    float entries[4];
+    const int hitCount = SortRayChildren(ray, subBoxes, subCount, order, entries);
+
+    bool isHit = false;
+    for (int i = 0; i < hitCount; i++) {
+        if (entries[i] > ray.HitDistance) break;
+        if (IntersectRayImplicit(level + 1, subCoords[order[i]][0], subCoords[order[i]][1], ray)) isHit = true;
+    }
+    return isHit;
 }
 //
 bool CDLODQuadTree::IntersectRay(const glm::vec3 &rayOrigin, const glm::vec3 &rayDirection, float maxDistance,
                                  glm::vec3 &hitPoint) const {
-    float closestHitDist = FLT_MAX;
-    glm::vec3 closestHit = {};
+    RayQuery ray(rayOrigin, rayDirection, maxDistance);
 
+    // Top level nodes front to back too.
+    std::vector<std::pair<float, int>> topNodes;
     for (int y = 0; y < m_topNodeCountY; y++)
         for (int x = 0; x < m_topNodeCountX; x++) {
-            glm::vec3 hit;
-            if (m_topLevelNodes[y][x]->IntersectRay(rayOrigin, rayDirection, maxDistance, hit, *this)) {
-                glm::vec3 diff = hit - rayOrigin;
-                float dist = glm::length(diff);
-                assert(dist <= maxDistance);
-                if (dist < closestHitDist) {
-                    closestHitDist = dist;
-                    closestHit = hit;
-                }
-            }
+            AABB boundingBox;
+            if (m_desc.ImplicitStorage)
+                GetNodeAABB(0, x, y, boundingBox);
+            else
+                m_topLevelNodes[y][x]->GetAABB(boundingBox, m_rasterSizeX, m_rasterSizeY, m_desc.MapDims);
+
+            float entry, exit;
+            if (ray.IntersectAABB(boundingBox, entry, exit)) topNodes.emplace_back(entry, y * m_topNodeCountX + x);
         }
-
-    if (closestHitDist != FLT_MAX) {
-        hitPoint = closestHit;
-        return true;
+    std::sort(topNodes.begin(), topNodes.end());
+
+    bool isHit = false;
+    for (const auto &topNode : topNodes) {
+        if (topNode.first > ray.HitDistance) break;
+        const int x = topNode.second % m_topNodeCountX, y = topNode.second / m_topNodeCountX;
+        const bool isNodeHit = m_desc.ImplicitStorage ? IntersectRayImplicit(0, x, y, ray)
+                                                      : m_topLevelNodes[y][x]->IntersectRay(ray, *this);
+        if (isNodeHit) isHit = true;
     }
 
-    return false;
+    if (isHit) hitPoint = rayOrigin + rayDirection * ray.HitDistance;
+    return isHit;
+}
+//
+int CDLODQuadTree::IntersectRays(int rayCount, const glm::vec3 *rayOrigins, const glm::vec3 *rayDirections,
+                                 float maxDistance, glm::vec3 *hitPoints, bool *isHits) const {
+    helpers::parallelFor(rayCount, getThreadCount(0), [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            isHits[i] = IntersectRay(rayOrigins[i], rayDirections[i], maxDistance, hitPoints[i]);
+    });
+
+    int hitCount = 0;
+    for (int i = 0; i < rayCount; i++)
+        if (isHits[i]) hitCount++;
+    return hitCount;
 }
 //
 CDLODQuadTree::LODSelection::LODSelection(SelectedNode *selectionBuffer, int maxSelectionCount, const glm::vec3 &observerPos,
@@ -836,6 +1758,9 @@ CDLODQuadTree::LODSelection::LODSelection(SelectedNode *selectionBuffer, int max
     m_morphStartRatio = morphStartRatio;
     m_minSelectedLODLevel = 0;
     m_maxSelectedLODLevel = 0;
+    memset(m_morphingCounts, 0, sizeof(m_morphingCounts));
+    m_selectionTime = 0.0f;
+    m_testedNodeCount = 0;
     m_sortByDistance = sortByDistance;
 }
 //
@@ -9,12 +9,18 @@
 #define _CDLOD_QUAD_TREE_H_
 
 #include <glm/glm.hpp>
+#include <vector>
 
 #include "Common.h"
 #include "MiniMath.h"
 
 //////////////////////////////////////////////////////////////////////////
 // Interface for providing source height data to CDLODQuadTree
+//
+// Thread safety: CDLODQuadTree::Create calls GetAreaMinMaxZ, GetRow and GetHeightAt from several threads at once (see
+// CreateDesc::ThreadCount), and so does IntersectRays with ExactRayIntersection. Every method has to be safe to call
+// concurrently with itself and the others, and return the same data no matter the order the calls come in. The heights
+// can't change while a quadtree is being created from the source. CH
 //////////////////////////////////////////////////////////////////////////
 class IHeightmapSource {
    public:
@@ -26,12 +32,25 @@ class IHeightmapSource {
     virtual unsigned short GetHeightAt(int x, int y) const = 0;
 
     virtual void GetAreaMinMaxZ(int x, int y, int sizeX, int sizeY, unsigned short& minZ, unsigned short& maxZ) const = 0;
+
+    // Optional. Copies texels [x, x + count) of row "y" (all in range) to "pDst" and returns true. Sources that store
+    // their rows implement this so that CDLODQuadTree::Create can reduce rows of leaves with HeightmapMinMaxRow instead of
+    // calling GetAreaMinMaxZ per leaf. Procedural sources can keep the default. CH
+    virtual bool GetRow(int x, int y, int count, unsigned short* pDst) const { return false; }
 };
 
+// Min/max of "count" heights, folded into "minZ"/"maxZ". Uses SSE2/NEON where available. CH
+void HeightmapMinMaxRow(const unsigned short* pRow, int count, unsigned short& minZ, unsigned short& maxZ);
+
 //////////////////////////////////////////////////////////////////////////
 // Main class for storing and working with CDLOD quadtree
 //////////////////////////////////////////////////////////////////////////
+class CDLODGPUSelection;
+
 class CDLODQuadTree {
+    struct MinMaxZ;   // defined with the implicit storage below CH
+    struct RayQuery;  // defined with the ray intersection below CH
+
    public:
     static const int c_maxLODLevels = 15;
 
@@ -50,6 +69,19 @@ class CDLODQuadTree {
 
         glm::vec2 textureWorldSize;
         glm::vec2 textureSize;
+
+        // Store the tree implicitly instead of as linked Node structs. Nodes are then addressed by (level, x, y), and only
+        // their min/max heights are stored (4 bytes per node). CH
+        bool ImplicitStorage;
+
+        // Intersect rays with the heightmap's own triangles (two per raster cell) at the leaves, instead of two triangles
+        // per leaf. pHeightmap is then kept, so it has to outlive the quad tree and be safe to read from multiple threads
+        // (IntersectRays). CH
+        bool ExactRayIntersection;
+
+        // Threads Create reads the heightmap and builds the tree on (0: one per hardware thread). The tree is the same for
+        // any count. CH
+        int ThreadCount;
     };
 
     struct SelectedNode {
@@ -68,6 +100,8 @@ class CDLODQuadTree {
 
         SelectedNode() {}
         SelectedNode(const Node* node, int LODLevel, bool tl, bool tr, bool bl, bool br);
+        SelectedNode(unsigned int x, unsigned int y, unsigned short size, unsigned short minZ, unsigned short maxZ,
+                     int LODLevel, bool tl, bool tr, bool bl, bool br);
 
         void GetAABB(AABB& aabb, int rasterSizeX, int rasterSizeY, const MapDimensions& mapDims) const;
     };
@@ -76,6 +110,7 @@ class CDLODQuadTree {
        private:
         friend class CDLODQuadTree;
         friend struct CDLODQuadTree::Node;
+        friend class CDLODGPUSelection;
 
         // Input
         SelectedNode* m_selectionBuffer;
@@ -99,6 +134,9 @@ class CDLODQuadTree {
         bool m_visDistTooSmall;
         int m_minSelectedLODLevel;
         int m_maxSelectedLODLevel;
+        int m_morphingCounts[c_maxLODLevels];  // selected nodes that reach into the morph region of their LOD level
+        float m_selectionTime;                 // milliseconds spent in CDLODQuadTree::LODSelect
+        int m_testedNodeCount;                 // nodes frustum/range tested by CDLODQuadTree::LODSelect
 
        public:
         LODSelection(SelectedNode* selectionBuffer, int maxSelectionCount, const glm::vec3& observerPos,
@@ -122,8 +160,14 @@ class CDLODQuadTree {
 
         int GetMinSelectedLevel() const { return m_minSelectedLODLevel; }
         int GetMaxSelectedLevel() const { return m_maxSelectedLODLevel; }
+
+        int GetMorphingCount(int LODLevel) const { return m_morphingCounts[LODLevel]; }
+        float GetSelectionTime() const { return m_selectionTime; }
+        int GetTestedNodeCount() const { return m_testedNodeCount; }
     };
 
+    class LODSelectionCache;
+
     template <int maxSelectionCount>
     class LODSelectionOnStack : public LODSelection {
         SelectedNode m_selectionBufferOnStack[maxSelectionCount];
@@ -157,6 +201,22 @@ class CDLODQuadTree {
             int RasterSizeX;
             int RasterSizeY;
             MapDimensions MapDims;
+            int TestedNodeCount;
+            LODSelectionCache* Cache;  // CDLODQuadTree::LODSelectIncremental only, otherwise NULL CH
+        };
+
+        // Frustum and range test results of a node. The parent makes these for all of its children at once
+        // (CDLODQuadTree::LODSelectTestNodes). CH
+        struct LODSelectTest {
+            AABB BoundingBox;
+            IntersectType FrustumIt;
+            unsigned char InsidePlaneMask;  // frustum planes the box is completely inside of, which its children skip
+            bool InRange;                   // intersects the visibility range sphere of the node's level
+            bool InNextRange;               // intersects the visibility range sphere of the next level
+            // How far the frustum planes (plane distance) and the observer can move before any of the above could change.
+            // Only made for LODSelectInfo::Cache. CH
+            float FrustumSlack;
+            float RangeSlack;
         };
 
         friend class CDLODQuadTree;
@@ -196,18 +256,118 @@ class CDLODQuadTree {
         void FillSubNodes(Node* nodes[4], int& count) const;
 
        private:
-        void Create(int x, int y, int size, int level, const CreateDesc& createDesc, Node* allNodesBuffer,
-                    int& allNodesBufferLastIndex);
+        // Leaves take their heights from "leafMinMaxZ" and CDLODQuadTree::m_leafCornerZ (CDLODQuadTree::CreateLeaves). CH
+        void Create(int x, int y, int size, int level, const CreateDesc& createDesc, const CDLODQuadTree& quadTree,
+                    const MinMaxZ* leafMinMaxZ, Node* allNodesBuffer, int& allNodesBufferLastIndex);
 
-        LODSelectResult LODSelect(LODSelectInfo& lodSelectInfo, bool parentCompletelyInFrustum) const;
+        LODSelectResult LODSelect(LODSelectInfo& lodSelectInfo, const LODSelectTest& test) const;
         void GetAreaMinMaxHeight(int fromX, int fromY, int toX, int toY, float& minZ, float& maxZ,
                                  const CDLODQuadTree& quadTree) const;
 
-        bool IntersectRay(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float maxDistance, glm::vec3& hitPoint,
-                          const CDLODQuadTree& quadTree) const;
+        // Returns true if a hit closer than ray.HitDistance was found (and moves ray.HitDistance to it). The caller has
+        // already tested the node's box. CH
+        bool IntersectRay(RayQuery& ray, const CDLODQuadTree& quadTree) const;
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    // Frame coherent selection (LODSelectIncremental)
+    //
+    // Keeps the last test of every node and how far the observer and the frustum planes could move before it could come
+    // out differently, so a node is only tested again once it could have changed. For the nodes the last selection
+    // recursed into it also keeps the selected nodes of their subtrees and the smallest such margin in there: a node whose
+    // test is unchanged and whose subtree is still inside that margin copies its selected nodes from the last selection
+    // instead of going through its children. One cache per observer (camera), used by one thread at a time, and Reset
+    // when the quadtree is created again. Implicit storage only. CH
+    class LODSelectionCache {
+       public:
+        LODSelectionCache();
+
+        // The next selection starts from scratch.
+        void Reset() { m_valid = false; }
+
+        // Observer or frustum plane movement since the last selection above which the next one starts from scratch. 0
+        // (default) is the diagonal of a leaf node.
+        float MaxMoveDistance;
+
+        // Last selection
+        bool WasFullSelection() const { return m_fullSelection; }
+        int GetReusedSelectionCount() const { return m_reusedSelectionCount; }  // selected nodes copied
+
+       private:
+        friend class CDLODQuadTree;
+
+        // Budgets are a slack plus the movement total (m_frustumMoved, m_observerMoved) when it was measured, so the
+        // result is unchanged while the current total is below them.
+        //
+        // A node is in the last selection if its Frame is the last selection's, or its parent is and Frame is the
+        // parent's EvalFrame. A copied node's subtree isn't touched, so its starts are then offset by how far the parent
+        // moved since (m_selectionShift).
+        struct Entry {
+            // Last test (LODSelectTestNodes)
+            unsigned int TestFrame;
+            float TestFrustumBudget;
+            float TestRangeBudget;
+            unsigned char TestParentInsidePlaneMask;
+            unsigned char FrustumIt;
+            unsigned char InsidePlaneMask;
+            bool InRange;
+            bool InNextRange;
+
+            // Last LODSelectImplicit that got past the test
+            unsigned char Result;  // Node::LODSelectResult
+            bool VisDistTooSmall;  // set LODSelection::m_visDistTooSmall somewhere in the subtree
+            unsigned int Frame;      // selection that evaluated or copied it
+            unsigned int EvalFrame;  // selection that evaluated it
+            int SelectionStart;      // subtree's selected nodes in Frame's selection
+            int EvalSelectionStart;  // same in EvalFrame's selection
+            int SelectionCount;
+            float FrustumBudget;  // smallest in the subtree, not counting the node's own test
+            float RangeBudget;
+        };
+
+        const CDLODQuadTree* m_quadTree;
+        std::vector<Entry> m_entries;           // indexed like CDLODQuadTree::m_minMaxZ
+        std::vector<SelectedNode> m_selection;  // last selection, unsorted
+        unsigned int m_frame;
+        unsigned int m_fullSelectionFrame;  // budgets from before it are measured against other totals
+        bool m_valid;
+
+        // Last selection's input
+        glm::vec3 m_observerPos;
+        glm::vec4 m_frustumPlanes[6];
+        float m_visibilityDistance;
+        float m_LODDistanceRatio;
+        float m_morphStartRatio;
+        int m_maxSelectionCount;
+
+        // Movement totals since the last full selection, and the float error allowed on top of the slacks.
+        float m_frustumMoved;
+        float m_observerMoved;
+        float m_frustumEpsilon;
+        float m_rangeEpsilon;
+
+        // For the node LODSelectImplicit is called for next.
+        unsigned int m_validFrame;
+        int m_selectionShift;
+
+        bool m_fullSelection;
+        int m_reusedSelectionCount;
+
+        void Begin(const CDLODQuadTree& quadTree, const LODSelection& selectionObj);
+        void End(const LODSelection& selectionObj, int selectionCount);
+
+        // The node's last test, if it still holds.
+        bool GetTest(int nodeIndex, unsigned char parentInsidePlaneMask, Node::LODSelectTest& test) const;
+        void SetTest(int nodeIndex, unsigned char parentInsidePlaneMask, const Node::LODSelectTest& test);
+        // Copies the node's selected nodes from the last selection if nothing in its subtree can have changed. Otherwise
+        // returns m_validFrame and m_selectionShift for the node's children.
+        bool Reuse(Node::LODSelectInfo& lodSelectInfo, int nodeIndex, const Node::LODSelectTest& test,
+                   Node::LODSelectResult& result, unsigned int& childValidFrame, int& childSelectionShift);
     };
 
    private:
+    friend class CDLODGPUSelection;
+
     CreateDesc m_desc;
 
     Node* m_allNodesBuffer;
@@ -230,6 +390,73 @@ class CDLODQuadTree {
 
     float m_LODLevelNodeDiagSizes[c_maxLODLevels];
 
+    //////////////////////////////////////////////////////////////////////////
+    // Implicit storage (CreateDesc::ImplicitStorage)
+    //
+    // Node (level, x, y) covers the raster from (x, y) * size to (x + 1, y + 1) * size, where size is
+    // (m_topNodeSize >> level). Its children are (level + 1, 2x + i, 2y + j) for the ones that start inside the raster,
+    // which is the same set of nodes Node::Create makes. Level 0 holds the top level nodes, and the last level holds the
+    // leaves. CH
+    struct MinMaxZ {
+        unsigned short MinZ;
+        unsigned short MaxZ;
+    };
+
+    std::vector<MinMaxZ> m_minMaxZ;  // every level, row major within a level (level 0 first)
+    int m_levelOffsets[c_maxLODLevels];
+    int m_levelNodeCountX[c_maxLODLevels];
+    int m_levelNodeCountY[c_maxLODLevels];
+    // Heights at the leaf node corners ((leaf count x + 1) * (leaf count y + 1)) for the ray test. Neighboring leaves share
+    // them, so this replaces the four floats each leaf Node keeps.
+    std::vector<unsigned short> m_leafCornerZ;
+
+    // Level node counts/offsets. Used by both storage modes. CH
+    void CreateLevels();
+    // Reads the leaf min/max heights ("leafMinMaxZ", leaf count x * leaf count y) and m_leafCornerZ from the heightmap,
+    // spread over the hardware threads. IHeightmapSource is called from multiple threads here. CH
+    void CreateLeaves(MinMaxZ* leafMinMaxZ);
+    void CreateImplicit();
+
+    int GetNodeIndex(int level, int x, int y) const { return m_levelOffsets[level] + y * m_levelNodeCountX[level] + x; }
+    const MinMaxZ& GetMinMaxZ(int level, int x, int y) const { return m_minMaxZ[GetNodeIndex(level, x, y)]; }
+    bool HasNode(int level, int x, int y) const { return x < m_levelNodeCountX[level] && y < m_levelNodeCountY[level]; }
+    void GetNodeAABB(int level, int x, int y, AABB& aabb) const;
+    float GetWorldRadius() const;  // farthest map corner from the origin
+
+    // LODSelect and LODSelectIncremental ("cache" is NULL for LODSelect). CH
+    void LODSelectNodes(LODSelection* selectionObj, LODSelectionCache* cache) const;
+    Node::LODSelectResult LODSelectImplicit(Node::LODSelectInfo& lodSelectInfo, int level, int x, int y,
+                                            const Node::LODSelectTest& test) const;
+    void GetAreaMinMaxHeightImplicit(int level, int x, int y, int fromX, int fromY, int toX, int toY, float& minZ,
+                                     float& maxZ) const;
+    bool IntersectRayImplicit(int level, int x, int y, RayQuery& ray) const;
+
+    //////////////////////////////////////////////////////////////////////////
+    // Ray intersection
+    //
+    // Nodes are visited front to back: children are sorted by where the ray enters their boxes, and the ones that start
+    // past the closest hit so far are skipped. CH
+    struct RayQuery {
+        glm::vec3 Origin;
+        glm::vec3 Direction;
+        glm::vec3 InvDirection;
+        bool Parallel[3];   // Direction is (nearly) parallel to the axis, same epsilon as AABB::IntersectRay
+        float HitDistance;  // along Direction; the max distance until something is hit
+
+        RayQuery(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+
+        // The part of [0, HitDistance] that is inside of "box".
+        bool IntersectAABB(const AABB& box, float& entry, float& exit) const;
+    };
+
+    // Sorts up to four children front to back, and drops the ones the ray misses. CH
+    static int SortRayChildren(const RayQuery& ray, const AABB boxes[4], int count, int order[4], float entries[4]);
+    // Two triangles (tl, tr, bl) and (tr, bl, br), like the leaf quads.
+    static bool IntersectRayQuad(RayQuery& ray, const glm::vec3& tl, const glm::vec3& tr, const glm::vec3& bl,
+                                 const glm::vec3& br);
+    // Leaf of raster size "size" at raster (X, Y), with the heights at its corners (TL, TR, BL, BR). CH
+    bool IntersectRayLeaf(const AABB& box, int X, int Y, int size, const float cornerZ[4], RayQuery& ray) const;
+
    public:
     CDLODQuadTree();
     virtual ~CDLODQuadTree();
@@ -242,9 +469,25 @@ class CDLODQuadTree {
     void DebugDrawAllNodes() const;
 
     void LODSelect(LODSelection* selectionObj) const;
-
+    // LODSelect that starts from the last selection made with "cache" when the observer moved only a little (see
+    // LODSelectionCache). The selection is the same as LODSelect's. CH
+    void LODSelectIncremental(LODSelection* selectionObj, LODSelectionCache* cache) const;
+    // Only the visibility ranges and morph consts of LODSelect, for selections made elsewhere (CDLODGPUSelection). The
+    // selection itself is left empty. CH
+    void LODSelectRanges(LODSelection* selectionObj) const;
+    // Tests up to four nodes of "level" (siblings, or a single top level node) side by side, with SSE2/NEON where
+    // available (see CDLOD_QUADTREE_SCALAR). Planes in "parentInsidePlaneMask" are skipped. Gives the same results as
+    // AABB::TestInBoundingPlanes and AABB::IntersectSphereSq. CH
+    static void LODSelectTestNodes(const Node::LODSelectInfo& lodSelectInfo, int level, const AABB boxes[4], int count,
+                                   unsigned char parentInsidePlaneMask, Node::LODSelectTest tests[4]);
+
+    // "maxDistance" is in units of "rayDirection".
     bool IntersectRay(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float maxDistance,
                       glm::vec3& hitPoint) const;
+    // IntersectRay for "rayCount" rays (AI line of sight, object placement, ...) spread over the hardware threads.
+    // Returns the number of hits. CH
+    int IntersectRays(int rayCount, const glm::vec3* rayOrigins, const glm::vec3* rayDirections, float maxDistance,
+                      glm::vec3* hitPoints, bool* isHits) const;
 
     void GetAreaMinMaxHeight(float fromX, float fromY, float sizeX, float sizeY, float& minZ, float& maxZ) const;
 
@@ -333,5 +576,24 @@ inline CDLODQuadTree::SelectedNode::SelectedNode(const Node* node, int LODLevel,
     this->MaxZ = node->MaxZ;
 }
 //
+inline CDLODQuadTree::SelectedNode::SelectedNode(unsigned int x, unsigned int y, unsigned short size, unsigned short minZ,
+                                                 unsigned short maxZ, int LODLevel, bool tl, bool tr, bool bl, bool br)
+    : X(x), Y(y), Size(size), MinZ(minZ), MaxZ(maxZ), TL(tl), TR(tr), BL(bl), BR(br), LODLevel(LODLevel) {}
+//
+void inline CDLODQuadTree::GetNodeAABB(int level, int x, int y, AABB& aabb) const {
+    // Same math as Node::GetAABB so both storages give the same boxes.
+    const int size = m_topNodeSize >> level;
+    const int X = x * size;
+    const int Y = y * size;
+    const MinMaxZ& minMaxZ = GetMinMaxZ(level, x, y);
+    const MapDimensions& mapDims = m_desc.MapDims;
+    aabb.Min.x = mapDims.MinX + X * mapDims.SizeX / (float)(m_rasterSizeX - 1);
+    aabb.Max.x = mapDims.MinX + (X + size) * mapDims.SizeX / (float)(m_rasterSizeX - 1);
+    aabb.Min.y = mapDims.MinY + Y * mapDims.SizeY / (float)(m_rasterSizeY - 1);
+    aabb.Max.y = mapDims.MinY + (Y + size) * mapDims.SizeY / (float)(m_rasterSizeY - 1);
+    aabb.Min.z = mapDims.MinZ + minMaxZ.MinZ * mapDims.SizeZ / 65535.0f;
+    aabb.Max.z = mapDims.MinZ + minMaxZ.MaxZ * mapDims.SizeZ / 65535.0f;
+}
+//
 
 #endif  // !_CDLOD_QUAD_TREE_H_
\ No newline at end of file
@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Rolling window of per frame CDLODRenderStats, with an optional CSV
+// dump of every frame.
+//////////////////////////////////////////////////////////////////////
+
+#include "CDLODRenderStatsHistory.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4996)  // fopen
+#endif
+
+CDLODRenderStatsHistory::CDLODRenderStatsHistory(int windowSize)
+    : m_frames(windowSize), m_next(0), m_count(0), m_pushCount(0), m_csvFile(NULL), m_csvLODLevelCount(0) {
+    assert(windowSize > 0);
+}
+//
+CDLODRenderStatsHistory::~CDLODRenderStatsHistory() { StopCSV(); }
+//
+void CDLODRenderStatsHistory::Push(const CDLODRenderStats& stats) {
+    m_frames[m_next] = stats;
+    m_next = (m_next + 1) % static_cast<int>(m_frames.size());
+    m_count = (std::min)(m_count + 1, static_cast<int>(m_frames.size()));
+
+    if (m_csvFile != NULL) WriteCSVRow(stats);
+    m_pushCount++;
+}
+//
+void CDLODRenderStatsHistory::Clear() {
+    m_next = 0;
+    m_count = 0;
+    m_pushCount = 0;
+}
+//
+const CDLODRenderStats& CDLODRenderStatsHistory::GetLatest() const {
+    assert(m_count > 0);
+    const int size = static_cast<int>(m_frames.size());
+    return m_frames[(m_next + size - 1) % size];
+}
+//
+void CDLODRenderStatsHistory::GetSummary(Summary& summary) const {
+    memset(&summary, 0, sizeof(summary));
+    summary.FrameCount = m_count;
+    if (m_count == 0) return;
+
+    // The window is at most a few hundred frames, so just walk it.
+    for (int i = 0; i < m_count; i++) {
+        const CDLODRenderStats& stats = m_frames[i];
+        for (int j = 0; j < CDLODQuadTree::c_maxLODLevels; j++) summary.AvgRenderedQuads[j] += stats.RenderedQuads[j];
+        summary.AvgTotalRenderedQuads += stats.TotalRenderedQuads;
+        summary.AvgTotalRenderedTriangles += stats.TotalRenderedTriangles;
+        summary.AvgDrawCalls += stats.DrawCalls;
+        summary.AvgMorphingQuads += stats.MorphingQuads;
+        summary.AvgSelectionTime += stats.SelectionTime;
+        summary.MaxTotalRenderedQuads = (std::max)(summary.MaxTotalRenderedQuads, stats.TotalRenderedQuads);
+        summary.MaxTotalRenderedTriangles = (std::max)(summary.MaxTotalRenderedTriangles, stats.TotalRenderedTriangles);
+        summary.MaxDrawCalls = (std::max)(summary.MaxDrawCalls, stats.DrawCalls);
+        summary.MaxSelectionTime = (std::max)(summary.MaxSelectionTime, stats.SelectionTime);
+    }
+
+    const float invCount = 1.0f / m_count;
+    for (int j = 0; j < CDLODQuadTree::c_maxLODLevels; j++) summary.AvgRenderedQuads[j] *= invCount;
+    summary.AvgTotalRenderedQuads *= invCount;
+    summary.AvgTotalRenderedTriangles *= invCount;
+    summary.AvgDrawCalls *= invCount;
+    summary.AvgMorphingQuads *= invCount;
+    summary.AvgSelectionTime *= invCount;
+}
+//
+bool CDLODRenderStatsHistory::StartCSV(const char* fileName, int LODLevelCount) {
+    assert(LODLevelCount > 0 && LODLevelCount <= CDLODQuadTree::c_maxLODLevels);
+    StopCSV();
+
+    m_csvFile = fopen(fileName, "w");
+    if (m_csvFile == NULL) return false;
+    m_csvLODLevelCount = LODLevelCount;
+
+    fprintf(m_csvFile, "frame,selection_ms,quads,triangles,draw_calls,morphing_quads");
+    for (int i = 0; i < m_csvLODLevelCount; i++) fprintf(m_csvFile, ",quads_lod%d", i);
+    fprintf(m_csvFile, "\n");
+    return true;
+}
+//
+void CDLODRenderStatsHistory::StopCSV() {
+    if (m_csvFile == NULL) return;
+    fclose(m_csvFile);
+    m_csvFile = NULL;
+    m_csvLODLevelCount = 0;
+}
+//
+void CDLODRenderStatsHistory::WriteCSVRow(const CDLODRenderStats& stats) {
+    fprintf(m_csvFile, "%llu,%.4f,%d,%d,%d,%d", m_pushCount, stats.SelectionTime, stats.TotalRenderedQuads,
+            stats.TotalRenderedTriangles, stats.DrawCalls, stats.MorphingQuads);
+    for (int i = 0; i < m_csvLODLevelCount; i++) fprintf(m_csvFile, ",%d", stats.RenderedQuads[i]);
+    fprintf(m_csvFile, "\n");
+}
@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Rolling window of per frame CDLODRenderStats, with an optional CSV
+// dump of every frame.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _CDLOD_RENDER_STATS_HISTORY_H_
+#define _CDLOD_RENDER_STATS_HISTORY_H_
+
+#include <stdio.h>
+#include <vector>
+
+#include "CDLODRenderer.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Terrain telemetry
+//
+// Push the stats of every frame. The summary covers the last "windowSize" frames. The CSV file gets one row per pushed
+// frame, so a run can be graphed later to tune the LOD distances, or to find where selection blew up.
+//////////////////////////////////////////////////////////////////////////
+class CDLODRenderStatsHistory {
+   public:
+    struct Summary {
+        int FrameCount;
+        float AvgRenderedQuads[CDLODQuadTree::c_maxLODLevels];
+        float AvgTotalRenderedQuads;
+        float AvgTotalRenderedTriangles;
+        float AvgDrawCalls;
+        float AvgMorphingQuads;
+        float AvgSelectionTime;
+        int MaxTotalRenderedQuads;
+        int MaxTotalRenderedTriangles;
+        int MaxDrawCalls;
+        float MaxSelectionTime;
+    };
+
+    explicit CDLODRenderStatsHistory(int windowSize = 120);
+    ~CDLODRenderStatsHistory();
+
+    CDLODRenderStatsHistory(const CDLODRenderStatsHistory&) = delete;
+    CDLODRenderStatsHistory& operator=(const CDLODRenderStatsHistory&) = delete;
+
+    void Push(const CDLODRenderStats& stats);
+    void Clear();
+
+    int GetFrameCount() const { return m_count; }
+    // Only valid if GetFrameCount() > 0.
+    const CDLODRenderStats& GetLatest() const;
+    void GetSummary(Summary& summary) const;
+
+    // Writes a header row, then a row on every Push until StopCSV. Returns false if the file can't be opened.
+    bool StartCSV(const char* fileName, int LODLevelCount);
+    void StopCSV();
+    bool IsWritingCSV() const { return m_csvFile != NULL; }
+
+   private:
+    void WriteCSVRow(const CDLODRenderStats& stats);
+
+    std::vector<CDLODRenderStats> m_frames;  // ring buffer
+    int m_next;
+    int m_count;
+    unsigned long long m_pushCount;
+
+    FILE* m_csvFile;
+    int m_csvLODLevelCount;
+};
+
+#endif  // _CDLOD_RENDER_STATS_HISTORY_H_
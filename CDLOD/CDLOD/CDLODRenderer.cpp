@@ -7,12 +7,44 @@
 
 #include "CDLODRenderer.h"
 
+#include <cstddef>
+
+#include "CDLODGPUSelection.h"
 #include "CDLODQuadTree.h"
 
 // Not sure why this was hardcoded to 7. Shouldn't it be dynamic? I believe the meshes are not remade on any regular interval
 // so stack v. heap memory shouldn't be an issue. I'm not sure, but I'm changing it for now. CH
 constexpr int NUM_GRID_MESHES = 7;
 
+namespace {
+// First run index of the runs that start at each quadrant (see CDLODInstanceBatches::GetQuadrantRun).
+constexpr int c_quadrantRunOffsets[4] = {0, 4, 7, 9};
+
+// Calls "func(run)" for every run of neighboring quadrants the node draws, in TL, TR, BL, BR order. These are the draws
+// the per node path used to merge. CH
+template <typename TFunc>
+void forEachQuadrantRun(const CDLODQuadTree::SelectedNode& nodeSel, TFunc&& func) {
+    const bool quadrants[4] = {nodeSel.TL, nodeSel.TR, nodeSel.BL, nodeSel.BR};
+    for (int q = 0; q < 4;) {
+        if (!quadrants[q]) {
+            q++;
+            continue;
+        }
+        int count = 1;
+        while (q + count < 4 && quadrants[q + count]) count++;
+        func(c_quadrantRunOffsets[q] + count - 1);
+        q += count;
+    }
+}
+}  // namespace
+
+//
+void CDLODInstanceBatches::GetQuadrantRun(int run, int& firstQuadrant, int& quadrantCount) {
+    firstQuadrant = 0;
+    while (firstQuadrant < 3 && run >= c_quadrantRunOffsets[firstQuadrant + 1]) firstQuadrant++;
+    quadrantCount = run - c_quadrantRunOffsets[firstQuadrant] + 1;
+}
+
 //
 CDLODRenderer::CDLODRenderer() : m_pContext(nullptr) {}
 //
@@ -73,8 +105,9 @@ vk::Result CDLODRenderer::Render(const CDLODRendererBatchInfo& batchInfo, CDLODR
     //////////////////////////////////////////////////////////////////////////
     // Setup mesh
     // V(device->SetStreamSource(0, (IDirect3DVertexBuffer9*)gridMesh->GetVertexBuffer(), 0, sizeof(PositionVertex)));
-    vk::DeviceSize offset = 0;
-    batchInfo.renderData.cmd.bindVertexBuffers(0, 1, &gridMesh->GetVertexBuffer().buffer, &offset);
+    const vk::Buffer vertexBuffers[2] = {gridMesh->GetVertexBuffer().buffer, batchInfo.renderData.instanceBuffer};
+    const vk::DeviceSize vertexBufferOffsets[2] = {0, batchInfo.renderData.instanceBufferOffset};
+    batchInfo.renderData.cmd.bindVertexBuffers(0, 2, vertexBuffers, vertexBufferOffsets);
     // V(device->SetIndices((IDirect3DIndexBuffer9*)gridMesh->GetIndexBuffer()));
     batchInfo.renderData.cmd.bindIndexBuffer(gridMesh->GetIndexBuffer().buffer, 0, vk::IndexType::eUint32);
     // V(device->SetFVF(PositionVertex::FVF));
@@ -87,146 +120,171 @@ vk::Result CDLODRenderer::Render(const CDLODRendererBatchInfo& batchInfo, CDLODR
     perDrawData.data3 = batchInfo.renderData.dbgCamData;
     //////////////////////////////////////////////////////////////////////////
 
-    const CDLODQuadTree::SelectedNode* selectionArray = batchInfo.CDLODSelection->GetSelection();
-    const int selectionCount = batchInfo.CDLODSelection->GetSelectionCount();
-
-    int qtRasterX = batchInfo.CDLODSelection->GetQuadTree()->GetRasterSizeX();
-    int qtRasterY = batchInfo.CDLODSelection->GetQuadTree()->GetRasterSizeY();
-    MapDimensions mapDims = batchInfo.CDLODSelection->GetQuadTree()->GetWorldMapDims();
-
-    int prevMorphConstLevelSet = -1;
-    for (int i = 0; i < selectionCount; i++) {
-        const CDLODQuadTree::SelectedNode& nodeSel = selectionArray[i];
-
-        // Filter out the node if required
-        if (batchInfo.FilterLODLevel != -1 && batchInfo.FilterLODLevel != nodeSel.LODLevel) continue;
-
-        // Set LOD level specific consts (if changed from previous node - shouldn't change too much as array should be
-        // sorted)
-        if (prevMorphConstLevelSet != nodeSel.LODLevel) {
-            prevMorphConstLevelSet = nodeSel.LODLevel;
-            batchInfo.CDLODSelection->GetMorphConsts(prevMorphConstLevelSet, perDrawData.data1);
-            perDrawData.data0.w = (float)nodeSel.LODLevel;
-            // batchInfo.VertexShader->SetFloatArray(batchInfo.VSMorphConstsHandle, v, 4);
-
-            // bool useDetailMap = batchInfo.DetailMeshLODLevelsAffected > nodeSel.LODLevel;
-            // if (batchInfo.VSUseDetailMapHandle != NULL) {
-            //    V(batchInfo.VertexShader->SetBool(batchInfo.VSUseDetailMapHandle, useDetailMap));
-            //}
+    //////////////////////////////////////////////////////////////////////////
+    // One instanced draw per LOD level and quadrant run. The quad offset/scale of every node comes from the instance
+    // buffer, so only the LOD level specific consts are pushed. CH
+    const CDLODInstanceBatches* instanceBatches = batchInfo.InstanceBatches;
+    const bool indirect = (instanceBatches == NULL);
+    assert(!indirect || batchInfo.renderData.indirectBuffer);
+    if (indirect && !batchInfo.renderData.indirectBuffer) return vk::Result::eErrorUnknown;
+
+    const uint32_t numIdxPerQuad = gridMesh->GetNumIndiciesPerQuadrant();
+    const uint32_t quadrantFirstIndex[4] = {0, static_cast<uint32_t>(gridMesh->GetIndexEndTL()),
+                                            static_cast<uint32_t>(gridMesh->GetIndexEndTR()),
+                                            static_cast<uint32_t>(gridMesh->GetIndexEndBL())};
+
+    const int minLevel = (batchInfo.FilterLODLevel != -1) ? batchInfo.FilterLODLevel : 0;
+    const int maxLevel = (batchInfo.FilterLODLevel != -1) ? batchInfo.FilterLODLevel
+                                                          : batchInfo.CDLODSelection->GetQuadTree()->GetLODLevelCount() - 1;
+
+    // The instance counts are only known on the GPU (CDLODGPUSelection). The draws of a level that have instances are
+    // packed at the front of the level's commands, so with VK_KHR_draw_indirect_count the GPU's count of them is drawn.
+    // Otherwise every command gets a draw, and the empty ones draw nothing. CH
+    if (indirect) {
+        const bool drawIndirectCount = m_pContext != nullptr && m_pContext->drawIndirectCountEnabled;
+        const vk::DeviceSize stride = sizeof(vk::DrawIndexedIndirectCommand);
+        for (int level = minLevel; level <= maxLevel; level++) {
+            batchInfo.CDLODSelection->GetMorphConsts(level, perDrawData.data1);
+            perDrawData.data0.w = (float)level;
+            batchInfo.renderData.cmd.pushConstants(batchInfo.renderData.pipelineLayout,
+                                                   batchInfo.renderData.pushConstantStages, 0,
+                                                   sizeof(CDLODRendererBatchInfo::PerDrawData), &perDrawData);
+            const vk::DeviceSize offset = batchInfo.renderData.indirectBufferOffset +
+                                          offsetof(CDLODGPUSelection::IndirectData, Commands) +
+                                          level * CDLODInstanceBatches::c_quadrantRunCount * stride;
+            if (drawIndirectCount) {
+                const vk::DeviceSize countOffset = batchInfo.renderData.indirectBufferOffset +
+                                                   offsetof(CDLODGPUSelection::IndirectData, DrawCounts) +
+                                                   level * sizeof(uint32_t);
+                batchInfo.renderData.cmd.drawIndexedIndirectCountKHR(
+                    batchInfo.renderData.indirectBuffer, offset, batchInfo.renderData.indirectBuffer, countOffset,
+                    CDLODInstanceBatches::c_quadrantRunCount, static_cast<uint32_t>(stride));
+                if (renderStats != NULL) renderStats->DrawCalls++;
+            } else {
+                for (int run = 0; run < CDLODInstanceBatches::c_quadrantRunCount; run++)
+                    batchInfo.renderData.cmd.drawIndexedIndirect(batchInfo.renderData.indirectBuffer,
+                                                                 offset + run * stride, 1, static_cast<uint32_t>(stride));
+                if (renderStats != NULL) renderStats->DrawCalls += CDLODInstanceBatches::c_quadrantRunCount;
+            }
         }
+        return vk::Result::eSuccess;
+    }
 
-        // debug render - should account for unselected parts below!
-        // GetCanvas3D()->DrawBox( D3DXVECTOR3(worldX, worldY, m_mapDims.MinZ), D3DXVECTOR3(worldX+worldSizeX,
-        // worldY+worldSizeY, m_mapDims.MaxZ()), 0xFF0000FF, 0x00FF0080 );
-
-        bool drawFull = nodeSel.TL && nodeSel.TR && nodeSel.BL && nodeSel.BR;
-
-        AABB boundingBox;
-        nodeSel.GetAABB(boundingBox, qtRasterX, qtRasterY, mapDims);
-
-        // V(batchInfo.VertexShader->SetFloatArray(batchInfo.VSQuadScaleHandle, (boundingBox.Max.x - boundingBox.Min.x),
-        //                                        (boundingBox.Max.y - boundingBox.Min.y), (float)nodeSel.LODLevel, 0.0f));
+    for (int level = minLevel; level <= maxLevel; level++) {
+        bool haveConsts = false;
+        for (int run = 0; run < CDLODInstanceBatches::c_quadrantRunCount; run++) {
+            const CDLODInstanceBatches::Batch& batch = instanceBatches->Batches[level][run];
+            if (batch.InstanceCount == 0) continue;
+
+            // Set LOD level specific consts
+            if (!haveConsts) {
+                haveConsts = true;
+                batchInfo.CDLODSelection->GetMorphConsts(level, perDrawData.data1);
+                perDrawData.data0.w = (float)level;
+                batchInfo.renderData.cmd.pushConstants(batchInfo.renderData.pipelineLayout,
+                                                       batchInfo.renderData.pushConstantStages, 0,
+                                                       sizeof(CDLODRendererBatchInfo::PerDrawData), &perDrawData);
+            }
+
+            int firstQuadrant, quadrantCount;
+            CDLODInstanceBatches::GetQuadrantRun(run, firstQuadrant, quadrantCount);
+            const uint32_t indexCount = numIdxPerQuad * quadrantCount;
+            const uint32_t firstIndex = quadrantFirstIndex[firstQuadrant];
+
+            if (batchInfo.PerInstanceDraws) {
+                for (uint32_t i = 0; i < batch.InstanceCount; i++)
+                    batchInfo.renderData.cmd.drawIndexed(indexCount, 1, firstIndex, 0, batch.FirstInstance + i);
+            } else {
+                batchInfo.renderData.cmd.drawIndexed(indexCount, batch.InstanceCount, firstIndex, 0, batch.FirstInstance);
+            }
+        }
+    }
 
-        // V(batchInfo.VertexShader->SetFloatArray(batchInfo.VSQuadOffsetHandle, boundingBox.Min.x, boundingBox.Min.y,
-        //                                        (boundingBox.Min.z + boundingBox.Max.z) * 0.5f, 0.0f));
+    if (renderStats != NULL)
+        GetRenderStats(*batchInfo.CDLODSelection, *instanceBatches, numIdxPerQuad, batchInfo.FilterLODLevel,
+                       batchInfo.PerInstanceDraws, *renderStats);
 
-        perDrawData.data1.w = (boundingBox.Min.z + boundingBox.Max.z) * 0.5f;
-        perDrawData.data2 = {boundingBox.Min.x, boundingBox.Min.y, (boundingBox.Max.x - boundingBox.Min.x),
-                             (boundingBox.Max.y - boundingBox.Min.y)};
+    return vk::Result::eSuccess;
+}
+//
+void CDLODRenderer::GetRenderStats(const CDLODQuadTree::LODSelection& selection, const CDLODInstanceBatches& batches,
+                                   int indicesPerQuadrant, int filterLODLevel, bool perInstanceDraws,
+                                   CDLODRenderStats& renderStats) {
+    renderStats.Reset();
+
+    const int minLevel = (filterLODLevel != -1) ? filterLODLevel : 0;
+    const int maxLevel = (filterLODLevel != -1) ? filterLODLevel : selection.GetQuadTree()->GetLODLevelCount() - 1;
+
+    for (int level = minLevel; level <= maxLevel; level++) {
+        for (int run = 0; run < CDLODInstanceBatches::c_quadrantRunCount; run++) {
+            const CDLODInstanceBatches::Batch& batch = batches.Batches[level][run];
+            if (batch.InstanceCount == 0) continue;
+
+            int firstQuadrant, quadrantCount;
+            CDLODInstanceBatches::GetQuadrantRun(run, firstQuadrant, quadrantCount);
+            renderStats.DrawCalls += perInstanceDraws ? batch.InstanceCount : 1;
+            renderStats.TotalRenderedTriangles += batch.InstanceCount * indicesPerQuadrant * quadrantCount / 3;
+        }
+    }
 
-        batchInfo.renderData.cmd.pushConstants(batchInfo.renderData.pipelineLayout, batchInfo.renderData.pushConstantStages,
-                                               0, sizeof(CDLODRendererBatchInfo::PerDrawData), &perDrawData);
+    const CDLODQuadTree::SelectedNode* selectionArray = selection.GetSelection();
+    const int selectionCount = selection.GetSelectionCount();
+    for (int i = 0; i < selectionCount; i++) {
+        const int LODLevel = selectionArray[i].LODLevel;
+        if (LODLevel < minLevel || LODLevel > maxLevel) continue;
+        renderStats.RenderedQuads[LODLevel]++;
+        renderStats.TotalRenderedQuads++;
+    }
+    for (int level = minLevel; level <= maxLevel; level++) renderStats.MorphingQuads += selection.GetMorphingCount(level);
+}
+//
+void CDLODRenderer::MakeInstanceBatches(const CDLODQuadTree::LODSelection& selection,
+                                        CDLODInstanceBatches::PerInstanceData* instances, CDLODInstanceBatches& batches) {
+    memset(&batches, 0, sizeof(batches));
 
-        const uint32_t numIdxPerQuad = gridMesh->GetNumIndiciesPerQuadrant();
-        uint32_t indexCount = 0;
-        uint32_t firstIndex = 0;
-        bool haveDraw = false;
+    const CDLODQuadTree::SelectedNode* selectionArray = selection.GetSelection();
+    const int selectionCount = selection.GetSelectionCount();
 
-        if (nodeSel.TL) {
-            haveDraw = true;
-            indexCount = numIdxPerQuad;
-        }
+    // Count the instances of every batch.
+    for (int i = 0; i < selectionCount; i++) {
+        const CDLODQuadTree::SelectedNode& nodeSel = selectionArray[i];
+        forEachQuadrantRun(nodeSel, [&](int run) { batches.Batches[nodeSel.LODLevel][run].InstanceCount++; });
+    }
 
-        if (nodeSel.TR) {
-            indexCount = numIdxPerQuad + (haveDraw ? indexCount : 0);
-            firstIndex = haveDraw ? firstIndex : gridMesh->GetIndexEndTL();
-            haveDraw = true;
-        } else if (haveDraw) {
-            batchInfo.renderData.cmd.drawIndexed(indexCount, 1, firstIndex, 0, 0);
-            haveDraw = false;
+    // Lay the batches out by LOD level, then run.
+    uint32_t firstInstance = 0;
+    for (int level = 0; level < CDLODQuadTree::c_maxLODLevels; level++) {
+        for (int run = 0; run < CDLODInstanceBatches::c_quadrantRunCount; run++) {
+            CDLODInstanceBatches::Batch& batch = batches.Batches[level][run];
+            batch.FirstInstance = firstInstance;
+            firstInstance += batch.InstanceCount;
+            batch.InstanceCount = 0;
         }
+    }
+    batches.InstanceCount = static_cast<int>(firstInstance);
+    assert(batches.InstanceCount <= CDLODInstanceBatches::GetMaxInstanceCount(selectionCount));
 
-        if (nodeSel.BL) {
-            indexCount = numIdxPerQuad + (haveDraw ? indexCount : 0);
-            firstIndex = haveDraw ? firstIndex : gridMesh->GetIndexEndTR();
-            haveDraw = true;
-        } else if (haveDraw) {
-            batchInfo.renderData.cmd.drawIndexed(indexCount, 1, firstIndex, 0, 0);
-            haveDraw = false;
-        }
+    // Fill them in, keeping the selection order within a batch.
+    int qtRasterX = selection.GetQuadTree()->GetRasterSizeX();
+    int qtRasterY = selection.GetQuadTree()->GetRasterSizeY();
+    MapDimensions mapDims = selection.GetQuadTree()->GetWorldMapDims();
 
-        if (nodeSel.BR) {
-            indexCount = numIdxPerQuad + (haveDraw ? indexCount : 0);
-            firstIndex = haveDraw ? firstIndex : gridMesh->GetIndexEndBL();
-            haveDraw = true;
-        }
+    for (int i = 0; i < selectionCount; i++) {
+        const CDLODQuadTree::SelectedNode& nodeSel = selectionArray[i];
 
-        if (haveDraw) {
-            batchInfo.renderData.cmd.drawIndexed(indexCount, 1, firstIndex, 0, 0);
-        }
+        AABB boundingBox;
+        nodeSel.GetAABB(boundingBox, qtRasterX, qtRasterY, mapDims);
 
-        // if (nodeSel.TL) {
-        //    batchInfo.renderData.cmd.drawIndexed(gridMesh->GetNumIndiciesPerQuadrant(), 1, 0, 0, 0);
-        //}
-        // if (nodeSel.TR) {
-        //    batchInfo.renderData.cmd.drawIndexed(gridMesh->GetNumIndiciesPerQuadrant(), 1, gridMesh->GetIndexEndTL(), 0,
-        //    0);
-        //}
-        // if (nodeSel.BL) {
-        //    batchInfo.renderData.cmd.drawIndexed(gridMesh->GetNumIndiciesPerQuadrant(), 1, gridMesh->GetIndexEndTR(), 0,
-        //    0);
-        //}
-        // if (nodeSel.BR) {
-        //    batchInfo.renderData.cmd.drawIndexed(gridMesh->GetNumIndiciesPerQuadrant(), 1, gridMesh->GetIndexEndBL(), 0,
-        //    0);
-        //}
-
-        // int gridDim = gridMesh->GetDimensions();
-
-        // int renderedTriangles = 0;
-
-        // int totalVertices = (gridDim + 1) * (gridDim + 1);
-        // int totalIndices = gridDim * gridDim * 2 * 3;
-        // if (drawFull) {
-        //    V(device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, totalVertices, 0, totalIndices / 3));
-        //    renderedTriangles += totalIndices / 3;
-        //} else {
-        //    int halfd = ((gridDim + 1) / 2) * ((gridDim + 1) / 2) * 2;
-
-        //    can be optimized by combining calls if (nodeSel.TL) {
-        //        V(device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, totalVertices, 0, halfd));
-        //        renderedTriangles += halfd;
-        //    }
-        //    if (nodeSel.TR) {
-        //        V(device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, totalVertices, gridMesh->GetIndexEndTL(), halfd));
-        //        renderedTriangles += halfd;
-        //    }
-        //    if (nodeSel.BL) {
-        //        V(device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, totalVertices, gridMesh->GetIndexEndTR(), halfd));
-        //        renderedTriangles += halfd;
-        //    }
-        //    if (nodeSel.BR) {
-        //        V(device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, totalVertices, gridMesh->GetIndexEndBL(), halfd));
-        //        renderedTriangles += halfd;
-        //    }
-        //}
-
-        // if (renderStats != NULL) {
-        //    renderStats->RenderedQuads[nodeSel.LODLevel]++;
-        //    renderStats->TotalRenderedQuads++;
-        //    renderStats->TotalRenderedTriangles += renderedTriangles;
-        //}
+        CDLODInstanceBatches::PerInstanceData instance;
+        instance.data0 = {boundingBox.Min.x, boundingBox.Min.y, (boundingBox.Max.x - boundingBox.Min.x),
+                          (boundingBox.Max.y - boundingBox.Min.y)};
+        instance.data1 = {(boundingBox.Min.z + boundingBox.Max.z) * 0.5f,
+                          (float)((nodeSel.TL ? 1 : 0) | (nodeSel.TR ? 2 : 0) | (nodeSel.BL ? 4 : 0) | (nodeSel.BR ? 8 : 0)),
+                          0.0f, 0.0f};
+
+        forEachQuadrantRun(nodeSel, [&](int run) {
+            CDLODInstanceBatches::Batch& batch = batches.Batches[nodeSel.LODLevel][run];
+            instances[batch.FirstInstance + batch.InstanceCount++] = instance;
+        });
     }
-
-    return vk::Result::eSuccess;
 }
@@ -27,6 +27,9 @@ struct CDLODRenderStats {
     int RenderedQuads[CDLODQuadTree::c_maxLODLevels];
     int TotalRenderedQuads;
     int TotalRenderedTriangles;
+    int DrawCalls;
+    int MorphingQuads;    // rendered quads that reach into the morph region of their LOD level CH
+    float SelectionTime;  // milliseconds (not filled by CDLODRenderer::Render, see LODSelection::GetSelectionTime) CH
 
     void Reset() { memset(this, 0, sizeof(*this)); }
 
@@ -34,9 +37,39 @@ struct CDLODRenderStats {
         for (int i = 0; i < CDLODQuadTree::c_maxLODLevels; i++) RenderedQuads[i] += other.RenderedQuads[i];
         TotalRenderedQuads += other.TotalRenderedQuads;
         TotalRenderedTriangles += other.TotalRenderedTriangles;
+        DrawCalls += other.DrawCalls;
+        MorphingQuads += other.MorphingQuads;
+        SelectionTime += other.SelectionTime;
     }
 };
 
+// The selected nodes packed for instanced drawing (CDLODRenderer::MakeInstanceBatches). Each node is split into runs of
+// neighboring quadrants (TL, TR, BL, BR), which are contiguous in VkGridMesh's index buffer. The instances are grouped by
+// LOD level and run, so every group is a single instanced drawIndexed. CH
+struct CDLODInstanceBatches {
+    // Number of (first quadrant, quadrant count) runs: 4 + 3 + 2 + 1.
+    static const int c_quadrantRunCount = 10;
+
+    struct PerInstanceData {
+        glm::vec4 data0;  // quadOffset:      .x (aabb.minX), .y (aabb.minY)
+                          // quadScale:       .z (aabb.sizeX), .w (aabb.sizeY)
+        glm::vec4 data1;  // quadOffset:      .x ((aabb.minZ+aabb.maxZ)/2)
+                          // quadrant mask:   .y (TL 1, TR 2, BL 4, BR 8)
+    };
+
+    struct Batch {
+        uint32_t FirstInstance;
+        uint32_t InstanceCount;
+    };
+
+    Batch Batches[CDLODQuadTree::c_maxLODLevels][c_quadrantRunCount];
+    int InstanceCount;
+
+    // A node has at most two runs (ex. TL and BL), so this many instances are always enough.
+    static int GetMaxInstanceCount(int maxSelectionCount) { return 2 * maxSelectionCount; }
+    static void GetQuadrantRun(int run, int& firstQuadrant, int& quadrantCount);
+};
+
 struct CDLODRendererBatchInfo {
     MapDimensions MapDims;
     const CDLODQuadTree::LODSelection* CDLODSelection;
@@ -50,6 +83,10 @@ struct CDLODRendererBatchInfo {
         vk::PipelineLayout pipelineLayout;
         vk::ShaderStageFlags pushConstantStages;
         glm::vec4 dbgCamData;  // .x,.y,.z world position, .w use camera
+        vk::Buffer instanceBuffer;  // CDLODInstanceBatches::PerInstanceData
+        vk::DeviceSize instanceBufferOffset;
+        vk::Buffer indirectBuffer;  // CDLODGPUSelection indirect draws, used when InstanceBatches is NULL
+        vk::DeviceSize indirectBufferOffset;
     } renderData;
 
     // D3DXHANDLE VSGridDimHandle;
@@ -60,8 +97,8 @@ struct CDLODRendererBatchInfo {
         glm::vec4 data0;  // gridDim:         .x (dimension), .y (dimension/2), .z (2/dimension)
                           //                  .w (LODLevel)
         glm::vec4 data1;  // morph constants: .x (start), .y (1/(end-start)), .z (end/(end-start))
-                          //                  .w ((aabb.minZ+aabb.maxZ)/2)
-        glm::vec4 data2;  // quadOffset:      .x (aabb.minX), .y (aabb.minY)
+                          //                  .w ((aabb.minZ+aabb.maxZ)/2) (unused by Render, see PerInstanceData)
+        glm::vec4 data2;  // quadOffset:      .x (aabb.minX), .y (aabb.minY) (unused by Render, see PerInstanceData)
                           // quadScale:       .z (aabb.sizeX), .w (aabb.sizeY)
         glm::vec4 data3;  // dbg camera:      .x (wpos.x), .y (wpos.y), .z (wpos.z), .w (use camera)
     };
@@ -70,13 +107,20 @@ struct CDLODRendererBatchInfo {
 
     int FilterLODLevel;  // only render quad if it is of FilterLODLevel; if -1 then render all
 
+    // Made from CDLODSelection, and written to renderData.instanceBuffer. If NULL the draws are indirect
+    // (renderData.indirectBuffer), and CDLODSelection only has to have its ranges made.
+    const CDLODInstanceBatches* InstanceBatches;
+    bool PerInstanceDraws;  // one draw per instance instead of per batch (the old per node draws, for comparison)
+
     CDLODRendererBatchInfo()
         : CDLODSelection(NULL),
           MeshGridDimensions(0),
           // VertexShader(NULL),
           // PixelShader(NULL),
           // VSGridDimHandle(0),
-          FilterLODLevel(-1) {}
+          FilterLODLevel(-1),
+          InstanceBatches(NULL),
+          PerInstanceDraws(false) {}
 };
 
 class CDLODRenderer {
@@ -112,6 +156,14 @@ class CDLODRenderer {
     //
     void SetIndependentGlobalVertexShaderConsts(const CDLODQuadTree& cdlodQuadTree, PerQuadTreeData& data) const;
     vk::Result Render(const CDLODRendererBatchInfo& batchInfo, CDLODRenderStats* renderStats = NULL) const;
+    // Fills "instances" (at least CDLODInstanceBatches::GetMaxInstanceCount(selection count) long) and "batches". CH
+    static void MakeInstanceBatches(const CDLODQuadTree::LODSelection& selection,
+                                    CDLODInstanceBatches::PerInstanceData* instances, CDLODInstanceBatches& batches);
+    // The stats Render gives for "batches" (MakeInstanceBatches) of "selection", drawn with a grid mesh of
+    // "indicesPerQuadrant" indices per quadrant. SelectionTime is left at 0. CH
+    static void GetRenderStats(const CDLODQuadTree::LODSelection& selection, const CDLODInstanceBatches& batches,
+                               int indicesPerQuadrant, int filterLODLevel, bool perInstanceDraws,
+                               CDLODRenderStats& renderStats);
     //
    protected:
     //
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Runs CDLODQuadTree::LODSelect on a worker thread into a double
+// buffered LODSelection.
+//////////////////////////////////////////////////////////////////////
+
+#include "CDLODSelectionWorker.h"
+
+#include <cassert>
+
+CDLODSelectionWorker::CDLODSelectionWorker()
+    : m_quadTree(NULL), m_front(0), m_incremental(false), m_pending(false), m_finished(false), m_stop(false) {}
+//
+CDLODSelectionWorker::~CDLODSelectionWorker() { Stop(); }
+//
+void CDLODSelectionWorker::Start(const CDLODQuadTree* quadTree, int maxSelectionCount, bool incremental) {
+    assert(!IsStarted());
+    assert(quadTree != NULL && maxSelectionCount > 0);
+
+    m_quadTree = quadTree;
+    for (auto& buffer : m_selectionBuffers) buffer.resize(maxSelectionCount);
+    m_front = 0;
+    m_incremental = incremental;
+    m_cache.Reset();
+    m_pending = false;
+    m_finished = false;
+    m_stop = false;
+
+    m_thread = std::thread(&CDLODSelectionWorker::Run, this);
+}
+//
+void CDLODSelectionWorker::Stop() {
+    if (!IsStarted()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+
+    m_quadTree = NULL;
+    for (auto& selection : m_selections) selection.reset();
+    for (auto& buffer : m_selectionBuffers) buffer = {};
+    m_pending = false;
+    m_finished = false;
+}
+//
+void CDLODSelectionWorker::Submit(const glm::vec3& observerPos, float visibilityDistance, const glm::vec4 frustumPlanes[6],
+                                  float LODDistanceRatio, float morphStartRatio, bool sortByDistance) {
+    assert(IsStarted());
+
+    glm::vec4 planes[6];
+    for (int i = 0; i < 6; i++) planes[i] = frustumPlanes[i];
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return !m_pending; });
+
+        const int back = 1 - m_front;
+        auto& buffer = m_selectionBuffers[back];
+        m_selections[back].emplace(buffer.data(), static_cast<int>(buffer.size()), observerPos, visibilityDistance, planes,
+                                   LODDistanceRatio, morphStartRatio, sortByDistance);
+        m_pending = true;
+        m_finished = false;
+    }
+    m_condition.notify_all();
+}
+//
+const CDLODQuadTree::LODSelection* CDLODSelectionWorker::Acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this] { return !m_pending; });
+
+    if (m_finished) {
+        m_front = 1 - m_front;
+        m_finished = false;
+    }
+    return m_selections[m_front] ? &*m_selections[m_front] : NULL;
+}
+//
+void CDLODSelectionWorker::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_condition.wait(lock, [this] { return m_stop || m_pending; });
+        if (m_stop) return;
+
+        // Only Submit writes the back buffer, and it waits for m_pending to clear first.
+        CDLODQuadTree::LODSelection* selection = &*m_selections[1 - m_front];
+        lock.unlock();
+        if (m_incremental)
+            m_quadTree->LODSelectIncremental(selection, &m_cache);
+        else
+            m_quadTree->LODSelect(selection);
+        lock.lock();
+
+        m_pending = false;
+        m_finished = true;
+        m_condition.notify_all();
+    }
+}
@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Runs CDLODQuadTree::LODSelect on a worker thread into a double
+// buffered LODSelection.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _CDLOD_SELECTION_WORKER_H_
+#define _CDLOD_SELECTION_WORKER_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "CDLODQuadTree.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Asynchronous LOD selection
+//
+// Submit starts selecting into the back buffer as soon as the camera for a frame is known, and Acquire waits for it and
+// makes it the front buffer. The front buffer stays untouched until the next Acquire that finds a finished selection,
+// so it can be read while the next one runs. The quadtree must outlive Stop, and must not change while the worker is
+// running. With "incremental" each selection starts from the last one (CDLODQuadTree::LODSelectIncremental).
+//////////////////////////////////////////////////////////////////////////
+class CDLODSelectionWorker {
+   public:
+    CDLODSelectionWorker();
+    ~CDLODSelectionWorker();
+
+    CDLODSelectionWorker(const CDLODSelectionWorker&) = delete;
+    CDLODSelectionWorker& operator=(const CDLODSelectionWorker&) = delete;
+
+    void Start(const CDLODQuadTree* quadTree, int maxSelectionCount, bool incremental = false);
+    void Stop();
+
+    bool IsStarted() const { return m_thread.joinable(); }
+
+    // Waits for a selection still in flight. A finished selection that was never acquired is dropped.
+    void Submit(const glm::vec3& observerPos, float visibilityDistance, const glm::vec4 frustumPlanes[6],
+                float LODDistanceRatio, float morphStartRatio = 0.66f, bool sortByDistance = false);
+    // Returns the latest finished selection, or NULL if nothing was ever submitted.
+    const CDLODQuadTree::LODSelection* Acquire();
+
+   private:
+    void Run();
+
+    const CDLODQuadTree* m_quadTree;
+
+    std::vector<CDLODQuadTree::SelectedNode> m_selectionBuffers[2];
+    std::optional<CDLODQuadTree::LODSelection> m_selections[2];
+    int m_front;
+
+    bool m_incremental;
+    CDLODQuadTree::LODSelectionCache m_cache;  // worker thread only
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_pending;   // back buffer submitted, not finished yet
+    bool m_finished;  // back buffer finished, not acquired yet
+    bool m_stop;
+};
+
+#endif  // _CDLOD_SELECTION_WORKER_H_
@@ -0,0 +1,618 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Tiled, memory-mapped heightmap source for CDLODQuadTree, and tile
+// residency for streaming the vertex heightmap texture.
+//////////////////////////////////////////////////////////////////////
+
+#include "TiledHeightmap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stb_image.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+inline uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+inline bool isPowerOfTwo(int value) { return value > 0 && (value & (value - 1)) == 0; }
+
+// Fills "pTile" with tile (tx, ty) of mip "mip", repeating the last column/row past the edges of the raster.
+void makeTile(const TiledHeightmap::Layout& layout, int sizeX, int sizeY, int mip, int tx, int ty,
+              const TiledHeightmap::HeightFunc& heightFunc, unsigned short* pTile) {
+    const int tileSize = layout.TileSize;
+    for (int j = 0; j < tileSize; j++) {
+        const int y = (std::min)((ty * tileSize + j) << mip, sizeY - 1);
+        for (int i = 0; i < tileSize; i++) {
+            const int x = (std::min)((tx * tileSize + i) << mip, sizeX - 1);
+            pTile[j * tileSize + i] = heightFunc(x, y);
+        }
+    }
+}
+
+// VALUE NOISE (SyntheticHeight)
+
+inline float hashToUnit(int x, int y, unsigned int seed) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x8DA6B343u ^ static_cast<uint32_t>(y) * 0xD8163841u ^ seed * 0xCB1AB31Fu;
+    h ^= h >> 13;
+    h *= 0x5BD1E995u;
+    h ^= h >> 15;
+    return static_cast<float>(h & 0xFFFFFF) / static_cast<float>(0xFFFFFF);
+}
+
+float valueNoise(int x, int y, int wavelength, unsigned int seed) {
+    const int x0 = x / wavelength, y0 = y / wavelength;
+    float fx = static_cast<float>(x - x0 * wavelength) / wavelength;
+    float fy = static_cast<float>(y - y0 * wavelength) / wavelength;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    const float a = hashToUnit(x0, y0, seed) + (hashToUnit(x0 + 1, y0, seed) - hashToUnit(x0, y0, seed)) * fx;
+    const float b = hashToUnit(x0, y0 + 1, seed) + (hashToUnit(x0 + 1, y0 + 1, seed) - hashToUnit(x0, y0 + 1, seed)) * fx;
+    return a + (b - a) * fy;
+}
+
+}  // namespace
+
+namespace TiledHeightmap {
+
+// LAYOUT
+
+Layout Layout::Make(const Header& header) {
+    assert(header.SizeX > 1 && header.SizeY > 1);
+    assert(isPowerOfTwo(header.TileSize) && header.TileSize >= c_minTileSize && header.TileSize <= c_maxTileSize);
+
+    Layout layout = {};
+    layout.TileSize = header.TileSize;
+    layout.TileBytes = static_cast<uint64_t>(header.TileSize) * header.TileSize * sizeof(unsigned short);
+    layout.TileStride = alignUp(layout.TileBytes, c_tileAlignment);
+
+    // Halve the raster until a single tile covers it.
+    for (int mip = 0; mip < c_maxMipLevels; mip++) {
+        const uint64_t mipTileSize = static_cast<uint64_t>(header.TileSize) << mip;
+        layout.TileCountX[mip] = static_cast<int>((header.SizeX + mipTileSize - 1) / mipTileSize);
+        layout.TileCountY[mip] = static_cast<int>((header.SizeY + mipTileSize - 1) / mipTileSize);
+        layout.MipTileOffset[mip] = layout.TotalTileCount;
+        layout.TotalTileCount += layout.TileCountX[mip] * layout.TileCountY[mip];
+        layout.MipCount++;
+        if (layout.TileCountX[mip] == 1 && layout.TileCountY[mip] == 1) break;
+    }
+    assert(layout.TileCountX[layout.MipCount - 1] == 1 && layout.TileCountY[layout.MipCount - 1] == 1);
+
+    const uint64_t minMaxBytes =
+        static_cast<uint64_t>(layout.TileCountX[0]) * layout.TileCountY[0] * 2 * sizeof(unsigned short);
+    layout.TileDataOffset = alignUp(sizeof(Header) + minMaxBytes, c_tileAlignment);
+    return layout;
+}
+
+// MAPPED FILE
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : m_hFile(INVALID_HANDLE_VALUE), m_hMapping(nullptr), m_size(0) {}
+
+bool MappedFile::Open(const char* path) {
+    Close();
+    m_hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_hFile == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(size.QuadPart);
+    // A mapping object doesn't commit anything by itself. Only the views do.
+    m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_hMapping == nullptr) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_hMapping != nullptr) CloseHandle(m_hMapping);
+    if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+    m_hMapping = nullptr;
+    m_hFile = INVALID_HANDLE_VALUE;
+    m_size = 0;
+}
+
+bool MappedFile::IsOpen() const { return m_hMapping != nullptr; }
+
+const void* MappedFile::Map(uint64_t offset, uint64_t size, bool randomAccess) const {
+    assert(IsOpen() && offset % c_tileAlignment == 0 && offset + size <= m_size);
+    return MapViewOfFile(m_hMapping, FILE_MAP_READ, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset),
+                         static_cast<SIZE_T>(size));
+}
+
+void MappedFile::Unmap(const void* pData, uint64_t size) const { UnmapViewOfFile(pData); }
+
+#else
+
+MappedFile::MappedFile() : m_fd(-1), m_size(0) {}
+
+bool MappedFile::Open(const char* path) {
+    Close();
+    m_fd = open(path, O_RDONLY);
+    if (m_fd < 0) return false;
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0) {
+        Close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_fd >= 0) close(m_fd);
+    m_fd = -1;
+    m_size = 0;
+}
+
+bool MappedFile::IsOpen() const { return m_fd >= 0; }
+
+const void* MappedFile::Map(uint64_t offset, uint64_t size, bool randomAccess) const {
+    assert(IsOpen() && offset % c_tileAlignment == 0 && offset + size <= m_size);
+    void* pData = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, m_fd, static_cast<off_t>(offset));
+    if (pData == MAP_FAILED) return nullptr;
+    // Tiles are small and read whole, so let the readahead work. Anything else is sampled all over the place.
+    if (randomAccess) madvise(pData, static_cast<size_t>(size), MADV_RANDOM);
+    return pData;
+}
+
+void MappedFile::Unmap(const void* pData, uint64_t size) const {
+    munmap(const_cast<void*>(pData), static_cast<size_t>(size));
+}
+
+#endif
+
+// WRITE/CONVERT
+
+bool Write(const char* path, int sizeX, int sizeY, int tileSize, const HeightFunc& heightFunc) {
+    Header header = {c_magic, c_version, static_cast<uint32_t>(sizeX), static_cast<uint32_t>(sizeY),
+                     static_cast<uint32_t>(tileSize)};
+    const Layout layout = Layout::Make(header);
+    header.MipCount = static_cast<uint32_t>(layout.MipCount);
+    header.TileDataOffset = layout.TileDataOffset;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    // The min/max table is filled in while the mip 0 tiles are written.
+    std::vector<unsigned short> tileMinMax(static_cast<size_t>(layout.TileCountX[0]) * layout.TileCountY[0] * 2);
+    std::vector<char> padding(static_cast<size_t>(c_tileAlignment), 0);
+    const auto writePadding = [&](uint64_t offset) {
+        const uint64_t count = offset - static_cast<uint64_t>(file.tellp());
+        assert(count <= padding.size());
+        file.write(padding.data(), static_cast<std::streamsize>(count));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(tileMinMax.data()), tileMinMax.size() * sizeof(unsigned short));
+    writePadding(layout.TileDataOffset);
+
+    std::vector<unsigned short> tile(static_cast<size_t>(tileSize) * tileSize);
+    for (int mip = 0; mip < layout.MipCount; mip++) {
+        for (int ty = 0; ty < layout.TileCountY[mip]; ty++) {
+            for (int tx = 0; tx < layout.TileCountX[mip]; tx++) {
+                makeTile(layout, sizeX, sizeY, mip, tx, ty, heightFunc, tile.data());
+                if (mip == 0) {
+                    // The padding repeats edge texels, so it can't change the min/max.
+                    const auto minMax = std::minmax_element(tile.begin(), tile.end());
+                    const int tileIndex = layout.GetTileIndex(0, tx, ty);
+                    tileMinMax[tileIndex * 2 + 0] = *minMax.first;
+                    tileMinMax[tileIndex * 2 + 1] = *minMax.second;
+                }
+                file.write(reinterpret_cast<const char*>(tile.data()), layout.TileBytes);
+                writePadding(layout.GetTileOffset(layout.GetTileIndex(mip, tx, ty) + 1));
+                if (!file.good()) return false;
+            }
+        }
+    }
+
+    file.seekp(sizeof(Header));
+    file.write(reinterpret_cast<const char*>(tileMinMax.data()), tileMinMax.size() * sizeof(unsigned short));
+    return file.good();
+}
+
+bool ConvertRaw(const char* rawPath, int sizeX, int sizeY, const char* path, int tileSize) {
+    MappedFile raw;
+    if (!raw.Open(rawPath)) return false;
+    const uint64_t size = static_cast<uint64_t>(sizeX) * sizeY * sizeof(unsigned short);
+    if (raw.GetSize() != size) return false;
+
+    const auto* pData = static_cast<const unsigned short*>(raw.Map(0, size, true));
+    if (pData == nullptr) return false;
+    const bool result = Write(path, sizeX, sizeY, tileSize, [pData, sizeX](int x, int y) {
+        return pData[static_cast<size_t>(y) * sizeX + x];
+    });
+    raw.Unmap(pData, size);
+    return result;
+}
+
+bool ConvertPng(const char* pngPath, const char* path, int tileSize) {
+    int width, height, channels;
+    if (stbi_is_16_bit(pngPath)) {
+        stbi_us* pData = stbi_load_16(pngPath, &width, &height, &channels, 1);
+        if (pData == nullptr) return false;
+        const bool result = Write(path, width, height, tileSize, [pData, width](int x, int y) {
+            return static_cast<unsigned short>(pData[static_cast<size_t>(y) * width + x]);
+        });
+        stbi_image_free(pData);
+        return result;
+    }
+    stbi_uc* pData = stbi_load(pngPath, &width, &height, &channels, 1);
+    if (pData == nullptr) return false;
+    // Spread 8 bit heights over the whole range (255 * 257 = 65535).
+    const bool result = Write(path, width, height, tileSize, [pData, width](int x, int y) {
+        return static_cast<unsigned short>(pData[static_cast<size_t>(y) * width + x] * 257);
+    });
+    stbi_image_free(pData);
+    return result;
+}
+
+unsigned short SyntheticHeight(int x, int y, unsigned int seed) {
+    // 8 octaves from a 4096 texel wavelength down to 32.
+    float height = 0.0f, amplitude = 0.5f, total = 0.0f;
+    for (int wavelength = 4096; wavelength >= 32; wavelength /= 2) {
+        height += amplitude * valueNoise(x, y, wavelength, seed++);
+        total += amplitude;
+        amplitude *= 0.5f;
+    }
+    return static_cast<unsigned short>(height / total * 65535.0f + 0.5f);
+}
+
+}  // namespace TiledHeightmap
+
+//////////////////////////////////////////////////////////////////////////
+// TiledHeightmapSource
+//////////////////////////////////////////////////////////////////////////
+TiledHeightmapSource::TiledHeightmapSource()
+    : m_desc(), m_header(), m_layout(), m_useCounter(0), m_pageIns(0), m_evictions(0) {}
+//
+bool TiledHeightmapSource::Create(const CreateDesc& desc) {
+    Clean();
+    assert(desc.Path != nullptr && desc.MaxResidentTiles > 0);
+    m_desc = desc;
+
+    if (!m_file.Open(desc.Path) || m_file.GetSize() < sizeof(TiledHeightmap::Header)) {
+        Clean();
+        return false;
+    }
+
+    // The header and the min/max table are small, so they are copied out and the view is dropped.
+    const auto* pHeader = static_cast<const TiledHeightmap::Header*>(m_file.Map(0, sizeof(TiledHeightmap::Header), false));
+    if (pHeader == nullptr) {
+        Clean();
+        return false;
+    }
+    m_header = *pHeader;
+    m_file.Unmap(pHeader, sizeof(TiledHeightmap::Header));
+
+    if (m_header.Magic != TiledHeightmap::c_magic || m_header.Version != TiledHeightmap::c_version ||
+        m_header.SizeX < 2 || m_header.SizeY < 2 || !isPowerOfTwo(static_cast<int>(m_header.TileSize)) ||
+        m_header.TileSize < TiledHeightmap::c_minTileSize || m_header.TileSize > TiledHeightmap::c_maxTileSize) {
+        Clean();
+        return false;
+    }
+    m_layout = TiledHeightmap::Layout::Make(m_header);
+    if (m_header.MipCount != static_cast<uint32_t>(m_layout.MipCount) ||
+        m_header.TileDataOffset != m_layout.TileDataOffset || m_file.GetSize() != m_layout.GetFileSize()) {
+        Clean();
+        return false;
+    }
+
+    const auto* pTables = static_cast<const uint8_t*>(m_file.Map(0, m_layout.TileDataOffset, false));
+    if (pTables == nullptr) {
+        Clean();
+        return false;
+    }
+    m_tileMinMax.resize(static_cast<size_t>(m_layout.TileCountX[0]) * m_layout.TileCountY[0] * 2);
+    memcpy(m_tileMinMax.data(), pTables + sizeof(TiledHeightmap::Header), m_tileMinMax.size() * sizeof(unsigned short));
+    m_file.Unmap(pTables, m_layout.TileDataOffset);
+
+    m_mappedTiles.reserve(desc.MaxResidentTiles);
+    m_tileToMapped.assign(m_layout.TotalTileCount, -1);
+    return true;
+}
+//
+void TiledHeightmapSource::Clean() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& mappedTile : m_mappedTiles) m_file.Unmap(mappedTile.pData, m_layout.TileBytes);
+    m_mappedTiles.clear();
+    m_tileToMapped.clear();
+    m_tileMinMax.clear();
+    m_file.Close();
+    m_header = {};
+    m_layout = {};
+    m_useCounter = m_pageIns = m_evictions = 0;
+}
+//
+const unsigned short* TiledHeightmapSource::AcquireTile(int tileIndex) const {
+    assert(tileIndex >= 0 && tileIndex < m_layout.TotalTileCount);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_useCounter++;
+
+    int index = m_tileToMapped[tileIndex];
+    if (index >= 0) {
+        m_mappedTiles[index].LastUse = m_useCounter;
+        m_mappedTiles[index].PinCount++;
+        return m_mappedTiles[index].pData;
+    }
+
+    if (static_cast<int>(m_mappedTiles.size()) < m_desc.MaxResidentTiles) {
+        index = static_cast<int>(m_mappedTiles.size());
+        m_mappedTiles.push_back({});
+    } else {
+        // Evict the least recently used tile that nobody is reading. The limit is small enough that a linear search
+        // beats keeping a list. Every reader pins one tile at a time, so waiting for a release can't deadlock.
+        while (true) {
+            index = -1;
+            for (int i = 0; i < static_cast<int>(m_mappedTiles.size()); i++)
+                if (m_mappedTiles[i].PinCount == 0 && (index < 0 || m_mappedTiles[i].LastUse < m_mappedTiles[index].LastUse))
+                    index = i;
+            if (index >= 0) break;
+            m_tileReleased.wait(lock);
+        }
+        // Another thread could have mapped the tile while this one waited.
+        const int mapped = m_tileToMapped[tileIndex];
+        if (mapped >= 0) {
+            m_mappedTiles[mapped].LastUse = m_useCounter;
+            m_mappedTiles[mapped].PinCount++;
+            return m_mappedTiles[mapped].pData;
+        }
+        m_file.Unmap(m_mappedTiles[index].pData, m_layout.TileBytes);
+        m_tileToMapped[m_mappedTiles[index].TileIndex] = -1;
+        m_evictions++;
+    }
+
+    // Mapping only sets up the view, the texels are read (and paged in) after the lock is released.
+    const auto* pData =
+        static_cast<const unsigned short*>(m_file.Map(m_layout.GetTileOffset(tileIndex), m_layout.TileBytes, false));
+    assert(pData != nullptr);
+    m_mappedTiles[index] = {tileIndex, pData, m_useCounter, 1};
+    m_tileToMapped[tileIndex] = index;
+    m_pageIns++;
+    return pData;
+}
+//
+void TiledHeightmapSource::ReleaseTile(int tileIndex) const {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const int index = m_tileToMapped[tileIndex];
+        assert(index >= 0 && m_mappedTiles[index].PinCount > 0);
+        if (--m_mappedTiles[index].PinCount > 0) return;
+    }
+    m_tileReleased.notify_one();
+}
+//
+unsigned short TiledHeightmapSource::GetHeightAt(int x, int y) const {
+    x = std::clamp(x, 0, GetSizeX() - 1);
+    y = std::clamp(y, 0, GetSizeY() - 1);
+    const int tileSize = m_layout.TileSize;
+
+    const int tileIndex = m_layout.GetTileIndex(0, x / tileSize, y / tileSize);
+    const auto* pTile = AcquireTile(tileIndex);
+    const auto height = pTile[(y % tileSize) * tileSize + (x % tileSize)];
+    ReleaseTile(tileIndex);
+    return height;
+}
+//
+void TiledHeightmapSource::GetAreaMinMaxZ(int x, int y, int sizeX, int sizeY, unsigned short& minZ,
+                                          unsigned short& maxZ) const {
+    const int fromX = std::clamp(x, 0, GetSizeX() - 1), toX = std::clamp(x + sizeX, fromX + 1, GetSizeX());
+    const int fromY = std::clamp(y, 0, GetSizeY() - 1), toY = std::clamp(y + sizeY, fromY + 1, GetSizeY());
+    const int tileSize = m_layout.TileSize;
+
+    minZ = 65535;
+    maxZ = 0;
+
+    // Only the tile lookups lock, so several threads can scan at once.
+    for (int ty = fromY / tileSize; ty <= (toY - 1) / tileSize; ty++) {
+        const int tileY = ty * tileSize;
+        const int y0 = (std::max)(fromY, tileY) - tileY, y1 = (std::min)(toY, tileY + tileSize) - tileY;
+        for (int tx = fromX / tileSize; tx <= (toX - 1) / tileSize; tx++) {
+            const int tileX = tx * tileSize;
+            const int x0 = (std::max)(fromX, tileX) - tileX, x1 = (std::min)(toX, tileX + tileSize) - tileX;
+            const int tileIndex = m_layout.GetTileIndex(0, tx, ty);
+
+            // Whole tiles (up to the raster edge) come from the table without touching the tile.
+            const bool wholeX = x0 == 0 && (x1 == tileSize || tileX + x1 == GetSizeX());
+            const bool wholeY = y0 == 0 && (y1 == tileSize || tileY + y1 == GetSizeY());
+            if (wholeX && wholeY) {
+                minZ = (std::min)(minZ, m_tileMinMax[tileIndex * 2 + 0]);
+                maxZ = (std::max)(maxZ, m_tileMinMax[tileIndex * 2 + 1]);
+                continue;
+            }
+
+            const auto* pTile = AcquireTile(tileIndex);
+            for (int j = y0; j < y1; j++) HeightmapMinMaxRow(pTile + j * tileSize + x0, x1 - x0, minZ, maxZ);
+            ReleaseTile(tileIndex);
+        }
+    }
+}
+//
+bool TiledHeightmapSource::GetRow(int x, int y, int count, unsigned short* pDst) const {
+    assert(x >= 0 && count > 0 && x + count <= GetSizeX() && y >= 0 && y < GetSizeY());
+    const int tileSize = m_layout.TileSize;
+    const int ty = y / tileSize, j = y % tileSize;
+    for (int tx = x / tileSize; tx <= (x + count - 1) / tileSize; tx++) {
+        const int tileX = tx * tileSize;
+        const int x0 = (std::max)(x, tileX) - tileX, x1 = (std::min)(x + count, tileX + tileSize) - tileX;
+        const int tileIndex = m_layout.GetTileIndex(0, tx, ty);
+        const auto* pTile = AcquireTile(tileIndex);
+        memcpy(pDst + (tileX + x0 - x), pTile + j * tileSize + x0, (x1 - x0) * sizeof(unsigned short));
+        ReleaseTile(tileIndex);
+    }
+    return true;
+}
+//
+void TiledHeightmapSource::CopyTile(int mip, int tx, int ty, unsigned short* pDst) const {
+    assert(mip >= 0 && mip < m_layout.MipCount);
+    assert(tx >= 0 && tx < m_layout.TileCountX[mip] && ty >= 0 && ty < m_layout.TileCountY[mip]);
+    const int tileIndex = m_layout.GetTileIndex(mip, tx, ty);
+    memcpy(pDst, AcquireTile(tileIndex), m_layout.TileBytes);
+    ReleaseTile(tileIndex);
+}
+//
+TiledHeightmapSource::Stats TiledHeightmapSource::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int residentTiles = static_cast<int>(m_mappedTiles.size());
+    return {residentTiles, residentTiles * m_layout.TileBytes, m_pageIns, m_evictions};
+}
+
+//////////////////////////////////////////////////////////////////////////
+// TiledHeightmapResidency
+//////////////////////////////////////////////////////////////////////////
+TiledHeightmapResidency::TiledHeightmapResidency()
+    : m_layout(), m_maxUploadsPerFrame(0), m_frame(0), m_tileTexelCount(0), m_evictions(0) {}
+//
+void TiledHeightmapResidency::Create(const TiledHeightmap::Layout& layout, int slotCount, int maxUploadsPerFrame) {
+    Clean();
+    // The page table stores slots as shorts, and the coarsest mip always has to fit.
+    assert(slotCount > 0 && slotCount <= 32767 && maxUploadsPerFrame > 0);
+    const int coarsestMip = layout.MipCount - 1;
+    assert(layout.TileCountX[coarsestMip] * layout.TileCountY[coarsestMip] <= slotCount);
+
+    m_layout = layout;
+    m_maxUploadsPerFrame = maxUploadsPerFrame;
+    m_pageTable.assign(layout.TotalTileCount, -1);
+    m_tileRequested.assign(layout.TotalTileCount, 0);
+    m_slotTiles.assign(slotCount, -1);
+    m_slotLastUse.assign(slotCount, 0);
+    m_freeSlots.resize(slotCount);
+    // Hand out low slots first.
+    for (int i = 0; i < slotCount; i++) m_freeSlots[i] = slotCount - 1 - i;
+    m_tileTexelCount = static_cast<size_t>(layout.TileSize) * layout.TileSize;
+    m_slotData.assign(slotCount * m_tileTexelCount, 0);
+}
+//
+void TiledHeightmapResidency::Clean() {
+    m_layout = {};
+    m_maxUploadsPerFrame = 0;
+    m_frame = 0;
+    m_pageTable.clear();
+    m_tileRequested.clear();
+    m_requests.clear();
+    m_slotTiles.clear();
+    m_slotLastUse.clear();
+    m_freeSlots.clear();
+    m_slotData.clear();
+    m_slotData.shrink_to_fit();
+    m_tileTexelCount = 0;
+    m_evictions = 0;
+}
+//
+void TiledHeightmapResidency::BeginFrame() {
+    m_frame++;
+    m_requests.clear();
+    const int coarsestMip = m_layout.MipCount - 1;
+    RequestArea(coarsestMip, 0, 0, m_layout.TileSize << coarsestMip, m_layout.TileSize << coarsestMip);
+}
+//
+void TiledHeightmapResidency::Request(int tileIndex) {
+    if (m_tileRequested[tileIndex] == m_frame) return;
+    m_tileRequested[tileIndex] = m_frame;
+    m_requests.push_back(tileIndex);
+}
+//
+void TiledHeightmapResidency::RequestArea(int mip, int x, int y, int sizeX, int sizeY) {
+    assert(mip >= 0 && mip < m_layout.MipCount && sizeX > 0 && sizeY > 0);
+    const int mipTileSize = m_layout.TileSize << mip;
+    const int fromX = (std::max)(x, 0) / mipTileSize;
+    const int fromY = (std::max)(y, 0) / mipTileSize;
+    const int toX = (std::min)((x + sizeX - 1) / mipTileSize, m_layout.TileCountX[mip] - 1);
+    const int toY = (std::min)((y + sizeY - 1) / mipTileSize, m_layout.TileCountY[mip] - 1);
+    for (int ty = fromY; ty <= toY; ty++)
+        for (int tx = fromX; tx <= toX; tx++) Request(m_layout.GetTileIndex(mip, tx, ty));
+}
+//
+void TiledHeightmapResidency::RequestSelection(const CDLODQuadTree::LODSelection& selection, int gridMeshDimension) {
+    assert(gridMeshDimension > 0);
+    for (int i = 0; i < selection.GetSelectionCount(); i++) {
+        const auto& node = selection.GetSelection()[i];
+        // The mip whose texel spacing matches the node's vertex spacing.
+        int mip = 0;
+        while (mip < m_layout.MipCount - 1 && (gridMeshDimension << (mip + 1)) <= node.Size) mip++;
+        // Vertices go from X to X + Size inclusive.
+        RequestArea(mip, node.X, node.Y, node.Size + 1, node.Size + 1);
+    }
+}
+//
+bool TiledHeightmapResidency::Update(const TiledHeightmapSource& source, std::vector<Upload>& uploads) {
+    assert(source.GetLayout().TotalTileCount == m_layout.TotalTileCount && source.GetLayout().TileSize == m_layout.TileSize);
+    // Keep what is already resident first, so that nothing requested this frame is evicted below.
+    std::vector<int> missing;
+    for (const int tileIndex : m_requests) {
+        const short slot = m_pageTable[tileIndex];
+        if (slot >= 0)
+            m_slotLastUse[slot] = m_frame;
+        else
+            missing.push_back(tileIndex);
+    }
+    // Coarse mips first (mips are stored in order, so a higher tile index is never a finer mip), so that there is always
+    // something coarser to fall back to.
+    std::sort(missing.begin(), missing.end(), std::greater<int>());
+
+    int uploadCount = 0;
+    for (const int tileIndex : missing) {
+        if (uploadCount == m_maxUploadsPerFrame) return false;
+
+        int slot = -1;
+        if (!m_freeSlots.empty()) {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        } else {
+            // Least recently used slot that wasn't requested this frame.
+            for (int i = 0; i < GetSlotCount(); i++)
+                if (m_slotLastUse[i] < m_frame && (slot < 0 || m_slotLastUse[i] < m_slotLastUse[slot])) slot = i;
+            if (slot < 0) return false;
+            m_pageTable[m_slotTiles[slot]] = -1;
+            m_evictions++;
+        }
+
+        m_slotTiles[slot] = tileIndex;
+        m_slotLastUse[slot] = m_frame;
+        m_pageTable[tileIndex] = static_cast<short>(slot);
+
+        int mip = m_layout.MipCount - 1;
+        while (tileIndex < m_layout.MipTileOffset[mip]) mip--;
+        const int indexInMip = tileIndex - m_layout.MipTileOffset[mip];
+        const Upload upload = {mip, indexInMip % m_layout.TileCountX[mip], indexInMip / m_layout.TileCountX[mip], slot};
+        source.CopyTile(upload.Mip, upload.TileX, upload.TileY, &m_slotData[slot * m_tileTexelCount]);
+        uploads.push_back(upload);
+        uploadCount++;
+    }
+    return true;
+}
+//
+unsigned short TiledHeightmapResidency::GetHeightAt(int x, int y, int& mip) const {
+    assert(x >= 0 && y >= 0);
+    const int tileSize = m_layout.TileSize;
+    for (mip = 0; mip < m_layout.MipCount; mip++) {
+        // Texel (x >> mip, y >> mip) of the mip holds raster texel ((x >> mip) << mip, (y >> mip) << mip).
+        const int u = x >> mip, v = y >> mip;
+        const int tx = u / tileSize, ty = v / tileSize;
+        if (tx >= m_layout.TileCountX[mip] || ty >= m_layout.TileCountY[mip]) continue;
+        const short slot = m_pageTable[m_layout.GetTileIndex(mip, tx, ty)];
+        if (slot >= 0) return GetSlotData(slot)[(v % tileSize) * tileSize + (u % tileSize)];
+    }
+    assert(false && "The coarsest mip isn't resident");
+    mip = m_layout.MipCount - 1;
+    return 0;
+}
@@ -0,0 +1,255 @@
+//////////////////////////////////////////////////////////////////////
+// Copyright(C) 2021 Colin Hughes<colin.s.hughes @gmail.com>
+// -------------------------------
+// Tiled, memory-mapped heightmap source for CDLODQuadTree, and tile
+// residency for streaming the vertex heightmap texture.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef _TILED_HEIGHTMAP_H_
+#define _TILED_HEIGHTMAP_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CDLODQuadTree.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Tiled heightmap file
+//
+// A uint16 raster split into square tiles that are stored one after another, so that any tile can be mapped on its own.
+// Tiles on the right and bottom edges are padded by repeating the last column/row. After the raster tiles (mip 0) comes
+// a chain of point sampled mips for streaming the vertex heightmap texture: texel (i, j) of mip m tile (tx, ty) is
+// raster texel ((tx * TileSize + i) << m, (ty * TileSize + j) << m). The file also stores the min/max height of every
+// mip 0 tile, so that area queries covering whole tiles don't have to touch the tiles at all.
+//
+// Layout: Header | min/max per mip 0 tile | padding | mip 0 tiles (row major) | mip 1 tiles | ...
+//////////////////////////////////////////////////////////////////////////
+namespace TiledHeightmap {
+
+static const uint32_t c_magic = 0x504D4854;  // "THMP"
+static const uint32_t c_version = 1;
+// Tiles start at multiples of this so that they can be mapped on their own. 64Kb is the allocation granularity on
+// Windows, and a multiple of the page size everywhere else.
+static const uint64_t c_tileAlignment = 64 * 1024;
+static const int c_minTileSize = 128;
+static const int c_maxTileSize = 4096;
+static const int c_maxMipLevels = 24;
+
+struct Header {
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t SizeX;
+    uint32_t SizeY;
+    uint32_t TileSize;
+    uint32_t MipCount;
+    uint64_t TileDataOffset;  // file offset of the first tile
+};
+
+// Tile counts and offsets that follow from the header.
+struct Layout {
+    int TileSize;
+    int MipCount;
+    int TileCountX[c_maxMipLevels];
+    int TileCountY[c_maxMipLevels];
+    int MipTileOffset[c_maxMipLevels];  // index of the first tile of each mip
+    int TotalTileCount;
+    uint64_t TileBytes;   // TileSize * TileSize * 2
+    uint64_t TileStride;  // TileBytes aligned to c_tileAlignment
+    uint64_t TileDataOffset;
+
+    // Only SizeX, SizeY and TileSize are used; MipCount and TileDataOffset are derived from them.
+    static Layout Make(const Header& header);
+
+    int GetTileIndex(int mip, int tx, int ty) const { return MipTileOffset[mip] + ty * TileCountX[mip] + tx; }
+    uint64_t GetTileOffset(int tileIndex) const { return TileDataOffset + tileIndex * TileStride; }
+    uint64_t GetFileSize() const { return GetTileOffset(TotalTileCount); }
+};
+
+// Read-only mapping of a file. Views are mapped and unmapped separately, so only the parts in use take up address space
+// and memory.
+class MappedFile {
+   public:
+    MappedFile();
+    ~MappedFile() { Close(); }
+
+    bool Open(const char* path);
+    void Close();
+    bool IsOpen() const;
+    uint64_t GetSize() const { return m_size; }
+
+    // "offset" has to be a multiple of c_tileAlignment.
+    const void* Map(uint64_t offset, uint64_t size, bool randomAccess) const;
+    void Unmap(const void* pData, uint64_t size) const;
+
+   private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+#ifdef _WIN32
+    void* m_hFile;
+    void* m_hMapping;
+#else
+    int m_fd;
+#endif
+    uint64_t m_size;
+};
+
+// Returns the height of raster texel (x, y). x and y are always in range.
+typedef std::function<unsigned short(int x, int y)> HeightFunc;
+
+// Writes a tiled heightmap file for a sizeX * sizeY raster. Tiles are made and written one at a time, so only a tile is
+// ever held in memory and the raster behind "heightFunc" can be larger than memory (or made up on the fly).
+bool Write(const char* path, int sizeX, int sizeY, int tileSize, const HeightFunc& heightFunc);
+// Converts a headerless, row major, little endian uint16 raster. The RAW file is mapped, not read into memory.
+bool ConvertRaw(const char* rawPath, int sizeX, int sizeY, const char* path, int tileSize);
+// Converts an 8 or 16 bit PNG (the first channel is used). PNGs can't be decoded in parts, so the image has to fit in
+// memory; use RAW for anything bigger.
+bool ConvertPng(const char* pngPath, const char* path, int tileSize);
+
+// Deterministic fractal value noise, for writing synthetic rasters of any size (e.g. to test paging).
+unsigned short SyntheticHeight(int x, int y, unsigned int seed);
+
+}  // namespace TiledHeightmap
+
+//////////////////////////////////////////////////////////////////////////
+// Heightmap source over a tiled heightmap file
+//
+// Tiles are mapped lazily the first time they are sampled, and the least recently used ones are unmapped once more than
+// MaxResidentTiles are mapped, so the memory used is bounded no matter how big the raster is. Sampling is safe from
+// multiple threads (see IHeightmapSource): the mutex only covers finding/mapping a tile, which is then pinned while it is
+// read so that it can't be unmapped under the reader. CH
+//////////////////////////////////////////////////////////////////////////
+class TiledHeightmapSource : public IHeightmapSource {
+   public:
+    struct CreateDesc {
+        const char* Path;
+        int MaxResidentTiles;
+    };
+
+    struct Stats {
+        int ResidentTiles;
+        uint64_t ResidentBytes;
+        uint64_t PageIns;
+        uint64_t Evictions;
+    };
+
+    TiledHeightmapSource();
+    virtual ~TiledHeightmapSource() { Clean(); }
+
+    bool Create(const CreateDesc& desc);
+    void Clean();
+
+    int GetSizeX() const override { return static_cast<int>(m_header.SizeX); }
+    int GetSizeY() const override { return static_cast<int>(m_header.SizeY); }
+    unsigned short GetHeightAt(int x, int y) const override;
+    void GetAreaMinMaxZ(int x, int y, int sizeX, int sizeY, unsigned short& minZ, unsigned short& maxZ) const override;
+    bool GetRow(int x, int y, int count, unsigned short* pDst) const override;
+
+    const TiledHeightmap::Layout& GetLayout() const { return m_layout; }
+    // Copies tile (tx, ty) of mip "mip" (TileSize * TileSize texels, row major) to "pDst". This is what gets uploaded
+    // into the vertex heightmap texture for TiledHeightmapResidency.
+    void CopyTile(int mip, int tx, int ty, unsigned short* pDst) const;
+    Stats GetStats() const;
+
+   private:
+    struct MappedTile {
+        int TileIndex;
+        const unsigned short* pData;
+        uint64_t LastUse;
+        int PinCount;  // readers between AcquireTile and ReleaseTile
+    };
+
+    // Returns the texels of a tile, mapping it first if needed, and pins it until ReleaseTile. Waits for a tile to be
+    // released when all MaxResidentTiles are pinned.
+    const unsigned short* AcquireTile(int tileIndex) const;
+    void ReleaseTile(int tileIndex) const;
+
+    CreateDesc m_desc;
+    TiledHeightmap::Header m_header;
+    TiledHeightmap::Layout m_layout;
+    TiledHeightmap::MappedFile m_file;
+    std::vector<unsigned short> m_tileMinMax;  // (min, max) per mip 0 tile
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_tileReleased;
+    mutable std::vector<MappedTile> m_mappedTiles;  // never more than MaxResidentTiles
+    mutable std::vector<int> m_tileToMapped;        // index into m_mappedTiles per tile, or -1
+    mutable uint64_t m_useCounter;
+    mutable uint64_t m_pageIns;
+    mutable uint64_t m_evictions;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Tile residency for the vertex heightmap texture
+//
+// Keeps the tiles (of any mip) that the selected nodes sample in a fixed number of slots, so that only SlotCount tiles
+// are ever held no matter how big the raster is. The slots mirror the layers of the vertex heightmap texture array.
+// This is only the CPU side: the texture array, the page table buffer and the upload copies don't exist yet, so
+// Cdlod::Renderer::Base doesn't use it. Every frame a renderer would:
+//   1. calls BeginFrame and requests the tiles the selected nodes sample (RequestSelection/RequestArea),
+//   2. calls Update, which copies the missing tiles from the source into their slots (evicting the tiles they held),
+//      and uploads each returned slot (GetSlotData) into its texture layer,
+//   3. hands the page table (slot per tile, or -1) to the vertex shader.
+// A node is requested at the mip that matches its vertex spacing. Coarse mips are served first, and the coarsest mip is
+// always requested, so the shader (and GetHeightAt) can fall back to the next coarser mip when a tile didn't fit. Tiles
+// that weren't requested this frame are evicted least recently used first. CH
+//////////////////////////////////////////////////////////////////////////
+class TiledHeightmapResidency {
+   public:
+    struct Upload {
+        int Mip;
+        int TileX;
+        int TileY;
+        int Slot;
+    };
+
+    TiledHeightmapResidency();
+
+    // "maxUploadsPerFrame" bounds the upload bandwidth; the rest is picked up on later frames.
+    void Create(const TiledHeightmap::Layout& layout, int slotCount, int maxUploadsPerFrame);
+    void Clean();
+
+    void BeginFrame();
+    // Requests the tiles of mip "mip" that cover raster texels [x, x + sizeX) * [y, y + sizeY).
+    void RequestArea(int mip, int x, int y, int sizeX, int sizeY);
+    // Requests the tiles that the selected nodes sample. "gridMeshDimension" is the number of quads along a node's side.
+    void RequestSelection(const CDLODQuadTree::LODSelection& selection, int gridMeshDimension);
+    // Copies the requested tiles that aren't resident yet from "source" into slots, and appends them to "uploads".
+    // Returns true if every requested tile is resident afterwards.
+    bool Update(const TiledHeightmapSource& source, std::vector<Upload>& uploads);
+
+    // Point samples raster texel (x, y) from the finest resident mip, which is returned in "mip" (the same fallback as
+    // the vertex shader). The coarsest mip has to be resident (any Update after the first BeginFrame).
+    unsigned short GetHeightAt(int x, int y, int& mip) const;
+
+    const std::vector<short>& GetPageTable() const { return m_pageTable; }
+    // TileSize * TileSize texels of the tile in "slot".
+    const unsigned short* GetSlotData(int slot) const { return &m_slotData[static_cast<size_t>(slot) * m_tileTexelCount]; }
+    int GetSlotCount() const { return static_cast<int>(m_slotTiles.size()); }
+    int GetResidentCount() const { return GetSlotCount() - static_cast<int>(m_freeSlots.size()); }
+    uint64_t GetSlotBytes() const { return m_slotData.size() * sizeof(unsigned short); }
+    uint64_t GetEvictionCount() const { return m_evictions; }
+
+   private:
+    void Request(int tileIndex);
+
+    TiledHeightmap::Layout m_layout;
+    int m_maxUploadsPerFrame;
+    uint64_t m_frame;
+
+    std::vector<short> m_pageTable;         // slot per tile, or -1
+    std::vector<uint64_t> m_tileRequested;  // frame a tile was last requested, per tile
+    std::vector<int> m_requests;            // tiles requested this frame
+    std::vector<int> m_slotTiles;           // tile per slot, or -1
+    std::vector<uint64_t> m_slotLastUse;    // frame a slot's tile was last requested, per slot
+    std::vector<int> m_freeSlots;
+    std::vector<unsigned short> m_slotData;  // m_tileTexelCount texels per slot
+    size_t m_tileTexelCount;
+    uint64_t m_evictions;
+};
+
+#endif  // _TILED_HEIGHTMAP_H_
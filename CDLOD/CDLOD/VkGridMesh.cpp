@@ -76,11 +76,8 @@ vk::Result VkGridMesh::OnCreateDevice(LoadingResource& ldgRes) {
         for (int y = 0; y < vertDim; y++)
             for (int x = 0; x < vertDim; x++) vertices[x + vertDim * y] = {x / (float)(gridDim), y / (float)(gridDim)};
 
-        BufferResource stgRes = {};
-        m_pContext->createBuffer(
-            ldgRes.transferCmd, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-            sizeof(VertexBufferType) * vertices.size(), name.c_str(), stgRes, m_vertexBuffer, vertices.data());
-        ldgRes.stgResources.push_back(std::move(stgRes));
+        m_pContext->createBuffer(ldgRes, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+                                 sizeof(VertexBufferType) * vertices.size(), name.c_str(), m_vertexBuffer, vertices.data());
     }
 
     {  // INDICES
@@ -148,11 +145,8 @@ vk::Result VkGridMesh::OnCreateDevice(LoadingResource& ldgRes) {
         m_indexEndBR = index;
         assert((m_indexEndBR % m_indicesPerQuadrant) == 0);
 
-        BufferResource stgRes = {};
-        m_pContext->createBuffer(
-            ldgRes.transferCmd, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-            sizeof(IndexBufferType) * indices.size(), name.c_str(), stgRes, m_indexBuffer, indices.data());
-        ldgRes.stgResources.push_back(std::move(stgRes));
+        m_pContext->createBuffer(ldgRes, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
+                                 sizeof(IndexBufferType) * indices.size(), name.c_str(), m_indexBuffer, indices.data());
     }
 
     return vk::Result::eSuccess;
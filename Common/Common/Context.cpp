@@ -6,6 +6,7 @@
 #include "Context.h"
 
 #include "Helpers.h"
+#include "StagingRing.h"
 
 // See: https://github.com/KhronosGroup/Vulkan-Hpp#extensions--per-device-function-pointers
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
@@ -28,6 +29,8 @@ Context::Context()
       independentBlendEnabled(false),
       imageCubeArrayEnabled(false),
       dualSrcBlendEnabled(false),
+      timelineSemaphoreEnabled(false),
+      drawIndirectCountEnabled(false),
       instance{},
       physicalDev{},
       physicalDevIndex(0),
@@ -142,12 +145,18 @@ void Context::initDevice() {
         // *pNext = &phyDevProps.featTransFback;
         // pNext = &phyDevProps.featTransFback.pNext;
     }
+    if (timelineSemaphoreEnabled) {
+        assert(phyDevProps.featTimelineSemaphore.timelineSemaphore && !phyDevProps.featTimelineSemaphore.pNext);
+        devInfo.pNext = &phyDevProps.featTimelineSemaphore;
+    }
 
     dev = physicalDev.createDevice(devInfo, pAllocator);
     assert(dev);
 
     VULKAN_HPP_DEFAULT_DISPATCHER.init(dev);
 
+    memAllocator.init(dev, memProps, phyDevProps.properties.limits, pAllocator);
+
     // Moved asserts below from old Extensions.h. Not sure yet if there is a better place.
 
     if (debugMarkersEnabled) {
@@ -178,6 +187,7 @@ void Context::initDevice() {
 
 void Context::destroyDevice() {
     dev.waitIdle();
+    memAllocator.destroy();
     dev.destroy(pAllocator);
 }
 
@@ -207,51 +217,50 @@ void Context::destroyDebug() {
     if (debugUtilsMessenger_) instance.destroyDebugUtilsMessengerEXT(debugUtilsMessenger_, pAllocator);
 }
 
-void Context::createBuffer(const vk::CommandBuffer &cmd, const vk::BufferUsageFlags usage, const vk::DeviceSize size,
-                           const std::string &&name, BufferResource &stgRes, BufferResource &buffRes, const void *data,
-                           const bool mappable) const {
-    assert(!stgRes.buffer);
-    assert(!stgRes.memory);
-    assert(!buffRes.buffer);
-    assert(!buffRes.memory);
+void *Context::stage(LoadingResource &ldgRes, const vk::DeviceSize size, const vk::DeviceSize alignment,
+                     vk::Buffer &buffer, vk::DeviceSize &offset) const {
+    StagingRing::Allocation allocation;
+    if (ldgRes.pStagingRing != nullptr && ldgRes.pStagingRing->allocate(size, alignment, allocation)) {
+        ldgRes.stagingTickets.push_back(allocation.ticket);
+        buffer = allocation.buffer;
+        offset = allocation.offset;
+        return allocation.pData;
+    }
 
-    // STAGING RESOURCE
-    buffRes.memoryRequirements.size =
+    // Too big for the ring, or it is full. The buffer is destroyed with the loading resource.
+    BufferResource stgRes = {};
+    stgRes.memoryRequirements.size =
         helpers::createBuffer(dev, size, vk::BufferUsageFlagBits::eTransferSrc,
-                              vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, memProps,
-                              stgRes.buffer, stgRes.memory, pAllocator);
-
-    // FILL STAGING BUFFER ON DEVICE
-    void *pData;
-    pData = dev.mapMemory(stgRes.memory, 0, buffRes.memoryRequirements.size);
-    /*
-     *  You can now simply memcpy the vertex data to the mapped memory and unmap it again using unmapMemory.
-     *  Unfortunately the driver may not immediately copy the data into the buffer memory, for example because
-     *  of caching. It is also possible that writes to the buffer are not visible in the mapped memory yet. There
-     *  are two ways to deal with that problem:
-     *      - Use a memory heap that is host coherent, indicated with vk::MemoryPropertyFlagBits::eHostCoherent
-     *      - Call flushMappedMemoryRanges to after writing to the mapped memory, and call
-     *        invalidateMappedMemoryRanges before reading from the mapped memory
-     *  We went for the first approach, which ensures that the mapped memory always matches the contents of the
-     *  allocated memory. Do keep in mind that this may lead to slightly worse performance than explicit flushing,
-     *  but we'll see why that doesn't matter in the next chapter.
-     */
-    memcpy(pData, data, static_cast<size_t>(size));
-    dev.unmapMemory(stgRes.memory);
+                              vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                              memAllocator, stgRes.buffer, stgRes.allocation, pAllocator);
+    ldgRes.stgResources.push_back(stgRes);
+    buffer = stgRes.buffer;
+    offset = 0;
+    return stgRes.allocation.pMappedData;
+}
+
+void Context::createBuffer(LoadingResource &ldgRes, const vk::BufferUsageFlags usage, const vk::DeviceSize size,
+                           const std::string &&name, BufferResource &buffRes, const void *data, const bool mappable) const {
+    assert(!buffRes.buffer);
+    assert(!buffRes.allocation.memory);
+
+    // STAGING (host coherent, so no flush is needed)
+    vk::Buffer stgBuffer;
+    vk::DeviceSize stgOffset;
+    memcpy(stage(ldgRes, size, StagingRing::BUFFER_ALIGNMENT, stgBuffer, stgOffset), data, static_cast<size_t>(size));
 
     // FAST VERTEX BUFFER
     vk::MemoryPropertyFlags memPropFlags = vk::MemoryPropertyFlagBits::eDeviceLocal;
     if (mappable) memPropFlags |= vk::MemoryPropertyFlagBits::eHostVisible;
-    helpers::createBuffer(dev, size,
-                          // TODO: probably don't need to check memory requirements again
-                          usage, memPropFlags, memProps, buffRes.buffer, buffRes.memory, pAllocator);
+    buffRes.memoryRequirements.size =
+        helpers::createBuffer(dev, size, usage, memPropFlags, memAllocator, buffRes.buffer, buffRes.allocation, pAllocator);
 
     // COPY FROM STAGING TO FAST
-    helpers::copyBuffer(cmd, stgRes.buffer, buffRes.buffer, buffRes.memoryRequirements.size);
+    helpers::copyBuffer(ldgRes.transferCmd, stgBuffer, buffRes.buffer, size, stgOffset);
     dbg_.setMarkerName(buffRes.buffer, name.c_str());
 }
 
 void Context::destroyBuffer(BufferResource &res) const {
     if (res.buffer) dev.destroyBuffer(res.buffer, pAllocator);
-    if (res.memory) dev.freeMemory(res.memory, pAllocator);
+    memAllocator.free(res.allocation);
 }
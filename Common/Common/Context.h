@@ -55,6 +55,7 @@ class Context {
         // vk::PhysicalDeviceVertexAttributeDivisorPropertiesEXT propsVertAttrDiv;
         vk::PhysicalDeviceTransformFeedbackFeaturesEXT featTransFback;
         // vk::PhysicalDeviceTransformFeedbackPropertiesEXT propsTransFback;
+        vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR featTimelineSemaphore;
     };
 
     bool samplerAnisotropyEnabled;
@@ -70,6 +71,8 @@ class Context {
     bool independentBlendEnabled;
     bool imageCubeArrayEnabled;
     bool dualSrcBlendEnabled;
+    bool timelineSemaphoreEnabled;
+    bool drawIndirectCountEnabled;
 
     std::vector<const char *> instanceEnabledLayerNames;
     std::vector<const char *> instanceEnabledExtensionNames;
@@ -87,6 +90,8 @@ class Context {
 
     vk::Device dev;
     vk::AllocationCallbacks *pAllocator;
+    // Device memory for buffers and images (thread safe).
+    mutable Memory::Allocator memAllocator;
 
     // SURFACE (TODO: figure out what is what)
     SurfaceProperties surfaceProps;
@@ -117,8 +122,12 @@ class Context {
                    void *pUserData);
     void destroyDebug();
 
-    void createBuffer(const vk::CommandBuffer &cmd, const vk::BufferUsageFlags usage, const vk::DeviceSize size,
-                      const std::string &&name, BufferResource &stgRes, BufferResource &buffRes, const void *data,
+    // Returns mapped memory for "size" bytes of upload data, and where it lives for the copy command. It comes from the
+    // loading resource's staging ring if there is room, otherwise from a staging buffer added to "stgResources".
+    void *stage(LoadingResource &ldgRes, const vk::DeviceSize size, const vk::DeviceSize alignment, vk::Buffer &buffer,
+                vk::DeviceSize &offset) const;
+    void createBuffer(LoadingResource &ldgRes, const vk::BufferUsageFlags usage, const vk::DeviceSize size,
+                      const std::string &&name, BufferResource &buffRes, const void *data,
                       const bool mappable = false) const;
     void destroyBuffer(BufferResource &res) const;
 
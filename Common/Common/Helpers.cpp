@@ -145,9 +145,18 @@ bool getMemoryType(const vk::PhysicalDeviceMemoryProperties &memProps, uint32_t
     return false;
 }
 
+bool getMemoryType(const vk::PhysicalDeviceMemoryProperties &memProps, uint32_t typeBits, vk::MemoryPropertyFlags reqMask,
+                   const std::vector<vk::MemoryPropertyFlags> &prefMasks, uint32_t *typeIndex) {
+    const auto memoryTypes = Memory::getMemoryTypes(memProps, typeBits, reqMask, prefMasks);
+    if (memoryTypes.empty()) return false;
+    *typeIndex = memoryTypes.front();
+    return true;
+}
+
 vk::DeviceSize createBuffer(const vk::Device &dev, const vk::DeviceSize &size, const vk::BufferUsageFlags &usage,
-                            const vk::MemoryPropertyFlags &props, const vk::PhysicalDeviceMemoryProperties &memProps,
-                            vk::Buffer &buff, vk::DeviceMemory &mem, const vk::AllocationCallbacks *pAllocator) {
+                            const vk::MemoryPropertyFlags &props, Memory::Allocator &memAllocator, vk::Buffer &buff,
+                            Memory::Allocation &allocation, const vk::AllocationCallbacks *pAllocator,
+                            const std::vector<vk::MemoryPropertyFlags> &prefMasks) {
     vk::BufferCreateInfo buffInfo = {};
     buffInfo.size = size;
     buffInfo.usage = usage;
@@ -163,75 +172,40 @@ vk::DeviceSize createBuffer(const vk::Device &dev, const vk::DeviceSize &size, c
 
     vk::MemoryRequirements memReqs = dev.getBufferMemoryRequirements(buff);
 
-    vk::MemoryAllocateInfo allocInfo = {};
-    allocInfo.allocationSize = memReqs.size;
-    auto pass = getMemoryType(memProps, memReqs.memoryTypeBits, props, &allocInfo.memoryTypeIndex);
-    assert(pass && "No mappable, coherent memory");
-
-    /*
-        It should be noted that in a real world application, you're not supposed to actually
-        call allocateMemory for every individual buffer. The maximum number of simultaneous
-        memory allocations is limited by the maxMemoryAllocationCount physical device limit,
-        which may be as low as 4096 even on high end hardware like an NVIDIA GTX 1080. The
-        right way to allocate memory for a large number of objects at the same time is to create
-        a custom allocator that splits up a single allocation among many different objects by
-        using the offset parameters that we've seen in many functions.
-
-        You can either implement such an allocator yourself, or use the VulkanMemoryAllocator
-        library provided by the GPUOpen initiative. However, for this tutorial it's okay to
-        use a separate allocation for every resource, because we won't come close to hitting
-        any of these limits for now.
-
-        The previous chapter already mentioned that you should allocate multiple resources like
-        buffers from a single memory allocation, but in fact you should go a step further.
-        Driver developers recommend that you also store multiple buffers, like the vertex and
-        index buffer, into a single vk::Buffer and use offsets in commands like
-        bindVertexBuffers. The advantage is that your data is more cache friendly in that
-        case, because it's closer together. It is even possible to reuse the same chunk of
-        memory for multiple resources if they are not used during the same render operations,
-        provided that their data is refreshed, of course. This is known as aliasing and some
-        Vulkan functions have explicit flags to specify that you want to do this.
-    */
-    mem = dev.allocateMemory(allocInfo, pAllocator);
+    // Placed in one of the allocator's blocks (see Memory::Allocator) instead of an allocateMemory call per buffer. The
+    // maximum number of allocations is limited by maxMemoryAllocationCount, which can be as low as 4096.
+    allocation = memAllocator.allocate(memReqs, props, true, prefMasks);
 
     // BIND MEMORY
-    dev.bindBufferMemory(buff, mem, 0);
+    dev.bindBufferMemory(buff, allocation.memory, allocation.offset);
 
     return memReqs.size;
 }
 
 void copyBuffer(const vk::CommandBuffer &cmd, const vk::Buffer &srcBuff, const vk::Buffer &dstBuff,
-                const vk::DeviceSize &size) {
+                const vk::DeviceSize &size, const vk::DeviceSize &srcOffset) {
     vk::BufferCopy copyRegion = {};
-    copyRegion.srcOffset = 0;  // Optional
+    copyRegion.srcOffset = srcOffset;
     copyRegion.dstOffset = 0;  // Optional
     copyRegion.size = size;
     cmd.copyBuffer(srcBuff, dstBuff, {copyRegion});
 }
 
-void createImageMemory(const vk::Device &dev, const vk::PhysicalDeviceMemoryProperties &memProps,
-                       const vk::MemoryPropertyFlags &memPropFlags, vk::Image &image, vk::DeviceMemory &memory,
-                       const vk::AllocationCallbacks *pAllocator) {
+void createImageMemory(const vk::Device &dev, Memory::Allocator &memAllocator, const vk::MemoryPropertyFlags &memPropFlags,
+                       const vk::ImageTiling &tiling, vk::Image &image, Memory::Allocation &allocation) {
     vk::MemoryRequirements memReqs = dev.getImageMemoryRequirements(image);
 
-    vk::MemoryAllocateInfo allocInfo = {};
-    allocInfo.allocationSize = memReqs.size;
-
-    // Use the memory properties to determine the type of memory required
-    auto pass = getMemoryType(memProps, memReqs.memoryTypeBits, memPropFlags, &allocInfo.memoryTypeIndex);
-    assert(pass);
-
     // Allocate memory
-    memory = dev.allocateMemory(allocInfo, pAllocator);
+    allocation = memAllocator.allocate(memReqs, memPropFlags, tiling == vk::ImageTiling::eLinear);
     // Bind memory
-    dev.bindImageMemory(image, memory, 0);
+    dev.bindImageMemory(image, allocation.memory, allocation.offset);
 }
 
-void createImage(const vk::Device &dev, const vk::PhysicalDeviceMemoryProperties &memProps,
+void createImage(const vk::Device &dev, Memory::Allocator &memAllocator,
                  const std::vector<uint32_t> &queueFamilyIndices, const vk::SampleCountFlagBits &numSamples,
                  const vk::Format &format, const vk::ImageTiling &tiling, const vk::ImageUsageFlags &usage,
                  const vk::MemoryPropertyFlags &reqMask, uint32_t width, uint32_t height, uint32_t mipLevels,
-                 uint32_t arrayLayers, vk::Image &image, vk::DeviceMemory &memory,
+                 uint32_t arrayLayers, vk::Image &image, Memory::Allocation &allocation,
                  const vk::AllocationCallbacks *pAllocator) {
     vk::ImageCreateInfo imageInfo = {};
     imageInfo.imageType = vk::ImageType::e2D;  // param?
@@ -250,13 +224,13 @@ void createImage(const vk::Device &dev, const vk::PhysicalDeviceMemoryProperties
     imageInfo.pQueueFamilyIndices = queueFamilyIndices.data();
 
     image = dev.createImage(imageInfo, pAllocator);
-    createImageMemory(dev, memProps, reqMask, image, memory, pAllocator);
+    createImageMemory(dev, memAllocator, reqMask, tiling, image, allocation);
 }
 
 void copyBufferToImage(const vk::CommandBuffer &cmd, uint32_t width, uint32_t height, uint32_t layerCount,
-                       const vk::Buffer &srcBuff, const vk::Image &dstImg) {
+                       const vk::Buffer &srcBuff, const vk::Image &dstImg, const vk::DeviceSize &bufferOffset) {
     vk::BufferImageCopy region = {};
-    region.bufferOffset = 0;
+    region.bufferOffset = bufferOffset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
 
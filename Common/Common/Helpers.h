@@ -276,27 +276,31 @@ vk::Format findDepthFormat(const vk::PhysicalDevice &phyDev);
 
 bool getMemoryType(const vk::PhysicalDeviceMemoryProperties &memProps, uint32_t typeBits, vk::MemoryPropertyFlags reqMask,
                    uint32_t *typeIndex);
+// Same as above, but the first of "prefMasks" (in order) that a memory type also has wins (Memory::getMemoryTypes).
+bool getMemoryType(const vk::PhysicalDeviceMemoryProperties &memProps, uint32_t typeBits, vk::MemoryPropertyFlags reqMask,
+                   const std::vector<vk::MemoryPropertyFlags> &prefMasks, uint32_t *typeIndex);
 
+// "prefMasks" are the memory preferences of Memory::Allocator::allocate.
 vk::DeviceSize createBuffer(const vk::Device &dev, const vk::DeviceSize &size, const vk::BufferUsageFlags &usage,
-                            const vk::MemoryPropertyFlags &props, const vk::PhysicalDeviceMemoryProperties &memProps,
-                            vk::Buffer &buff, vk::DeviceMemory &mem, const vk::AllocationCallbacks *pAllocator);
+                            const vk::MemoryPropertyFlags &props, Memory::Allocator &memAllocator, vk::Buffer &buff,
+                            Memory::Allocation &allocation, const vk::AllocationCallbacks *pAllocator,
+                            const std::vector<vk::MemoryPropertyFlags> &prefMasks = {});
 
 void copyBuffer(const vk::CommandBuffer &cmd, const vk::Buffer &srcBuff, const vk::Buffer &dstBuff,
-                const vk::DeviceSize &size);
+                const vk::DeviceSize &size, const vk::DeviceSize &srcOffset = 0);
 
-void createImageMemory(const vk::Device &dev, const vk::PhysicalDeviceMemoryProperties &memProps,
-                       const vk::MemoryPropertyFlags &memPropFlags, vk::Image &image, vk::DeviceMemory &memory,
-                       const vk::AllocationCallbacks *pAllocator);
+void createImageMemory(const vk::Device &dev, Memory::Allocator &memAllocator, const vk::MemoryPropertyFlags &memPropFlags,
+                       const vk::ImageTiling &tiling, vk::Image &image, Memory::Allocation &allocation);
 
-void createImage(const vk::Device &dev, const vk::PhysicalDeviceMemoryProperties &memProps,
+void createImage(const vk::Device &dev, Memory::Allocator &memAllocator,
                  const std::vector<uint32_t> &queueFamilyIndices, const vk::SampleCountFlagBits &numSamples,
                  const vk::Format &format, const vk::ImageTiling &tiling, const vk::ImageUsageFlags &usage,
                  const vk::MemoryPropertyFlags &reqMask, uint32_t width, uint32_t height, uint32_t mipLevels,
-                 uint32_t arrayLayers, vk::Image &image, vk::DeviceMemory &memory,
+                 uint32_t arrayLayers, vk::Image &image, Memory::Allocation &allocation,
                  const vk::AllocationCallbacks *pAllocator);
 
 void copyBufferToImage(const vk::CommandBuffer &cmd, uint32_t width, uint32_t height, uint32_t layerCount,
-                       const vk::Buffer &src_buf, const vk::Image &dst_img);
+                       const vk::Buffer &src_buf, const vk::Image &dst_img, const vk::DeviceSize &bufferOffset = 0);
 
 void createImageView(const vk::Device &device, const vk::Image &image, const vk::Format &format,
                      const vk::ImageViewType &viewType, const vk::ImageSubresourceRange &subresourceRange,
@@ -341,10 +345,11 @@ static FlagBits incrementByteFlag(FlagBits flags, T1 firstBit, T2 allBits) {
     return flags;
 }
 
-static void destroyImageResource(const vk::Device &dev, ImageResource &res, vk::AllocationCallbacks *pAllocator) {
+static void destroyImageResource(const vk::Device &dev, Memory::Allocator &memAllocator, ImageResource &res,
+                                 vk::AllocationCallbacks *pAllocator) {
     if (res.view) dev.destroyImageView(res.view, pAllocator);
     if (res.image) dev.destroyImage(res.image, pAllocator);
-    if (res.memory) dev.freeMemory(res.memory, pAllocator);
+    memAllocator.free(res.allocation);
 }
 
 constexpr bool compExtent2D(const vk::Extent2D &a, const vk::Extent2D &b) {
@@ -0,0 +1,455 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+inline uint32_t findLowestBit(uint64_t bits) {
+    uint32_t index = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+}
+inline uint32_t findHighestBit(uint64_t bits) {
+    uint32_t index = 0;
+    while (bits >>= 1) index++;
+    return index;
+}
+inline vk::DeviceSize alignDown(const vk::DeviceSize value, const vk::DeviceSize alignment) {
+    return value - (value % alignment);
+}
+inline vk::DeviceSize alignUp(const vk::DeviceSize value, const vk::DeviceSize alignment) {
+    return alignDown(value + alignment - 1, alignment);
+}
+}  // namespace
+
+// MEMORY TYPES
+
+std::vector<uint32_t> Memory::getMemoryTypes(const vk::PhysicalDeviceMemoryProperties &memProps, const uint32_t typeBits,
+                                             const vk::MemoryPropertyFlags reqMask,
+                                             const std::vector<vk::MemoryPropertyFlags> &prefMasks) {
+    std::vector<std::pair<size_t, uint32_t>> ranks;  // (first preference it has, index)
+    for (uint32_t i = 0; i < memProps.memoryTypeCount; i++) {
+        const auto &propertyFlags = memProps.memoryTypes[i].propertyFlags;
+        if (!(typeBits & (1u << i)) || (propertyFlags & reqMask) != reqMask) continue;
+        size_t rank = 0;
+        while (rank < prefMasks.size() && (propertyFlags & prefMasks[rank]) != prefMasks[rank]) rank++;
+        ranks.push_back({rank, i});
+    }
+    std::sort(ranks.begin(), ranks.end());
+
+    std::vector<uint32_t> memoryTypes;
+    for (const auto &rank : ranks) memoryTypes.push_back(rank.second);
+    return memoryTypes;
+}
+
+const std::vector<vk::MemoryPropertyFlags> &Memory::getHostWritePreferences(const bool deviceLocal) {
+    static const std::vector<vk::MemoryPropertyFlags> HOST = {
+        vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent,
+        vk::MemoryPropertyFlagBits::eHostCached,
+        vk::MemoryPropertyFlagBits::eHostCoherent,
+    };
+    static const std::vector<vk::MemoryPropertyFlags> DEVICE_LOCAL = {
+#if !(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK))
+        vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostCoherent,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+#endif
+        vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent,
+        vk::MemoryPropertyFlagBits::eHostCached,
+        vk::MemoryPropertyFlagBits::eHostCoherent,
+    };
+    return deviceLocal ? DEVICE_LOCAL : HOST;
+}
+
+// TLSF
+
+Memory::Tlsf::Tlsf(const vk::DeviceSize size) : size_(size), usedSize_(0), flBitmap_(0) {
+    assert(size_ > 0);
+    slBitmaps_.fill(0);
+    freeHeads_.fill(INVALID);
+    insertFree(makeNode(0, size_));
+}
+
+bool Memory::Tlsf::allocate(const vk::DeviceSize size, const vk::DeviceSize alignment, vk::DeviceSize &offset) {
+    assert(size > 0 && alignment > 0);
+    // Search for the worst case of alignment padding.
+    const auto searchSize = size + alignment - 1;
+    if (searchSize > size_) return false;
+
+    const auto index = findFree(searchSize);
+    if (index == INVALID) return false;
+    removeFree(index);
+
+    // Padding in front for the alignment goes back in the free lists. (The node in front can't be free because free
+    // neighbours are always merged.)
+    const auto alignedOffset = alignUp(nodes_[index].offset, alignment);
+    if (const auto padding = alignedOffset - nodes_[index].offset) {
+        const auto pad = makeNode(nodes_[index].offset, padding);
+        nodes_[pad].prevPhysical = nodes_[index].prevPhysical;
+        nodes_[pad].nextPhysical = index;
+        if (nodes_[pad].prevPhysical != INVALID) nodes_[nodes_[pad].prevPhysical].nextPhysical = pad;
+        nodes_[index].prevPhysical = pad;
+        nodes_[index].offset = alignedOffset;
+        nodes_[index].size -= padding;
+        insertFree(pad);
+    }
+
+    // So does the remainder.
+    if (const auto remainder = nodes_[index].size - size) {
+        const auto rest = makeNode(alignedOffset + size, remainder);
+        nodes_[rest].prevPhysical = index;
+        nodes_[rest].nextPhysical = nodes_[index].nextPhysical;
+        if (nodes_[rest].nextPhysical != INVALID) nodes_[nodes_[rest].nextPhysical].prevPhysical = rest;
+        nodes_[index].nextPhysical = rest;
+        nodes_[index].size = size;
+        insertFree(rest);
+    }
+
+    nodes_[index].free = false;
+    allocated_[alignedOffset] = index;
+    usedSize_ += size;
+    offset = alignedOffset;
+    return true;
+}
+
+void Memory::Tlsf::free(const vk::DeviceSize offset) {
+    auto it = allocated_.find(offset);
+    assert(it != allocated_.end() && "Offset was not allocated");
+    auto index = it->second;
+    allocated_.erase(it);
+    usedSize_ -= nodes_[index].size;
+
+    // Merge with the free neighbours. The node in front is kept, so node 0 always stays at offset 0.
+    const auto prev = nodes_[index].prevPhysical;
+    if (prev != INVALID && nodes_[prev].free) {
+        removeFree(prev);
+        nodes_[prev].size += nodes_[index].size;
+        nodes_[prev].nextPhysical = nodes_[index].nextPhysical;
+        if (nodes_[prev].nextPhysical != INVALID) nodes_[nodes_[prev].nextPhysical].prevPhysical = prev;
+        releaseNode(index);
+        index = prev;
+    }
+    const auto next = nodes_[index].nextPhysical;
+    if (next != INVALID && nodes_[next].free) {
+        removeFree(next);
+        nodes_[index].size += nodes_[next].size;
+        nodes_[index].nextPhysical = nodes_[next].nextPhysical;
+        if (nodes_[index].nextPhysical != INVALID) nodes_[nodes_[index].nextPhysical].prevPhysical = index;
+        releaseNode(next);
+    }
+
+    insertFree(index);
+}
+
+void Memory::Tlsf::getFreeRanges(uint32_t &count, vk::DeviceSize &largest) const {
+    count = 0;
+    largest = 0;
+    for (auto index = 0u; index != INVALID; index = nodes_[index].nextPhysical) {
+        if (!nodes_[index].free) continue;
+        count++;
+        largest = (std::max)(largest, nodes_[index].size);
+    }
+}
+
+void Memory::Tlsf::mapping(const vk::DeviceSize size, uint32_t &fl, uint32_t &sl) {
+    if (size < (1ull << SMALL_LOG2)) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size >> (SMALL_LOG2 - SL_LOG2));
+    } else {
+        const auto highestBit = findHighestBit(size);
+        fl = highestBit - SMALL_LOG2 + 1;
+        sl = static_cast<uint32_t>(size >> (highestBit - SL_LOG2)) - SL_COUNT;
+    }
+}
+
+uint32_t Memory::Tlsf::findFree(const vk::DeviceSize size) const {
+    // Round up to the next size class so that any node in the list found is large enough.
+    const auto step =
+        size < (1ull << SMALL_LOG2) ? (1ull << (SMALL_LOG2 - SL_LOG2)) : (1ull << (findHighestBit(size) - SL_LOG2));
+    uint32_t fl, sl;
+    mapping(size + step - 1, fl, sl);
+
+    if (fl < FL_COUNT) {
+        auto slBitmap = slBitmaps_[fl] & (~0u << sl);
+        if (!slBitmap) {
+            const auto flBitmap = fl + 1 < FL_COUNT ? flBitmap_ & (~0ull << (fl + 1)) : 0;
+            if (flBitmap) {
+                fl = findLowestBit(flBitmap);
+                slBitmap = slBitmaps_[fl];
+            }
+        }
+        if (slBitmap) return freeHeads_[fl * SL_COUNT + findLowestBit(slBitmap)];
+    }
+
+    // Nothing in the larger classes. The class "size" is in can still have a node that fits.
+    mapping(size, fl, sl);
+    for (auto index = freeHeads_[fl * SL_COUNT + sl]; index != INVALID; index = nodes_[index].nextFree)
+        if (nodes_[index].size >= size) return index;
+    return INVALID;
+}
+
+uint32_t Memory::Tlsf::makeNode(const vk::DeviceSize offset, const vk::DeviceSize size) {
+    uint32_t index;
+    if (unusedNodes_.empty()) {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    } else {
+        index = unusedNodes_.back();
+        unusedNodes_.pop_back();
+    }
+    nodes_[index] = {offset, size, INVALID, INVALID, INVALID, INVALID, false};
+    return index;
+}
+
+void Memory::Tlsf::insertFree(const uint32_t index) {
+    uint32_t fl, sl;
+    mapping(nodes_[index].size, fl, sl);
+    auto &head = freeHeads_[fl * SL_COUNT + sl];
+    nodes_[index].free = true;
+    nodes_[index].prevFree = INVALID;
+    nodes_[index].nextFree = head;
+    if (head != INVALID) nodes_[head].prevFree = index;
+    head = index;
+    flBitmap_ |= 1ull << fl;
+    slBitmaps_[fl] |= 1u << sl;
+}
+
+void Memory::Tlsf::removeFree(const uint32_t index) {
+    uint32_t fl, sl;
+    mapping(nodes_[index].size, fl, sl);
+    auto &head = freeHeads_[fl * SL_COUNT + sl];
+    const auto prev = nodes_[index].prevFree, next = nodes_[index].nextFree;
+    if (prev != INVALID) nodes_[prev].nextFree = next;
+    if (next != INVALID) nodes_[next].prevFree = prev;
+    if (head == index) head = next;
+    if (head == INVALID) {
+        slBitmaps_[fl] &= ~(1u << sl);
+        if (!slBitmaps_[fl]) flBitmap_ &= ~(1ull << fl);
+    }
+    nodes_[index].free = false;
+}
+
+void Memory::Tlsf::releaseNode(const uint32_t index) { unusedNodes_.push_back(index); }
+
+// ALLOCATOR
+
+Memory::Allocator::Allocator()
+    : pAllocator_(nullptr),
+      blockSize_(DEFAULT_BLOCK_SIZE),
+      bufferImageGranularity_(1),
+      nonCoherentAtomSize_(1),
+      dedicatedAllocationCount_(0),
+      dedicatedSize_(0) {}
+
+void Memory::Allocator::init(const vk::Device &dev, const vk::PhysicalDeviceMemoryProperties &memProps,
+                             const vk::PhysicalDeviceLimits &limits, const vk::AllocationCallbacks *pAllocator,
+                             const vk::DeviceSize blockSize) {
+    assert(pools_.empty() && "Memory allocator was already initialized");
+    dev_ = dev;
+    memProps_ = memProps;
+    pAllocator_ = pAllocator;
+    blockSize_ = blockSize;
+    bufferImageGranularity_ = limits.bufferImageGranularity;
+    nonCoherentAtomSize_ = limits.nonCoherentAtomSize;
+
+    // Two pools per memory type: linear, and optimal.
+    pools_.resize(static_cast<size_t>(memProps_.memoryTypeCount) * 2);
+    for (uint32_t i = 0; i < pools_.size(); i++) {
+        auto &pool = pools_[i];
+        pool.memoryTypeIndex = i / 2;
+        // Don't let a small heap (like the device local host visible one) be taken by a couple of blocks.
+        const auto &heap = memProps_.memoryHeaps[memProps_.memoryTypes[pool.memoryTypeIndex].heapIndex];
+        pool.blockSize = (std::max)((std::min)(blockSize_, heap.size / 8), vk::DeviceSize(1));
+    }
+}
+
+void Memory::Allocator::destroy() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &pool : pools_)
+        for (auto &pBlock : pool.blocks) destroyBlock(*pBlock);
+    pools_.clear();
+    dedicatedAllocationCount_ = 0;
+    dedicatedSize_ = 0;
+}
+
+Memory::Allocation Memory::Allocator::allocate(const vk::MemoryRequirements &memReqs, const vk::MemoryPropertyFlags reqMask,
+                                               const bool linear, const std::vector<vk::MemoryPropertyFlags> &prefMasks) {
+    const auto memoryTypes = getMemoryTypes(memProps_, memReqs.memoryTypeBits, reqMask, prefMasks);
+    assert(!memoryTypes.empty() && "No suitable memory type");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < memoryTypes.size(); i++) {
+        try {
+            return allocate(memoryTypes[i], memReqs, linear);
+        } catch (const vk::OutOfDeviceMemoryError &) {
+            // A small heap (like the BAR one) can run out while others have room.
+            if (i + 1 == memoryTypes.size()) throw;
+        }
+    }
+    return {};
+}
+
+Memory::Allocation Memory::Allocator::allocate(const uint32_t memoryTypeIndex, const vk::MemoryRequirements &memReqs,
+                                               const bool linear) {
+    Allocation allocation = {};
+    allocation.size = memReqs.size;
+    allocation.propertyFlags = memProps_.memoryTypes[memoryTypeIndex].propertyFlags;
+
+    auto &pool = getPool(memoryTypeIndex, linear);
+
+    if (memReqs.size > pool.blockSize / 2) {
+        allocation.memory = allocateMemory(memoryTypeIndex, memReqs.size, allocation.pMappedData);
+        dedicatedAllocationCount_++;
+        dedicatedSize_ += memReqs.size;
+        return allocation;
+    }
+
+    for (auto &pBlock : pool.blocks) {
+        if (pBlock->tlsf.allocate(memReqs.size, memReqs.alignment, allocation.offset)) {
+            allocation.pBlock = pBlock.get();
+            break;
+        }
+    }
+    if (allocation.pBlock == nullptr) {
+        // Room for the worst case of alignment padding.
+        allocation.pBlock = &createBlock(pool, memReqs.size + memReqs.alignment - 1);
+        const bool pass = allocation.pBlock->tlsf.allocate(memReqs.size, memReqs.alignment, allocation.offset);
+        assert(pass);
+    }
+
+    allocation.memory = allocation.pBlock->memory;
+    if (allocation.pBlock->pMappedData != nullptr)
+        allocation.pMappedData = allocation.pBlock->pMappedData + allocation.offset;
+    return allocation;
+}
+
+void Memory::Allocator::free(Allocation &allocation) {
+    if (!allocation.memory) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (allocation.pBlock == nullptr) {
+        // Freeing the memory unmaps it.
+        dev_.freeMemory(allocation.memory, pAllocator_);
+        dedicatedAllocationCount_--;
+        dedicatedSize_ -= allocation.size;
+    } else {
+        auto &block = *allocation.pBlock;
+        block.tlsf.free(allocation.offset);
+
+        // Keep one empty block per pool so that loading and unloading doesn't allocate and free a block every time.
+        auto &pool = pools_[block.poolIndex];
+        if (block.tlsf.empty() && pool.blocks.size() > 1) {
+            destroyBlock(block);
+            pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                                           [&block](const auto &pBlock) { return pBlock.get() == &block; }));
+        }
+    }
+
+    allocation = {};
+}
+
+Memory::Stats Memory::Allocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = {};
+    for (const auto &pool : pools_) {
+        for (const auto &pBlock : pool.blocks) {
+            stats.blockCount++;
+            stats.totalSize += pBlock->tlsf.getSize();
+            stats.usedSize += pBlock->tlsf.getUsedSize();
+            stats.allocationCount += pBlock->tlsf.getAllocationCount();
+
+            uint32_t freeRangeCount;
+            vk::DeviceSize largestFreeRange;
+            pBlock->tlsf.getFreeRanges(freeRangeCount, largestFreeRange);
+            stats.freeRangeCount += freeRangeCount;
+            stats.largestFreeRange = (std::max)(stats.largestFreeRange, largestFreeRange);
+        }
+    }
+    stats.dedicatedAllocationCount = dedicatedAllocationCount_;
+    stats.dedicatedSize = dedicatedSize_;
+    return stats;
+}
+
+vk::MappedMemoryRange Memory::Allocator::getMappedRange(const Allocation &allocation, const vk::DeviceSize offset,
+                                                        const vk::DeviceSize size) const {
+    const auto memorySize = allocation.pBlock != nullptr ? allocation.pBlock->tlsf.getSize() : allocation.size;
+    const auto begin = allocation.offset + offset;
+    const auto end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+    vk::MappedMemoryRange range = {};
+    range.memory = allocation.memory;
+    range.offset = alignDown(begin, nonCoherentAtomSize_);
+    range.size = (std::min)(alignUp(end, nonCoherentAtomSize_), memorySize) - range.offset;
+    return range;
+}
+
+void Memory::Allocator::flush(const Allocation &allocation, const vk::DeviceSize offset, const vk::DeviceSize size) const {
+    if (allocation.propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent) return;
+    const auto range = getMappedRange(allocation, offset, size);
+    dev_.flushMappedMemoryRanges(range);
+}
+
+void Memory::Allocator::invalidate(const Allocation &allocation, const vk::DeviceSize offset,
+                                   const vk::DeviceSize size) const {
+    if (allocation.propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent) return;
+    const auto range = getMappedRange(allocation, offset, size);
+    dev_.invalidateMappedMemoryRanges(range);
+}
+
+Memory::Allocator::Pool &Memory::Allocator::getPool(const uint32_t memoryTypeIndex, const bool linear) {
+    // With a granularity of 1 there is nothing to keep apart.
+    const auto optimal = !linear && bufferImageGranularity_ > 1;
+    return pools_[static_cast<size_t>(memoryTypeIndex) * 2 + (optimal ? 1 : 0)];
+}
+
+Memory::Block &Memory::Allocator::createBlock(Pool &pool, const vk::DeviceSize minSize) {
+    assert(minSize <= pool.blockSize);
+    // Allocate first, so the pool is left as it was if this throws.
+    auto blockSize = pool.blockSize;
+    void *pMappedData;
+    vk::DeviceMemory memory;
+    while (true) {
+        try {
+            memory = allocateMemory(pool.memoryTypeIndex, blockSize, pMappedData);
+            break;
+        } catch (const vk::OutOfDeviceMemoryError &) {
+            // Halve the block while the allocation still fits, and then let the next memory type be tried.
+            if (blockSize / 2 < minSize) throw;
+            blockSize /= 2;
+        }
+    }
+
+    const auto poolIndex = static_cast<uint32_t>(&pool - pools_.data());
+    pool.blocks.push_back(std::make_unique<Block>(poolIndex, blockSize));
+    auto &block = *pool.blocks.back();
+    block.propertyFlags = memProps_.memoryTypes[pool.memoryTypeIndex].propertyFlags;
+    block.memory = memory;
+    block.pMappedData = static_cast<uint8_t *>(pMappedData);
+    return block;
+}
+
+void Memory::Allocator::destroyBlock(Block &block) {
+    if (block.pMappedData != nullptr) dev_.unmapMemory(block.memory);
+    dev_.freeMemory(block.memory, pAllocator_);
+    block.memory = vk::DeviceMemory();
+    block.pMappedData = nullptr;
+}
+
+vk::DeviceMemory Memory::Allocator::allocateMemory(const uint32_t memoryTypeIndex, const vk::DeviceSize size,
+                                                   void *&pMappedData) {
+    vk::MemoryAllocateInfo allocInfo = {};
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+    auto memory = dev_.allocateMemory(allocInfo, pAllocator_);
+
+    pMappedData = nullptr;
+    if (memProps_.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+        pMappedData = dev_.mapMemory(memory, 0, VK_WHOLE_SIZE);
+    return memory;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef MEMORY_ALLOCATOR_H
+#define MEMORY_ALLOCATOR_H
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Memory {
+
+/*  Two level segregated fit (TLSF) allocator for the ranges of a single block of memory. It only does the bookkeeping
+    (no device calls). Free ranges are kept in lists by size class: the first level is the power of two, and the second
+    level splits that into SL_COUNT linear steps, so finding a free range that fits is a couple of bitmap scans. Freed
+    ranges are merged with their free neighbours right away.
+*/
+class Tlsf {
+   public:
+    Tlsf(const vk::DeviceSize size);
+
+    bool allocate(const vk::DeviceSize size, const vk::DeviceSize alignment, vk::DeviceSize &offset);
+    void free(const vk::DeviceSize offset);
+
+    inline vk::DeviceSize getSize() const { return size_; }
+    inline vk::DeviceSize getUsedSize() const { return usedSize_; }
+    inline uint32_t getAllocationCount() const { return static_cast<uint32_t>(allocated_.size()); }
+    inline bool empty() const { return allocated_.empty(); }
+    // Walks all the ranges.
+    void getFreeRanges(uint32_t &count, vk::DeviceSize &largest) const;
+
+   private:
+    static constexpr uint32_t SL_LOG2 = 4;
+    static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+    static constexpr uint32_t SMALL_LOG2 = 8;  // sizes below this power of two all go in the first level
+    static constexpr uint32_t FL_COUNT = 64 - SMALL_LOG2 + 1;
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    struct Node {
+        vk::DeviceSize offset, size;
+        uint32_t prevPhysical, nextPhysical;
+        uint32_t prevFree, nextFree;
+        bool free;
+    };
+
+    static void mapping(const vk::DeviceSize size, uint32_t &fl, uint32_t &sl);
+    uint32_t findFree(const vk::DeviceSize size) const;
+    uint32_t makeNode(const vk::DeviceSize offset, const vk::DeviceSize size);
+    void insertFree(const uint32_t index);
+    void removeFree(const uint32_t index);
+    void releaseNode(const uint32_t index);
+
+    vk::DeviceSize size_;
+    vk::DeviceSize usedSize_;
+    std::vector<Node> nodes_;  // the node at index 0 is always the one at offset 0
+    std::vector<uint32_t> unusedNodes_;
+    std::unordered_map<vk::DeviceSize, uint32_t> allocated_;  // offset -> node
+    uint64_t flBitmap_;
+    std::array<uint32_t, FL_COUNT> slBitmaps_;
+    std::array<uint32_t, FL_COUNT * SL_COUNT> freeHeads_;
+};
+
+/*  Every memory type in "typeBits" that has "reqMask", ordered by the first of "prefMasks" it also has (types with none
+    of them come last), and then by index. The front is the type to use, and the rest are the fallbacks in order.
+*/
+std::vector<uint32_t> getMemoryTypes(const vk::PhysicalDeviceMemoryProperties &memProps, const uint32_t typeBits,
+                                     const vk::MemoryPropertyFlags reqMask,
+                                     const std::vector<vk::MemoryPropertyFlags> &prefMasks = {});
+
+/*  Memory type preferences for host visible memory that the host writes, and the device reads. "deviceLocal" puts device
+    local memory (the BAR heap on discrete cards) first so the device doesn't read across the bus, then comes cached
+    memory. Coherent memory wins a tie, but isn't needed if the writes are flushed.
+*/
+const std::vector<vk::MemoryPropertyFlags> &getHostWritePreferences(const bool deviceLocal);
+
+// A device memory allocation that is split up by a Tlsf.
+struct Block {
+    Block(const uint32_t poolIndex, const vk::DeviceSize size) : poolIndex(poolIndex), tlsf(size) {}
+    uint32_t poolIndex;
+    vk::DeviceMemory memory;
+    vk::MemoryPropertyFlags propertyFlags;
+    uint8_t *pMappedData = nullptr;
+    Tlsf tlsf;
+};
+
+struct Allocation {
+    vk::DeviceMemory memory;
+    vk::DeviceSize offset = 0;
+    vk::DeviceSize size = 0;
+    vk::MemoryPropertyFlags propertyFlags;
+    void *pMappedData = nullptr;  // host visible memory is always mapped
+    Block *pBlock = nullptr;      // nullptr for a dedicated allocation
+};
+
+struct Stats {
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t dedicatedAllocationCount = 0;
+    uint32_t freeRangeCount = 0;
+    vk::DeviceSize totalSize = 0;  // of the blocks
+    vk::DeviceSize usedSize = 0;   // of the blocks
+    vk::DeviceSize largestFreeRange = 0;
+    vk::DeviceSize dedicatedSize = 0;
+
+    // Fraction of the block memory that is in use.
+    inline float utilization() const { return totalSize ? static_cast<float>(usedSize) / totalSize : 0.0f; }
+    // 0 when the free memory is one range, approaching 1 the more it is split up.
+    inline float fragmentation() const {
+        auto freeSize = totalSize - usedSize;
+        return freeSize ? 1.0f - static_cast<float>(largestFreeRange) / freeSize : 0.0f;
+    }
+};
+
+/*  Device memory is allocated in large blocks per memory type, and buffers and images are placed in the blocks with a
+    Tlsf each, instead of an allocateMemory call per resource ("maxMemoryAllocationCount" can be as low as 4096).
+    Resources larger than half a block get a dedicated allocation. If "bufferImageGranularity" is larger than 1, linear
+    (buffers, linear images) and optimal resources are kept in separate blocks so they never share a granularity page.
+    If the heap can't fit a new block, smaller ones are tried down to the size of the resource, and then the next memory
+    type.
+*/
+class Allocator {
+   public:
+    static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+    Allocator();
+
+    void init(const vk::Device &dev, const vk::PhysicalDeviceMemoryProperties &memProps,
+              const vk::PhysicalDeviceLimits &limits, const vk::AllocationCallbacks *pAllocator,
+              const vk::DeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+    void destroy();
+
+    // thread safe. If the preferred memory type's heap is out of memory the next type of "getMemoryTypes" is tried.
+    Allocation allocate(const vk::MemoryRequirements &memReqs, const vk::MemoryPropertyFlags reqMask, const bool linear,
+                        const std::vector<vk::MemoryPropertyFlags> &prefMasks = {});
+    void free(Allocation &allocation);
+    Stats getStats() const;
+
+    // A range of the allocation widened to "nonCoherentAtomSize" for flushMappedMemoryRanges or
+    // invalidateMappedMemoryRanges.
+    vk::MappedMemoryRange getMappedRange(const Allocation &allocation, const vk::DeviceSize offset = 0,
+                                         const vk::DeviceSize size = VK_WHOLE_SIZE) const;
+    // Both do nothing for host coherent memory.
+    void flush(const Allocation &allocation, const vk::DeviceSize offset = 0,
+               const vk::DeviceSize size = VK_WHOLE_SIZE) const;
+    void invalidate(const Allocation &allocation, const vk::DeviceSize offset = 0,
+                    const vk::DeviceSize size = VK_WHOLE_SIZE) const;
+
+   private:
+    struct Pool {
+        uint32_t memoryTypeIndex;
+        vk::DeviceSize blockSize;
+        std::vector<std::unique_ptr<Block>> blocks;
+    };
+
+    Allocation allocate(const uint32_t memoryTypeIndex, const vk::MemoryRequirements &memReqs, const bool linear);
+    Pool &getPool(const uint32_t memoryTypeIndex, const bool linear);
+    Block &createBlock(Pool &pool, const vk::DeviceSize minSize);
+    void destroyBlock(Block &block);
+    vk::DeviceMemory allocateMemory(const uint32_t memoryTypeIndex, const vk::DeviceSize size, void *&pMappedData);
+
+    vk::Device dev_;
+    vk::PhysicalDeviceMemoryProperties memProps_;
+    const vk::AllocationCallbacks *pAllocator_;
+    vk::DeviceSize blockSize_;
+    vk::DeviceSize bufferImageGranularity_;
+    vk::DeviceSize nonCoherentAtomSize_;
+
+    mutable std::mutex mutex_;
+    std::vector<Pool> pools_;
+    uint32_t dedicatedAllocationCount_;
+    vk::DeviceSize dedicatedSize_;
+};
+
+}  // namespace Memory
+
+#endif  // !MEMORY_ALLOCATOR_H
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace helpers {
+
+/*  Runs "func(begin, end)" over [0, count) split into one range per thread ("threadCount", or one per hardware thread if
+    it is 0). The calling thread does the first range, and the call returns when all of them are done. Callers keep
+    their results independent of the split, so any thread count gives the same output.
+*/
+template <typename TIndex, typename TFunc>
+void parallelFor(const TIndex count, uint32_t threadCount, TFunc &&func) {
+    if (count <= 0) return;
+    if (threadCount == 0) threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+    const auto rangeCount = static_cast<TIndex>((std::min)(uint64_t(threadCount), static_cast<uint64_t>(count)));
+    const TIndex rangeSize = (count + rangeCount - 1) / rangeCount;
+
+    std::vector<std::future<void>> futures;
+    for (TIndex begin = rangeSize; begin < count; begin += rangeSize)
+        futures.emplace_back(std::async(std::launch::async, func, begin, (std::min)(begin + rangeSize, count)));
+    func(TIndex(0), (std::min)(rangeSize, count));
+    for (auto &future : futures) future.get();
+}
+
+}  // namespace helpers
+
+#endif  // !PARALLEL_H
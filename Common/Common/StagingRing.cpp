@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "StagingRing.h"
+
+#include "Context.h"
+#include "Helpers.h"
+
+StagingRing::StagingRing() : offsets_(), buffer_(), allocation_(), pMappedData_(nullptr) {}
+
+void StagingRing::init(const Context &ctx, const vk::DeviceSize size) {
+    assert(!buffer_ && "Staging ring was already initialized");
+    offsets_.reset(size);
+
+    helpers::createBuffer(ctx.dev, size, vk::BufferUsageFlagBits::eTransferSrc,
+                          vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                          ctx.memAllocator, buffer_, allocation_, ctx.pAllocator);
+    pMappedData_ = static_cast<uint8_t *>(allocation_.pMappedData);
+}
+
+void StagingRing::destroy(const Context &ctx) {
+    if (buffer_) ctx.dev.destroyBuffer(buffer_, ctx.pAllocator);
+    ctx.memAllocator.free(allocation_);
+    buffer_ = vk::Buffer();
+    pMappedData_ = nullptr;
+    offsets_.reset(0);
+}
+
+bool StagingRing::allocate(const vk::DeviceSize size, const vk::DeviceSize alignment, Allocation &allocation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!buffer_) return false;
+
+    if (!offsets_.allocate(size, alignment, allocation.offset, allocation.ticket)) return false;
+    allocation.buffer = buffer_;
+    allocation.pData = pMappedData_ + allocation.offset;
+    return true;
+}
+
+void StagingRing::release(const uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    offsets_.release(ticket);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef STAGING_RING_H
+#define STAGING_RING_H
+
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <vulkan/vulkan.hpp>
+
+#include "MemoryAllocator.h"
+
+class Context;
+
+/*  One persistently mapped buffer that uploads are staged in, instead of a staging buffer and memory allocation per
+    upload. Space is handed out in order, and wraps around to the front when the end is reached. Every allocation has a
+    ticket that is released once the device is done with it (see Loading::Handler), and the space is reclaimed in order
+    as the oldest tickets are released. If there isn't room "allocate" fails, and the caller should fall back to a
+    dedicated staging buffer.
+*/
+class StagingRing {
+   public:
+    // Nothing requires an alignment for buffer copies, this just keeps the memcpy destinations aligned.
+    static constexpr vk::DeviceSize BUFFER_ALIGNMENT = 16;
+    // Buffer to image copies need an offset that is a multiple of 4 and of the texel block size. 48 is a multiple of
+    // all the uncompressed texel sizes (including the 12 byte three component 32 bit formats).
+    static constexpr vk::DeviceSize IMAGE_ALIGNMENT = 48;
+
+    struct Allocation {
+        uint64_t ticket;
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+        void *pData;
+    };
+
+    // The offset, and ticket bookkeeping of the ring without the buffer, so it doesn't need a device.
+    class Offsets {
+       public:
+        inline vk::DeviceSize getSize() const { return size_; }
+        // Allocations that aren't reclaimed yet.
+        inline size_t getPendingCount() const { return entries_.size(); }
+
+        void reset(const vk::DeviceSize size) {
+            size_ = size;
+            head_ = tail_ = 0;
+            frontTicket_ = 0;
+            entries_.clear();
+        }
+
+        // Returns false if there isn't room (overflow), or "size" is larger than the ring.
+        bool allocate(const vk::DeviceSize size, const vk::DeviceSize alignment, vk::DeviceSize &offset,
+                      uint64_t &ticket) {
+            if (!allocateOffset(size, alignment, offset)) return false;
+            ticket = frontTicket_ + entries_.size();
+            entries_.push_back({offset + size, false});
+            head_ = offset + size;
+            return true;
+        }
+
+        // Reclaims from the oldest allocation until one is still in use.
+        void release(const uint64_t ticket) {
+            assert(ticket >= frontTicket_ && ticket - frontTicket_ < entries_.size() && "Unknown staging ticket");
+            entries_[ticket - frontTicket_].released = true;
+            while (!entries_.empty() && entries_.front().released) {
+                tail_ = entries_.front().end;
+                entries_.pop_front();
+                frontTicket_++;
+            }
+            if (entries_.empty()) head_ = tail_ = 0;
+        }
+
+       private:
+        struct Entry {
+            vk::DeviceSize end;
+            bool released;
+        };
+
+        bool allocateOffset(const vk::DeviceSize size, const vk::DeviceSize alignment, vk::DeviceSize &offset) const {
+            assert(size > 0 && alignment > 0);
+            if (size > size_) return false;  // overflow
+
+            if (entries_.empty()) {
+                offset = 0;
+                return true;
+            }
+
+            offset = ((head_ + alignment - 1) / alignment) * alignment;
+            if (head_ > tail_) {
+                // In use: [tail, head). Try the end, and then wrap around to the front.
+                if (offset + size <= size_) return true;
+                offset = 0;
+            }
+            // In use: [tail, end) and [0, head). Stop short of the tail so head == tail only means empty.
+            return offset + size < tail_;
+        }
+
+        vk::DeviceSize size_ = 0;
+        vk::DeviceSize head_ = 0;  // end of the newest allocation
+        vk::DeviceSize tail_ = 0;  // start of the oldest allocation that isn't reclaimed
+        uint64_t frontTicket_ = 0;
+        std::deque<Entry> entries_;  // allocations that aren't reclaimed, oldest first
+    };
+
+    StagingRing();
+
+    void init(const Context &ctx, const vk::DeviceSize size);
+    void destroy(const Context &ctx);
+
+    // thread safe
+    bool allocate(const vk::DeviceSize size, const vk::DeviceSize alignment, Allocation &allocation);
+    void release(const uint64_t ticket);
+
+    inline vk::DeviceSize getSize() const { return offsets_.getSize(); }
+
+   private:
+    std::mutex mutex_;
+    Offsets offsets_;  // used with the mutex locked
+
+    vk::Buffer buffer_;
+    Memory::Allocation allocation_;
+    uint8_t *pMappedData_;
+};
+
+#endif  // !STAGING_RING_H
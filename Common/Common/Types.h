@@ -15,7 +15,10 @@
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include "MemoryAllocator.h"
+
 enum class QUEUE;
+class StagingRing;
 
 enum class MODEL_FILE_TYPE {
     //
@@ -86,14 +89,14 @@ class NonCopyable {
 
 struct BufferResource {
     vk::Buffer buffer;
-    vk::DeviceMemory memory;
+    Memory::Allocation allocation;
     vk::MemoryRequirements memoryRequirements;
 };
 
 struct ImageResource {
     vk::Format format;
     vk::Image image;
-    vk::DeviceMemory memory;
+    Memory::Allocation allocation;
     vk::ImageView view;
 };
 
@@ -101,6 +104,8 @@ struct LoadingResource {
     bool shouldWait = false;
     vk::CommandBuffer graphicsCmd, transferCmd;
     std::vector<BufferResource> stgResources;
+    StagingRing *pStagingRing = nullptr;
+    std::vector<uint64_t> stagingTickets;
     std::vector<vk::Fence> fences;
     vk::Semaphore semaphore;
 };
@@ -148,6 +153,9 @@ struct SubmitResource {
     std::array<vk::CommandBuffer, size> commandBuffers = {};
     uint32_t signalSemaphoreCount = 0;
     std::array<vk::Semaphore, size> signalSemaphores = {};
+    // Timeline semaphore values (ignored for binary semaphores)
+    std::array<uint64_t, size> waitSemaphoreValues = {};
+    std::array<uint64_t, size> signalSemaphoreValues = {};
     QUEUE queueType;
     void resetCount() {
         waitSemaphoreCount = 0;
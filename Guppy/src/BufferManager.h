@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 #define DIAGNOSE false
@@ -17,8 +18,11 @@
 
 #include <Common/Context.h>
 #include <Common/Helpers.h>
+#include <Common/StagingRing.h>
+#include <Common/Types.h>
 
 #include "BufferItem.h"
+#include "BufferPages.h"
 #include "Shell.h"
 
 namespace Buffer {
@@ -27,10 +31,17 @@ namespace Manager {
 template <typename T>
 class Data {
    public:
-    Data(vk::DeviceSize maxSize, vk::DeviceSize alignment)  //
-        : TOTAL_SIZE(maxSize * alignment), ALIGNMENT(alignment) {
+    Data(vk::DeviceSize size, vk::DeviceSize alignment)  //
+        : TOTAL_SIZE(size * alignment), ALIGNMENT(alignment) {
         pData_ = (uint8_t *)std::calloc(1, TOTAL_SIZE);
     }
+    // The items point into the data, so it is moved (when "resources_" grows) and never copied.
+    Data(Data &&other) noexcept : TOTAL_SIZE(other.TOTAL_SIZE), ALIGNMENT(other.ALIGNMENT), pData_(other.pData_) {
+        other.pData_ = nullptr;
+    }
+    Data(const Data &) = delete;
+    Data &operator=(const Data &) = delete;
+    ~Data() { std::free(pData_); }
 
     const vk::DeviceSize TOTAL_SIZE;
     const vk::DeviceSize ALIGNMENT;
@@ -57,58 +68,68 @@ class Data {
     uint8_t *pData_;
 };
 
+// A page of the manager. Its slots are handed out by Base's "Pages".
 template <typename T>
 struct Resource {
    public:
-    Resource(vk::DeviceSize totalSize, vk::DeviceSize alignment)
+    Resource(vk::DeviceSize size, vk::DeviceSize alignment)
         : buffer(),
-          currentOffset(),
-          memory(),
+          allocation(),
           memoryRequirements(),
-          pMappedData(nullptr),
-          data(std::forward<vk::DeviceSize>(totalSize), std::forward<vk::DeviceSize>(alignment)) {}
+          data(std::forward<vk::DeviceSize>(size), std::forward<vk::DeviceSize>(alignment)) {}
     vk::Buffer buffer;
-    vk::DeviceSize currentOffset;
-    vk::DeviceMemory memory;
+    Ranges dirtyRanges;  // slots to copy to the mapped memory on the next "Base::flush"
+    Memory::Allocation allocation;  // always mapped
     vk::MemoryRequirements memoryRequirements;
-    void *pMappedData;
     Buffer::Manager::Data<T> data;
 };
 
 template <class TBase, class TDerived, template <typename> class TSmartPointer>
 class Base {
    public:
-    /*  Last I checked, forcing a "const maxSize" here is very important unless a proper
-        allocator is written. The mapped memory, and the info objects that are handed out
-        will be invalidated if there is a vector resize operation. So, for now I am just
-        setting a max size, adding asserts that I don't request anything over the original
-        allocation amount, and then recommend just increasing the max size... until I
-        write the allocation code.
+    /*  The manager is paged. "pageSize" is the slot count of each buffer (page) that is created. The first page is
+        created in "init", and the rest only when an insert doesn't fit in the pages that exist, so the memory follows
+        the real usage instead of a worst case. Pages are never moved or freed before "destroy", so the mapped memory,
+        and the info objects that are handed out stay valid: "Buffer::Info::resourcesOffset" is the page, and
+        "Buffer::Info::dataOffset" the slot in it (the buffer, and memory offset in the info are the page's).
+
+        "properties" are the memory properties the pages require. On top of those "getMemoryPreferences" is
+        used to pick the memory type. The pages are mapped for their whole lifetime. If "properties" aren't host
+        visible the pages are mostly written by the device (ex. compute shader output): they go in device local memory,
+        and aren't mapped. What the host writes to them ("updateData", inserts) is copied with "upload".
     */
-    Base(const std::string &&name, const vk::DeviceSize &&maxSize, const bool &&keepMapped,
-         const vk::BufferUsageFlags &&usage, const vk::MemoryPropertyFlags &&properties,
-         const vk::SharingMode &&sharingMode = vk::SharingMode::eExclusive, const vk::BufferCreateFlags &&flags = {})
+    Base(const std::string &&name, const vk::DeviceSize &&pageSize, const vk::BufferUsageFlags &&usage,
+         const vk::MemoryPropertyFlags &&properties, const vk::SharingMode &&sharingMode = vk::SharingMode::eExclusive,
+         const vk::BufferCreateFlags &&flags = {}, const bool &&deferFlush = false)
         : NAME(name),
-          MAX_SIZE(maxSize),
-          KEEP_MAPPED(keepMapped),
+          PAGE_SIZE(pageSize),
           USAGE(usage),
           PROPERTIES(properties),
           MODE(sharingMode),
           FLAGS(flags),
-          alignment_(sizeof(typename TDerived::DATA)) {}
+          DEFER_FLUSH(deferFlush),
+          alignment_(sizeof(typename TDerived::DATA)),
+          pContext_(nullptr),
+          atomSize_(1),
+          flushedFrameIndex_(UINT8_MAX) {}
 
     const std::string NAME;
-    const vk::DeviceSize MAX_SIZE;
-    const bool KEEP_MAPPED;
+    const vk::DeviceSize PAGE_SIZE;
     const vk::BufferUsageFlags USAGE;
     const vk::MemoryPropertyFlags PROPERTIES;
     const vk::SharingMode MODE;
     const vk::BufferCreateFlags FLAGS;
+    // If set "updateData" only marks the item's slots dirty, and the owner calls "flush" once a frame. Inserts are
+    // still copied right away.
+    const bool DEFER_FLUSH;
 
     virtual void init(const Context &ctx, std::vector<uint32_t> queueFamilyIndices = {}) {
         reset(ctx);
+        pContext_ = &ctx;
         queueFamilyIndices_ = queueFamilyIndices;
-        createBuffer(ctx);
+        pages_.setFrameCount(ctx.imageCount);
+        atomSize_ = ctx.physicalDevProps[ctx.physicalDevIndex].properties.limits.nonCoherentAtomSize;
+        createBuffer(ctx, PAGE_SIZE);
     }
 
 #if DIAGNOSE
@@ -121,68 +142,129 @@ class Base {
 
     template <typename TCreateInfo>
     TDerived *insert(const vk::Device &dev, TCreateInfo *pCreateInfo) {
-        assert(pItems.size() < MAX_SIZE);
         auto info = fill(dev, std::vector<typename TDerived::DATA>(pCreateInfo->dataCount), pCreateInfo->countInRange);
         diagnose(info);
         pItems.emplace_back(new TDerived(std::move(info), get(info), pCreateInfo));
-        if (pCreateInfo == nullptr || pCreateInfo->update) updateData(dev, pItems.back()->BUFFER_INFO);
+        if (pCreateInfo == nullptr || pCreateInfo->update) insertData(dev, pItems.back()->BUFFER_INFO);
         return static_cast<TDerived *>(pItems.back().get());
     }
 
     TDerived *insert(const vk::Device &dev, bool update = true,
                      const std::vector<typename TDerived::DATA> &data = std::vector<typename TDerived::DATA>(1)) {
-        assert(pItems.size() < MAX_SIZE);
         auto info = fill(dev, data, false);
         diagnose(info);
         pItems.emplace_back(new TDerived(std::move(info), get(info)));
-        if (update) updateData(dev, pItems.back()->BUFFER_INFO);
+        if (update) insertData(dev, pItems.back()->BUFFER_INFO);
         return static_cast<TDerived *>(pItems.back().get());
     }
 
+    /*  Frees the slots of the item for the next inserts. The item is released (its "pItems" element is left null, so
+        the item offsets of the other items don't change, and anything going through "pItems" has to skip it), and
+        anything still holding it, or using its buffer info, has to let go. The frames in flight can still read the
+        slots, so they are only reused once "flush" was called for as many frames as there are swapchain images.
+        Nothing in the engine removes items yet (the owners release everything at once with "destroy"), so for now
+        the reuse is only reachable through this call. Mesh::Handler::removeMesh is where mesh instance data would go.
+    */
+    void remove(const Buffer::Info info) {
+        assert(hasItem(info.itemOffset) && "Item was already removed");
+        pItems[info.itemOffset] = nullptr;
+        pages_.free(info.resourcesOffset, info.dataOffset, info.count);
+    }
+
+    // If index is set only that slot of the item is updated.
     void updateData(const vk::Device &dev, const Buffer::Info &info, const int index = -1) {
+        assert(hasItem(info.itemOffset) && "Item was removed");
         if (pItems[info.itemOffset]->dirty) {
-            updateMappedMemory(dev, info, index);
+            auto &resource = resources_[info.resourcesOffset];
+            if (index == -1)
+                resource.dirtyRanges.add(info.dataOffset, info.count);
+            else
+                resource.dirtyRanges.add(info.dataOffset + index, 1);
             pItems[info.itemOffset]->dirty = false;
+            if (!DEFER_FLUSH && isHostVisible()) copyDirtyRanges(dev);
         }
     }
 
-    TDerived &getTypedItem(const uint32_t &index) { return std::ref(*static_cast<TDerived *>(pItems.at(index).get())); }
+    /*  Called once a frame by the owner, after the frame's fence was waited on, and after the frame's updates. It
+        copies the dirty slots to the mapped memory, and a new "frameIndex" brings the slots of removed items a frame
+        closer to being reused. Calling it again in the same frame only copies what was dirtied since.
+    */
+    void flush(const vk::Device &dev, const uint8_t frameIndex) {
+        assert(isHostVisible() && "Device local pages are written with \"upload\"");
+        // There is only a frame index to compare with more than one swapchain image.
+        if (frameIndex != flushedFrameIndex_ || pContext_->imageCount == 1) pages_.nextFrame();
+        flushedFrameIndex_ = frameIndex;
+        copyDirtyRanges(dev);
+    }
+
+    /*  Copies what the host wrote to device local pages from the staging ring of "ldgRes" (a copy command per dirty
+        run). The owner submits "ldgRes" with Loading::Handler.
+    */
+    void upload(LoadingResource &ldgRes) {
+        assert(!isHostVisible() && "Host visible pages are written with \"flush\"");
+        for (auto &resource : resources_) {
+            for (const auto &[offset, count] : resource.dirtyRanges.get()) {
+                const auto range = count * alignment_;
+                vk::Buffer stgBuffer;
+                vk::DeviceSize stgOffset;
+                auto pData = pContext_->stage(ldgRes, range, StagingRing::BUFFER_ALIGNMENT, stgBuffer, stgOffset);
+                memcpy(pData, &resource.data.get(offset), static_cast<size_t>(range));
+                ldgRes.transferCmd.copyBuffer(stgBuffer, resource.buffer,
+                                              vk::BufferCopy{stgOffset, offset * alignment_, range});
+            }
+            resource.dirtyRanges.clear();
+        }
+    }
+
+    /*  Pages up to this size can go in the BAR heap (device local, host visible memory). Without resizable BAR it is
+        only 256MB, so it is kept for the small data the host writes every frame (uniforms, materials, ...), and bigger
+        pages go in host memory.
+    */
+    static constexpr vk::DeviceSize BAR_PAGE_SIZE_LIMIT = 1024 * 1024;
+
+    /*  Host visible memory is always required, so anything else is a preference (Memory::getHostWritePreferences):
+        device local memory for pages up to "BAR_PAGE_SIZE_LIMIT", then cached memory. Coherent memory wins a tie, but
+        isn't needed since "flush" flushes the ranges of memory that isn't.
+    */
+    static const std::vector<vk::MemoryPropertyFlags> &getMemoryPreferences(const vk::DeviceSize size) {
+        return Memory::getHostWritePreferences(size <= BAR_PAGE_SIZE_LIMIT);
+    }
+
+    // False if the item was removed.
+    inline bool hasItem(const uint32_t index) const { return index < pItems.size() && pItems[index]; }
+    TDerived &getTypedItem(const uint32_t &index) {
+        assert(hasItem(index) && "Item was removed");
+        return std::ref(*static_cast<TDerived *>(pItems.at(index).get()));
+    }
 
     void destroy(const Context &ctx) {
         reset(ctx);
         pItems.clear();
     }
 
-    std::vector<TSmartPointer<TBase>> pItems;  // TODO: public?
+    std::vector<TSmartPointer<TBase>> pItems;  // Removed items are null. TODO: public?
 
    protected:
     virtual void setInfo(Buffer::Info &info){};
 
     Buffer::Info fill(const vk::Device &dev, const std::vector<typename TDerived::DATA> data, const bool countInRange) {
         assert(resources_.size() && "Did you initialize the manager?");
-        auto &resource = resources_.back();
-
-        bool isValid = true;
-        isValid = !data.empty();
-        assert(isValid && "\"data\" cannot be empty.");
-        isValid &= ((resource.currentOffset + data.size()) * alignment_) <= resource.data.TOTAL_SIZE;
-        assert(isValid && "Either increase the max size, or figure out how to grow the \"resources_\".");
-        // TODO: other validation? also, does above make any sense?
+        assert(!data.empty() && "\"data\" cannot be empty.");
 
         Buffer::Info info = {};
+        allocate(data.size(), info.resourcesOffset, info.dataOffset);
+        auto &resource = resources_[info.resourcesOffset];
+
         info.bufferInfo.buffer = resource.buffer;
         info.bufferInfo.range = countInRange ? alignment_ * data.size() : alignment_;
         // Note: The offset for descriptor buffer info is 0 for a dynamic buffer. This
         // is overriden in "Descriptor::Manager::setInfo".
-        info.memoryOffset = info.bufferInfo.offset = alignment_ * resource.currentOffset;
-        info.resourcesOffset = resources_.size() - 1;
-        info.dataOffset = resource.currentOffset;
+        info.memoryOffset = info.bufferInfo.offset = alignment_ * info.dataOffset;
         // TODO: putting this here could be super confusing. It relies on the update
         // functions to create a new item.
         info.itemOffset = static_cast<uint32_t>(pItems.size());
 
-        resource.data.set(resource.currentOffset, data);
-        resource.currentOffset += data.size();
+        resource.data.set(info.dataOffset, data);
         info.count = static_cast<uint32_t>(data.size());
         assert(info.count > 0);
 
@@ -195,48 +277,81 @@ class Base {
     vk::DeviceSize alignment_;
 
    private:
-    // TODO: change the caller so that all the memory can be updated at once.
-    void updateMappedMemory(const vk::Device &dev, const Buffer::Info &info, const int index) {
-        auto &resource = resources_[info.resourcesOffset];
-
-        // If the index was set offset into both memory pointers.
-        auto memoryOffset = info.memoryOffset + ((index == -1) ? 0 : (index * resource.data.ALIGNMENT));
-        auto dataOffset = info.dataOffset + ((index == -1) ? 0 : index);
+    // New items are copied right away even if the flush is deferred, because they can be used before the owner's
+    // next "flush" (ex. by compute work submitted in a tick).
+    void insertData(const vk::Device &dev, const Buffer::Info &info) {
+        updateData(dev, info);
+        if (isHostVisible()) copyDirtyRanges(dev);
+    }
 
-        auto pData = static_cast<uint8_t *>(resource.pMappedData) + memoryOffset;
-        // If index is not set copy the entire range for the item.
-        vk::DeviceSize range = (index == -1) ? (info.count * resource.data.ALIGNMENT) : resource.data.ALIGNMENT;
+    /*  Copies the dirty slots of all the pages to the mapped memory. The dirty ranges are coalesced, so this is one
+        memcpy per run of dirty slots. If the memory isn't coherent the runs are widened to "nonCoherentAtomSize",
+        and merged again, for one "flushMappedMemoryRanges" call per page.
+    */
+    void copyDirtyRanges(const vk::Device &dev) {
+        for (auto &resource : resources_) {
+            if (resource.dirtyRanges.empty()) continue;
+
+            const auto &allocation = resource.allocation;
+            const bool isCoherent = static_cast<bool>(allocation.propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+            Ranges flushRanges;  // bytes of the device memory
+            for (const auto &[offset, count] : resource.dirtyRanges.get()) {
+                auto memoryOffset = offset * alignment_;
+                auto range = count * alignment_;
+                auto pData = static_cast<uint8_t *>(allocation.pMappedData) + memoryOffset;
+                memcpy(pData, &resource.data.get(offset), static_cast<size_t>(range));
+                if (!isCoherent) flushRanges.addAligned(allocation.offset + memoryOffset, range, atomSize_);
+            }
+            if (!flushRanges.empty()) {
+                std::vector<vk::MappedMemoryRange> memoryRanges;
+                for (const auto &[begin, size] : flushRanges.get()) {
+                    // Back to the allocation. "getMappedRange" widens it the same way, and clamps it to the memory.
+                    const auto allocationBegin = (std::max)(begin, allocation.offset);
+                    const auto allocationEnd = (std::min)(begin + size, allocation.offset + allocation.size);
+                    memoryRanges.push_back(pContext_->memAllocator.getMappedRange(
+                        allocation, allocationBegin - allocation.offset, allocationEnd - allocationBegin));
+                }
+                dev.flushMappedMemoryRanges(memoryRanges);
+            }
+            resource.dirtyRanges.clear();
+        }
+    }
 
-        if (KEEP_MAPPED) {
-            memcpy(pData, &resource.data.get(dataOffset), range);
-        } else {
-            // TODO: Only map the region that is being copied???
-            resource.pMappedData = dev.mapMemory(resource.memory, 0, resource.memoryRequirements.size);
+    inline bool isHostVisible() const { return static_cast<bool>(PROPERTIES & vk::MemoryPropertyFlagBits::eHostVisible); }
 
-            memcpy(pData, &resource.data.get(dataOffset), range);
-            dev.unmapMemory(resource.memory);
-        }
+    // Finds "count" contiguous slots (Pages::allocate), or makes a new page for them. A page is only bigger than
+    // "PAGE_SIZE" if it is made for an item that doesn't fit in one.
+    void allocate(const vk::DeviceSize count, vk::DeviceSize &resourcesOffset, vk::DeviceSize &dataOffset) {
+        if (pages_.allocate(count, resourcesOffset, dataOffset)) return;
+        assert(pContext_ != nullptr);
+        createBuffer(*pContext_, (std::max)(PAGE_SIZE, count));
+        const bool isAllocated = pages_.allocate(count, resourcesOffset, dataOffset);
+        assert(isAllocated);
     }
 
     void reset(const Context &ctx) {
         for (auto &resource : resources_) {
-            if (KEEP_MAPPED) ctx.dev.unmapMemory(resource.memory);
             ctx.dev.destroyBuffer(resource.buffer, ctx.pAllocator);
-            ctx.dev.freeMemory(resource.memory, ctx.pAllocator);
+            ctx.memAllocator.free(resource.allocation);
         }
+        resources_.clear();
+        pages_.clear();
     }
 
-    void createBuffer(const Context &ctx) {
-        resources_.push_back({MAX_SIZE, alignment_});
+    void createBuffer(const Context &ctx, const vk::DeviceSize size) {
+        resources_.emplace_back(size, alignment_);
+        pages_.add(size);
         auto &resource = resources_.back();
 
-        // TODO: I FORGOT TO USE A STAGING BUFFER HERE TO SPEED THIS UP!!!
+        // Host visible pages aren't staged. They are persistently mapped, and the small ones are in device local host
+        // visible memory, so the per frame writes go straight to memory the device reads quickly. Staging would only
+        // add a copy. Device local pages are staged by "upload".
 
         // CREATE BUFFER
 
         vk::BufferCreateInfo createInfo = {};
         createInfo.flags = FLAGS;
-        createInfo.size = MAX_SIZE * alignment_;
+        createInfo.size = size * alignment_;
         createInfo.usage = USAGE;
         createInfo.sharingMode = vk::SharingMode::eExclusive;
         createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilyIndices_.size());
@@ -249,31 +364,26 @@ class Base {
         assert(resource.memoryRequirements.size == createInfo.size &&
                "Figure out how to deal with this! (\"range\" of add)");
 
-        vk::MemoryAllocateInfo allocInfo;
-        allocInfo.setAllocationSize(resource.memoryRequirements.size);
-        auto pass = helpers::getMemoryType(ctx.memProps, resource.memoryRequirements.memoryTypeBits, PROPERTIES,
-                                           &allocInfo.memoryTypeIndex);
-        assert(pass && "No mappable, coherent memory");
-
-        resource.memory = ctx.dev.allocateMemory(allocInfo, ctx.pAllocator);
-
-        // MAP MEMORY
-
-        // TODO: why doesn't below work WWWWTTTTTTFFFFFFFFFFF!!!!!!
-        // auto pData = resource.data.data();
-        //  resource.pMappedData = ctx.dev.mapMemory(resource.memory, 0, memReqs.size);
-        resource.pMappedData = ctx.dev.mapMemory(resource.memory, 0, resource.memoryRequirements.size);
-
-        /*  Copying all the memory here is probably a redunant init step. The way its written now,
-            each item will do a memcpy if dirty after creation. Maybe just make that a necessary step,
-            and leave the rest of the buffer garbage.
-        */
-        memcpy(resource.pMappedData, resource.data.data(), static_cast<size_t>(resource.memoryRequirements.size));
-        if (!KEEP_MAPPED) ctx.dev.unmapMemory(resource.memory);
+        // Host visible memory is mapped by the allocator.
+        if (isHostVisible()) {
+            resource.allocation = ctx.memAllocator.allocate(resource.memoryRequirements, PROPERTIES, true,
+                                                            getMemoryPreferences(createInfo.size));
+            assert(resource.allocation.pMappedData && "No mappable memory");
+
+            /*  Copying all the memory here is probably a redunant init step. The way its written now,
+                each item will do a memcpy if dirty after creation. Maybe just make that a necessary step,
+                and leave the rest of the buffer garbage.
+            */
+            memcpy(resource.allocation.pMappedData, resource.data.data(),
+                   static_cast<size_t>(resource.memoryRequirements.size));
+            ctx.memAllocator.flush(resource.allocation);
+        } else {
+            resource.allocation = ctx.memAllocator.allocate(resource.memoryRequirements, PROPERTIES, true);
+        }
 
         // BIND MEMORY
 
-        ctx.dev.bindBufferMemory(resource.buffer, resource.memory, 0);
+        ctx.dev.bindBufferMemory(resource.buffer, resource.allocation.memory, resource.allocation.offset);
         std::string markerName = NAME + " block (" + std::to_string(resources_.size()) + ")";
         // ctx.dbg.setMarkerName(resource.buffer, markerName.c_str());
         // ctx.dbg.setMarkerTag(resource.buffer, markerName.c_str(), tag);
@@ -283,8 +393,12 @@ class Base {
         return &resources_[info.resourcesOffset].data.get(info.dataOffset);
     }
 
+    const Context *pContext_;
     std::vector<uint32_t> queueFamilyIndices_;
     std::vector<Manager::Resource<typename TDerived::DATA>> resources_;
+    Pages pages_;  // one per resource
+    vk::DeviceSize atomSize_;
+    uint8_t flushedFrameIndex_;
 };
 
 }  // namespace Manager
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef BUFFER_PAGES_H
+#define BUFFER_PAGES_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Buffer {
+namespace Manager {
+
+// Sorted (offset, count) ranges of slots (or bytes). Ranges that touch, or overlap are merged when added.
+class Ranges {
+   public:
+    using range = std::pair<vk::DeviceSize, vk::DeviceSize>;
+
+    inline bool empty() const { return ranges_.empty(); }
+    inline void clear() { ranges_.clear(); }
+    inline const std::vector<range> &get() const { return ranges_; }
+
+    void add(const vk::DeviceSize offset, const vk::DeviceSize count) {
+        assert(count > 0);
+        auto it = std::lower_bound(ranges_.begin(), ranges_.end(), range{offset, count});
+        // Merge with the previous range...
+        if (it != ranges_.begin() && std::prev(it)->first + std::prev(it)->second >= offset) {
+            --it;
+            it->second = (std::max)(it->first + it->second, offset + count) - it->first;
+        } else {
+            it = ranges_.insert(it, {offset, count});
+        }
+        // ... and the ones that follow.
+        auto itNext = std::next(it);
+        while (itNext != ranges_.end() && it->first + it->second >= itNext->first) {
+            it->second = (std::max)(it->first + it->second, itNext->first + itNext->second) - it->first;
+            itNext = ranges_.erase(itNext);
+        }
+    }
+
+    // Adds the range widened to multiples of "alignment" (ex. "nonCoherentAtomSize" for "flushMappedMemoryRanges").
+    void addAligned(const vk::DeviceSize offset, const vk::DeviceSize count, const vk::DeviceSize alignment) {
+        assert(alignment > 0);
+        const auto begin = offset / alignment * alignment;
+        const auto end = (offset + count + alignment - 1) / alignment * alignment;
+        add(begin, end - begin);
+    }
+
+    // Removes "count" slots from the first range that is big enough.
+    bool take(const vk::DeviceSize count, vk::DeviceSize &offset) {
+        for (auto it = ranges_.begin(); it != ranges_.end(); ++it) {
+            if (it->second < count) continue;
+            offset = it->first;
+            it->first += count;
+            it->second -= count;
+            if (it->second == 0) ranges_.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+   private:
+    std::vector<range> ranges_;
+};
+
+/*  The slot bookkeeping of Base's pages without the buffers, so it doesn't need a device. Slots are handed out from
+    the ranges freed in any page (first fit), then from the end of the last page. Freed slots can still be read by the
+    frames in flight, so they are only handed out again after "frameCount" calls to "nextFrame".
+*/
+class Pages {
+   public:
+    struct Page {
+        vk::DeviceSize size;           // slot count
+        vk::DeviceSize currentOffset;  // slots after this were never handed out
+        Ranges freeRanges;
+    };
+
+    inline void clear() {
+        pages_.clear();
+        pending_.clear();
+    }
+    inline void setFrameCount(const uint32_t frameCount) { frameCount_ = (std::max)(frameCount, 1u); }
+    inline size_t size() const { return pages_.size(); }
+    inline const Page &operator[](const size_t page) const { return pages_[page]; }
+    // Slots that were freed, but are still waiting for the frames in flight.
+    inline vk::DeviceSize getPendingCount() const {
+        vk::DeviceSize count = 0;
+        for (const auto &freed : pending_) count += freed.count;
+        return count;
+    }
+
+    void add(const vk::DeviceSize size) {
+        assert(size > 0);
+        pages_.push_back({size, 0, {}});
+    }
+
+    // Returns false if the slots don't fit in any page, and a page of at least "count" slots has to be added.
+    bool allocate(const vk::DeviceSize count, vk::DeviceSize &page, vk::DeviceSize &offset) {
+        assert(count > 0);
+        for (page = 0; page < pages_.size(); page++)
+            if (pages_[page].freeRanges.take(count, offset)) return true;
+
+        if (pages_.empty() || pages_.back().currentOffset + count > pages_.back().size) return false;
+        page = pages_.size() - 1;
+        offset = pages_.back().currentOffset;
+        pages_.back().currentOffset += count;
+        return true;
+    }
+
+    void free(const vk::DeviceSize page, const vk::DeviceSize offset, const vk::DeviceSize count) {
+        assert(page < pages_.size() && offset + count <= pages_[page].currentOffset);
+        pending_.push_back({frame_, page, offset, count});
+    }
+
+    // Called once a frame, after the frame's fence was waited on.
+    void nextFrame() {
+        frame_++;
+        auto it = pending_.begin();
+        for (; it != pending_.end() && frame_ - it->frame >= frameCount_; ++it)
+            pages_[it->page].freeRanges.add(it->offset, it->count);
+        pending_.erase(pending_.begin(), it);
+    }
+
+   private:
+    struct Freed {
+        uint64_t frame;
+        vk::DeviceSize page, offset, count;
+    };
+
+    std::vector<Page> pages_;
+    std::vector<Freed> pending_;  // in the order they were freed
+    uint32_t frameCount_ = 1;
+    uint64_t frame_ = 0;
+};
+
+}  // namespace Manager
+}  // namespace Buffer
+
+#endif  // !BUFFER_PAGES_H
@@ -35,6 +35,12 @@ const CreateInfo VERT_TEX_CREATE_INFO = {
     vk::ShaderStageFlagBits::eVertex,  //
     {SHADER_LINK::CDLOD},
 };
+const CreateInfo SELECT_COMP_CREATE_INFO = {
+    SHADER::CDLOD_SELECT_COMP,
+    "Cdlod Selection Compute Shader",
+    "cdlod/comp.cdlod.select.glsl",
+    vk::ShaderStageFlagBits::eCompute,
+};
 }  // namespace Cdlod
 }  // namespace Shader
 
@@ -49,9 +55,76 @@ Base::Base(const Buffer::Info&& info, DATA* pData)
     dirty = true;
 }
 }  // namespace QuadTree
+namespace Selection {
+Base::Base(const Buffer::Info&& info, DATA* pData, const Buffer::CreateInfo* pCreateInfo)
+    : Buffer::Item(std::forward<const Buffer::Info>(info)),
+      Descriptor::Base(UNIFORM_DYNAMIC::CDLOD_SELECT),
+      Buffer::PerFramebufferDataItem<DATA>(pData) {
+    setData();
+}
+void Base::setSelection(const CDLODQuadTree::LODSelection& selection, const VkGridMesh& gridMesh,
+                        const int maxSelectionCount, const uint32_t frameIndex) {
+    CDLODGPUSelection::GetPerFrameData(selection, gridMesh, maxSelectionCount, data_);
+    setData(frameIndex);
+}
+}  // namespace Selection
 }  // namespace Cdlod
 }  // namespace UniformDynamic
 
+// STORAGE
+namespace Storage {
+namespace Cdlod {
+namespace Selection {
+Base::Base(const Buffer::Info&& info, DATA* pData, const CreateInfo* pCreateInfo)
+    : Buffer::Item(std::forward<const Buffer::Info>(info)),
+      Buffer::DataItem<DATA>(pData),
+      Descriptor::Base(pCreateInfo->descType) {}
+}  // namespace Selection
+}  // namespace Cdlod
+}  // namespace Storage
+
+// INSTANCE
+namespace Instance {
+namespace Cdlod {
+namespace Node {
+void GetInputDescriptions(Pipeline::CreateInfoResources& createInfoRes) {
+    const auto BINDING = static_cast<uint32_t>(createInfoRes.bindDescs.size());
+    createInfoRes.bindDescs.push_back({});
+    createInfoRes.bindDescs.back().binding = BINDING;
+    createInfoRes.bindDescs.back().stride = sizeof(DATA);
+    createInfoRes.bindDescs.back().inputRate = vk::VertexInputRate::eInstance;
+
+    // data0
+    auto offset = offsetof(DATA, data0);
+    createInfoRes.attrDescs.push_back({});
+    createInfoRes.attrDescs.back().binding = BINDING;
+    createInfoRes.attrDescs.back().location = static_cast<uint32_t>(createInfoRes.attrDescs.size() - 1);
+    createInfoRes.attrDescs.back().format = vk::Format::eR32G32B32A32Sfloat;  // vec4
+    createInfoRes.attrDescs.back().offset = static_cast<uint32_t>(offset);
+
+    // data1
+    offset = offsetof(DATA, data1);
+    createInfoRes.attrDescs.push_back({});
+    createInfoRes.attrDescs.back().binding = BINDING;
+    createInfoRes.attrDescs.back().location = static_cast<uint32_t>(createInfoRes.attrDescs.size() - 1);
+    createInfoRes.attrDescs.back().format = vk::Format::eR32G32B32A32Sfloat;  // vec4
+    createInfoRes.attrDescs.back().offset = static_cast<uint32_t>(offset);
+}
+Base::Base(const Buffer::Info&& info, DATA* pData)
+    : Buffer::Item(std::forward<const Buffer::Info>(info)), Buffer::DataItem<DATA>(pData) {
+    dirty = true;
+}
+void Base::setSelection(const CDLODQuadTree::LODSelection& selection, CDLODInstanceBatches& batches) {
+    assert(static_cast<uint32_t>(CDLODInstanceBatches::GetMaxInstanceCount(selection.GetSelectionCount())) <=
+           BUFFER_INFO.count);
+    CDLODRenderer::MakeInstanceBatches(selection, pData_, batches);
+    setActiveCount(static_cast<uint32_t>(batches.InstanceCount));
+    dirty = true;
+}
+}  // namespace Node
+}  // namespace Cdlod
+}  // namespace Instance
+
 // DESCRIPTOR SET
 namespace Descriptor {
 namespace Set {
@@ -60,6 +133,17 @@ const CreateInfo CDLOD_DEFAULT_CREATE_INFO = {
     "_DS_CDLOD",
     {{{0, 0}, {UNIFORM_DYNAMIC::CDLOD_QUAD_TREE}}},
 };
+const CreateInfo CDLOD_SELECT_CREATE_INFO = {
+    DESCRIPTOR_SET::CDLOD_SELECT,
+    "_DS_CDLOD_SELECT",
+    {
+        {{0, 0}, {UNIFORM_DYNAMIC::CDLOD_SELECT}},
+        {{1, 0}, {STORAGE_BUFFER_DYNAMIC::CDLOD_NODE}},
+        {{2, 0}, {STORAGE_BUFFER_DYNAMIC::CDLOD_WORK}},
+        {{3, 0}, {STORAGE_BUFFER_DYNAMIC::CDLOD_INDIRECT}},
+        {{4, 0}, {STORAGE_BUFFER_DYNAMIC::CDLOD_INSTANCE}},
+    },
+};
 }  // namespace Set
 }  // namespace Descriptor
 
@@ -81,6 +165,8 @@ void GetCdlodInputAssemblyInfoResource(Pipeline::CreateInfoResources& createInfo
         createInfoRes.attrDescs.back().location = 0;
         createInfoRes.attrDescs.back().format = vk::Format::eR32G32Sfloat;  // vec2
         createInfoRes.attrDescs.back().offset = 0;
+
+        Instance::Cdlod::Node::GetInputDescriptions(createInfoRes);
     }
 
     // bindings
@@ -140,5 +226,17 @@ void Texture::getInputAssemblyInfoResources(CreateInfoResources& createInfoRes)
     GetCdlodInputAssemblyInfoResource(createInfoRes);
 }
 
+// SELECT (COMPUTE)
+const Pipeline::CreateInfo SELECT_CREATE_INFO = {
+    COMPUTE::CDLOD_SELECT,
+    "Cdlod Selection Compute Pipeline",
+    {SHADER::CDLOD_SELECT_COMP},
+    {{DESCRIPTOR_SET::CDLOD_SELECT, vk::ShaderStageFlagBits::eCompute}},
+    {},
+    {PUSH_CONSTANT::CDLOD_SELECT},
+    {CDLODGPUSelection::c_localSize, 1, 1},
+};
+Select::Select(Handler& handler) : Compute(handler, &SELECT_CREATE_INFO) {}
+
 }  // namespace Cdlod
 }  // namespace Pipeline
@@ -6,6 +6,7 @@
 #ifndef CDLOD_H
 #define CDLOD_H
 
+#include <CDLOD/CDLODGPUSelection.h>
 #include <CDLOD/CDLODQuadTree.h>
 #include <CDLOD/CDLODRenderer.h>
 
@@ -13,6 +14,7 @@
 #include "Descriptor.h"
 #include "DescriptorManager.h"
 #include "Deferred.h"
+#include "Instance.h"
 #include "Pipeline.h"
 
 // SHADER
@@ -25,6 +27,7 @@ extern const CreateInfo CREATE_INFO;
 namespace Cdlod {
 extern const CreateInfo VERT_CREATE_INFO;
 extern const CreateInfo VERT_TEX_CREATE_INFO;
+extern const CreateInfo SELECT_COMP_CREATE_INFO;
 }  // namespace Cdlod
 }  // namespace Shader
 
@@ -40,18 +43,84 @@ class Base : public Descriptor::Base, public Buffer::DataItem<DATA> {
 };
 using Manager = Descriptor::Manager<Descriptor::Base, Base, std::shared_ptr>;
 }  // namespace QuadTree
+namespace Selection {
+using DATA = CDLODGPUSelection::PerFrameData;
+class Base : public Descriptor::Base, public Buffer::PerFramebufferDataItem<DATA> {
+   public:
+    Base(const Buffer::Info&& info, DATA* pData, const Buffer::CreateInfo* pCreateInfo);
+    // "selection" only needs its ranges made (CDLODQuadTree::LODSelectRanges). "gridMesh" is the mesh that is drawn.
+    void setSelection(const CDLODQuadTree::LODSelection& selection, const VkGridMesh& gridMesh,
+                      const int maxSelectionCount, const uint32_t frameIndex);
+};
+using Manager = Descriptor::Manager<Descriptor::Base, Base, std::shared_ptr>;
+}  // namespace Selection
 }  // namespace Cdlod
 }  // namespace UniformDynamic
 
+// STORAGE
+namespace Storage {
+namespace Cdlod {
+namespace Selection {
+// The GPU selection buffers (nodes, work, indirect draws, instances) are all raw storage. The manager pads every element
+// to the min uniform buffer offset alignment, so the elements are blocks big enough that there is no padding. Only the
+// nodes are written by the host (CDLOD_NODE). The rest are only written by the compute passes, so their manager is
+// device local (see Descriptor::GetVulkanMemoryProperty).
+struct DATA {
+    glm::uvec4 data[16];
+};
+struct CreateInfo : Buffer::CreateInfo {
+    CreateInfo(const STORAGE_BUFFER_DYNAMIC descType, const size_t size) : descType(descType) {
+        countInRange = true;
+        update = false;
+        dataCount = static_cast<uint32_t>((size + sizeof(DATA) - 1) / sizeof(DATA));
+    }
+    STORAGE_BUFFER_DYNAMIC descType;
+};
+class Base : public Buffer::DataItem<DATA>, public Descriptor::Base {
+   public:
+    Base(const Buffer::Info&& info, DATA* pData, const CreateInfo* pCreateInfo);
+
+    template <typename T>
+    T* getData() {
+        dirty = true;
+        return reinterpret_cast<T*>(pData_);
+    }
+};
+using Manager = Descriptor::Manager<Descriptor::Base, Base, std::shared_ptr>;
+}  // namespace Selection
+}  // namespace Cdlod
+}  // namespace Storage
+
+// INSTANCE
+namespace Instance {
+namespace Cdlod {
+namespace Node {
+using DATA = CDLODInstanceBatches::PerInstanceData;
+void GetInputDescriptions(Pipeline::CreateInfoResources& createInfoRes);
+class Base;
+struct CreateInfo : public Instance::CreateInfo<DATA, Base> {};
+class Base : public Buffer::DataItem<DATA>, public Instance::Base {
+   public:
+    Base(const Buffer::Info&& info, DATA* pData);
+
+    // Packs the selection into the buffer (see CDLODRenderer::MakeInstanceBatches), and makes those the active instances.
+    void setSelection(const CDLODQuadTree::LODSelection& selection, CDLODInstanceBatches& batches);
+};
+}  // namespace Node
+}  // namespace Cdlod
+}  // namespace Instance
+
 // PUSH CONSTANT
 namespace Cdlod {
 using PushConstant = CDLODRendererBatchInfo::PerDrawData;
+using SelectPushConstant = CDLODGPUSelection::PushConstant;
 }  // namespace Cdlod
 
 // DESCRIPTOR SET
 namespace Descriptor {
 namespace Set {
 extern const CreateInfo CDLOD_DEFAULT_CREATE_INFO;
+extern const CreateInfo CDLOD_SELECT_CREATE_INFO;
 }  // namespace Set
 }  // namespace Descriptor
 
@@ -60,7 +129,7 @@ namespace Pipeline {
 class Handler;
 namespace Cdlod {
 
-static void GetCdlodInputAssemblyInfoResource(Pipeline::CreateInfoResources& createInfoRes);
+void GetCdlodInputAssemblyInfoResource(Pipeline::CreateInfoResources& createInfoRes);
 
 class Wireframe : public Deferred::MRTColor {
    public:
@@ -79,6 +148,11 @@ class Texture : public Deferred::MRTTexture {
     void getInputAssemblyInfoResources(CreateInfoResources& createInfoRes) override;
 };
 
+class Select : public Compute {
+   public:
+    Select(Handler& handler);
+};
+
 }  // namespace Cdlod
 }  // namespace Pipeline
 
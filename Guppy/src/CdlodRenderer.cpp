@@ -22,6 +22,10 @@
 #include "TextureHandler.h"
 #include "UniformHandler.h"
 
+#if CDLOD_VALIDATE_GPU_SELECTION
+#include <sstream>
+#endif
+
 #define DEBUG_PRINT false
 #if DEBUG_PRINT
 #pragma warning(disable : 4996)
@@ -58,6 +62,20 @@ void logEnd() {}
 }  // namespace
 #endif
 
+namespace {
+// Size of each selection buffer. This was the size of the LODSelectionOnStack that record() used to select into.
+constexpr int MAX_SELECTION_COUNT = 4096;
+// The node instance manager is sized for this many framebuffers.
+constexpr uint32_t MAX_FRAMEBUFFER_COUNT = 4;
+#if CDLOD_VALIDATE_GPU_SELECTION
+// Only the host reads the work buffer copies.
+const std::vector<vk::MemoryPropertyFlags> READBACK_MEMORY_PREFERENCES = {
+    vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent,
+    vk::MemoryPropertyFlagBits::eHostCached,
+};
+#endif
+}  // namespace
+
 namespace Cdlod {
 namespace Renderer {
 
@@ -66,6 +84,10 @@ Base::Base(Scene::Handler& handler)
     : Handlee<Scene::Handler>(handler),  //
       CDLODRenderer(),
       useDebugCamera_(false),
+      usePerInstanceDraws_(false),
+      useGpuSelection_(false),
+      collectRenderStats_(true),
+      renderStatsCsvFileName_(),
       pPerQuadTreeItem_(nullptr),
       pSettings_(nullptr),
       pHeightmap_(nullptr),
@@ -74,7 +96,24 @@ Base::Base(Scene::Handler& handler)
       terrainGridMeshDims_(0),
       rasterWidth_(0),
       rasterHeight_(0),
-      cdlodQuadTree_() {}
+      tiledHeightmap_(),
+      cdlodQuadTree_(),
+      selectionWorker_(),
+      selectionWanted_(false),
+      nodeInstMgr_("Instance Cdlod Node Manager Data",
+                   MAX_FRAMEBUFFER_COUNT * CDLODInstanceBatches::GetMaxInstanceCount(MAX_SELECTION_COUNT)),
+      pNodeInstances_(),
+      instanceBatches_(),
+      instancesFrameCount_(UINT64_MAX),
+      selectionUniformMgr_("Cdlod Selection Data", UNIFORM_DYNAMIC::CDLOD_SELECT, MAX_FRAMEBUFFER_COUNT, "_UD_CDLOD_SELECT"),
+      pSelectionUniform_(nullptr),
+      pSelectionNodeMgr_(nullptr),
+      pSelectionStorageMgr_(nullptr),
+      pSelectionNodes_(nullptr),
+      gpuSelectionFrames_(),
+      frameRenderStats_(),
+      renderStatsFrameCount_(UINT64_MAX),
+      renderStatsHistory_() {}
 
 void Base::onInit() {
     reset();
@@ -85,6 +124,13 @@ void Base::onInit() {
     assert(pSettings_ != nullptr);
 
     pHeightmap_ = getHeightmap();
+    if (!pSettings_->TiledHeightmapPath.empty()) {
+        // Page the heightmap from the file. Only the tiles in use are mapped, so the raster can be bigger than memory.
+        if (tiledHeightmap_.Create({pSettings_->TiledHeightmapPath.c_str(), pSettings_->MaxResidentHeightmapTiles}))
+            pHeightmap_ = &tiledHeightmap_;
+        else
+            assert(false && "Could not open the tiled heightmap");
+    }
     assert(pHeightmap_ != nullptr);
     rasterWidth_ = pHeightmap_->GetSizeX();
     rasterHeight_ = pHeightmap_->GetSizeY();
@@ -151,8 +197,77 @@ void Base::onInit() {
     createDesc.MapDims = *pMapDims_;
     createDesc.textureWorldSize = pSettings_->TextureWorldSize;
     createDesc.textureSize = pSettings_->TextureSize;
+    createDesc.ImplicitStorage = true;
     assert(createDesc.pHeightmap);
     cdlodQuadTree_.Create(createDesc);
+#ifdef CDLOD_GPU_SELECTION
+    // The GPU selection reads the min/max heights of the implicit storage.
+    useGpuSelection_ = pSettings_->GpuSelection && CDLODGPUSelection::IsSupported(cdlodQuadTree_);
+#else
+    useGpuSelection_ = false;  // The selection pipeline is only built with the CDLOD_GPU_SELECTION option.
+#endif
+    if (!useGpuSelection_) selectionWorker_.Start(&cdlodQuadTree_, MAX_SELECTION_COUNT, pSettings_->IncrementalSelection);
+
+    if (collectRenderStats_ && !renderStatsCsvFileName_.empty()) {
+        if (!renderStatsHistory_.StartCSV(renderStatsCsvFileName_.c_str(), pSettings_->LODLevelCount)) {
+            assert(false && "Could not open the CDLOD render stats file");
+        }
+    }
+
+    {  // Node instances. They are written every frame, so each framebuffer gets its own buffer.
+        const auto& ctx = handler().shell().context();
+        assert(ctx.imageCount <= MAX_FRAMEBUFFER_COUNT);
+        nodeInstMgr_.init(ctx);
+        const std::vector<Instance::Cdlod::Node::DATA> data(CDLODInstanceBatches::GetMaxInstanceCount(MAX_SELECTION_COUNT));
+        for (uint32_t i = 0; i < ctx.imageCount; i++) {
+            nodeInstMgr_.insert(ctx.dev, false, data);
+            pNodeInstances_.push_back(nodeInstMgr_.pItems.back());
+            pNodeInstances_.back()->setActiveCount(0);
+        }
+    }
+
+    if (useGpuSelection_) {  // GPU selection. Only the node heights are written here, the rest is written by the GPU.
+        const auto& ctx = handler().shell().context();
+        Storage::Cdlod::Selection::CreateInfo nodeInfo(
+            STORAGE_BUFFER_DYNAMIC::CDLOD_NODE, CDLODGPUSelection::GetNodeCount(cdlodQuadTree_) * sizeof(uint32_t));
+        Storage::Cdlod::Selection::CreateInfo workInfo(STORAGE_BUFFER_DYNAMIC::CDLOD_WORK,
+                                                       CDLODGPUSelection::GetWorkBufferSize(MAX_SELECTION_COUNT));
+        Storage::Cdlod::Selection::CreateInfo indirectInfo(STORAGE_BUFFER_DYNAMIC::CDLOD_INDIRECT,
+                                                           sizeof(CDLODGPUSelection::IndirectData));
+        Storage::Cdlod::Selection::CreateInfo instanceInfo(
+            STORAGE_BUFFER_DYNAMIC::CDLOD_INSTANCE,
+            CDLODInstanceBatches::GetMaxInstanceCount(MAX_SELECTION_COUNT) * sizeof(CDLODInstanceBatches::PerInstanceData));
+
+        pSelectionNodeMgr_ = std::make_unique<Storage::Cdlod::Selection::Manager>(
+            "Cdlod Selection Node Data", STORAGE_BUFFER_DYNAMIC::CDLOD_NODE, nodeInfo.dataCount);
+        pSelectionNodeMgr_->init(ctx);
+        pSelectionNodes_ = pSelectionNodeMgr_->insert(ctx.dev, &nodeInfo);
+        CDLODGPUSelection::GetNodeData(cdlodQuadTree_, pSelectionNodes_->getData<uint32_t>());
+        pSelectionNodeMgr_->updateData(ctx.dev, pSelectionNodes_->BUFFER_INFO);
+
+        pSelectionStorageMgr_ = std::make_unique<Storage::Cdlod::Selection::Manager>(
+            "Cdlod Selection Storage Data", STORAGE_BUFFER_DYNAMIC::CDLOD_INDIRECT,
+            ctx.imageCount * (workInfo.dataCount + indirectInfo.dataCount + instanceInfo.dataCount));
+        pSelectionStorageMgr_->init(ctx);
+        for (uint32_t i = 0; i < ctx.imageCount; i++) {
+            GpuSelectionFrame frame = {};
+            frame.pWork = pSelectionStorageMgr_->insert(ctx.dev, &workInfo);
+            frame.pIndirect = pSelectionStorageMgr_->insert(ctx.dev, &indirectInfo);
+            frame.pInstances = pSelectionStorageMgr_->insert(ctx.dev, &instanceInfo);
+#if CDLOD_VALIDATE_GPU_SELECTION
+            helpers::createBuffer(ctx.dev, CDLODGPUSelection::GetWorkBufferSize(MAX_SELECTION_COUNT),
+                                  vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostVisible,
+                                  ctx.memAllocator, frame.readback.buffer, frame.readback.allocation, ctx.pAllocator,
+                                  READBACK_MEMORY_PREFERENCES);
+#endif
+            gpuSelectionFrames_.push_back(frame);
+        }
+
+        selectionUniformMgr_.init(ctx);
+        Buffer::CreateInfo uniformInfo = {};
+        uniformInfo.dataCount = ctx.imageCount;
+        pSelectionUniform_ = selectionUniformMgr_.insert(ctx.dev, &uniformInfo);
+    }
 
     {  // This should all be known after quad tree creation...
         assert(pPerQuadTreeItem_ != nullptr);
@@ -163,6 +278,40 @@ void Base::onInit() {
 }
 
 void Base::onReset() {
+    // The worker reads the quad tree.
+    selectionWorker_.Stop();
+    selectionWanted_ = false;
+
+    pNodeInstances_.clear();
+    nodeInstMgr_.destroy(handler().shell().context());
+    instanceBatches_ = {};
+    instancesFrameCount_ = UINT64_MAX;
+
+#if CDLOD_VALIDATE_GPU_SELECTION
+    for (auto& frame : gpuSelectionFrames_) {
+        const auto& ctx = handler().shell().context();
+        ctx.dev.destroyBuffer(frame.readback.buffer, ctx.pAllocator);
+        ctx.memAllocator.free(frame.readback.allocation);
+    }
+#endif
+    gpuSelectionFrames_.clear();
+    pSelectionNodes_ = nullptr;
+    if (pSelectionNodeMgr_ != nullptr) {
+        pSelectionNodeMgr_->destroy(handler().shell().context());
+        pSelectionNodeMgr_ = nullptr;
+    }
+    if (pSelectionStorageMgr_ != nullptr) {
+        pSelectionStorageMgr_->destroy(handler().shell().context());
+        pSelectionStorageMgr_ = nullptr;
+    }
+    pSelectionUniform_ = nullptr;
+    selectionUniformMgr_.destroy(handler().shell().context());
+
+    renderStatsHistory_.StopCSV();
+    renderStatsHistory_.Clear();
+    frameRenderStats_.Reset();
+    renderStatsFrameCount_ = UINT64_MAX;
+
     reset();
 
     pSettings_ = nullptr;
@@ -173,25 +322,43 @@ void Base::onReset() {
     rasterWidth_ = 0;
     rasterHeight_ = 0;
     cdlodQuadTree_ = {};
+    // After the quad tree, which samples it.
+    tiledHeightmap_.Clean();
     pPerQuadTreeItem_ = nullptr;
     useDebugCamera_ = false;
+    usePerInstanceDraws_ = false;
+    useGpuSelection_ = false;
+    collectRenderStats_ = true;
+    renderStatsCsvFileName_.clear();
+}
+
+void Base::frame() {
+    if (selectionWanted_ && selectionWorker_.IsStarted()) submitSelection();
 }
 
 void Base::record(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
                   const vk::CommandBuffer& cmd) {
-    Camera::FrustumInfo frustumInfo;
-    if (useDebugCamera_) {
-        assert(handler().uniformHandler().hasDebugCamera());
-        frustumInfo = handler().uniformHandler().getDebugCamera().getFrustumInfoZupLH();
-    } else {
-        frustumInfo = handler().uniformHandler().getMainCamera().getFrustumInfoZupLH();
+    selectionWanted_ = true;
+
+    if (useGpuSelection_) {
+        // recordDispatch selected the nodes, so only the ranges (morph consts) are needed here.
+        auto frustumInfo = getFrustumInfo();
+        CDLODQuadTree::LODSelection cdlodSelection(nullptr, 0, frustumInfo.eye, frustumInfo.farDistance,
+                                                   frustumInfo.planes.data(), pSettings_->LODLevelDistanceRatio);
+        cdlodQuadTree_.LODSelectRanges(&cdlodSelection);
+        if (collectRenderStats_) updateRenderStats(cdlodSelection);
+        renderTerrain(cdlodSelection, pPipelineBindData, cmd);
+        return;
     }
 
-    // CDLOD uses z-up left-handed math for everything. CH
-    CDLODQuadTree::LODSelectionOnStack<4096> cdlodSelection(frustumInfo.eye, frustumInfo.farDistance,
-                                                            frustumInfo.planes.data(), pSettings_->LODLevelDistanceRatio);
-
-    cdlodQuadTree_.LODSelect(&cdlodSelection);
+    // Normally frame() already submitted this frame's selection. Otherwise (the first frame drawn) select now.
+    const CDLODQuadTree::LODSelection* pSelection = selectionWorker_.Acquire();
+    if (pSelection == nullptr) {
+        submitSelection();
+        pSelection = selectionWorker_.Acquire();
+    }
+    assert(pSelection != nullptr);
+    const auto& cdlodSelection = *pSelection;
 
     //
     // Check if we have too small visibility distance that causes morph between LOD levels to be incorrect.
@@ -200,9 +367,167 @@ void Base::record(const PASS passType, const std::shared_ptr<Pipeline::BindData>
     }
     //////////////////////////////////////////////////////////////////////////
 
+    updateInstances(cdlodSelection);
+    if (collectRenderStats_) updateRenderStats(cdlodSelection);
+
     renderTerrain(cdlodSelection, pPipelineBindData, cmd);
 }
 
+void Base::updateInstances(const CDLODQuadTree::LODSelection& cdlodSelection) {
+    // Every pipeline recorded this frame draws the same selection, so only pack it once.
+    const auto frameCount = handler().game().getFrameCount();
+    if (instancesFrameCount_ == frameCount) return;
+    instancesFrameCount_ = frameCount;
+
+    auto& pInstances = pNodeInstances_[handler().passHandler().renderPassMgr().getFrameIndex()];
+    pInstances->setSelection(cdlodSelection, instanceBatches_);
+    nodeInstMgr_.updateData(handler().shell().context().dev, pInstances->BUFFER_INFO);
+}
+
+void Base::updateRenderStats(const CDLODQuadTree::LODSelection& cdlodSelection) {
+    // Every pipeline recorded this frame adds to the frame's stats, so they are pushed when the next frame starts.
+    const auto frameCount = handler().game().getFrameCount();
+    if (renderStatsFrameCount_ == frameCount) return;
+    if (renderStatsFrameCount_ != UINT64_MAX) renderStatsHistory_.Push(frameRenderStats_);
+    renderStatsFrameCount_ = frameCount;
+
+    frameRenderStats_.Reset();
+    frameRenderStats_.SelectionTime = cdlodSelection.GetSelectionTime();
+}
+
+Camera::FrustumInfo Base::getFrustumInfo() const {
+    // CDLOD uses z-up left-handed math for everything. CH
+    if (useDebugCamera_) {
+        assert(handler().uniformHandler().hasDebugCamera());
+        return handler().uniformHandler().getDebugCamera().getFrustumInfoZupLH();
+    }
+    return handler().uniformHandler().getMainCamera().getFrustumInfoZupLH();
+}
+
+void Base::submitSelection() {
+    auto frustumInfo = getFrustumInfo();
+    selectionWorker_.Submit(frustumInfo.eye, frustumInfo.farDistance, frustumInfo.planes.data(),
+                            pSettings_->LODLevelDistanceRatio);
+}
+
+void Base::recordDispatch(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
+                          const vk::CommandBuffer& cmd, const uint8_t frameIndex) {
+    // Like the worker, only select for renderers that draw.
+    if (!useGpuSelection_ || !selectionWanted_) return;
+    assert(frameIndex < gpuSelectionFrames_.size());
+    auto& frame = gpuSelectionFrames_[frameIndex];
+#if CDLOD_VALIDATE_GPU_SELECTION
+    // The command buffer is being recorded again, so the last selection in this frame's buffers is done.
+    validateGpuSelection(frameIndex);
+#endif
+
+    {  // Per frame data
+        auto frustumInfo = getFrustumInfo();
+        CDLODQuadTree::LODSelection cdlodSelection(nullptr, 0, frustumInfo.eye, frustumInfo.farDistance,
+                                                   frustumInfo.planes.data(), pSettings_->LODLevelDistanceRatio);
+        cdlodQuadTree_.LODSelectRanges(&cdlodSelection);
+        pSelectionUniform_->setSelection(cdlodSelection, *PickGridMesh(terrainGridMeshDims_), MAX_SELECTION_COUNT,
+                                         frameIndex);
+        selectionUniformMgr_.updateData(handler().shell().context().dev, pSelectionUniform_->BUFFER_INFO, frameIndex);
+#if CDLOD_VALIDATE_GPU_SELECTION
+        frame.frustum = frustumInfo;
+#endif
+    }
+
+    Descriptor::Set::bindDataMap descSetBindDataMap;
+    handler().descriptorHandler().getBindData(
+        pPipelineBindData->type, descSetBindDataMap,
+        {pSelectionUniform_, pSelectionNodes_, frame.pWork, frame.pIndirect, frame.pInstances});
+    assert(descSetBindDataMap.size() == 1);
+    const auto& descSetBindData = descSetBindDataMap.begin()->second;
+    const auto setIndex = (std::min)(static_cast<uint8_t>(descSetBindData.descriptorSets.size() - 1), frameIndex);
+
+    cmd.bindPipeline(pPipelineBindData->bindPoint, pPipelineBindData->pipeline);
+    cmd.bindDescriptorSets(pPipelineBindData->bindPoint, pPipelineBindData->layout, descSetBindData.firstSet,
+                           descSetBindData.descriptorSets[setIndex], descSetBindData.dynamicOffsets);
+
+    // Every pass reads (and adds to) what the passes before it wrote.
+    const auto dispatch = [&](const CDLODGPUSelection::PassType pass, const int level) {
+        const CDLODGPUSelection::PushConstant pushConstant = {static_cast<uint32_t>(pass), static_cast<uint32_t>(level)};
+        cmd.pushConstants(pPipelineBindData->layout, pPipelineBindData->pushConstantStages, 0,
+                          static_cast<uint32_t>(sizeof(pushConstant)), &pushConstant);
+        cmd.dispatch(CDLODGPUSelection::GetDispatchCount(cdlodQuadTree_, pass, level, MAX_SELECTION_COUNT), 1, 1);
+
+        vk::MemoryBarrier memoryBarrier = {
+            vk::AccessFlagBits::eShaderWrite,                                     // srcAccessMask
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,  // dstAccessMask
+        };
+        cmd.pipelineBarrier(                            //
+            vk::PipelineStageFlagBits::eComputeShader,  // srcStageMask
+            vk::PipelineStageFlagBits::eComputeShader,  // dstStageMask
+            {},                                         // dependencyFlags
+            {memoryBarrier},                            // pMemoryBarriers
+            {}, {});
+    };
+    dispatch(CDLODGPUSelection::PT_Clear, 0);
+    dispatch(CDLODGPUSelection::PT_Seed, 0);
+    for (int level = 0; level < pSettings_->LODLevelCount; level++) dispatch(CDLODGPUSelection::PT_Traverse, level);
+    dispatch(CDLODGPUSelection::PT_Layout, 0);
+    dispatch(CDLODGPUSelection::PT_Write, 0);
+
+#if CDLOD_VALIDATE_GPU_SELECTION
+    {  // Copy what the passes wrote for validateGpuSelection.
+        vk::MemoryBarrier barrier = {vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead};
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {},
+                            {barrier}, {}, {});
+        const vk::BufferCopy region = {frame.pWork->BUFFER_INFO.memoryOffset, 0,
+                                       CDLODGPUSelection::GetWorkBufferSize(MAX_SELECTION_COUNT)};
+        cmd.copyBuffer(frame.pWork->BUFFER_INFO.bufferInfo.buffer, frame.readback.buffer, {region});
+        vk::BufferMemoryBarrier hostBarrier = {vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead};
+        hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.buffer = frame.readback.buffer;
+        hostBarrier.size = VK_WHOLE_SIZE;
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {},
+                            {hostBarrier}, {});
+        frame.hasReadback = true;
+    }
+#endif
+
+    // The draws read the indirect commands and the instances.
+    vk::MemoryBarrier memoryBarrier = {
+        vk::AccessFlagBits::eShaderWrite,                                                    // srcAccessMask
+        vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead,  // dstAccessMask
+    };
+    cmd.pipelineBarrier(                                                                       //
+        vk::PipelineStageFlagBits::eComputeShader,                                             // srcStageMask
+        vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,  // dstStageMask
+        {},                                                                                    // dependencyFlags
+        {memoryBarrier},                                                                       // pMemoryBarriers
+        {}, {});
+}
+
+#if CDLOD_VALIDATE_GPU_SELECTION
+void Base::validateGpuSelection(const uint8_t frameIndex) {
+    auto& frame = gpuSelectionFrames_[frameIndex];
+    if (!frame.hasReadback) return;
+    frame.hasReadback = false;
+
+    const auto& ctx = handler().shell().context();
+    ctx.memAllocator.invalidate(frame.readback.allocation);
+    std::vector<CDLODQuadTree::SelectedNode> gpuNodes(MAX_SELECTION_COUNT), cpuNodes(MAX_SELECTION_COUNT);
+    const int gpuCount = CDLODGPUSelection::ReadSelection(cdlodQuadTree_, frame.readback.allocation.pMappedData,
+                                                          MAX_SELECTION_COUNT, gpuNodes.data());
+
+    CDLODQuadTree::LODSelection cpuSelection(cpuNodes.data(), MAX_SELECTION_COUNT, frame.frustum.eye,
+                                             frame.frustum.farDistance, frame.frustum.planes.data(),
+                                             pSettings_->LODLevelDistanceRatio);
+    CDLODGPUSelection::Select(cdlodQuadTree_, &cpuSelection);
+    if (!CDLODGPUSelection::IsSameSelection(gpuNodes.data(), gpuCount, cpuSelection.GetSelection(),
+                                            cpuSelection.GetSelectionCount())) {
+        std::stringstream ss;
+        ss << "Cdlod GPU selection validation: the GPU selected " << gpuCount << " nodes, and the CPU "
+           << cpuSelection.GetSelectionCount() << " nodes, but they aren't the same";
+        handler().shell().log(Shell::LogPriority::LOG_WARN, ss.str().c_str());
+    }
+}
+#endif
+
 void Base::renderTerrain(const CDLODQuadTree::LODSelection& cdlodSelection,
                          const std::shared_ptr<Pipeline::BindData>& pPipelineBindData, const vk::CommandBuffer& cmd) {
     // HRESULT hr;
@@ -251,6 +576,20 @@ void Base::renderTerrain(const CDLODQuadTree::LODSelection& cdlodSelection,
     cdlodBatchInfo.renderData.cmd = cmd;
     cdlodBatchInfo.renderData.pipelineLayout = pPipelineBindData->layout;
     cdlodBatchInfo.renderData.pushConstantStages = pPipelineBindData->pushConstantStages;
+    if (useGpuSelection_) {
+        const auto& frame = gpuSelectionFrames_[handler().passHandler().renderPassMgr().getFrameIndex()];
+        cdlodBatchInfo.renderData.instanceBuffer = frame.pInstances->BUFFER_INFO.bufferInfo.buffer;
+        cdlodBatchInfo.renderData.instanceBufferOffset = frame.pInstances->BUFFER_INFO.memoryOffset;
+        cdlodBatchInfo.renderData.indirectBuffer = frame.pIndirect->BUFFER_INFO.bufferInfo.buffer;
+        cdlodBatchInfo.renderData.indirectBufferOffset = frame.pIndirect->BUFFER_INFO.memoryOffset;
+        cdlodBatchInfo.InstanceBatches = nullptr;
+    } else {
+        const auto& pInstances = pNodeInstances_[handler().passHandler().renderPassMgr().getFrameIndex()];
+        cdlodBatchInfo.renderData.instanceBuffer = pInstances->BUFFER_INFO.bufferInfo.buffer;
+        cdlodBatchInfo.renderData.instanceBufferOffset = pInstances->BUFFER_INFO.memoryOffset;
+        cdlodBatchInfo.InstanceBatches = &instanceBatches_;
+    }
+    cdlodBatchInfo.PerInstanceDraws = usePerInstanceDraws_;
     if (useDebugCamera_) {
         cdlodBatchInfo.renderData.dbgCamData = glm::vec4(handler().uniformHandler().getDebugCamera().getPosition(), 1.0f);
     }
@@ -323,9 +662,7 @@ void Base::renderTerrain(const CDLODQuadTree::LODSelection& cdlodSelection,
     // Connect selection to our render batch info
     cdlodBatchInfo.CDLODSelection = &cdlodSelection;
 
-    // m_renderStats.TerrainStats.Reset();
-
-    // CDLODRenderStats stepStats;
+    CDLODRenderStats stepStats;
 
     //////////////////////////////////////////////////////////////////////////
     // Debug view
@@ -335,7 +672,10 @@ void Base::renderTerrain(const CDLODQuadTree::LODSelection& cdlodSelection,
     //////////////////////////////////////////////////////////////////////////
     // Render
     //
-    for (int i = cdlodSelection.GetMinSelectedLevel(); i <= cdlodSelection.GetMaxSelectedLevel(); i++) {
+    // The selected levels of the GPU selection aren't known here.
+    const int minLevel = useGpuSelection_ ? 0 : cdlodSelection.GetMinSelectedLevel();
+    const int maxLevel = useGpuSelection_ ? pSettings_->LODLevelCount - 1 : cdlodSelection.GetMaxSelectedLevel();
+    for (int i = minLevel; i <= maxLevel; i++) {
         // if (m_debugView) {
         //    float whiten = 0.8f;
         //    m_psTerrainFlat.SetFloatArray("g_colorMult", whiten + (1.0f - whiten) * dbgLODLevelColors[i % 4][0],
@@ -392,9 +732,8 @@ void Base::renderTerrain(const CDLODQuadTree::LODSelection& cdlodSelection,
         bindDescSetData(cmd, pPipelineBindData, i);  // CH
 
         // V(device->SetPixelShader(*cdlodBatchInfo.PixelShader));
-        // m_dlodRenderer.Render(cdlodBatchInfo, &stepStats);
-        Render(cdlodBatchInfo, nullptr);  // CH
-        // m_renderStats.TerrainStats.Add(stepStats);
+        Render(cdlodBatchInfo, collectRenderStats_ ? &stepStats : nullptr);  // CH
+        if (collectRenderStats_) frameRenderStats_.Add(stepStats);
 
         // if (m_settings.ShadowmapEnabled && vaGetShadowMapSupport() == smsATIShadows) {
         //    int sms0 = m_psTerrainFlat.GetTextureSamplerIndex("g_shadowMapTexture");
@@ -457,6 +796,8 @@ void Debug::init() {
         settings_.MinViewRange = 35000.0f;
         settings_.MaxViewRange = 100000.0f;
         settings_.LODLevelDistanceRatio = 2.0f;
+        settings_.GpuSelection = false;
+        settings_.IncrementalSelection = true;
     }
 
     // QUAD TREE
@@ -7,19 +7,33 @@
 #define CDLOD_RENDERER_H
 
 #include <array>
+#include <memory>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan.hpp>
 
 #include <CDLOD/CDLODQuadTree.h>
 #include <CDLOD/CDLODRenderer.h>
+#include <CDLOD/CDLODRenderStatsHistory.h>
+#include <CDLOD/CDLODSelectionWorker.h>
+#include <CDLOD/TiledHeightmap.h>
 
 #include "BufferItem.h"
+#include "Camera.h"
 #include "Cdlod.h"
 #include "DescriptorConstants.h"
 #include "Enum.h"
 #include "Handlee.h"
+#include "InstanceManager.h"
 #include "MeshConstants.h"
 #include "PipelineConstants.h"
 
+/**
+ * Set to true to check the GPU selection (Settings::GpuSelection) against its CPU traversal (CDLODGPUSelection::Select).
+ * Every frame's work buffer is read back, and compared once the frame's command buffer is reused. Mismatches are logged.
+ */
+#define CDLOD_VALIDATE_GPU_SELECTION false
+
 // clang-format off
 namespace Descriptor { class Base; }
 namespace Scene      { class Handler; }
@@ -68,6 +82,20 @@ struct Settings {
     // Texture sizes.
     glm::vec2 TextureWorldSize;
     glm::vec2 TextureSize;
+
+    // Tiled heightmap file (TiledHeightmap::ConvertRaw/ConvertPng) to page the heightmap from instead of getHeightmap().
+    // This is how terrains bigger than memory are loaded.
+    std::string TiledHeightmapPath;
+    // Tiles of the file that can be mapped at once (TiledHeightmapSource::CreateDesc::MaxResidentTiles).
+    int MaxResidentHeightmapTiles;
+
+    // Select the nodes in a compute shader and draw them indirectly (CDLODGPUSelection) instead of on the selection
+    // worker. Only used if the quad tree supports it, and the app is built with the CDLOD_GPU_SELECTION option. Keep this
+    // off until the shader has been checked against LODSelect on a device (CDLOD_VALIDATE_GPU_SELECTION).
+    bool GpuSelection;
+    // Start each selection on the worker from the last one (CDLODQuadTree::LODSelectIncremental). Selects the same nodes
+    // with fewer node tests while the camera moves slowly.
+    bool IncrementalSelection;
 };
 
 // BASE - This class is based off of DemoRender in CDLOD proper.
@@ -79,11 +107,18 @@ class Base : public Handlee<Scene::Handler>, public CDLODRenderer {
         onReset();
     }
     virtual void tick() {}
-    virtual void frame() {}
+    // Starts the LOD selection for this frame on the selection worker. The camera has to be updated first.
+    virtual void frame();
 
     virtual bool shouldDraw(const PIPELINE type) const { return true; }
     virtual void record(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
                         const vk::CommandBuffer& cmd);
+    // Selects this frame's nodes on the GPU (useGpuSelection_). Has to be recorded before the draws.
+    void recordDispatch(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
+                        const vk::CommandBuffer& cmd, const uint8_t frameIndex);
+
+    // Stats of the last frames recorded. The latest frame is pushed once the next one starts recording.
+    const CDLODRenderStatsHistory& getRenderStats() const { return renderStatsHistory_; }
 
    protected:
     Base(Scene::Handler& handler);
@@ -103,11 +138,23 @@ class Base : public Handlee<Scene::Handler>, public CDLODRenderer {
     constexpr auto getRasterHeight() const { return rasterHeight_; }
 
     bool useDebugCamera_;
+    bool usePerInstanceDraws_;  // Draw every instance on its own, like the old per node path. (For comparison)
+    bool useGpuSelection_;      // Settings::GpuSelection, if the quad tree supports it.
+    bool collectRenderStats_;
+    std::string renderStatsCsvFileName_;  // If set in init() every frame's stats are written to this file.
     UniformDynamic::Cdlod::QuadTree::Base* pPerQuadTreeItem_;
 
    private:
     void onReset();
 
+    Camera::FrustumInfo getFrustumInfo() const;
+    void submitSelection();
+    void updateInstances(const CDLODQuadTree::LODSelection& cdlodSelection);
+    void updateRenderStats(const CDLODQuadTree::LODSelection& cdlodSelection);
+#if CDLOD_VALIDATE_GPU_SELECTION
+    void validateGpuSelection(const uint8_t frameIndex);
+#endif
+
     void renderTerrain(const CDLODQuadTree::LODSelection& cdlodSelection,
                        const std::shared_ptr<Pipeline::BindData>& pPipelineBindData, const vk::CommandBuffer& cmd);
 
@@ -120,7 +167,42 @@ class Base : public Handlee<Scene::Handler>, public CDLODRenderer {
     int rasterWidth_;
     int rasterHeight_;
 
+    // Settings::TiledHeightmapPath
+    TiledHeightmapSource tiledHeightmap_;
+
     CDLODQuadTree cdlodQuadTree_;
+    CDLODSelectionWorker selectionWorker_;
+    // Set by record, so that renderers that never draw don't keep the selection worker busy.
+    bool selectionWanted_;
+
+    Instance::Manager<Instance::Cdlod::Node::Base, Instance::Cdlod::Node::Base> nodeInstMgr_;
+    std::vector<std::shared_ptr<Instance::Cdlod::Node::Base>> pNodeInstances_;  // per framebuffer
+    CDLODInstanceBatches instanceBatches_;
+    uint64_t instancesFrameCount_;  // frame that pNodeInstances_/instanceBatches_ were last written
+
+    // GPU selection
+    struct GpuSelectionFrame {
+        Storage::Cdlod::Selection::Base* pWork;
+        Storage::Cdlod::Selection::Base* pIndirect;
+        Storage::Cdlod::Selection::Base* pInstances;
+#if CDLOD_VALIDATE_GPU_SELECTION
+        BufferResource readback;       // copy of pWork
+        Camera::FrustumInfo frustum;   // of the selection in "readback"
+        bool hasReadback;
+#endif
+    };
+    UniformDynamic::Cdlod::Selection::Manager selectionUniformMgr_;
+    UniformDynamic::Cdlod::Selection::Base* pSelectionUniform_;
+    // Both are sized by the quad tree. The nodes are written by the host, and the rest (work, indirect draws, instances)
+    // are device local.
+    std::unique_ptr<Storage::Cdlod::Selection::Manager> pSelectionNodeMgr_;
+    std::unique_ptr<Storage::Cdlod::Selection::Manager> pSelectionStorageMgr_;
+    Storage::Cdlod::Selection::Base* pSelectionNodes_;
+    std::vector<GpuSelectionFrame> gpuSelectionFrames_;  // per framebuffer
+
+    CDLODRenderStats frameRenderStats_;  // every pipeline recorded this frame
+    uint64_t renderStatsFrameCount_;     // frame of frameRenderStats_
+    CDLODRenderStatsHistory renderStatsHistory_;
 };
 
 // DEBUG
@@ -64,15 +64,21 @@ void Base::createCommandBuffers(const uint32_t count) {
                                                 resources.cmds.size());
 }
 
-void Base::createSemaphores(const uint32_t count, const uint32_t drawCount) {
+void Base::createSemaphores(const uint32_t count, const uint32_t drawCount, const bool timeline) {
     const auto& ctx = handler().shell().context();
+    assert(!timeline || ctx.timelineSemaphoreEnabled);
+
+    vk::SemaphoreTypeCreateInfoKHR typeInfo = {vk::SemaphoreTypeKHR::eTimeline, 0};
+    vk::SemaphoreCreateInfo createInfo = {};
+    if (timeline) createInfo.pNext = &typeInfo;
+
     assert(resources.semaphores.empty());
     for (uint32_t i = 0; i < count; i++) {
-        resources.semaphores.push_back(ctx.dev.createSemaphore({}, ctx.pAllocator));
+        resources.semaphores.push_back(ctx.dev.createSemaphore(createInfo, ctx.pAllocator));
     }
     assert(resources.drawSemaphores.empty());
     for (uint32_t i = 0; i < drawCount; i++) {
-        resources.drawSemaphores.push_back(ctx.dev.createSemaphore({}, ctx.pAllocator));
+        resources.drawSemaphores.push_back(ctx.dev.createSemaphore(createInfo, ctx.pAllocator));
     }
 }
 
@@ -86,6 +92,13 @@ void Base::createFences(const uint32_t count) {
 
 void Base::onDestroy() {
     const auto& ctx = handler().shell().context();
+    // WAIT (work that doesn't use fences needs to wait on its own in destroy)
+    if (!resources.fences.empty()) {
+        auto result = ctx.dev.waitForFences(resources.fences, VK_TRUE, UINT64_MAX);
+        assert(result == vk::Result::eSuccess);
+    }
+    // DERIVED
+    destroy();
     // CMDS
     ctx.dev.freeCommandBuffers(handler().commandHandler().computeCmdPool(), resources.cmds);
     resources.cmds.clear();
@@ -95,8 +108,6 @@ void Base::onDestroy() {
     for (const auto& s : resources.drawSemaphores) ctx.dev.destroy(s, ctx.pAllocator);
     resources.drawSemaphores.clear();
     // FENCES
-    auto result = ctx.dev.waitForFences(resources.fences, VK_TRUE, UINT64_MAX);
-    assert(result == vk::Result::eSuccess);
     for (const auto& f : resources.fences) ctx.dev.destroy(f, ctx.pAllocator);
     resources.fences.clear();
     // MISC.
@@ -63,7 +63,7 @@ class Base : public Handlee<Pass::Handler> {
     }
 
     // RENDER PASS
-    virtual void updateRenderPassSubmitResource(RenderPass::SubmitResource& resource, const uint8_t frameIndex) const {}
+    virtual void updateRenderPassSubmitResource(RenderPass::SubmitResource& resource, const uint8_t frameIndex) {}
 
     // RESOURCES
     struct Resources {
@@ -83,7 +83,7 @@ class Base : public Handlee<Pass::Handler> {
     virtual void destroy() {}
 
     void createCommandBuffers(const uint32_t count);
-    void createSemaphores(const uint32_t count, const uint32_t drawCount);
+    void createSemaphores(const uint32_t count, const uint32_t drawCount, const bool timeline = false);
     void createFences(const uint32_t count);
 
     FlagBits status_;
@@ -25,9 +25,11 @@ extern const std::vector<COMPUTE_WORK> ACTIVE;
 
 struct SubmitResource {
     std::vector<vk::Semaphore> waitSemaphores;
-    vk::PipelineStageFlags waitDstStageMask;
+    std::vector<vk::PipelineStageFlags> waitDstStageMasks;
+    std::vector<uint64_t> waitSemaphoreValues;  // timeline semaphore values (ignored for binary semaphores)
     std::vector<vk::CommandBuffer> commandBuffers;
     std::vector<vk::Semaphore> signalSemaphores;
+    std::vector<uint64_t> signalSemaphoreValues;  // timeline semaphore values (ignored for binary semaphores)
     vk::Fence fence;
 };
 
@@ -117,15 +117,29 @@ void Manager::updateRenderPassSubmitResource(const RENDER_PASS passType, RenderP
 }
 
 void Manager::submit(const SubmitResource& resource) {
+    assert(resource.waitDstStageMasks.size() == resource.waitSemaphores.size());
+
     vk::SubmitInfo info = {};
     info.waitSemaphoreCount = static_cast<uint32_t>(resource.waitSemaphores.size());
     info.pWaitSemaphores = resource.waitSemaphores.data();
-    info.pWaitDstStageMask = &resource.waitDstStageMask;
+    info.pWaitDstStageMask = resource.waitDstStageMasks.data();
     info.commandBufferCount = static_cast<uint32_t>(resource.commandBuffers.size());
     info.pCommandBuffers = resource.commandBuffers.data();
     info.signalSemaphoreCount = static_cast<uint32_t>(resource.signalSemaphores.size());
     info.pSignalSemaphores = resource.signalSemaphores.data();
 
+    // Timeline semaphore values. The counts have to match the semaphore counts when they are used.
+    vk::TimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+    if (resource.waitSemaphoreValues.size() || resource.signalSemaphoreValues.size()) {
+        assert(resource.waitSemaphoreValues.size() == resource.waitSemaphores.size());
+        assert(resource.signalSemaphoreValues.size() == resource.signalSemaphores.size());
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(resource.waitSemaphoreValues.size());
+        timelineInfo.pWaitSemaphoreValues = resource.waitSemaphoreValues.data();
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(resource.signalSemaphoreValues.size());
+        timelineInfo.pSignalSemaphoreValues = resource.signalSemaphoreValues.data();
+        info.pNext = &timelineInfo;
+    }
+
     handler().commandHandler().computeQueue().submit({info}, resource.fence);
 }
 
@@ -88,6 +88,7 @@ const std::set<DESCRIPTOR_SET> ALL = {
     DESCRIPTOR_SET::OCEAN_DRAW,
     // CDLOD
     DESCRIPTOR_SET::CDLOD_DEFAULT,
+    DESCRIPTOR_SET::CDLOD_SELECT,
 #ifdef USE_VOLUMETRIC_LIGHTING
     // ...
 #endif
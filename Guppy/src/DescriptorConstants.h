@@ -80,6 +80,7 @@ enum class DESCRIPTOR_SET {
     OCEAN_DRAW,
     // CDLOD
     CDLOD_DEFAULT,
+    CDLOD_SELECT,
 #ifdef USE_VOLUMETRIC_LIGHTING
     // ...
 #endif
@@ -144,6 +145,10 @@ struct GetVulkanBufferUsage {
     vk::BufferUsageFlags operator()(const STORAGE_BUFFER_DYNAMIC& type )    const {
         switch (type) {
             case STORAGE_BUFFER_DYNAMIC::VERTEX: return vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer;
+            case STORAGE_BUFFER_DYNAMIC::CDLOD_NODE:
+            case STORAGE_BUFFER_DYNAMIC::CDLOD_WORK:
+            case STORAGE_BUFFER_DYNAMIC::CDLOD_INDIRECT:
+            case STORAGE_BUFFER_DYNAMIC::CDLOD_INSTANCE: return vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc;
             default: return vk::BufferUsageFlagBits::eStorageBuffer;
         }
     }
@@ -159,21 +164,18 @@ struct GetVulkanDescriptorType {
     vk::DescriptorType operator()(const STORAGE_BUFFER_DYNAMIC&)    const { return vk::DescriptorType::eStorageBufferDynamic; }
     vk::DescriptorType operator()(const INPUT_ATTACHMENT&)          const { return vk::DescriptorType::eInputAttachment; }
 };
+// Required properties only. The rest (device local, cached, coherent) is up to Buffer::Manager::Base::getMemoryPreferences.
+// Buffers that only the device writes are device local, and never mapped.
 struct GetVulkanMemoryProperty {
     template <typename T> vk::MemoryPropertyFlags operator()(const T& type) const {
-        return vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+        return vk::MemoryPropertyFlagBits::eHostVisible;
     }
     vk::MemoryPropertyFlags operator()(const STORAGE_BUFFER_DYNAMIC& type) const {
         switch (type) {
-            case STORAGE_BUFFER_DYNAMIC::VERTEX: return
-                (vk::MemoryPropertyFlagBits::eHostVisible
-#if !(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK))
-                | vk::MemoryPropertyFlagBits::eDeviceLocal
-#endif
-                | vk::MemoryPropertyFlagBits::eHostCoherent);
-            default: return
-                (vk::MemoryPropertyFlagBits::eHostVisible
-                | vk::MemoryPropertyFlagBits::eHostCoherent);
+            case STORAGE_BUFFER_DYNAMIC::CDLOD_WORK:
+            case STORAGE_BUFFER_DYNAMIC::CDLOD_INDIRECT:
+            case STORAGE_BUFFER_DYNAMIC::CDLOD_INSTANCE: return vk::MemoryPropertyFlagBits::eDeviceLocal;
+            default: return vk::MemoryPropertyFlagBits::eHostVisible;
         }
     }
 };
@@ -235,6 +237,7 @@ struct HasPerFramebufferData {
             case UNIFORM_DYNAMIC::PRTCL_CLOTH:
             case UNIFORM_DYNAMIC::MATRIX_4:
             case UNIFORM_DYNAMIC::HFF:
+            case UNIFORM_DYNAMIC::CDLOD_SELECT:
 #ifdef USE_VOLUMETRIC_LIGHTING
             // ...
 #endif
@@ -87,6 +87,7 @@ Descriptor::Handler::Handler(Game* pGame) : Game::Handler(pGame), pool_() {
             case DESCRIPTOR_SET::OCEAN_DISPATCH:                            pDescriptorSets_.emplace_back(new Set::Base(std::ref(*this), &Set::OCEAN_DISPATCH_CREATE_INFO)); break;
             case DESCRIPTOR_SET::OCEAN_DRAW:                                pDescriptorSets_.emplace_back(new Set::Base(std::ref(*this), &Set::OCEAN_DRAW_CREATE_INFO)); break;
             case DESCRIPTOR_SET::CDLOD_DEFAULT:                             pDescriptorSets_.emplace_back(new Set::Base(std::ref(*this), &Set::CDLOD_DEFAULT_CREATE_INFO)); break;
+            case DESCRIPTOR_SET::CDLOD_SELECT:                              pDescriptorSets_.emplace_back(new Set::Base(std::ref(*this), &Set::CDLOD_SELECT_CREATE_INFO)); break;
 #ifdef USE_VOLUMETRIC_LIGHTING
             // ...
 #endif
@@ -585,6 +586,7 @@ void Descriptor::Handler::getBindData(const PIPELINE& pipelineType, Descriptor::
         auto itDescSetsMapKey = descriptorSetsMapKey.begin();
         auto itCmbSampMat = pDynamicItems.begin();
         auto itStrBuffDyn = pDynamicItems.begin();
+        auto itUniDyn = pDynamicItems.begin();
         for (const auto& [key, bindingInfo] : pSet->getBindingMap()) {
             if (std::visit(IsCombinedSamplerMaterial{}, bindingInfo.descType)) {
                 // MATERIAL SAMPLER
@@ -613,6 +615,27 @@ void Descriptor::Handler::getBindData(const PIPELINE& pipelineType, Descriptor::
                     assert(false && "No space left in key, or no storage buffer.");
                     exit(EXIT_FAILURE);
                 }
+            } else if (std::visit(IsUniformDynamic{}, bindingInfo.descType)) {
+                // DYNAMIC UNIFORM BUFFER
+                /**
+                 * The sets are written with the buffer of the item, and the buffer managers are paged, so items on
+                 * different pages can't share sets. Only pages after the first one take a place in the key.
+                 */
+                const auto& descType = bindingInfo.descType;
+                itUniDyn = std::find_if(itUniDyn, pDynamicItems.end(),
+                                        [&descType](const auto& pItem) { return pItem->getDescriptorType() == descType; });
+                if (itUniDyn != pDynamicItems.end()) {
+                    const auto page = static_cast<uint32_t>((*itUniDyn)->BUFFER_INFO.resourcesOffset);
+                    if (page > 0) {
+                        if (itDescSetsMapKey == descriptorSetsMapKey.end()) {
+                            assert(false && "No space left in key for the buffer page.");
+                            exit(EXIT_FAILURE);
+                        }
+                        *itDescSetsMapKey = Set::PAGE_KEY_BIT | page;
+                        itDescSetsMapKey++;
+                    }
+                    itUniDyn++;
+                }
             }
         }
 
@@ -24,18 +24,19 @@ class Manager : public Buffer::Manager::Base<TBase, TDerived, TSmartPointer> {
     using TManager = Buffer::Manager::Base<TBase, TDerived, TSmartPointer>;
 
    public:
-    Manager(const std::string &&name, const DESCRIPTOR &&descriptorType, const vk::DeviceSize &&maxSize,
-            const bool &&keepMapped, const std::string &&macroName = "N/A",
-            const vk::SharingMode &&sharingMode = vk::SharingMode::eExclusive, const vk::BufferCreateFlags &&flags = {})
+    Manager(const std::string &&name, const DESCRIPTOR &&descriptorType, const vk::DeviceSize &&pageSize,
+            const std::string &&macroName = "N/A",
+            const vk::SharingMode &&sharingMode = vk::SharingMode::eExclusive, const vk::BufferCreateFlags &&flags = {},
+            const bool &&deferFlush = false)
         : TManager(
               //
               std::forward<const std::string>(name),                              //
-              std::forward<const vk::DeviceSize>(maxSize),                        //
-              std::forward<const bool>(keepMapped),                               //
+              std::forward<const vk::DeviceSize>(pageSize),                       //
               std::visit(Descriptor::GetVulkanBufferUsage{}, descriptorType),     //
               std::visit(Descriptor::GetVulkanMemoryProperty{}, descriptorType),  //
               std::forward<const vk::SharingMode>(sharingMode),                   //
-              std::forward<const vk::BufferCreateFlags>(flags)),
+              std::forward<const vk::BufferCreateFlags>(flags),                   //
+              std::forward<const bool>(deferFlush)),
           DESCRIPTOR_TYPE(descriptorType),
           MACRO_NAME(macroName) {}
 
@@ -28,6 +28,8 @@ namespace Set {
 const uint32_t OFFSET_ALL = UINT32_MAX;
 
 using mapKey = std::array<uint32_t, 4>;
+// Marks a buffer page in a map key, so it can't be mistaken for a texture or item offset.
+const uint32_t PAGE_KEY_BIT = 0x80000000;
 
 class Base : public Handlee<Descriptor::Handler> {
     friend class Descriptor::Handler;
@@ -132,6 +132,8 @@ enum class PUSH_CONSTANT {
     HFF_COLUMN,
     FFT_ROW_COL_OFFSET,
     CDLOD,
+    CDLOD_SELECT,
+    OCEAN_DISPERSION,
 };
 
 enum class MESH {
@@ -206,6 +208,11 @@ enum class STORAGE_BUFFER_DYNAMIC {
     PRTCL_NORMAL,
     //
     NORMAL,
+    // CDLOD
+    CDLOD_NODE,
+    CDLOD_WORK,
+    CDLOD_INDIRECT,
+    CDLOD_INSTANCE,
     //
     DONT_CARE,
     VERTEX,  // Buffer usage only
@@ -253,6 +260,7 @@ enum class UNIFORM_DYNAMIC {
     TESS_PHONG,
     CDLOD_GRID,
     CDLOD_QUAD_TREE,
+    CDLOD_SELECT,
     CAMERA_PERSPECTIVE_BASIC,
     // WATER
     HFF,
@@ -388,7 +396,11 @@ enum class COMPUTE : uint32_t {
     // OCEAN
     OCEAN_DISP,
     OCEAN_FFT,
+    OCEAN_FFT_STOCKHAM,
     OCEAN_VERT_INPUT,
+    OCEAN_NORMAL,
+    // CDLOD
+    CDLOD_SELECT,
 #ifdef USE_VOLUMETRIC_LIGHTING
     // ...
 #endif
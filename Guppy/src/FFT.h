@@ -9,14 +9,14 @@
 #include <string_view>
 #include <vector>
 
+#include <Ocean/FFTTables.h>
+
 #include "BufferItem.h"
 #include "Descriptor.h"
 #include "DescriptorManager.h"
 #include "Pipeline.h"
 
 namespace FFT {
-std::vector<int16_t> MakeBitReversalOffsets(uint32_t N);
-std::vector<float> MakeTwiddleFactors(uint32_t N);
 using RowColumnOffset = int32_t;
 }  // namespace FFT
 
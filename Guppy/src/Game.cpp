@@ -30,6 +30,7 @@ Game::Settings::Settings()
       initialHeight(1080),
       queueCount(1),
       backBufferCount(3),
+      computeFramesInFlight(2),
       ticksPerSecond(30),
       vsync(true),
       animate(true),
@@ -63,7 +64,8 @@ Game::Settings::Settings()
       enableSampleShading(true),
       enableDoubleClicks(false),
       enableDirectoryListener(true),
-      assertOnRecompileShader(false) {
+      assertOnRecompileShader(false),
+      validateOceanOnCpu(false) {
 }
 
 Game::~Game() = default;
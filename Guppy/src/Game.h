@@ -55,6 +55,7 @@ class Game {
         int initialHeight;
         int queueCount;
         int backBufferCount;
+        int computeFramesInFlight;  // compute submissions that can be pending at once (ocean)
         int ticksPerSecond;
         bool vsync;
         bool animate;
@@ -80,6 +81,7 @@ class Game {
         bool enableDoubleClicks;
         bool enableDirectoryListener;
         bool assertOnRecompileShader;
+        bool validateOceanOnCpu;  // check the ocean compute work against Ocean::Simulation (slow)
     };
 
     Game(const Game &game) = delete;
@@ -179,6 +179,11 @@ void Guppy::frame() {
     handlers_.pUniform->frame();  // Camera updates happen here... this seems bad.
     handlers_.pScene->frame();
     handlers_.pParticle->frame();
+    handlers_.pMesh->frame();  // After anything that updates instance data.
+    // After anything that updates uniforms, or materials.
+    handlers_.pUniform->flush();
+    handlers_.pMaterial->flush();
+    handlers_.pParticle->flush();
     // DRAW
     handlers_.pPass->frame();
     // POST-DRAW
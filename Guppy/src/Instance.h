@@ -31,7 +31,7 @@ class Base : public virtual Buffer::Item {
     // doing anything more complicated atm.
     constexpr auto getActiveCount() const { return activeCount_; }
     constexpr void setActiveCount(uint32_t count) {
-        assert(count < BUFFER_INFO.count);
+        assert(count <= BUFFER_INFO.count);
         activeCount_ = (std::min)(count, BUFFER_INFO.count);
     }
 
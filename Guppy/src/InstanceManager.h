@@ -25,22 +25,19 @@ class Manager : public Buffer::Manager::Base<TBase, TDerived, std::shared_ptr> {
     using TManager = Buffer::Manager::Base<TBase, TDerived, std::shared_ptr>;
 
    public:
-    Manager(const std::string&& name, const vk::DeviceSize&& maxSize, const bool&& keepMapped = true,
-            const vk::BufferUsageFlagBits&& usage = vk::BufferUsageFlagBits::eVertexBuffer)
+    Manager(const std::string&& name, const vk::DeviceSize&& pageSize,
+            const vk::BufferUsageFlagBits&& usage = vk::BufferUsageFlagBits::eVertexBuffer, const bool&& deferFlush = false)
         : TManager(
               //
-              std::forward<const std::string>(name),        //
-              std::forward<const vk::DeviceSize>(maxSize),  //
-              std::forward<const bool>(keepMapped),         //
-              std::forward<const vk::BufferUsageFlagBits>(usage),
-              // This used to not have the vk::MemoryPropertyFlagBits::eHostCoherent set. It was needed to work
-              // with the macOS build. TBH I am not sure which would be faster - using the coherent bit,
-              // or flusing and invalidating. I just set the bit because I didn't know how to test it atm.
-              (vk::MemoryPropertyFlagBits::eHostVisible
-#if !(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK))
-                | vk::MemoryPropertyFlagBits::eDeviceLocal
-#endif
-               | vk::MemoryPropertyFlagBits::eHostCoherent)) {
+              std::forward<const std::string>(name),               //
+              std::forward<const vk::DeviceSize>(pageSize),        //
+              std::forward<const vk::BufferUsageFlagBits>(usage),  //
+              // This used to require device local, and coherent memory (coherent was needed to work with the macOS
+              // build). Now only host visible is required, and the rest is up to the preferences of the base class,
+              // which also flushes memory that isn't coherent.
+              vk::MemoryPropertyFlagBits::eHostVisible,  //
+              vk::SharingMode::eExclusive, {},           //
+              std::forward<const bool>(deferFlush)) {
     }
     virtual ~Manager() = default;
 
@@ -15,6 +15,12 @@ Loading::Handler::Handler(Game* pGame) : Game::Handler(pGame){};
 void Loading::Handler::init() {
     reset();
     tick();
+    if (stagingRing_.getSize() == 0) stagingRing_.init(shell().context(), STAGING_RING_SIZE);
+}
+
+void Loading::Handler::destroy() {
+    tick();
+    stagingRing_.destroy(shell().context());
 }
 
 // This used to be called cleanup but was executed during onTick, so I changed the name.
@@ -38,6 +44,7 @@ void Loading::Handler::tick() {
 // thread sync
 std::unique_ptr<LoadingResource> Loading::Handler::createLoadingResources() const {
     auto pLdgRes = std::make_unique<LoadingResource>();
+    pLdgRes->pStagingRing = &stagingRing_;
 
     // There should always be at least a graphics queue...
     vk::CommandBufferAllocateInfo allocInfo = {commandHandler().graphicsCmdPool(), vk::CommandBufferLevel::ePrimary, 1};
@@ -129,11 +136,10 @@ bool Loading::Handler::destroyResource(LoadingResource& resource) const {
 
     if (ready) {
         // Free stating resources
-        for (auto& res : resource.stgResources) {
-            ctx.dev.destroyBuffer(res.buffer, ctx.pAllocator);
-            ctx.dev.freeMemory(res.memory, ctx.pAllocator);
-        }
+        for (auto& res : resource.stgResources) ctx.destroyBuffer(res);
         resource.stgResources.clear();
+        for (const auto ticket : resource.stagingTickets) resource.pStagingRing->release(ticket);
+        resource.stagingTickets.clear();
 
         // Free fences
         for (auto& fence : resource.fences) ctx.dev.destroyFence(fence, ctx.pAllocator);
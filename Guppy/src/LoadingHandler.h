@@ -11,19 +11,22 @@
 #include <vulkan/vulkan.hpp>
 
 #include <Common/Helpers.h>
+#include <Common/StagingRing.h>
 #include <Common/Types.h>
 
 #include "Game.h"
 
 namespace Loading {
 
+constexpr vk::DeviceSize STAGING_RING_SIZE = 64 * 1024 * 1024;
+
 class Handler : public Game::Handler {
    public:
     Handler(Game *pGame);
 
     void init() override;
     void tick() override;
-    inline void destroy() override { tick(); };
+    void destroy() override;
 
     std::unique_ptr<LoadingResource> createLoadingResources() const;
     void loadSubmit(std::unique_ptr<LoadingResource> pLdgRes);
@@ -35,6 +38,8 @@ class Handler : public Game::Handler {
     bool destroyResource(LoadingResource &resource) const;
 
     std::vector<std::unique_ptr<LoadingResource>> ldgResources_;
+    // Shared by all the loading resources for their uploads (thread safe).
+    mutable StagingRing stagingRing_;
 };
 
 }  // namespace Loading
@@ -5,13 +5,16 @@
 
 #include "MaterialHandler.h"
 
+#include "RenderPassManager.h"
 #include "Shell.h"
+// HANDLERS
+#include "PassHandler.h"
 
 Material::Handler::Handler(Game* pGame)
     : Game::Handler(pGame),
       defMgr_{"Default Material", UNIFORM_DYNAMIC::MATERIAL_DEFAULT, 50},  //
       pbrMgr_{"PBR Material", UNIFORM_DYNAMIC::MATERIAL_PBR, 5},
-      obj3dMgr_{"Default Obj3d Material", UNIFORM_DYNAMIC::MATERIAL_OBJ3D, 50, true} {}
+      obj3dMgr_{"Default Obj3d Material", UNIFORM_DYNAMIC::MATERIAL_OBJ3D, 50} {}
 
 void Material::Handler::init() {
     reset();
@@ -20,6 +23,13 @@ void Material::Handler::init() {
     obj3dMgr_.init(shell().context());
 }
 
+void Material::Handler::flush() {
+    const auto frameIndex = passHandler().renderPassMgr().getFrameIndex();
+    defMgr_.flush(shell().context().dev, frameIndex);
+    pbrMgr_.flush(shell().context().dev, frameIndex);
+    obj3dMgr_.flush(shell().context().dev, frameIndex);
+}
+
 void Material::Handler::updateTexture(const std::shared_ptr<Texture::Base>& pTexture) {
     assert(pTexture->status == STATUS::READY);
     defMgr_.updateTexture(shell().context().dev, pTexture);
@@ -27,18 +27,20 @@ using ManagerType = Descriptor::Manager<Material::Base, TDerived, ItemPointer>;
 template <class TDerived>
 class Manager : public ManagerType<TDerived> {
    public:
-    Manager(const std::string &&name, const DESCRIPTOR &&descriptorType, const vk::DeviceSize &&maxSize,
-            const bool keepMapped = false)
+    Manager(const std::string &&name, const DESCRIPTOR &&descriptorType, const vk::DeviceSize &&pageSize)
         : ManagerType<TDerived>{
               std::forward<const std::string>(name),
               std::forward<const DESCRIPTOR>(descriptorType),
-              std::forward<const vk::DeviceSize>(maxSize),
-              std::forward<const bool>(keepMapped),
+              std::forward<const vk::DeviceSize>(pageSize),
+              "N/A",
+              vk::SharingMode::eExclusive,
+              {},
+              true,  // Flushed once a frame by the handler.
           } {}
 
     void updateTexture(const vk::Device &dev, const std::shared_ptr<Texture::Base> &pTexture) {
         for (auto &pItem : ManagerType<TDerived>::pItems)
-            if (pItem->getTexture() == pTexture) {
+            if (pItem && pItem->getTexture() == pTexture) {
                 pItem->setTextureData();
                 ManagerType<TDerived>::updateData(dev, pItem->BUFFER_INFO);
             }
@@ -76,6 +78,8 @@ class Handler : public Game::Handler {
     }
 
     void updateTexture(const std::shared_ptr<Texture::Base> &pTexture);
+    // Copies the material updates to the buffers. Called once a frame after all the updates.
+    void flush();
 
     template <typename TMaterialCreateInfo>
     std::shared_ptr<Material::Base> &makeMaterial(TMaterialCreateInfo *pCreateInfo) {
@@ -139,29 +139,21 @@ void Mesh::Base::loadBuffers() {
     vk::BufferUsageFlags vertexUsage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer;
 
     // Vertex buffer
-    BufferResource stgRes = {};
-    ctx.createBuffer(pLdgRes_->transferCmd, vertexUsage, getVertexBufferSize(), NAME + " vertex", stgRes, vertexRes_,
-                     getVertexData(), MAPPABLE);
-    pLdgRes_->stgResources.push_back(std::move(stgRes));
+    ctx.createBuffer(*pLdgRes_, vertexUsage, getVertexBufferSize(), NAME + " vertex", vertexRes_, getVertexData(), MAPPABLE);
 
     vk::BufferUsageFlags indexUsage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer;
 
     // Index buffer
     if (getIndexCount()) {
-        stgRes = {};
-        ctx.createBuffer(pLdgRes_->transferCmd, indexUsage, getIndexBufferSize(), NAME + " index", stgRes, indexRes_,
-                         getIndexData(), MAPPABLE);
-        pLdgRes_->stgResources.push_back(std::move(stgRes));
+        ctx.createBuffer(*pLdgRes_, indexUsage, getIndexBufferSize(), NAME + " index", indexRes_, getIndexData(), MAPPABLE);
     }
 
     // Index adjacency buffer
     if (indicesAdjaceny_.size()) {
         // TODO: I should probably either create this buffer or the normal index buffer. If you
         // update this then you should also do this everywhere like "updateBuffers" for example.
-        stgRes = {};
-        ctx.createBuffer(pLdgRes_->transferCmd, indexUsage, getIndexBufferAdjSize(), NAME + " adjacency index", stgRes,
-                         indexAdjacencyRes_, indicesAdjaceny_.data(), MAPPABLE);
-        pLdgRes_->stgResources.push_back(std::move(stgRes));
+        ctx.createBuffer(*pLdgRes_, indexUsage, getIndexBufferAdjSize(), NAME + " adjacency index", indexAdjacencyRes_,
+                         indicesAdjaceny_.data(), MAPPABLE);
     }
 }
 
@@ -174,10 +166,10 @@ void Mesh::Base::createBufferData(const vk::CommandBuffer& cmd, BufferResource&
     res.memoryRequirements.size =
         helpers::createBuffer(ctx.dev, bufferSize, vk::BufferUsageFlagBits::eTransferSrc,
                               vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                              ctx.memProps, stgRes.buffer, stgRes.memory, ctx.pAllocator);
+                              ctx.memAllocator, stgRes.buffer, stgRes.allocation, ctx.pAllocator);
 
     // FILL STAGING BUFFER ON DEVICE
-    void* pData = ctx.dev.mapMemory(stgRes.memory, 0, res.memoryRequirements.size);
+    void* pData = stgRes.allocation.pMappedData;
     /*
      *  You can now simply memcpy the vertex data to the mapped memory and unmap it again using unmapMemory.
      *  Unfortunately the driver may not immediately copy the data into the buffer memory, for example because
@@ -191,14 +183,13 @@ void Mesh::Base::createBufferData(const vk::CommandBuffer& cmd, BufferResource&
      *  but we'll see why that doesn't matter in the next chapter.
      */
     memcpy(pData, data, static_cast<size_t>(bufferSize));
-    ctx.dev.unmapMemory(stgRes.memory);
 
     // FAST VERTEX BUFFER
     vk::MemoryPropertyFlags memProps = vk::MemoryPropertyFlagBits::eDeviceLocal;
     if (MAPPABLE) memProps |= vk::MemoryPropertyFlagBits::eHostVisible;
     helpers::createBuffer(ctx.dev, bufferSize,
                           // TODO: probably don't need to check memory requirements again
-                          usage, memProps, ctx.memProps, res.buffer, res.memory, ctx.pAllocator);
+                          usage, memProps, ctx.memAllocator, res.buffer, res.allocation, ctx.pAllocator);
 
     // COPY FROM STAGING TO FAST
     helpers::copyBuffer(cmd, stgRes.buffer, res.buffer, res.memoryRequirements.size);
@@ -214,28 +205,26 @@ void Mesh::Base::addVertex(const Face& face) {
 }
 
 void Mesh::Base::updateBuffers() {
-    auto& dev = handler().shell().context().dev;
+    // The memory allocator keeps host visible memory mapped, but it might not be coherent.
+    const auto& memAllocator = handler().shell().context().memAllocator;
 
     // VERTEX BUFFER
     vk::DeviceSize bufferSize = getVertexBufferSize(true);
-    void* pData = dev.mapMemory(vertexRes_.memory, 0, VK_WHOLE_SIZE);
-    memcpy(pData, getVertexData(), static_cast<size_t>(bufferSize));
-    dev.unmapMemory(vertexRes_.memory);
+    memcpy(vertexRes_.allocation.pMappedData, getVertexData(), static_cast<size_t>(bufferSize));
+    memAllocator.flush(vertexRes_.allocation, 0, bufferSize);
 
     // INDEX BUFFER
     if (getIndexCount()) {
         bufferSize = getIndexBufferSize(true);
-        pData = dev.mapMemory(indexRes_.memory, 0, indexRes_.memoryRequirements.size);
-        memcpy(pData, getIndexData(), static_cast<size_t>(bufferSize));
-        dev.unmapMemory(indexRes_.memory);
+        memcpy(indexRes_.allocation.pMappedData, getIndexData(), static_cast<size_t>(bufferSize));
+        memAllocator.flush(indexRes_.allocation, 0, bufferSize);
     }
 
     // INDEX BUFFER (ADJACENCY)
     if (indicesAdjaceny_.size()) {
         bufferSize = getIndexBufferAdjSize(true);
-        pData = dev.mapMemory(indexAdjacencyRes_.memory, 0, indexAdjacencyRes_.memoryRequirements.size);
-        memcpy(pData, indicesAdjaceny_.data(), static_cast<size_t>(bufferSize));
-        dev.unmapMemory(indexAdjacencyRes_.memory);
+        memcpy(indexAdjacencyRes_.allocation.pMappedData, indicesAdjaceny_.data(), static_cast<size_t>(bufferSize));
+        memAllocator.flush(indexAdjacencyRes_.allocation, 0, bufferSize);
     }
 }
 
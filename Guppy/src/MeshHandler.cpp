@@ -5,13 +5,15 @@
 
 #include "MeshHandler.h"
 
+#include "RenderPassManager.h"
 #include "Shell.h"
 // HANDLERS
+#include "PassHandler.h"
 #include "SceneHandler.h"
 
 Mesh::Handler::Handler(Game* pGame)
-    : Game::Handler(pGame),                                          //
-      instObj3dMgr_{"Instance Object 3d Data", (2 * 1000000) + 100}  //
+    : Game::Handler(pGame),  //
+      instObj3dMgr_{"Instance Object 3d Data", 100000, vk::BufferUsageFlagBits::eVertexBuffer, true}  //
 {}
 
 void Mesh::Handler::init() {
@@ -20,6 +22,11 @@ void Mesh::Handler::init() {
     instObj3dMgr_.init(shell().context());
 }
 
+void Mesh::Handler::frame() {
+    // Instance updates are only marked dirty, and copied to the buffer here all at once.
+    instObj3dMgr_.flush(shell().context().dev, passHandler().renderPassMgr().getFrameIndex());
+}
+
 void Mesh::Handler::tick() {
     // Check loading futures...
     if (!ldgFutures_.empty()) {
@@ -76,7 +83,10 @@ bool Mesh::Handler::checkOffset(const MESH type, const Mesh::index offset) {
 }
 
 void Mesh::Handler::removeMesh(std::unique_ptr<Mesh::Base>& pMesh) {
-    // TODO...
+    // TODO: This needs the scene offsets, and the draw loops to skip removed meshes first. Then the mesh can be
+    // destroyed, and its instance data freed with "instObj3dMgr_.remove(pMesh->pInstObj3d_->BUFFER_INFO)" when no
+    // other mesh shares it ("pInstObj3d_.use_count()"). Buffer::Manager::Base::remove holds the slots back for the
+    // frames in flight.
     assert(false);
 }
 
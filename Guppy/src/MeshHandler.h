@@ -66,6 +66,7 @@ class Handler : public Game::Handler {
 
     void init() override;
     void tick() override;
+    void frame() override;
 
     bool checkOffset(const MESH type, const Mesh::index offset);
 
@@ -5,13 +5,18 @@
 
 #include "Ocean.h"
 
+#include <algorithm>
 #include <cmath>
-#include <complex>
-#include <random>
+#include <cstring>
+#include <glm/gtc/constants.hpp>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <utility>
 
 #include <Common/Helpers.h>
 
+#include "Cdlod.h"
 #include "Deferred.h"
 #include "FFT.h"
 #include "OceanRenderer.h"
@@ -22,19 +27,10 @@
 #include "PipelineHandler.h"
 #include "PassHandler.h"
 #include "TextureHandler.h"
+#include "UniformHandler.h"
 
 namespace {
 
-float phillipsSpectrum(const glm::vec2 k, const float kMagnitude, const Ocean::SurfaceCreateInfo& info) {
-    if (kMagnitude < 1e-5f) return 0.0f;
-    float kHatOmegaHat = glm::dot(k, info.omega) / kMagnitude;  // cosine factor
-    float kMagnitude2 = kMagnitude * kMagnitude;
-    float damp = exp(-kMagnitude2 * info.l * info.l);
-    float phk = info.A * damp * (exp(-1.0f / (kMagnitude2 * info.L * info.L)) / (kMagnitude2 * kMagnitude2)) *
-                (kHatOmegaHat * kHatOmegaHat);
-    return phk;
-}
-
 Sampler::CreateInfo getDefaultOceanSampCreateInfo(const std::string&& name, const uint32_t N, const uint32_t M,
                                                   const vk::ImageUsageFlags usageFlags,
                                                   const std::vector<Sampler::LayerInfo> layerInfos) {
@@ -59,7 +55,7 @@ Texture::CreateInfo makeDefaultVertInputSampCreateInfo(const std::string&& name,
                                                        const DESCRIPTOR descriptorType) {
     const std::vector<Sampler::LayerInfo> layerInfos = {
         {::Sampler::USAGE::POSITION},  // position
-        {::Sampler::USAGE::NORMAL},    // normal
+        {::Sampler::USAGE::NORMAL},    // normal (.w: jacobian determinant)
     };
     auto sampInfo = getDefaultOceanSampCreateInfo(name + " Sampler", N, M, usageFlags, layerInfos);
     sampInfo.type = SAMPLER::DEFAULT;
@@ -145,6 +141,47 @@ void MakeHeightmapVertexInput(const uint32_t X,                     //
 
 }  // namespace
 
+namespace Ocean {
+SpectrumCache::Key GetSpectrumCacheKey(const SurfaceCreateInfo& info) {
+    return {
+        info.Lx, info.Lz, info.N, info.M, info.V, info.omega.x, info.omega.y, info.l, info.A, info.L, info.lambda, info.seed,
+    };
+}
+
+glm::vec2 GetDisplacementBounds(const SurfaceCreateInfo& info) {
+    // The largest of N * M roughly gaussian samples stays within about five standard deviations.
+    constexpr float SIGMAS = 5.0f;
+
+    // The bounds only depend on the spectrum, so keep the last result. The surface is rebuilt with the same parameters
+    // far more often than the parameters change.
+    static std::mutex cacheMutex;
+    static std::optional<std::pair<SpectrumCache::Key, glm::vec2>> cache;
+    const auto key = GetSpectrumCacheKey(info);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cache && SpectrumCache::IsSameKey(cache->first, key)) return cache->second;
+
+    std::vector<float> wave(info.N * info.M * 4), hTilde0(info.N * info.M * 4);
+    if (!SpectrumCache::Load(SPECTRUM_CACHE_PATH, key, wave.data(), hTilde0.data()))
+        MakeWaveFourierData(info, wave.data(), hTilde0.data());
+
+    // Variance of the height and of the horizontal displacement. Each wave contributes |h~0(k)|^2 + |h~0(-k)|^2, and the
+    // displacement is the height scaled by lambda * k / |k| (zero for the tiny wave vectors, same as the dispersion).
+    double heightVar = 0.0, dispVar = 0.0;
+    for (size_t i = 0; i < wave.size(); i += 4) {
+        const double power = (hTilde0[i + 0] * hTilde0[i + 0]) + (hTilde0[i + 1] * hTilde0[i + 1]) +
+                             (hTilde0[i + 2] * hTilde0[i + 2]) + (hTilde0[i + 3] * hTilde0[i + 3]);
+        heightVar += power;
+        if (wave[i + 2] >= 1e-6f) dispVar += power;
+    }
+    const glm::vec2 bounds = {
+        SIGMAS * static_cast<float>(std::sqrt(heightVar)),
+        SIGMAS * std::abs(info.lambda) * static_cast<float>(std::sqrt(dispVar)),
+    };
+    cache = std::make_pair(key, bounds);
+    return bounds;
+}
+}  // namespace Ocean
+
 // BUFFER VIEW
 namespace BufferView {
 namespace Ocean {
@@ -152,7 +189,7 @@ void MakeResources(Texture::Handler& handler, const ::Ocean::SurfaceCreateInfo&
     auto bitRevOffsets = ::FFT::MakeBitReversalOffsets(info.N);
     handler.makeBufferView(BufferView::Ocean::FFT_BIT_REVERSAL_OFFSETS_N_ID, vk::Format::eR16Sint,
                            sizeof(uint16_t) * bitRevOffsets.size(), bitRevOffsets.data());
-    if (info.N != info.M) bitRevOffsets = ::FFT::MakeBitReversalOffsets(info.N);
+    if (info.N != info.M) bitRevOffsets = ::FFT::MakeBitReversalOffsets(info.M);
     handler.makeBufferView(BufferView::Ocean::FFT_BIT_REVERSAL_OFFSETS_M_ID, vk::Format::eR16Sint,
                            sizeof(uint16_t) * bitRevOffsets.size(), bitRevOffsets.data());
     auto twiddleFactors = ::FFT::MakeTwiddleFactors((std::max)(info.N, info.M));
@@ -170,9 +207,6 @@ void MakeResources(Texture::Handler& handler, const ::Ocean::SurfaceCreateInfo&
 
     using namespace Texture::Ocean;
 
-    std::default_random_engine gen;
-    std::normal_distribution<float> dist(0.0, 1.0);
-
     auto dataSize = (static_cast<uint64_t>(info.N) * 4) * static_cast<uint64_t>(info.M) * sizeof(float);
 
     // Wave vector data
@@ -183,41 +217,11 @@ void MakeResources(Texture::Handler& handler, const ::Ocean::SurfaceCreateInfo&
     float* pHTilde0 = (float*)malloc(dataSize);
     assert(pHTilde0);
 
-    const int halfN = info.N / 2, halfM = info.M / 2;
-    int idx;
-    float kx, kz, kMagnitude, phk;
-    std::complex<float> hTilde0, hTilde0Conj, xhi;
-
-    for (int i = 0, m = -halfM; i < static_cast<int>(info.M); i++, m++) {
-        for (int j = 0, n = -halfN; j < static_cast<int>(info.N); j++, n++) {
-            idx = (i * info.N * 4) + (j * 4);
-
-            {  // Wave vector data
-                kx = 2.0f * glm::pi<float>() * n / info.Lx;
-                kz = 2.0f * glm::pi<float>() * m / info.Lz;
-                kMagnitude = sqrt(kx * kx + kz * kz);
-
-                pWave[idx + 0] = kx;
-                pWave[idx + 1] = kz;
-                pWave[idx + 2] = kMagnitude;
-                pWave[idx + 3] = sqrt(::Ocean::g * kMagnitude);
-            }
-
-            {  // Fourier domain data
-                phk = phillipsSpectrum({kx, kz}, kMagnitude, info);
-                xhi = {dist(gen), dist(gen)};
-                hTilde0 = xhi * sqrt(phk / 2.0f);
-                // conjugate
-                phk = phillipsSpectrum({-kx, -kz}, kMagnitude, info);
-                xhi = {dist(gen), dist(gen)};
-                hTilde0Conj = std::conj(xhi * sqrt(phk / 2.0f));
-
-                pHTilde0[idx + 0] = hTilde0.real();
-                pHTilde0[idx + 1] = hTilde0.imag();
-                pHTilde0[idx + 2] = hTilde0Conj.real();
-                pHTilde0[idx + 3] = hTilde0Conj.imag();
-            }
-        }
+    // The data only depends on the create info, so reuse it from the last run with the same parameters when possible.
+    const auto cacheKey = ::Ocean::GetSpectrumCacheKey(info);
+    if (!::Ocean::SpectrumCache::Load(::Ocean::SPECTRUM_CACHE_PATH, cacheKey, pWave, pHTilde0)) {
+        ::Ocean::MakeWaveFourierData(info, pWave, pHTilde0);
+        ::Ocean::SpectrumCache::Store(::Ocean::SPECTRUM_CACHE_PATH, cacheKey, pWave, pHTilde0);
     }
 
     {  // Create textures
@@ -249,7 +253,6 @@ void MakeResources(Texture::Handler& handler, const ::Ocean::SurfaceCreateInfo&
         // Dispersion relation
         std::vector<Sampler::LayerInfo> layerInfos = {
             {::Sampler::USAGE::HEIGHT},    // fourier domain dispersion relation (height)
-            {::Sampler::USAGE::NORMAL},    // fourier domain dispersion relation (slope)
             {::Sampler::USAGE::DONT_CARE}  // fourier domain dispersion relation (differential)
         };
         sampInfo = getDefaultOceanSampCreateInfo(std::string(DISP_REL_ID) + " Sampler", info.N, info.M,
@@ -257,20 +260,25 @@ void MakeResources(Texture::Handler& handler, const ::Ocean::SurfaceCreateInfo&
         texInfo = {std::string(DISP_REL_ID), {sampInfo}, false, false, STORAGE_IMAGE::PIPELINE};
         handler.make(&texInfo);
 
-        // Vertex shader input
-        texInfo = makeDefaultVertInputSampCreateInfo(
+        /* Vertex shader input. There is one per framebuffer so that the compute work can write the one the next frame
+         * draws with while the current frames still sample the others. They stay in the general layout, and are storage
+         * images for the compute work and combined samplers for the surface shaders. These are made here instead of with
+         * the rest of the per-framebuffer textures in the texture handler because the dimensions aren't known until now.
+         */
+        const auto vertInputTexInfo = makeDefaultVertInputSampCreateInfo(
             std::string(VERT_INPUT_ID), info.N, info.M,
-            (vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc), STORAGE_IMAGE::PIPELINE);
-        handler.make(&texInfo);
+            (vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc),
+            STORAGE_IMAGE::PIPELINE);
+        for (uint32_t i = 0; i < handler.shell().context().imageCount; i++) {
+            texInfo = vertInputTexInfo;
+            texInfo.perFramebuffer = true;
+            texInfo.name += Texture::Handler::getIdSuffix(i);
+            for (auto& vertInputSampInfo : texInfo.samplerCreateInfos)
+                vertInputSampInfo.name += Texture::Handler::getIdSuffix(i);
+            handler.make(&texInfo);
+        }
     }
 }
-CreateInfo MakeCopyTexInfo(const uint32_t N, const uint32_t M) {
-    auto texInfo = makeDefaultVertInputSampCreateInfo(
-        std::string(VERT_INPUT_COPY_ID), N, M, (vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled),
-        COMBINED_SAMPLER::PIPELINE);
-    texInfo.perFramebuffer = true;
-    return texInfo;
-}
 }  // namespace Ocean
 }  // namespace Texture
 
@@ -322,7 +330,7 @@ const CreateInfo OCEAN_DRAW_CREATE_INFO = {
     {
         {{0, 0}, {UNIFORM::CAMERA_PERSPECTIVE_DEFAULT}},
         {{1, 0}, {UNIFORM_DYNAMIC::MATERIAL_DEFAULT}},
-        {{2, 0}, {COMBINED_SAMPLER::PIPELINE, Texture::Ocean::VERT_INPUT_COPY_ID}},
+        {{2, 0}, {COMBINED_SAMPLER::PIPELINE, Texture::Ocean::VERT_INPUT_ID}},
     },
 };
 }  // namespace Set
@@ -498,6 +506,10 @@ const CreateInfo OCEAN_WF_CDLOD_CREATE_INFO = {
     {PUSH_CONSTANT::CDLOD},
 };
 WireframeCdlod::WireframeCdlod(Handler& handler) : Wireframe(handler, &OCEAN_WF_CDLOD_CREATE_INFO) {}
+// Same vertex input as the terrain (grid mesh and Instance::Cdlod::Node) because CDLODRenderer::Render draws it.
+void WireframeCdlod::getInputAssemblyInfoResources(CreateInfoResources& createInfoRes) {
+    Cdlod::GetCdlodInputAssemblyInfoResource(createInfoRes);
+}
 
 // SURFACE (CDLOD)
 const CreateInfo OCEAN_SURFACE_CDLOD_CREATE_INFO = {
@@ -512,6 +524,9 @@ const CreateInfo OCEAN_SURFACE_CDLOD_CREATE_INFO = {
     {PUSH_CONSTANT::CDLOD},
 };
 SurfaceCdlod::SurfaceCdlod(Handler& handler) : Surface(handler, &OCEAN_SURFACE_CDLOD_CREATE_INFO) {}
+void SurfaceCdlod::getInputAssemblyInfoResources(CreateInfoResources& createInfoRes) {
+    Cdlod::GetCdlodInputAssemblyInfoResource(createInfoRes);
+}
 
 }  // namespace Ocean
 }  // namespace Pipeline
@@ -542,11 +557,33 @@ void DATA::getInputDescriptions(Pipeline::CreateInfoResources& createInfoRes) {
     createInfoRes.attrDescs.back().location = static_cast<uint32_t>(createInfoRes.attrDescs.size() - 1);
     createInfoRes.attrDescs.back().format = vk::Format::eR32G32B32A32Sfloat;  // vec4
     createInfoRes.attrDescs.back().offset = static_cast<uint32_t>(offset);
+
+    // data2
+    offset = offsetof(DATA, data2);
+    createInfoRes.attrDescs.push_back({});
+    createInfoRes.attrDescs.back().binding = BINDING;
+    createInfoRes.attrDescs.back().location = static_cast<uint32_t>(createInfoRes.attrDescs.size() - 1);
+    createInfoRes.attrDescs.back().format = vk::Format::eR32G32B32A32Sfloat;  // vec4
+    createInfoRes.attrDescs.back().offset = static_cast<uint32_t>(offset);
+
+    // data3
+    offset = offsetof(DATA, data3);
+    createInfoRes.attrDescs.push_back({});
+    createInfoRes.attrDescs.back().binding = BINDING;
+    createInfoRes.attrDescs.back().location = static_cast<uint32_t>(createInfoRes.attrDescs.size() - 1);
+    createInfoRes.attrDescs.back().format = vk::Format::eR32G32B32A32Sfloat;  // vec4
+    createInfoRes.attrDescs.back().offset = static_cast<uint32_t>(offset);
 }
 Base::Base(const Buffer::Info&& info, DATA* pData)
     : Buffer::Item(std::forward<const Buffer::Info>(info)), Buffer::DataItem<DATA>(pData) {
     dirty = true;
 }
+void Base::setInstances(const DATA* pData, const uint32_t count) {
+    assert(count <= BUFFER_INFO.count);
+    if (count) std::memcpy(pData_, pData, sizeof(DATA) * count);
+    setActiveCount(count);
+    dirty = true;
+}
 }  // namespace Ocean
 }  // namespace Cdlod
 }  // namespace Instance
@@ -559,41 +596,52 @@ OceanSurface::OceanSurface(Pass::Handler& handler, const OceanCreateInfo* pCreat
       pRenderer_(pRenderer),
       surfaceInfo_(pCreateInfo->surfaceInfo),
       gridMeshDims_(0),
-      gridMesh_(handler.shell().context()),
-      pInstanceData_(nullptr) {
+      displacementBounds_(),
+      patchCountX_(0),
+      patchCountZ_(0) {
     // Validate the surface info.
-    assert(surfaceInfo_.N == surfaceInfo_.M);  // Needs to be square currently.
-    assert(surfaceInfo_.N == ::Ocean::FFT_LOCAL_SIZE * ::Ocean::FFT_WORKGROUP_SIZE);
-    assert(surfaceInfo_.N == ::Ocean::DISP_LOCAL_SIZE * ::Ocean::DISP_WORKGROUP_SIZE);
-    assert(helpers::isPowerOfTwo(surfaceInfo_.N) && helpers::isPowerOfTwo(surfaceInfo_.M));
+    assert(::Ocean::IsValid(surfaceInfo_));
 
     drawMode = GRAPHICS::OCEAN_SURFACE_CDLOD_DEFERRED;
     status_ |= STATUS::PENDING_BUFFERS;
 }
 
 void OceanSurface::init() {
-    {  // Create the instance data
-        assert(surfaceInfo_.N == surfaceInfo_.M);
-        gridMeshDims_ = 32;
+    const auto& ctx = handler().shell().context();
 
-        const uint32_t instanceCount = surfaceInfo_.N / gridMeshDims_;
+    {  // Create the grid meshes. Each LOD halves the dimensions, and the smallest one is at least 4x4.
+        gridMeshDims_ = (std::min)(32u, (std::min)(surfaceInfo_.N, surfaceInfo_.M));
+
+        const uint32_t lodCount =
+            (std::max)(1u, (std::min)(::Ocean::PATCH_LOD_COUNT, static_cast<uint32_t>(std::log2(gridMeshDims_))));
+        gridMeshes_.reserve(lodCount);
+        for (uint32_t lod = 0; lod < lodCount; lod++) {
+            gridMeshes_.emplace_back(ctx);
+            gridMeshes_.back().SetDimensions(gridMeshDims_ >> lod);
+        }
+    }
+
+    {  // Create the patches
+        patchCountX_ = surfaceInfo_.N / gridMeshDims_;
+        patchCountZ_ = surfaceInfo_.M / gridMeshDims_;
+        const auto instanceCountX = patchCountX_;
+        const auto instanceCountZ = patchCountZ_;
         // This is just for testing. I removed the model matrix from the vertex input, so this is what centers the debug
         // ocean quad.
         const glm::vec2 offset = {-(surfaceInfo_.Lx / 2.0f), -(surfaceInfo_.Lz / 2.0f)};
 
-        Instance::Cdlod::Ocean::CreateInfo instInfo = {};
         Instance::Cdlod::Ocean::DATA instData = {};
 
         // Scale (This is really uniform (dynamic) data)
-        instData.data0.z = surfaceInfo_.Lx / instanceCount;
-        instData.data0.w = surfaceInfo_.Lz / instanceCount;
-        instData.data1.z = 1.0f / instanceCount;
-        instData.data1.w = 1.0f / instanceCount;
+        instData.data0.z = surfaceInfo_.Lx / instanceCountX;
+        instData.data0.w = surfaceInfo_.Lz / instanceCountZ;
+        instData.data1.z = 1.0f / instanceCountX;
+        instData.data1.w = 1.0f / instanceCountZ;
 
-        for (float y = 0; y < instanceCount; y++) {
-            float v = glm::mix(0.0f, 1.0f, (y / instanceCount));
-            for (float x = 0; x < instanceCount; x++) {
-                float u = glm::mix(0.0f, 1.0f, (x / instanceCount));
+        for (float y = 0; y < instanceCountZ; y++) {
+            float v = glm::mix(0.0f, 1.0f, (y / instanceCountZ));
+            for (float x = 0; x < instanceCountX; x++) {
+                float u = glm::mix(0.0f, 1.0f, (x / instanceCountX));
 
                 // Offset
                 instData.data0.x = glm::mix(0.0f, surfaceInfo_.Lx, u) + offset.x;
@@ -601,11 +649,21 @@ void OceanSurface::init() {
                 instData.data1.x = u;
                 instData.data1.y = v;
 
-                instInfo.data.push_back(instData);
+                patchData_.push_back(instData);
+                patches_.push_back({{instData.data0.x, instData.data0.y}, {instData.data0.z, instData.data0.w}});
             }
         }
 
-        pInstanceData_ = pRenderer_->makeInstance(&instInfo);
+        displacementBounds_ = ::Ocean::GetDisplacementBounds(surfaceInfo_);
+        selectedData_.resize(patchData_.size());
+    }
+
+    {  // Create the instance data. The selection is written every frame, so each framebuffer gets its own buffer.
+        for (uint32_t i = 0; i < ctx.imageCount; i++) {
+            Instance::Cdlod::Ocean::CreateInfo instInfo = {};
+            instInfo.data = patchData_;
+            pInstanceData_.push_back(pRenderer_->makeInstance(&instInfo));
+        }
     }
 }
 
@@ -613,9 +671,74 @@ void OceanSurface::destroy() {
     pRenderer_ = nullptr;
     surfaceInfo_ = {};
     gridMeshDims_ = 0;
-    gridMesh_.destroy();
-    assert(pInstanceData_.use_count() == 1);
-    pInstanceData_ = nullptr;
+    for (auto& gridMesh : gridMeshes_) gridMesh.destroy();
+    gridMeshes_.clear();
+    displacementBounds_ = {};
+    patchCountX_ = 0;
+    patchCountZ_ = 0;
+    patches_.clear();
+    patchData_.clear();
+    selection_.clear();
+    selectedData_.clear();
+    for (auto& pInstanceData : pInstanceData_) assert(pInstanceData.use_count() == 1);
+    pInstanceData_.clear();
+}
+
+void OceanSurface::selectPatches(const uint8_t frameIndex) {
+    auto& uniformHandler = handler().uniformHandler();
+    const auto& camera = uniformHandler.hasDebugCamera() ? uniformHandler.getDebugCamera() : uniformHandler.getMainCamera();
+
+    ::Ocean::PatchSelectInfo selectInfo = {};
+    selectInfo.planes = camera.getFrustumPlanes();
+    selectInfo.eye = camera.getPosition();
+    selectInfo.maxHeight = displacementBounds_.x;
+    selectInfo.maxDisplacement = displacementBounds_.y;
+    // LOD 1 starts two patches away from the eye.
+    selectInfo.lodDistance = 2.0f * (std::max)(patches_.front().scale.x, patches_.front().scale.y);
+    selectInfo.lodCount = static_cast<uint32_t>(gridMeshes_.size());
+
+    ::Ocean::SelectPatches(selectInfo, patches_, selection_);
+
+    const auto count = static_cast<uint32_t>(selection_.indices.size());
+    for (uint32_t i = 0; i < count; i++) {
+        const auto index = selection_.indices[i];
+        const auto lod = selection_.patchLods[index];
+        const auto meshDim = static_cast<float>(gridMeshes_[lod].GetDimensions());
+
+        auto& data = selectedData_[i];
+        data = patchData_[index];
+
+        // Stitching: the edge vertices snap to the grid of a coarser neighbour so that the shared edges match exactly.
+        const auto neighbourLods = ::Ocean::GetNeighbourLods(selection_, patchCountX_, patchCountZ_, index);
+        for (uint32_t edge = 0; edge < 4; edge++) {
+            data.data2[edge] =
+                neighbourLods[edge] > lod ? 1.0f / static_cast<float>(gridMeshes_[neighbourLods[edge]].GetDimensions())
+                                          : 0.0f;
+        }
+
+        // Geomorph: the interior vertices morph to the next LOD's grid over the last 30% of this LOD's distance range. The
+        // last LOD has nothing to morph to.
+        data.data3.x = meshDim;
+        if (lod + 1 < selectInfo.lodCount) {
+            data.data3.z = selectInfo.lodDistance * static_cast<float>(1u << lod);
+            data.data3.y = data.data3.z * 0.7f;
+        } else {
+            data.data3.y = data.data3.z = 0.0f;
+        }
+    }
+
+    auto& pInstanceData = pInstanceData_[frameIndex];
+    pInstanceData->setInstances(selectedData_.data(), count);
+    pRenderer_->updateInstance(pInstanceData->BUFFER_INFO);
+}
+
+// Select once per frame. Every pipeline recorded for the frame draws the same selection.
+void OceanSurface::frame() {
+    // The CDLOD modes are drawn by Ocean::Renderer (CDLODRenderer::Render), so they don't use the patches.
+    if (!draw_ || status_ != STATUS::READY || drawMode == GRAPHICS::OCEAN_WF_CDLOD_DEFERRED ||
+        drawMode == GRAPHICS::OCEAN_SURFACE_CDLOD_DEFERRED)
+        return;
+    selectPatches(handler().passHandler().renderPassMgr().getFrameIndex());
 }
 
 void OceanSurface::record(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
@@ -636,16 +759,26 @@ void OceanSurface::record(const PASS passType, const std::shared_ptr<Pipeline::B
         case GRAPHICS::OCEAN_WF_TESS_DEFERRED:
         case GRAPHICS::OCEAN_SURFACE_TESS_DEFERRED:
 #endif
-        case GRAPHICS::OCEAN_WF_CDLOD_DEFERRED:
-        case GRAPHICS::OCEAN_SURFACE_CDLOD_DEFERRED: {
-            const std::vector<vk::Buffer> buffers = {gridMesh_.GetVertexBuffer().buffer,
-                                                     pInstanceData_->BUFFER_INFO.bufferInfo.buffer};
-            const std::vector<vk::DeviceSize> offsets = {0, pInstanceData_->BUFFER_INFO.memoryOffset};
-            cmd.bindVertexBuffers(0, buffers, offsets);
-            cmd.bindIndexBuffer(gridMesh_.GetIndexBuffer().buffer, 0, vk::IndexType::eUint32);
-
-            const int totalIndices = gridMesh_.GetDimensions() * gridMesh_.GetDimensions() * 2 * 3;
-            cmd.drawIndexed(totalIndices, pInstanceData_->BUFFER_INFO.count, 0, 0, 0);
+        {
+            // frame() normally selected already. Otherwise (the first frame drawn) select now.
+            if (selection_.lodCounts.empty()) selectPatches(frameIndex);
+            const auto& pInstanceData = pInstanceData_[frameIndex];
+
+            // One draw per LOD. The selection is grouped by LOD, so each one is a range of the instance buffer.
+            for (uint32_t lod = 0; lod < static_cast<uint32_t>(gridMeshes_.size()); lod++) {
+                const auto instanceCount = selection_.lodCounts[lod];
+                if (instanceCount == 0) continue;
+
+                const auto& gridMesh = gridMeshes_[lod];
+                const std::vector<vk::Buffer> buffers = {gridMesh.GetVertexBuffer().buffer,
+                                                         pInstanceData->BUFFER_INFO.bufferInfo.buffer};
+                const std::vector<vk::DeviceSize> offsets = {0, pInstanceData->BUFFER_INFO.memoryOffset};
+                cmd.bindVertexBuffers(0, buffers, offsets);
+                cmd.bindIndexBuffer(gridMesh.GetIndexBuffer().buffer, 0, vk::IndexType::eUint32);
+
+                const int totalIndices = gridMesh.GetDimensions() * gridMesh.GetDimensions() * 2 * 3;
+                cmd.drawIndexed(totalIndices, instanceCount, 0, 0, selection_.getFirst(lod));
+            }
         } break;
         default: {
             assert(false);
@@ -654,11 +787,7 @@ void OceanSurface::record(const PASS passType, const std::shared_ptr<Pipeline::B
 }
 
 void OceanSurface::load(std::unique_ptr<LoadingResource>& pLdgRes) {
-    const auto& ctx = handler().shell().context();
-
-    assert(surfaceInfo_.N == surfaceInfo_.M);
-    gridMesh_.SetDimensions(gridMeshDims_);
-    gridMesh_.CreateBuffers(*pLdgRes);
+    for (auto& gridMesh : gridMeshes_) gridMesh.CreateBuffers(*pLdgRes);
 }
 
 }  // namespace GraphicsWork
\ No newline at end of file
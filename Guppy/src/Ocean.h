@@ -9,14 +9,18 @@
 #include <glm/glm.hpp>
 #include <memory>
 #include <string_view>
+#include <vector>
 #include <vulkan/vulkan.hpp>
 
 #include <CDLOD/VkGridMesh.h>
+#include <Ocean/OceanSurface.h>
 
 #include "ConstantsAll.h"
 #include "DescriptorManager.h"
 #include "GraphicsWork.h"
 #include "Instance.h"
+#include "OceanPatches.h"
+#include "OceanSpectrumCache.h"
 #include "Pipeline.h"
 
 // clang-format off
@@ -27,47 +31,19 @@ namespace Texture { class Handler; }
 
 namespace Ocean {
 
+// Number of grid mesh levels of detail for the instanced surface patches (dimensions halve each level).
+constexpr uint32_t PATCH_LOD_COUNT = 4;
+
+// Where the MakeWaveFourierData output is cached between runs (SpectrumCache), and the fields it is keyed on.
+const std::string SPECTRUM_CACHE_PATH = DATA_PATH + "cache/";
+SpectrumCache::Key GetSpectrumCacheKey(const SurfaceCreateInfo& info);
+
 /**
- * Unfortunately the ocean data sample dimensions need to be square because of how the fft compute shader works currently.
- * The sample dimensions also need to be known here because of the pipeline creation order, and having to use a text
- * replacement routine for the local size value. Still not sure if specialization info could be used for something like that.
- * It didn't work the first time I tried it.
+ * Estimates how far the surface can move from rest: .x is the largest |height|, and .y is the largest horizontal
+ * displacement. The surface is a sum of random waves, so these are a few standard deviations of the spectrum instead of a
+ * hard bound (summing every amplitude would be so loose that nothing would ever get culled).
  */
-constexpr uint32_t N = 256;
-constexpr uint32_t M = N;
-constexpr uint32_t FFT_LOCAL_SIZE = 64;
-constexpr uint32_t FFT_WORKGROUP_SIZE = N / FFT_LOCAL_SIZE;
-constexpr uint32_t DISP_LOCAL_SIZE = 32;
-constexpr uint32_t DISP_WORKGROUP_SIZE = N / DISP_LOCAL_SIZE;
-
-constexpr float T = 200.0f;  // wave repeat time
-constexpr float g = 9.81f;   // gravity
-
-struct SurfaceCreateInfo {
-    SurfaceCreateInfo()
-        : Lx(1000.0f),  //
-          Lz(1000.0f),
-          N(::Ocean::N),
-          M(::Ocean::M),
-          V(31.0f),
-          omega(1.0f, 0.0f),
-          l(1.0f),
-          A(2e-5f),
-          L(),
-          lambda(-1.0f) {
-        L = (V * V) / g;
-    }
-    float Lx;         // grid size (meters)
-    float Lz;         // grid size (meters)
-    uint32_t N;       // grid size (discrete Lx)
-    uint32_t M;       // grid size (discrete Lz)
-    float V;          // wind speed (meters/second)
-    glm::vec2 omega;  // wind direction (normalized)
-    float l;          // small wave cutoff (meters)
-    float A;          // Phillips spectrum constant (wave amplitude?)
-    float L;          // largest possible waves from continuous wind speed V
-    float lambda;     // horizontal displacement scale factor
-};
+glm::vec2 GetDisplacementBounds(const SurfaceCreateInfo& info);
 
 }  // namespace Ocean
 
@@ -89,12 +65,9 @@ namespace Ocean {
 
 constexpr std::string_view WAVE_FOURIER_ID = "Ocean Wave & Fourier Data Texture";
 constexpr std::string_view DISP_REL_ID = "Ocean Dispersion Relation Data Texture";
-constexpr std::string_view VERT_INPUT_ID = "Ocean Vertex Shader Input Texture";
+constexpr std::string_view VERT_INPUT_ID = "Ocean Vertex Shader Input Texture";  // per framebuffer (ring of outputs)
 void MakeResources(Texture::Handler& handler, const ::Ocean::SurfaceCreateInfo& info);
 
-constexpr std::string_view VERT_INPUT_COPY_ID = "Ocean Vertex Shader Input Copy Texture";
-CreateInfo MakeCopyTexInfo(const uint32_t N, const uint32_t M);
-
 }  // namespace Ocean
 }  // namespace Texture
 
@@ -199,12 +172,18 @@ class SurfaceTess : public Surface {
 class WireframeCdlod : public Wireframe {
    public:
     WireframeCdlod(Handler& handler);
+
+   private:
+    void getInputAssemblyInfoResources(CreateInfoResources& createInfoRes) override;
 };
 
 // SURFACE (CDLOD)
 class SurfaceCdlod : public Surface {
    public:
     SurfaceCdlod(Handler& handler);
+
+   private:
+    void getInputAssemblyInfoResources(CreateInfoResources& createInfoRes) override;
 };
 
 }  // namespace Ocean
@@ -220,12 +199,18 @@ struct DATA {
                       // quadScale:  .z.w
     glm::vec4 data1;  // uvOffset:   .x.y
                       // uvScale:    .z.w
+    glm::vec4 data2;  // edge snap:  -x, +x, -z, +z (vertex spacing of a coarser neighbour, or 0)
+    glm::vec4 data3;  // meshDim:    .x
+                      // morph:      .y start, .z end (distance)
 };
 class Base;
 struct CreateInfo : public Instance::CreateInfo<DATA, Base> {};
 class Base : public Buffer::DataItem<DATA>, public Instance::Base {
    public:
     Base(const Buffer::Info&& info, DATA* pData);
+
+    // Copies "count" instances to the front of the buffer and makes them the active ones.
+    void setInstances(const DATA* pData, const uint32_t count);
 };
 }  // namespace Ocean
 }  // namespace Cdlod
@@ -250,14 +235,25 @@ class OceanSurface : public Base {
                 const vk::CommandBuffer& cmd) override;
 
    private:
+    void frame() override;
     void load(std::unique_ptr<LoadingResource>& pLdgRes) override;
 
+    void selectPatches(const uint8_t frameIndex);
+
     Ocean::Renderer* pRenderer_;
     Ocean::SurfaceCreateInfo surfaceInfo_;
     // DEBUG
     uint32_t gridMeshDims_;
-    VkGridMesh gridMesh_;
-    std::shared_ptr<Instance::Cdlod::Ocean::Base> pInstanceData_;
+    std::vector<VkGridMesh> gridMeshes_;  // per LOD (dimensions halve each level)
+    // Patches
+    glm::vec2 displacementBounds_;
+    uint32_t patchCountX_;
+    uint32_t patchCountZ_;
+    std::vector<Ocean::Patch> patches_;
+    std::vector<Instance::Cdlod::Ocean::DATA> patchData_;  // same order as patches_
+    Ocean::PatchSelection selection_;
+    std::vector<Instance::Cdlod::Ocean::DATA> selectedData_;
+    std::vector<std::shared_ptr<Instance::Cdlod::Ocean::Base>> pInstanceData_;  // per framebuffer (selected patches)
 };
 
 }  // namespace GraphicsWork
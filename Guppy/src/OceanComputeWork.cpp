@@ -5,6 +5,11 @@
 
 #include "OceanComputeWork.h"
 
+#include <chrono>
+#include <sstream>
+
+#include <Common/Helpers.h>
+
 #include "Descriptor.h"
 #include "FFT.h"
 #include "Ocean.h"
@@ -12,10 +17,15 @@
 // HANLDERS
 #include "ParticleHandler.h"
 #include "PassHandler.h"
+#include "PipelineHandler.h"
 #include "SceneHandler.h"
 #include "TextureHandler.h"
 #include "UniformHandler.h"
 
+#if OCEAN_FFT_TIMESTAMPS
+#include <array>
+#endif
+
 // SHADER
 namespace Shader {
 namespace Ocean {
@@ -31,12 +41,24 @@ const CreateInfo FFT_COMP_CREATE_INFO = {
     "ocean/comp.ocean.fft.glsl",
     vk::ShaderStageFlagBits::eCompute,
 };
+const CreateInfo FFT_STOCKHAM_COMP_CREATE_INFO = {
+    SHADER::OCEAN_FFT_STOCKHAM_COMP,
+    "Ocean Surface Stockham Radix-4 Fast Fourier Transform Compute Shader",
+    "ocean/comp.ocean.fft.stockham.glsl",
+    vk::ShaderStageFlagBits::eCompute,
+};
 const CreateInfo VERT_INPUT_COMP_CREATE_INFO = {
     SHADER::OCEAN_VERT_INPUT_COMP,
     "Ocean Surface Vertex Input Compute Shader",
     "ocean/comp.ocean.vertInput.glsl",
     vk::ShaderStageFlagBits::eCompute,
 };
+const CreateInfo NORMAL_COMP_CREATE_INFO = {
+    SHADER::OCEAN_NORMAL_COMP,
+    "Ocean Surface Normal Compute Shader",
+    "ocean/comp.ocean.normal.glsl",
+    vk::ShaderStageFlagBits::eCompute,
+};
 }  // namespace Ocean
 }  // namespace Shader
 
@@ -58,11 +80,7 @@ Base::Base(const Buffer::Info&& info, DATA* pData, const CreateInfo* pCreateInfo
     pData_->data1[1] = static_cast<uint32_t>(log2(pCreateInfo->info.M));                  // log2(M)
     dirty = true;
 }
-void Base::update(const float elapsedTime) {
-    internalTime_ += elapsedTime;
-    pData_->data0[1] = internalTime_;
-    dirty = true;
-}
+void Base::update(const float elapsedTime) { internalTime_ += elapsedTime; }
 }  // namespace SimulationDispatch
 }  // namespace Ocean
 }  // namespace UniformDynamic
@@ -91,39 +109,58 @@ namespace Pipeline {
 
 namespace Ocean {
 
-// DISPERSION (COMPUTE)
-const CreateInfo DISP_CREATE_INFO = {
-    COMPUTE::OCEAN_DISP,
-    "Ocean Surface Dispersion Compute Pipeline",
-    {SHADER::OCEAN_DISP_COMP},
-    {{DESCRIPTOR_SET::OCEAN_DISPATCH, vk::ShaderStageFlagBits::eCompute}},
-    {},
-    {},
-    {::Ocean::DISP_LOCAL_SIZE, ::Ocean::DISP_LOCAL_SIZE, 1},
-};
-Dispersion::Dispersion(Handler& handler)
-    : Compute(handler, &DISP_CREATE_INFO), omega0_(2.0f * glm::pi<float>() / ::Ocean::T) {}
-
-void Dispersion::getShaderStageInfoResources(CreateInfoResources& createInfoRes) {
-    createInfoRes.specializationMapEntries.push_back({{}});
-
-    // Use specialization constants to pass number of samples to the shader (used for MSAA resolve)
-    createInfoRes.specializationMapEntries.back().back().constantID = 0;
-    createInfoRes.specializationMapEntries.back().back().offset = 0;
-    createInfoRes.specializationMapEntries.back().back().size = sizeof(omega0_);
+namespace {
+/**
+ * Adds specialization info for the compute stage. Every member of the data struct is a 4 byte constant, and the constant
+ * ids follow the member order.
+ */
+template <typename TSpecData>
+void setSpecializationInfo(CreateInfoResources& createInfoRes, const TSpecData& specData) {
+    static_assert(sizeof(TSpecData) % sizeof(uint32_t) == 0, "Specialization constants should all be 4 bytes");
+
+    createInfoRes.specializationMapEntries.push_back({});
+    for (uint32_t i = 0; i < static_cast<uint32_t>(sizeof(TSpecData) / sizeof(uint32_t)); i++) {
+        createInfoRes.specializationMapEntries.back().push_back({});
+        createInfoRes.specializationMapEntries.back().back().constantID = i;
+        createInfoRes.specializationMapEntries.back().back().offset = i * sizeof(uint32_t);
+        createInfoRes.specializationMapEntries.back().back().size = sizeof(uint32_t);
+    }
 
     createInfoRes.specializationInfo.push_back({});
     createInfoRes.specializationInfo.back().mapEntryCount =
         static_cast<uint32_t>(createInfoRes.specializationMapEntries.back().size());
     createInfoRes.specializationInfo.back().pMapEntries = createInfoRes.specializationMapEntries.back().data();
-    createInfoRes.specializationInfo.back().dataSize = sizeof(omega0_);
-    createInfoRes.specializationInfo.back().pData = &omega0_;
+    createInfoRes.specializationInfo.back().dataSize = sizeof(TSpecData);
+    createInfoRes.specializationInfo.back().pData = &specData;
 
     assert(createInfoRes.shaderStageInfos.size() == 1 &&
            createInfoRes.shaderStageInfos[0].stage == vk::ShaderStageFlagBits::eCompute);
     // Add the specialization to the shader info.
     createInfoRes.shaderStageInfos[0].pSpecializationInfo = &createInfoRes.specializationInfo.back();
 }
+}  // namespace
+
+// DISPERSION (COMPUTE)
+const CreateInfo DISP_CREATE_INFO = {
+    COMPUTE::OCEAN_DISP,
+    "Ocean Surface Dispersion Compute Pipeline",
+    {SHADER::OCEAN_DISP_COMP},
+    {{DESCRIPTOR_SET::OCEAN_DISPATCH, vk::ShaderStageFlagBits::eCompute}},
+    {},
+    {PUSH_CONSTANT::OCEAN_DISPERSION},
+};
+Dispersion::Dispersion(Handler& handler) : Compute(handler, &DISP_CREATE_INFO), specData_() {}
+
+void Dispersion::getShaderStageInfoResources(CreateInfoResources& createInfoRes) {
+    const auto& surfaceInfo = handler().sceneHandler().ocnRenderer.getSurfaceInfo();
+    specData_.omega0 = 2.0f * glm::pi<float>() / ::Ocean::T;
+    specData_.N = surfaceInfo.N;
+    specData_.M = surfaceInfo.M;
+    specData_.localSizeX = specData_.localSizeY = surfaceInfo.dispLocalSize;
+    // The Stockham fft reads and writes in natural order.
+    specData_.bitReverse = (surfaceInfo.fftKernel == ::Ocean::FFT_KERNEL::RADIX_2) ? VK_TRUE : VK_FALSE;
+    setSpecializationInfo(createInfoRes, specData_);
+}
 
 // FFT (COMPUTE)
 const CreateInfo FFT_CREATE_INFO = {
@@ -133,9 +170,35 @@ const CreateInfo FFT_CREATE_INFO = {
     {{DESCRIPTOR_SET::OCEAN_DISPATCH, vk::ShaderStageFlagBits::eCompute}},
     {},
     {PUSH_CONSTANT::FFT_ROW_COL_OFFSET},
-    {::Ocean::FFT_LOCAL_SIZE, 1, 1},
 };
-FFT::FFT(Handler& handler) : Compute(handler, &FFT_CREATE_INFO) {}
+FFT::FFT(Handler& handler) : Compute(handler, &FFT_CREATE_INFO), specData_() {}
+
+void FFT::getShaderStageInfoResources(CreateInfoResources& createInfoRes) {
+    specData_.localSizeX = handler().sceneHandler().ocnRenderer.getSurfaceInfo().fftLocalSize;
+    setSpecializationInfo(createInfoRes, specData_);
+}
+
+// FFT STOCKHAM (COMPUTE)
+const CreateInfo FFT_STOCKHAM_CREATE_INFO = {
+    COMPUTE::OCEAN_FFT_STOCKHAM,
+    "Ocean Surface Stockham Radix-4 FFT Compute Pipeline",
+    {SHADER::OCEAN_FFT_STOCKHAM_COMP},
+    {{DESCRIPTOR_SET::OCEAN_DISPATCH, vk::ShaderStageFlagBits::eCompute}},
+    {},
+    {PUSH_CONSTANT::FFT_ROW_COL_OFFSET},
+};
+FFTStockham::FFTStockham(Handler& handler) : Compute(handler, &FFT_STOCKHAM_CREATE_INFO), specData_() {}
+
+void FFTStockham::getShaderStageInfoResources(CreateInfoResources& createInfoRes) {
+    const auto& surfaceInfo = handler().sceneHandler().ocnRenderer.getSurfaceInfo();
+    /* The shared memory arrays are sized for the largest dimension, and a workgroup has an invocation per radix-4
+     * butterfly of it. The size is clamped so the pipeline can still be created when the radix-2 kernel is selected for
+     * a surface that is too large for this one.
+     */
+    specData_.size = (std::max)(4u, (std::min)((std::max)(surfaceInfo.N, surfaceInfo.M), ::Ocean::STOCKHAM_MAX_SIZE));
+    specData_.localSizeX = specData_.size / 4;
+    setSpecializationInfo(createInfoRes, specData_);
+}
 
 // VERTEX INPUT (COMPUTE)
 const CreateInfo VERTEX_INPUT_CREATE_INFO = {
@@ -143,16 +206,41 @@ const CreateInfo VERTEX_INPUT_CREATE_INFO = {
     "Ocean Surface Vertex Input Compute Pipeline",
     {SHADER::OCEAN_VERT_INPUT_COMP},
     {{DESCRIPTOR_SET::OCEAN_DISPATCH, vk::ShaderStageFlagBits::eCompute}},
-    {},
-    {},
-    {::Ocean::DISP_LOCAL_SIZE, ::Ocean::DISP_LOCAL_SIZE, 1},
 };
-VertexInput::VertexInput(Handler& handler) : Compute(handler, &VERTEX_INPUT_CREATE_INFO) {}
+VertexInput::VertexInput(Handler& handler) : Compute(handler, &VERTEX_INPUT_CREATE_INFO), specData_() {}
+
+void VertexInput::getShaderStageInfoResources(CreateInfoResources& createInfoRes) {
+    specData_.localSizeX = specData_.localSizeY = handler().sceneHandler().ocnRenderer.getSurfaceInfo().dispLocalSize;
+    setSpecializationInfo(createInfoRes, specData_);
+}
+
+// NORMAL (COMPUTE)
+const CreateInfo NORMAL_CREATE_INFO = {
+    COMPUTE::OCEAN_NORMAL,
+    "Ocean Surface Normal Compute Pipeline",
+    {SHADER::OCEAN_NORMAL_COMP},
+    {{DESCRIPTOR_SET::OCEAN_DISPATCH, vk::ShaderStageFlagBits::eCompute}},
+};
+Normal::Normal(Handler& handler) : Compute(handler, &NORMAL_CREATE_INFO), specData_() {}
+
+void Normal::getShaderStageInfoResources(CreateInfoResources& createInfoRes) {
+    specData_.localSizeX = specData_.localSizeY = handler().sceneHandler().ocnRenderer.getSurfaceInfo().dispLocalSize;
+    setSpecializationInfo(createInfoRes, specData_);
+}
 
 }  // namespace Ocean
 
 }  // namespace Pipeline
 
+namespace {
+// Readback buffers are only read by the host: cached memory first, then anything host visible.
+const std::vector<vk::MemoryPropertyFlags> READBACK_MEMORY_PREFERENCES = {
+    vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent,
+    vk::MemoryPropertyFlagBits::eHostCached,
+    vk::MemoryPropertyFlagBits::eHostCoherent,
+};
+}  // namespace
+
 namespace ComputeWork {
 
 const CreateInfo CREATE_INFO = {
@@ -162,17 +250,25 @@ const CreateInfo CREATE_INFO = {
         COMPUTE::OCEAN_DISP,
         COMPUTE::OCEAN_FFT,
         COMPUTE::OCEAN_VERT_INPUT,
+        COMPUTE::OCEAN_NORMAL,
+#ifdef OCEAN_FFT_STOCKHAM
+        COMPUTE::OCEAN_FFT_STOCKHAM,
+#endif
     },
 };
 
 Ocean::Ocean(Pass::Handler& handler, const index&& offset)
     : Base(handler, std::forward<const index>(offset), &CREATE_INFO),
-      startFrameCount_(UINT64_MAX),
       pauseFrameCount_(UINT64_MAX),
+      dispWorkgroupCount_(),
+      fftWorkgroupCount_(),
+      fftPipelineIndex_(0),
+      simulationTime_(0.0f),
+      timeline_(false),
+      computeValue_(0),
+      heightReadbackScale_(0),
       pGraphicsWork_(nullptr),
-      pOcnSimDpch_(nullptr),
-      pVertInputTex_(nullptr),
-      pVertInputTexCopies_{nullptr, nullptr, nullptr} {}
+      pOcnSimDpch_(nullptr) {}
 
 const std::vector<Descriptor::Base*> Ocean::getDynamicDataItems(const PIPELINE pipelineType) const {
     if (pOcnSimDpch_ == nullptr) {
@@ -187,7 +283,7 @@ const std::vector<Descriptor::Base*> Ocean::getDynamicDataItems(const PIPELINE p
 
 void Ocean::dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
                      const Descriptor::Set::BindData& descSetBindData, const vk::CommandBuffer& cmd,
-                     const uint8_t frameIndex) {
+                     const uint8_t frameIndex) const {
     const auto setIndex = (std::min)(static_cast<uint8_t>(descSetBindData.descriptorSets.size() - 1), frameIndex);
 
     cmd.bindPipeline(pPipelineBindData->bindPoint, pPipelineBindData->pipeline);
@@ -200,9 +296,19 @@ void Ocean::dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindD
 
     switch (std::visit(Pipeline::GetCompute{}, pPipelineBindData->type)) {
         case COMPUTE::OCEAN_DISP: {
-            cmd.dispatch(::Ocean::DISP_WORKGROUP_SIZE, ::Ocean::DISP_WORKGROUP_SIZE, 1);
+            cmd.pushConstants(pPipelineBindData->layout, pPipelineBindData->pushConstantStages, 0,
+                              static_cast<uint32_t>(sizeof(Pipeline::Ocean::Dispersion::PushConstant)),
+                              &simulationTime_);
+
+            // Barrier for the previous submission. Nothing waits on the cpu anymore, so it can still be using the images.
+            vk::MemoryBarrier barrier = {vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderWrite};
+            cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                                vk::PipelineStageFlagBits::eComputeShader, {}, {barrier}, {}, {});
+
+            cmd.dispatch(dispWorkgroupCount_[0], dispWorkgroupCount_[1], 1);
         } break;
-        case COMPUTE::OCEAN_FFT: {
+        case COMPUTE::OCEAN_FFT:
+        case COMPUTE::OCEAN_FFT_STOCKHAM: {
             FFT::RowColumnOffset offset = 1;  // row
             cmd.pushConstants(pPipelineBindData->layout, pPipelineBindData->pushConstantStages, 0,
                               static_cast<uint32_t>(sizeof(FFT::RowColumnOffset)), &offset);
@@ -212,7 +318,7 @@ void Ocean::dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindD
             cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {},
                                 {barrier}, {}, {});
 
-            cmd.dispatch(::Ocean::FFT_WORKGROUP_SIZE, 1, 1);
+            cmd.dispatch(fftWorkgroupCount_[0], 1, 1);
 
             offset = 0;  // column
             cmd.pushConstants(pPipelineBindData->layout, pPipelineBindData->pushConstantStages, 0,
@@ -223,7 +329,7 @@ void Ocean::dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindD
             cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {},
                                 {barrier}, {}, {});
 
-            cmd.dispatch(::Ocean::FFT_WORKGROUP_SIZE, 1, 1);
+            cmd.dispatch(fftWorkgroupCount_[1], 1, 1);
         } break;
         case COMPUTE::OCEAN_VERT_INPUT: {
             // Barrier for second fft pass
@@ -231,7 +337,15 @@ void Ocean::dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindD
             cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {},
                                 {barrier}, {}, {});
 
-            cmd.dispatch(::Ocean::DISP_WORKGROUP_SIZE, ::Ocean::DISP_WORKGROUP_SIZE, 1);
+            cmd.dispatch(dispWorkgroupCount_[0], dispWorkgroupCount_[1], 1);
+        } break;
+        case COMPUTE::OCEAN_NORMAL: {
+            // Barrier for vertex input. The normal pass reads the neighboring positions.
+            vk::MemoryBarrier barrier = {vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead};
+            cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {},
+                                {barrier}, {}, {});
+
+            cmd.dispatch(dispWorkgroupCount_[0], dispWorkgroupCount_[1], 1);
         } break;
         default: {
             assert(false);
@@ -239,113 +353,339 @@ void Ocean::dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindD
     }
 }
 
-void Ocean::updateRenderPassSubmitResource(RenderPass::SubmitResource& resource, const uint8_t frameIndex) const {
+void Ocean::updateRenderPassSubmitResource(RenderPass::SubmitResource& resource, const uint8_t frameIndex) {
     if (status_ == STATUS::READY) {
-        const auto& ctx = handler().shell().context();
-        const auto frameCount = handler().game().getFrameCount();
+        if (!timeline_) {
+            // Block until the compute work that last wrote the vertex input image for this frame is done.
+            if (vertInputComputeValues_[frameIndex]) waitForCompute(vertInputComputeValues_[frameIndex]);
+            return;
+        }
 
-        const bool notPausedNotFirstFrame = (!getPaused() && (startFrameCount_ != frameCount));
+        const auto frameCount = handler().game().getFrameCount();
 
-        // When the simulation starts draw needs wait after the first frame because it lags a single frame behind. Also, when
-        // the simulation is paused we need to keep waiting until all copies are done.
-        if (notPausedNotFirstFrame || (getPaused() && ((frameCount - pauseFrameCount_) < ctx.imageCount))) {
-            const auto workIndex = ((frameIndex + handler().shell().context().imageCount - 1) % 3);
-            resource.waitSemaphores[resource.waitSemaphoreCount] = resources.semaphores[workIndex];
+        // Wait for the compute work that last wrote the vertex input image for this frame. The value is already reached
+        // when the simulation is paused, so this is cheap.
+        if (vertInputComputeValues_[frameIndex]) {
+            resource.waitSemaphores[resource.waitSemaphoreCount] = resources.semaphores[0];
+            resource.waitSemaphoreValues[resource.waitSemaphoreCount] = vertInputComputeValues_[frameIndex];
             resource.waitDstStageMasks[resource.waitSemaphoreCount] = vk::PipelineStageFlagBits::eVertexShader;
             resource.waitSemaphoreCount++;
         }
 
-        // If not the first frame (surface doesn't draw on first frame), and the simulation is not paused then add a signal
-        // semaphore to indicate the heightmap copy is not in use.
-        if (notPausedNotFirstFrame) {
-            resource.signalSemaphores[resource.signalSemaphoreCount] = resources.drawSemaphores[frameIndex];
-            resource.signalSemaphoreCount++;
+        /* Signal the draw timeline so the compute work knows when the vertex input image is no longer in use. The value is
+         * remembered here because this is only called for frames that are submitted with the surface's pass.
+         */
+        resource.signalSemaphores[resource.signalSemaphoreCount] = resources.drawSemaphores[0];
+        resource.signalSemaphoreValues[resource.signalSemaphoreCount] = frameCount + 1;
+        resource.signalSemaphoreCount++;
+        vertInputDrawValues_[frameIndex] = frameCount + 1;
+    }
+}
+
+void Ocean::recordHeightReadback(const vk::CommandBuffer cmd, const uint32_t cmdIndex, const uint8_t vertInputIndex) {
+    const auto& buffer = heightReadbackResources_[cmdIndex].buffer;
+
+    {  // The copy reads what the compute passes wrote to the vertex input image.
+        vk::MemoryBarrier barrier = {vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead};
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {},
+                            {barrier}, {}, {});
+    }
+
+    cmd.copyImageToBuffer(pVertInputTexs_[vertInputIndex]->samplers[0].image, vk::ImageLayout::eGeneral, buffer,
+                          heightReadbackRegions_);
+
+    vk::BufferMemoryBarrier barrier = {vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead};
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, {barrier}, {});
+}
+
+void Ocean::readHeights() {
+    if (!heightReadbackScale_) return;
+
+    // Only look at the counter. A readback that isn't done yet is picked up on a later frame.
+    const auto slot = heightReadbackRing_.acquire(getCompletedComputeValue());
+    if (slot == ::Ocean::ReadbackRing::NONE) return;
+
+    handler().shell().context().memAllocator.invalidate(heightReadbackResources_[slot].allocation);
+    const auto& info = heightField_.getInfo();
+    const auto rowLength = info.width * heightReadbackScale_;
+    const auto* pData = pHeightReadbackData_[slot];
+    auto* pTexel = heightField_.data();
+    for (uint32_t z = 0; z < info.height; z++) {
+        const auto* pRow = pData + (static_cast<size_t>(z) * rowLength);
+        for (uint32_t x = 0; x < info.width; x++) {
+            const auto& position = pRow[x * heightReadbackScale_];
+            *pTexel++ = {position.x, position.y, position.z};
         }
     }
+    heightField_.setTime(heightReadbackTimes_[slot]);
 }
 
-void Ocean::copyImage(const vk::CommandBuffer cmd, const uint8_t frameIndex) {
+#if OCEAN_FFT_TIMESTAMPS
+void Ocean::readTimestamps(const uint32_t cmdIndex) {
+    if (!queryWritten_[cmdIndex]) return;
+    queryWritten_[cmdIndex] = false;
+
     const auto& ctx = handler().shell().context();
 
-    /* Copy the current dispersion relation data to an image for the next frame. This means the ocean surface draws
-     * the data calculated during the previous frame (using the indices this way just makes reusing the previous code
-     * easier).
-     */
-    const auto copyFrameIndex = ((frameIndex + 1) % ctx.imageCount);
-    const auto& srcSampler = pVertInputTex_->samplers[0];
-    const auto& dstSampler = pVertInputTexCopies_[copyFrameIndex]->samplers[0];
-
-    // Set values that don't change first.
-    vk::ImageMemoryBarrier imgBarrier = {};
-    imgBarrier.image = dstSampler.image;
-    imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imgBarrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    imgBarrier.subresourceRange.layerCount = dstSampler.imgCreateInfo.arrayLayers;
-    imgBarrier.subresourceRange.levelCount = 1;
-
-    {  // Barrier for final compute work, and image transition for the copy.
-        vk::MemoryBarrier memBarrier = {vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead};
-
-        imgBarrier.oldLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-        imgBarrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
-        imgBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
-        imgBarrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+    // The last submit with this command buffer is done, so the results are available.
+    std::array<uint64_t, 2> timestamps;
+    const auto result = ctx.dev.getQueryPoolResults(queryPool_, 2 * cmdIndex, 2, sizeof(timestamps), timestamps.data(),
+                                                    sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    assert(result == vk::Result::eSuccess);
+
+    const auto timestampPeriod = ctx.physicalDevProps[ctx.physicalDevIndex].properties.limits.timestampPeriod;  // ns
+    fftTimeSum_ += static_cast<double>(timestamps[1] - timestamps[0]) * timestampPeriod * 1e-6;
+
+    if (++fftTimeCount_ == OCEAN_FFT_TIMESTAMP_LOG_COUNT) {
+        const bool isStockham = handler().sceneHandler().ocnRenderer.getSurfaceInfo().fftKernel ==
+                                ::Ocean::FFT_KERNEL::STOCKHAM_RADIX_4;
+        std::stringstream ss;
+        ss << "Ocean FFT (" << (isStockham ? "Stockham radix-4" : "radix-2") << "): " << (fftTimeSum_ / fftTimeCount_)
+           << "ms average over " << fftTimeCount_ << " submissions";
+        handler().shell().log(Shell::LogPriority::LOG_INFO, ss.str().c_str());
+        fftTimeSum_ = 0.0;
+        fftTimeCount_ = 0;
+    }
+}
+#endif
 
+void Ocean::readback(const vk::CommandBuffer cmd, const uint32_t cmdIndex, const uint8_t vertInputIndex) {
+    const auto& sampler = pVertInputTexs_[vertInputIndex]->samplers[0];
+
+    {  // The copy reads what the compute passes wrote to the vertex input image.
+        vk::MemoryBarrier barrier = {vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead};
         cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {},
-                            {memBarrier}, {}, {imgBarrier});
+                            {barrier}, {}, {});
     }
 
-    {  // Copy the image data.
-        vk::ImageCopy region = {};
-        region.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-        region.srcSubresource.layerCount = srcSampler.imgCreateInfo.arrayLayers;
-        region.dstSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-        region.dstSubresource.layerCount = dstSampler.imgCreateInfo.arrayLayers;
-        region.extent = srcSampler.imgCreateInfo.extent;
+    vk::BufferImageCopy region = {};
+    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    region.imageSubresource.layerCount = sampler.imgCreateInfo.arrayLayers;
+    region.imageExtent = sampler.imgCreateInfo.extent;
+
+    cmd.copyImageToBuffer(sampler.image, vk::ImageLayout::eGeneral, readbackResources_[cmdIndex].buffer, {region});
+
+    vk::BufferMemoryBarrier barrier = {vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead};
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readbackResources_[cmdIndex].buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, {barrier}, {});
+}
+
+void Ocean::validate(const uint32_t cmdIndex) {
+    if (!pCpuSimulation_) return;
+    const float time = readbackTimes_[cmdIndex];
+    if (time < 0.0f) return;
+    readbackTimes_[cmdIndex] = -1.0f;
+
+    const auto& ctx = handler().shell().context();
 
-        cmd.copyImage(srcSampler.image, vk::ImageLayout::eGeneral, dstSampler.image, vk::ImageLayout::eTransferDstOptimal,
-                      {region});
+    const auto start = std::chrono::high_resolution_clock::now();
+    pCpuSimulation_->update(time);
+    const std::chrono::duration<double, std::milli> cpuTime = std::chrono::high_resolution_clock::now() - start;
+
+    // The readback has the position layer followed by the normal layer.
+    const auto& positions = pCpuSimulation_->getPositions();
+    const auto& normals = pCpuSimulation_->getNormals();
+    ctx.memAllocator.invalidate(readbackResources_[cmdIndex].allocation);
+    const auto* pData = static_cast<const glm::vec4*>(readbackResources_[cmdIndex].allocation.pMappedData);
+
+    float positionError = 0.0f, normalError = 0.0f, jacobianError = 0.0f, maxHeight = 0.0f;
+    for (size_t i = 0; i < positions.size(); i++) {
+        const auto dp = glm::abs(pData[i] - positions[i]);
+        const auto dn = glm::abs(pData[positions.size() + i] - normals[i]);
+        positionError = (std::max)(positionError, (std::max)((std::max)(dp.x, dp.y), dp.z));
+        normalError = (std::max)(normalError, (std::max)((std::max)(dn.x, dn.y), dn.z));
+        jacobianError = (std::max)(jacobianError, dn.w);
+        maxHeight = (std::max)(maxHeight, std::abs(positions[i].z));
     }
 
-    {  // Image transition out from transfer. Not sure what the dst settings should be...
-        imgBarrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-        imgBarrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-        imgBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        imgBarrier.dstAccessMask = {};
+    // The fft error grows with the magnitude of the data, so the tolerance is relative to the largest height.
+    const bool pass =
+        (positionError <= 1e-3f * (maxHeight + 1.0f)) && (normalError <= 1e-3f) && (jacobianError <= 1e-3f);
+
+    std::stringstream ss;
+    ss << "Ocean CPU validation (time: " << time << "): max position error " << positionError << " (max height "
+       << maxHeight << "), max normal error " << normalError << ", max jacobian error " << jacobianError
+       << ", CPU update " << cpuTime.count() << "ms";
+    handler().shell().log(pass ? Shell::LogPriority::LOG_INFO : Shell::LogPriority::LOG_WARN, ss.str().c_str());
+}
+
+uint64_t Ocean::getCompletedComputeValue() const {
+    const auto& ctx = handler().shell().context();
+    if (timeline_) return ctx.dev.getSemaphoreCounterValueKHR(resources.semaphores[0]);
+
+    // The oldest submission whose fence isn't signaled yet bounds the value.
+    uint64_t value = computeValue_;
+    for (size_t i = 0; i < resources.fences.size(); i++) {
+        if (cmdComputeValues_[i] && ctx.dev.getFenceStatus(resources.fences[i]) == vk::Result::eNotReady)
+            value = (std::min)(value, cmdComputeValues_[i] - 1);
+    }
+    return value;
+}
 
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {},
-                            {imgBarrier});
+void Ocean::waitForCompute(const uint64_t value) const {
+    const auto& ctx = handler().shell().context();
+    vk::Result result;
+
+    if (!timeline_) {
+        // The submission used command buffer (value - 1) % framesInFlight. If the command buffer was submitted again since
+        // then, its fence was already waited on.
+        const auto cmdIndex = static_cast<size_t>((value - 1) % resources.fences.size());
+        if (cmdComputeValues_[cmdIndex] != value) return;
+        result = ctx.dev.waitForFences(resources.fences[cmdIndex], VK_TRUE, UINT64_MAX);
+        assert(result == vk::Result::eSuccess);
+        return;
     }
+
+    if (ctx.dev.getSemaphoreCounterValueKHR(resources.semaphores[0]) >= value) return;
+
+    vk::SemaphoreWaitInfoKHR waitInfo = {};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &resources.semaphores[0];
+    waitInfo.pValues = &value;
+    result = ctx.dev.waitSemaphoresKHR(waitInfo, UINT64_MAX);
+    assert(result == vk::Result::eSuccess);
 }
 
 void Ocean::init() {
     const auto& ctx = handler().shell().context();
+    const auto framesInFlight = static_cast<uint32_t>(handler().game().settings().computeFramesInFlight);
+    assert(framesInFlight > 0);
     // RESOURCES
-    createCommandBuffers(ctx.imageCount);
-    createSemaphores(ctx.imageCount, ctx.imageCount);
-    createFences(ctx.imageCount);
+    createCommandBuffers(framesInFlight);
+    timeline_ = ctx.timelineSemaphoreEnabled;
+    if (timeline_) {
+        createSemaphores(1, 1, true);  // compute timeline, draw timeline
+    } else {
+        // The cpu waits on the previous frame's fence before writing a vertex input image, so there needs to be another.
+        assert(ctx.imageCount > 1);
+        createFences(framesInFlight);
+        cmdComputeValues_.assign(framesInFlight, 0);
+    }
+    vertInputComputeValues_.assign(ctx.imageCount, 0);
+    vertInputDrawValues_.assign(ctx.imageCount, 0);
     // The following submit resources are always the same so set the sizes.
     resources.submit.commandBuffers.resize(1);
-    resources.submit.signalSemaphores.resize(1);
+    if (timeline_) {
+        resources.submit.signalSemaphores = {resources.semaphores[0]};
+        resources.submit.signalSemaphoreValues.resize(1);
+    }
 }
 
 void Ocean::tick() {
     if (status_ != STATUS::READY) {
         const auto& ctx = handler().shell().context();
 
-        // Store pointers to the dispersion relationship textures for convenience/speed.
-        pVertInputTex_ = handler().textureHandler().getTexture(Texture::Ocean::VERT_INPUT_ID).get();
-        assert(pVertInputTex_ != nullptr);
-        assert(ctx.imageCount == 3);  // Potential image count problem.
+        // Store pointers to the vertex input textures for convenience/speed.
         for (uint32_t i = 0; i < ctx.imageCount; i++) {
-            pVertInputTexCopies_[i] = handler().textureHandler().getTexture(Texture::Ocean::VERT_INPUT_COPY_ID, i).get();
-            assert(pVertInputTexCopies_[i] != nullptr);
+            pVertInputTexs_.push_back(handler().textureHandler().getTexture(Texture::Ocean::VERT_INPUT_ID, i).get());
+            assert(pVertInputTexs_.back() != nullptr);
         }
 
         // Store a pointer to the graphics work for convenience.
         pGraphicsWork_ = handler().sceneHandler().ocnRenderer.pGraphicsWork.get();
 
+        /* Workgroup counts for the surface dimensions. The row pass of the radix-2 fft has an invocation per row (M), and
+         * the column pass has an invocation per column (N). The Stockham fft has a workgroup per row/column instead.
+         */
+        const auto& surfaceInfo = handler().sceneHandler().ocnRenderer.getSurfaceInfo();
+        assert(::Ocean::IsValid(surfaceInfo));
+        dispWorkgroupCount_[0] = ::Ocean::GetWorkgroupCount(surfaceInfo.N, surfaceInfo.dispLocalSize);
+        dispWorkgroupCount_[1] = ::Ocean::GetWorkgroupCount(surfaceInfo.M, surfaceInfo.dispLocalSize);
+        switch (surfaceInfo.fftKernel) {
+            case ::Ocean::FFT_KERNEL::RADIX_2: {
+                fftWorkgroupCount_[0] = ::Ocean::GetWorkgroupCount(surfaceInfo.M, surfaceInfo.fftLocalSize);
+                fftWorkgroupCount_[1] = ::Ocean::GetWorkgroupCount(surfaceInfo.N, surfaceInfo.fftLocalSize);
+                fftPipelineIndex_ = getPipelineBindDataList().getOffset(COMPUTE::OCEAN_FFT);
+            } break;
+#ifdef OCEAN_FFT_STOCKHAM
+            case ::Ocean::FFT_KERNEL::STOCKHAM_RADIX_4: {
+                fftWorkgroupCount_[0] = surfaceInfo.M;
+                fftWorkgroupCount_[1] = surfaceInfo.N;
+                fftPipelineIndex_ = getPipelineBindDataList().getOffset(COMPUTE::OCEAN_FFT_STOCKHAM);
+            } break;
+#endif
+            default: {  // The Stockham kernel needs the OCEAN_FFT_STOCKHAM build option.
+                assert(false);
+            } break;
+        }
+
+        // Height readback
+        heightReadbackScale_ = surfaceInfo.heightReadbackScale;
+        if (heightReadbackScale_) {
+            const uint32_t width = surfaceInfo.N / heightReadbackScale_;
+            const uint32_t height = surfaceInfo.M / heightReadbackScale_;
+
+            /* The vertex shader samples the vertex input image with uv (0, 0) at (-Lx / 2, -Lz / 2), so a texel is drawn at
+             * its center. The readback keeps texel (i * scale, j * scale) of the full image.
+             */
+            const glm::vec2 texelSize = {surfaceInfo.Lx / surfaceInfo.N, surfaceInfo.Lz / surfaceInfo.M};
+            ::Ocean::HeightField::Info fieldInfo = {};
+            fieldInfo.origin = glm::vec2(-surfaceInfo.Lx / 2.0f, -surfaceInfo.Lz / 2.0f) + (0.5f * texelSize);
+            fieldInfo.spacing = texelSize * static_cast<float>(heightReadbackScale_);
+            fieldInfo.width = width;
+            fieldInfo.height = height;
+            heightField_.reset(fieldInfo);
+
+            // One region per row that is kept (position layer only).
+            const vk::DeviceSize rowSize = static_cast<vk::DeviceSize>(surfaceInfo.N) * sizeof(glm::vec4);
+            for (uint32_t z = 0; z < height; z++) {
+                vk::BufferImageCopy region = {};
+                region.bufferOffset = z * rowSize;
+                region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+                region.imageSubresource.baseArrayLayer = 0;
+                region.imageSubresource.layerCount = 1;
+                region.imageOffset = vk::Offset3D{0, static_cast<int32_t>(z * heightReadbackScale_), 0};
+                region.imageExtent = vk::Extent3D{surfaceInfo.N, 1, 1};
+                heightReadbackRegions_.push_back(region);
+            }
+
+            heightReadbackRing_.reset(static_cast<uint32_t>(resources.cmds.size()));
+            heightReadbackResources_.resize(resources.cmds.size());
+            heightReadbackTimes_.assign(resources.cmds.size(), 0.0f);
+            for (auto& res : heightReadbackResources_) {
+                // The host reads these, so cached memory is much faster to read. It is invalidated before reading when
+                // it isn't coherent.
+                helpers::createBuffer(ctx.dev, rowSize * height, vk::BufferUsageFlagBits::eTransferDst,
+                                      vk::MemoryPropertyFlagBits::eHostVisible, ctx.memAllocator, res.buffer, res.allocation,
+                                      ctx.pAllocator, READBACK_MEMORY_PREFERENCES);
+                pHeightReadbackData_.push_back(static_cast<const glm::vec4*>(res.allocation.pMappedData));
+            }
+        }
+
+#if OCEAN_FFT_TIMESTAMPS
+        {  // Timestamp queries
+            const auto& props = ctx.physicalDevProps[ctx.physicalDevIndex];
+            assert(props.queueProps[ctx.computeIndex].timestampValidBits > 0);
+            const auto queryCount = 2 * static_cast<uint32_t>(resources.cmds.size());
+            queryPool_ = ctx.dev.createQueryPool({{}, vk::QueryType::eTimestamp, queryCount}, ctx.pAllocator);
+            queryWritten_.assign(resources.cmds.size(), false);
+            fftTimeSum_ = 0.0;
+            fftTimeCount_ = 0;
+        }
+#endif
+
+        if (handler().game().settings().validateOceanOnCpu) {
+            // CPU reference simulation, and a host visible buffer per command buffer for reading back the vertex input
+            // image.
+            pCpuSimulation_ = std::make_unique<::Ocean::Simulation>(surfaceInfo);
+            readbackResources_.resize(resources.cmds.size());
+            readbackTimes_.assign(resources.cmds.size(), -1.0f);
+            const vk::DeviceSize readbackSize =
+                static_cast<vk::DeviceSize>(surfaceInfo.N) * surfaceInfo.M * sizeof(glm::vec4) * 2;  // position & normal
+            for (auto& res : readbackResources_) {
+                helpers::createBuffer(ctx.dev, readbackSize, vk::BufferUsageFlagBits::eTransferDst,
+                                      vk::MemoryPropertyFlagBits::eHostVisible, ctx.memAllocator, res.buffer,
+                                      res.allocation, ctx.pAllocator, READBACK_MEMORY_PREFERENCES);
+            }
+        }
+
         // Set the descriptor set bind data. This function should be called on first tick at earliest.
         assert(getDescSetBindDataMaps().empty());
         setDescSetBindData();
@@ -362,84 +702,153 @@ void Ocean::frame() {
     const auto frameIndex = handler().renderPassMgr().getFrameIndex();
     const auto frameCount = handler().game().getFrameCount();
 
-    const auto& fence = resources.fences[frameIndex];
-    const auto& cmd = resources.cmds[frameIndex];
-
-    // Need to copy for (imageCount - 1) frames after pause so that all image layers have the last set of dispatch's data. A
-    // dispatch is only ever needed when a copy is also required.
-    const bool needCopy = (!getPaused() || ((frameCount - pauseFrameCount_) < (ctx.imageCount - 1)));
+    // Pick up the newest finished height readback (this never waits).
+    readHeights();
 
-    // Wait for fence every frame, or the if the simulation was just paused.
-    if (needCopy) {
-        /* TODO: This is really bad to wait for a fence here. This should probably be moved tick(), and not be waited on
-         * indefinetly. I put a comment about this in TODO.new.txt.
-         */
-        vk::Result result = ctx.dev.waitForFences(fence, VK_TRUE, UINT64_MAX);
-        assert(result == vk::Result::eSuccess);
-        ctx.dev.resetFences({fence});
+    /* Need to dispatch for (imageCount - 1) frames after pause so that all the vertex input images have the last set of
+     * dispatch's data. The simulation time doesn't change while paused, so those dispatches write the same data.
+     */
+    const bool needDispatch = (!getPaused() || ((frameCount - pauseFrameCount_) < (ctx.imageCount - 1)));
+    if (!needDispatch) return;
 
-        // TODO: This concept needs some work obviously...
-        if (!pGraphicsWork_->getDraw()) pGraphicsWork_->toggleDraw();
-    }
+    // TODO: This concept needs some work obviously...
+    if (!pGraphicsWork_->getDraw()) pGraphicsWork_->toggleDraw();
 
-    // Update shader resources when simulation is not paused.
+    /* The command buffer for this submission was last submitted "framesInFlight" submissions ago. This only blocks if the
+     * gpu is that far behind. The graphics frame fences usually make sure that it isn't.
+     */
+    const uint64_t signalValue = computeValue_ + 1;
+    const uint64_t framesInFlight = resources.cmds.size();
+    if (signalValue > framesInFlight) waitForCompute(signalValue - framesInFlight);
+    const auto cmdIndex = static_cast<uint32_t>(computeValue_ % framesInFlight);
+    const auto& cmd = resources.cmds[cmdIndex];
+    if (!timeline_) ctx.dev.resetFences({resources.fences[cmdIndex]});
+
+    // The last submit with this command buffer is done, so its readback can be checked.
+    validate(cmdIndex);
+#if OCEAN_FFT_TIMESTAMPS
+    readTimestamps(cmdIndex);
+#endif
+
+    // Update the simulation time when the simulation is not paused.
     if (!getPaused()) {
         pOcnSimDpch_->update(handler().shell().getElapsedTime<float>());
-        handler().uniformHandler().ocnSimDpchMgr().updateData(ctx.dev, pOcnSimDpch_->BUFFER_INFO);
+        simulationTime_ = pOcnSimDpch_->getTime();
     }
 
+    /* Write the vertex input image that the next frame draws with. This means the ocean surface draws the data
+     * calculated during the previous frame. The descriptor sets are per framebuffer because of the vertex input images, so
+     * the image index picks the set.
+     */
+    const auto vertInputIndex = static_cast<uint8_t>((frameIndex + 1) % ctx.imageCount);
+
     // Record command buffers.
-    if (needCopy) {
-        cmd.begin(vk::CommandBufferBeginInfo{});
-
-        // Dispatch if not paused.
-        if (!getPaused()) {
-            const auto& pipelineBindDataList = getPipelineBindDataList();
-            assert(pipelineBindDataList.size() == 3);  // OCEAN_DISP/OCEAN_FFT/OCEAN_VERT_INPUT
-            dispatch(TYPE, pipelineBindDataList.getValue(0), getDescSetBindData(TYPE, 0), cmd, frameIndex);  // DISP
-            dispatch(TYPE, pipelineBindDataList.getValue(1), getDescSetBindData(TYPE, 1), cmd, frameIndex);  // FFT
-            dispatch(TYPE, pipelineBindDataList.getValue(2), getDescSetBindData(TYPE, 1), cmd, frameIndex);  // VERT_INPUT
-        }
+    cmd.begin(vk::CommandBufferBeginInfo{});
+
+    const auto& pipelineBindDataList = getPipelineBindDataList();
+    // OCEAN_DISP/OCEAN_FFT/OCEAN_VERT_INPUT/OCEAN_NORMAL(/OCEAN_FFT_STOCKHAM)
+#ifdef OCEAN_FFT_STOCKHAM
+    assert(pipelineBindDataList.size() == 5);
+#else
+    assert(pipelineBindDataList.size() == 4);
+#endif
+#if OCEAN_FFT_TIMESTAMPS
+    cmd.resetQueryPool(queryPool_, 2 * cmdIndex, 2);
+#endif
+    dispatch(TYPE, pipelineBindDataList.getValue(0), getDescSetBindData(TYPE, 0), cmd, vertInputIndex);  // DISP
+#if OCEAN_FFT_TIMESTAMPS
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eComputeShader, queryPool_, 2 * cmdIndex);
+#endif
+    dispatch(TYPE, pipelineBindDataList.getValue(fftPipelineIndex_), getDescSetBindData(TYPE, fftPipelineIndex_), cmd,
+             vertInputIndex);  // FFT/FFT_STOCKHAM
+#if OCEAN_FFT_TIMESTAMPS
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eComputeShader, queryPool_, 2 * cmdIndex + 1);
+    queryWritten_[cmdIndex] = true;
+#endif
+    dispatch(TYPE, pipelineBindDataList.getValue(2), getDescSetBindData(TYPE, 2), cmd, vertInputIndex);  // VERT_INPUT
+    dispatch(TYPE, pipelineBindDataList.getValue(3), getDescSetBindData(TYPE, 3), cmd, vertInputIndex);  // NORMAL
+
+    if (heightReadbackScale_) {
+        recordHeightReadback(cmd, cmdIndex, vertInputIndex);
+        heightReadbackRing_.write(cmdIndex, signalValue);
+        heightReadbackTimes_[cmdIndex] = simulationTime_;
+    }
 
-        // Copy the compute work data to a per-frame heightmap image for drawing.
-        copyImage(cmd, frameIndex);
-
-        {  // Finalize submit resources
-            cmd.end();
-            resources.submit.commandBuffers[0] = cmd;
-            resources.submit.signalSemaphores[0] = resources.semaphores[frameIndex];
-            /* Once the simulation starts the surface draw uses the copied heightmap from the previous frame. The surface
-             * draw submits a signal semaphore that we need to wait on here when we are copying to the heightmap that could
-             * still be apart of a draw. If the simulation is paused, and we still need to copy (which is implied) then we
-             * need to wait as well.
-             *
-             * Note: This class governs the use of the render semaphores, so this should be safe.
-             */
-            resources.submit.waitSemaphores.clear();
-            const bool needWait = (!getPaused() && ((frameCount - startFrameCount_) > (ctx.imageCount - 1))) || getPaused();
-            if (needWait) {
-                const auto drawIndex = ((frameIndex + 1) % 3);
-                resources.submit.waitSemaphores.push_back(resources.drawSemaphores[drawIndex]);
-                resources.submit.waitDstStageMask = vk::PipelineStageFlagBits::eTransfer;
+    if (pCpuSimulation_ && !getPaused()) {
+        readback(cmd, cmdIndex, vertInputIndex);
+        readbackTimes_[cmdIndex] = simulationTime_;
+    }
+
+    {  // Finalize submit resources
+        cmd.end();
+        resources.submit.commandBuffers[0] = cmd;
+        /* The dispatches write the vertex input image that the graphics frame (imageCount - 1) frames ago drew with. Wait
+         * for the last frame that drew with it. Frames that didn't draw the surface never signaled, so they are skipped.
+         */
+        resources.submit.waitSemaphores.clear();
+        resources.submit.waitDstStageMasks.clear();
+        resources.submit.waitSemaphoreValues.clear();
+        if (timeline_) {
+            resources.submit.signalSemaphoreValues[0] = signalValue;
+            if (vertInputDrawValues_[vertInputIndex]) {
+                resources.submit.waitSemaphores.push_back(resources.drawSemaphores[0]);
+                resources.submit.waitDstStageMasks.push_back(vk::PipelineStageFlagBits::eComputeShader);
+                resources.submit.waitSemaphoreValues.push_back(vertInputDrawValues_[vertInputIndex]);
             }
-            resources.submit.fence = fence;
-            resources.hasData = true;
+            resources.submit.fence = nullptr;
+        } else {
+            // The frame that used this framebuffer last drew with the image. Its fence isn't reset until that framebuffer
+            // is acquired again.
+            const auto& frameFence = handler().renderPassMgr().getFrameFence(vertInputIndex);
+            const auto result = ctx.dev.waitForFences(frameFence, VK_TRUE, UINT64_MAX);
+            assert(result == vk::Result::eSuccess);
+            resources.submit.fence = resources.fences[cmdIndex];
+            cmdComputeValues_[cmdIndex] = signalValue;
         }
+        resources.hasData = true;
+
+        vertInputComputeValues_[vertInputIndex] = signalValue;
+        computeValue_ = signalValue;
     }
 }
 
 void Ocean::togglePause() {
     const auto frameCount = handler().game().getFrameCount();
-    startFrameCount_ = getPaused() ? UINT64_MAX : frameCount;
     pauseFrameCount_ = getPaused() ? frameCount : UINT64_MAX;
 }
 
 void Ocean::destroy() {
-    startFrameCount_ = UINT64_MAX;
     pauseFrameCount_ = UINT64_MAX;
+    // Nothing else waits on the compute work, so wait for it here before the base class destroys everything.
+    if (computeValue_) waitForCompute(computeValue_);
+    computeValue_ = 0;
+    timeline_ = false;
+    vertInputComputeValues_.clear();
+    vertInputDrawValues_.clear();
+    cmdComputeValues_.clear();
+    dispWorkgroupCount_ = {};
+    fftWorkgroupCount_ = {};
+    fftPipelineIndex_ = 0;
+    simulationTime_ = 0.0f;
     pOcnSimDpch_ = nullptr;
-    pVertInputTex_ = nullptr;
-    pVertInputTexCopies_ = {};
+    pVertInputTexs_.clear();
+    for (auto& res : heightReadbackResources_) handler().shell().context().destroyBuffer(res);
+    heightReadbackResources_.clear();
+    pHeightReadbackData_.clear();
+    heightReadbackRegions_.clear();
+    heightReadbackTimes_.clear();
+    heightReadbackRing_.reset(0);
+    heightField_ = {};
+    heightReadbackScale_ = 0;
+#if OCEAN_FFT_TIMESTAMPS
+    handler().shell().context().dev.destroyQueryPool(queryPool_, handler().shell().context().pAllocator);
+    queryPool_ = nullptr;
+    queryWritten_.clear();
+#endif
+    for (auto& res : readbackResources_) handler().shell().context().destroyBuffer(res);
+    readbackResources_.clear();
+    readbackTimes_.clear();
+    pCpuSimulation_ = nullptr;
 }
 
 }  // namespace ComputeWork
\ No newline at end of file
@@ -6,17 +6,30 @@
 #ifndef OCEAN_COMPUTE_WORK_H
 #define OCEAN_COMPUTE_WORK_H
 
-#include <array>
+#include <cstddef>
 #include <memory>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include <Common/Types.h>
+#include <Ocean/OceanSimulation.h>
+
 #include "ComputeWork.h"
 #include "ConstantsAll.h"
 #include "DescriptorManager.h"
 #include "Ocean.h"
+#include "OceanHeightQuery.h"
 #include "Pipeline.h"
 
+/**
+ * Set to true to time the fft dispatches with gpu timestamps. The average time of the selected kernel
+ * (SurfaceCreateInfo::fftKernel) is logged every OCEAN_FFT_TIMESTAMP_LOG_COUNT submissions.
+ */
+#define OCEAN_FFT_TIMESTAMPS false
+#if OCEAN_FFT_TIMESTAMPS
+constexpr uint32_t OCEAN_FFT_TIMESTAMP_LOG_COUNT = 600;
+#endif
+
 // clang-format off
 namespace Descriptor { class Base; }
 // clang-format on
@@ -26,7 +39,9 @@ namespace Shader {
 namespace Ocean {
 extern const CreateInfo DISP_COMP_CREATE_INFO;
 extern const CreateInfo FFT_COMP_CREATE_INFO;
+extern const CreateInfo FFT_STOCKHAM_COMP_CREATE_INFO;
 extern const CreateInfo VERT_INPUT_COMP_CREATE_INFO;
+extern const CreateInfo NORMAL_COMP_CREATE_INFO;
 }  // namespace Ocean
 }  // namespace Shader
 
@@ -36,7 +51,7 @@ namespace Ocean {
 namespace SimulationDispatch {
 struct DATA {
     glm::vec4 data0;   // [0] horizontal displacement scale factor
-                       // [1] time
+                       // [1] unused (time is a dispersion push constant)
                        // [2] grid scale (Lx)
                        // [3] grid scale (Lz)
     glm::uvec2 data1;  // [0] log2 of discrete dimension N
@@ -48,8 +63,12 @@ struct CreateInfo : Buffer::CreateInfo {
 class Base : public Descriptor::Base, public Buffer::DataItem<DATA> {
    public:
     Base(const Buffer::Info&& info, DATA* pData, const CreateInfo* pCreateInfo);
+    // The time goes to the dispersion shader as a push constant, so this doesn't touch the buffer data. A shared uniform
+    // would be overwritten while earlier compute submissions are still in flight.
     void update(const float elapsedTime);
 
+    constexpr float getTime() const { return internalTime_; }
+
    private:
     float internalTime_;
 };
@@ -72,22 +91,75 @@ namespace Ocean {
 // DISPERSION
 class Dispersion : public Compute {
    public:
+    using PushConstant = float;  // simulation time
+
     Dispersion(Handler& handler);
 
    private:
-    void getShaderStageInfoResources(CreateInfoResources& createInfoRes);
+    void getShaderStageInfoResources(CreateInfoResources& createInfoRes) override;
 
-    float omega0_;
+    struct {
+        float omega0;
+        uint32_t N;
+        uint32_t M;
+        uint32_t localSizeX;
+        uint32_t localSizeY;
+        uint32_t bitReverse;
+    } specData_;
 };
-// FFT
+// FFT (RADIX-2)
 class FFT : public Compute {
    public:
     FFT(Handler& handler);
+
+   private:
+    void getShaderStageInfoResources(CreateInfoResources& createInfoRes) override;
+
+    struct {
+        uint32_t localSizeX;
+    } specData_;
+};
+// FFT (STOCKHAM RADIX-4)
+class FFTStockham : public Compute {
+   public:
+    FFTStockham(Handler& handler);
+
+   private:
+    void getShaderStageInfoResources(CreateInfoResources& createInfoRes) override;
+
+    struct {
+        uint32_t localSizeX;
+        uint32_t size;
+    } specData_;
 };
 // VERTEX INPUT
 class VertexInput : public Compute {
    public:
     VertexInput(Handler& handler);
+
+   private:
+    void getShaderStageInfoResources(CreateInfoResources& createInfoRes) override;
+
+    struct {
+        uint32_t localSizeX;
+        uint32_t localSizeY;
+    } specData_;
+};
+/* NORMAL
+ * Normals from finite differences of the fully displaced surface, so they account for the choppy horizontal displacement,
+ * and the jacobian determinant of the displacement for the foam mask. Both go to the normal layer of the vertex input image.
+ */
+class Normal : public Compute {
+   public:
+    Normal(Handler& handler);
+
+   private:
+    void getShaderStageInfoResources(CreateInfoResources& createInfoRes) override;
+
+    struct {
+        uint32_t localSizeX;
+        uint32_t localSizeY;
+    } specData_;
 };
 }  // namespace Ocean
 }  // namespace Pipeline
@@ -100,15 +172,27 @@ class Ocean : public Base {
 
     const std::vector<Descriptor::Base*> getDynamicDataItems(const PIPELINE pipelineType) const override;
 
-    static void dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
-                         const Descriptor::Set::BindData& descSetBindData, const vk::CommandBuffer& cmd,
-                         const uint8_t frameIndex);
+    void dispatch(const PASS& passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
+                  const Descriptor::Set::BindData& descSetBindData, const vk::CommandBuffer& cmd,
+                  const uint8_t frameIndex) const;
 
     // RENDER PASS
-    void updateRenderPassSubmitResource(RenderPass::SubmitResource& resource, const uint8_t frameIndex) const override;
+    void updateRenderPassSubmitResource(RenderPass::SubmitResource& resource, const uint8_t frameIndex) override;
+
+    /* HEIGHT QUERIES
+     * Heights of the displaced surface at world xz positions for gameplay (buoyancy, collision, etc.). They come from a
+     * downsampled readback of the vertex input image (SurfaceCreateInfo::heightReadbackScale), so they are a few frames
+     * behind what is drawn, and nothing waits on the gpu for them. The heights are 0 until the first readback arrives.
+     */
+    float sampleHeight(const float x, const float z) const { return heightField_.sampleHeight(x, z); }
+    void sampleHeights(const glm::vec2* pPositions, float* pHeights, const size_t count) const {
+        heightField_.sampleHeights(pPositions, pHeights, count);
+    }
+    constexpr const auto& getHeightField() const { return heightField_; }
 
    private:
-    void copyImage(const vk::CommandBuffer cmd, const uint8_t frameIndex);
+    uint64_t getCompletedComputeValue() const;
+    void waitForCompute(const uint64_t value) const;
 
     void init() override;
     void tick() override;
@@ -117,14 +201,77 @@ class Ocean : public Base {
     void destroy() override;
 
     // PAUSE
-    uint64_t startFrameCount_;
     uint64_t pauseFrameCount_;
 
+    // DISPATCH
+    glm::uvec2 dispWorkgroupCount_;  // [0] x, [1] y
+    glm::uvec2 fftWorkgroupCount_;   // [0] row pass, [1] column pass
+    uint32_t fftPipelineIndex_;      // pipeline of the selected fft kernel
+    Pipeline::Ocean::Dispersion::PushConstant simulationTime_;
+
+    /* SYNC
+     * Two timeline semaphores replace the per-frame fences and binary semaphores. The compute timeline
+     * (resources.semaphores[0]) counts compute submissions, and the draw timeline (resources.drawSemaphores[0]) is
+     * signaled with (frame count + 1) by the graphics frames that draw the surface. Nothing waits on the cpu unless the
+     * gpu falls more than "framesInFlight" compute submissions behind.
+     *
+     * VK_KHR_timeline_semaphore is optional. Without it there is a fence per command buffer, and the cpu waits instead:
+     * on the compute fence before a graphics frame draws with a vertex input image, and on the frame fence of the last
+     * frame that drew with an image before it is written again.
+     *
+     * The vertex input images are a ring with one image per framebuffer. The compute work for a frame writes the image
+     * that the next frame draws with, so there is nothing to copy.
+     */
+    bool timeline_;
+    uint64_t computeValue_;                         // last value signaled on the compute timeline
+    std::vector<uint64_t> vertInputComputeValues_;  // compute timeline value that last wrote each vertex input image
+    // Draw timeline value that was last signaled by a frame that drew with each vertex input image (0 if none). Only the
+    // frames that actually signal write this, so the compute work never waits on a value that is never reached.
+    std::vector<uint64_t> vertInputDrawValues_;
+    std::vector<uint64_t> cmdComputeValues_;  // no timeline: compute value last submitted with each command buffer
+
     // Convenience pointers
     GraphicsWork::OceanSurface* pGraphicsWork_;
     UniformDynamic::Ocean::SimulationDispatch::Base* pOcnSimDpch_;
-    const Texture::Base* pVertInputTex_;
-    std::array<const Texture::Base*, 3> pVertInputTexCopies_;
+    std::vector<const Texture::Base*> pVertInputTexs_;
+
+    /* HEIGHT READBACK
+     * A host visible buffer per command buffer gets every "scale"-th row of the position layer. The copy can't skip texels
+     * within a row, so the columns are picked when the newest finished buffer is read into the height field.
+     */
+    void recordHeightReadback(const vk::CommandBuffer cmd, const uint32_t cmdIndex, const uint8_t vertInputIndex);
+    void readHeights();
+
+    uint32_t heightReadbackScale_;  // 0 when the readback is disabled
+    ::Ocean::HeightField heightField_;
+    ::Ocean::ReadbackRing heightReadbackRing_;  // slot per command buffer
+    std::vector<vk::BufferImageCopy> heightReadbackRegions_;
+    std::vector<BufferResource> heightReadbackResources_;
+    std::vector<const glm::vec4*> pHeightReadbackData_;  // persistently mapped
+    std::vector<float> heightReadbackTimes_;             // simulation time of each readback
+
+#if OCEAN_FFT_TIMESTAMPS
+    // TIMESTAMPS
+    void readTimestamps(const uint32_t cmdIndex);
+
+    vk::QueryPool queryPool_;          // two timestamps per command buffer (before & after the fft)
+    std::vector<bool> queryWritten_;  // per command buffer
+    double fftTimeSum_;               // milliseconds
+    uint32_t fftTimeCount_;
+#endif
+
+    /* VALIDATION
+     * With Game::Settings::validateOceanOnCpu the compute work is checked against the CPU reference simulation
+     * (Ocean::Simulation). The vertex input image is read back after each dispatch, and the max error and the CPU update
+     * time are logged. This is slow, so it is only meant for checking shader changes (it works with software drivers like
+     * lavapipe too).
+     */
+    void readback(const vk::CommandBuffer cmd, const uint32_t cmdIndex, const uint8_t vertInputIndex);
+    void validate(const uint32_t cmdIndex);
+
+    std::unique_ptr<::Ocean::Simulation> pCpuSimulation_;  // nullptr when the validation is off
+    std::vector<BufferResource> readbackResources_;
+    std::vector<float> readbackTimes_;  // simulation time of each readback (negative when there is nothing to check)
 };
 }  // namespace ComputeWork
 
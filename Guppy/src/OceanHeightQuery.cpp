@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "OceanHeightQuery.h"
+
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// Fixed point steps for undoing the horizontal displacement. The displacement changes slowly compared to the texel
+// spacing, so this converges quickly.
+constexpr uint32_t DISPLACEMENT_ITERATIONS = 3;
+
+inline uint32_t wrap(const int32_t i, const uint32_t size) {
+    const auto s = static_cast<int32_t>(size);
+    return static_cast<uint32_t>(((i % s) + s) % s);
+}
+
+}  // namespace
+
+namespace Ocean {
+
+// HEIGHT FIELD
+
+void HeightField::reset(const Info& info) {
+    assert(info.width > 0 && info.height > 0 && info.spacing.x > 0.0f && info.spacing.y > 0.0f);
+    info_ = info;
+    time_ = 0.0f;
+    texels_.assign(static_cast<size_t>(info.width) * info.height, glm::vec3(0.0f));
+}
+
+glm::vec3 HeightField::sample(const glm::vec2& xz) const {
+    assert(!empty());
+    const glm::vec2 t = (xz - info_.origin) / info_.spacing;
+    const glm::vec2 t0 = glm::floor(t);
+    const glm::vec2 f = t - t0;
+
+    const auto x0 = wrap(static_cast<int32_t>(t0.x), info_.width), x1 = wrap(static_cast<int32_t>(t0.x) + 1, info_.width);
+    const auto z0 = wrap(static_cast<int32_t>(t0.y), info_.height) * info_.width;
+    const auto z1 = wrap(static_cast<int32_t>(t0.y) + 1, info_.height) * info_.width;
+
+    const auto a = glm::mix(texels_[z0 + x0], texels_[z0 + x1], f.x);
+    const auto b = glm::mix(texels_[z1 + x0], texels_[z1 + x1], f.x);
+    return glm::mix(a, b, f.y);
+}
+
+float HeightField::sampleHeight(const float x, const float z) const {
+    if (empty()) return 0.0f;
+    const glm::vec2 target = {x, z};
+    glm::vec2 p = target;
+    for (uint32_t i = 0; i < DISPLACEMENT_ITERATIONS; i++) {
+        const auto texel = sample(p);
+        p = target - glm::vec2(texel.x, texel.y);
+    }
+    return sample(p).z;
+}
+
+void HeightField::sampleHeights(const glm::vec2* pPositions, float* pHeights, const size_t count) const {
+    for (size_t i = 0; i < count; i++) pHeights[i] = sampleHeight(pPositions[i].x, pPositions[i].y);
+}
+
+// READBACK RING
+
+void ReadbackRing::reset(const uint32_t size) {
+    values_.assign(size, 0);
+    lastValue_ = 0;
+}
+
+void ReadbackRing::write(const uint32_t slot, const uint64_t value) {
+    assert(slot < size() && value > lastValue_);
+    values_[slot] = value;
+}
+
+uint32_t ReadbackRing::acquire(const uint64_t completedValue) {
+    uint32_t newest = NONE;
+    for (uint32_t i = 0; i < size(); i++) {
+        if (values_[i] == 0 || values_[i] > completedValue) continue;
+        if (values_[i] > lastValue_) {
+            newest = i;
+            lastValue_ = values_[i];
+        }
+        values_[i] = 0;
+    }
+    return newest;
+}
+
+}  // namespace Ocean
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef OCEAN_HEIGHT_QUERY_H
+#define OCEAN_HEIGHT_QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Ocean {
+
+/**
+ * CPU copy of the displaced ocean surface for gameplay queries (buoyancy, collision, etc.). The compute work reads back a
+ * downsampled copy of the position layer of the vertex input image a few frames late (ComputeWork::Ocean), and the queries
+ * bilinearly interpolate it. The surface tiles, so the map wraps around. This only depends on glm, so it can be filled
+ * from a CPU generated map (Ocean::Simulation) as well.
+ */
+class HeightField {
+   public:
+    struct Info {
+        glm::vec2 origin;   // xz world position of texel (0, 0) (meters)
+        glm::vec2 spacing;  // xz world distance between texels (meters)
+        uint32_t width;     // texels along x
+        uint32_t height;    // texels along z
+    };
+
+    // Texels are (x displacement, z displacement, height), the same as the position layer of the vertex input image.
+    void reset(const Info& info);
+    glm::vec3* data() { return texels_.data(); }
+    void setTime(const float time) { time_ = time; }
+
+    bool empty() const { return texels_.empty(); }
+    constexpr const auto& getInfo() const { return info_; }
+    // Simulation time of the data (seconds).
+    constexpr float getTime() const { return time_; }
+
+    // Bilinear interpolation of the texels at world position "xz" without undoing the displacement.
+    glm::vec3 sample(const glm::vec2& xz) const;
+    /* Height of the displaced surface at world position (x, z). The surface at a grid position p is drawn at p plus its
+     * horizontal displacement, so this looks for the grid position that lands on (x, z) with a few fixed point steps first.
+     * Returns 0 (sea level) when there is no data yet.
+     */
+    float sampleHeight(const float x, const float z) const;
+    // Batch version of sampleHeight ("count" xz positions in, "count" heights out).
+    void sampleHeights(const glm::vec2* pPositions, float* pHeights, const size_t count) const;
+
+   private:
+    Info info_ = {};
+    float time_ = 0.0f;
+    std::vector<glm::vec3> texels_;  // row major (width * height)
+};
+
+/**
+ * Bookkeeping for a ring of readback buffers that are written by submissions on a timeline semaphore. A slot is readable
+ * once the timeline reaches the value of the submission that wrote it. Only the newest readable slot is ever read, and
+ * nothing older than the last read comes back, so the results never go back in time.
+ */
+class ReadbackRing {
+   public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    void reset(const uint32_t size);
+    // Marks "slot" as written by the submission that signals "value". Anything unread in the slot is dropped.
+    void write(const uint32_t slot, const uint64_t value);
+    // Returns the newest slot whose submission is done (value <= "completedValue"), or NONE. Older done slots are dropped.
+    uint32_t acquire(const uint64_t completedValue);
+
+    uint32_t size() const { return static_cast<uint32_t>(values_.size()); }
+
+   private:
+    std::vector<uint64_t> values_;  // per slot (0 when there is nothing to read)
+    uint64_t lastValue_ = 0;        // value of the last slot acquired
+};
+
+}  // namespace Ocean
+
+#endif  //! OCEAN_HEIGHT_QUERY_H
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "OceanPatches.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// Bounds of the displaced patch. The displacement can move a vertex away from its patch horizontally, and the height
+// can go either way.
+inline void getBounds(const Ocean::PatchSelectInfo& info, const Ocean::Patch& patch, glm::vec3& min, glm::vec3& max) {
+    min = {patch.offset.x - info.maxDisplacement, -info.maxHeight, patch.offset.y - info.maxDisplacement};
+    max = {patch.offset.x + patch.scale.x + info.maxDisplacement, info.maxHeight,
+           patch.offset.y + patch.scale.y + info.maxDisplacement};
+}
+
+}  // namespace
+
+namespace Ocean {
+
+void PatchSelection::clear() {
+    indices.clear();
+    lodCounts.clear();
+    patchLods.clear();
+    visible.clear();
+    lods.clear();
+}
+
+uint32_t PatchSelection::getFirst(const uint32_t lod) const {
+    assert(lod < lodCounts.size());
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < lod; i++) first += lodCounts[i];
+    return first;
+}
+
+bool IsPatchVisible(const PatchSelectInfo& info, const Patch& patch) {
+    glm::vec3 min, max;
+    getBounds(info, patch, min, max);
+    for (const auto& plane : info.planes) {
+        // Test the corner that is furthest along the plane normal. If it is outside then the whole box is.
+        const glm::vec3 corner = {
+            (plane.x >= 0.0f) ? max.x : min.x,
+            (plane.y >= 0.0f) ? max.y : min.y,
+            (plane.z >= 0.0f) ? max.z : min.z,
+        };
+        if (glm::dot(glm::vec3(plane.x, plane.y, plane.z), corner) + plane.w < 0.0f) return false;
+    }
+    return true;
+}
+
+uint32_t GetPatchLod(const PatchSelectInfo& info, const Patch& patch) {
+    assert(info.lodCount > 0 && info.lodDistance > 0.0f);
+    glm::vec3 min, max;
+    getBounds(info, patch, min, max);
+    // Distance to the closest point of the bounds, so the patch under the eye is always LOD 0.
+    const float distance = glm::length(info.eye - glm::clamp(info.eye, min, max));
+    if (distance < info.lodDistance) return 0;
+    const auto lod = 1 + static_cast<uint32_t>(std::log2(distance / info.lodDistance));
+    return (std::min)(lod, info.lodCount - 1);
+}
+
+void SelectPatches(const PatchSelectInfo& info, const std::vector<Patch>& patches, PatchSelection& selection) {
+    selection.clear();
+    selection.lodCounts.resize(info.lodCount, 0);
+    selection.patchLods.resize(patches.size(), PATCH_NOT_SELECTED);
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(patches.size()); i++) {
+        if (!IsPatchVisible(info, patches[i])) continue;
+        selection.visible.push_back(i);
+        selection.lods.push_back(GetPatchLod(info, patches[i]));
+        selection.lodCounts[selection.lods.back()]++;
+        selection.patchLods[i] = selection.lods.back();
+    }
+
+    // Counting sort by LOD (stable, so each LOD keeps the patch order).
+    std::vector<uint32_t> firsts(info.lodCount, 0);
+    for (uint32_t lod = 1; lod < info.lodCount; lod++) firsts[lod] = firsts[lod - 1] + selection.lodCounts[lod - 1];
+    selection.indices.resize(selection.visible.size());
+    for (size_t i = 0; i < selection.visible.size(); i++)
+        selection.indices[firsts[selection.lods[i]]++] = selection.visible[i];
+}
+
+std::array<uint32_t, 4> GetNeighbourLods(const PatchSelection& selection, const uint32_t countX, const uint32_t countZ,
+                                         const uint32_t index) {
+    assert(selection.patchLods.size() == static_cast<size_t>(countX) * countZ && index < selection.patchLods.size());
+    const auto lod = selection.patchLods[index];
+    const auto x = index % countX, z = index / countX;
+
+    auto getLod = [&](const uint32_t neighbour) {
+        const auto neighbourLod = selection.patchLods[neighbour];
+        return neighbourLod == PATCH_NOT_SELECTED ? lod : neighbourLod;
+    };
+
+    std::array<uint32_t, 4> lods;
+    lods[NEG_X] = x > 0 ? getLod(index - 1) : lod;
+    lods[POS_X] = x + 1 < countX ? getLod(index + 1) : lod;
+    lods[NEG_Z] = z > 0 ? getLod(index - countX) : lod;
+    lods[POS_Z] = z + 1 < countZ ? getLod(index + countX) : lod;
+    return lods;
+}
+
+}  // namespace Ocean
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef OCEAN_PATCHES_H
+#define OCEAN_PATCHES_H
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Ocean {
+
+/**
+ * Per-frame selection of the instanced ocean surface patches (GraphicsWork::OceanSurface). Each patch is tested against the
+ * camera frustum using its bounds grown by the largest displacement of the surface, and the visible ones get a level of
+ * detail from their distance to the eye. This only depends on glm, so it can be driven without a device.
+ */
+
+constexpr uint32_t PATCH_NOT_SELECTED = UINT32_MAX;
+
+// Patch edges, in the order GetNeighbourLods returns them.
+enum PATCH_EDGE : uint32_t { NEG_X = 0, POS_X, NEG_Z, POS_Z };
+
+struct Patch {
+    glm::vec2 offset;  // xz world position of the patch corner (meters)
+    glm::vec2 scale;   // xz world size of the patch (meters)
+};
+
+struct PatchSelectInfo {
+    std::array<glm::vec4, 6> planes;  // frustum planes (world space y-up, normalized, inside is positive)
+    glm::vec3 eye;                    // world space y-up
+    float maxHeight;                  // largest |height| of the surface
+    float maxDisplacement;            // largest horizontal displacement of the surface
+    float lodDistance;                // patches closer than this use LOD 0, and each level after that doubles it
+    uint32_t lodCount;
+};
+
+struct PatchSelection {
+    void clear();
+    uint32_t getFirst(const uint32_t lod) const;
+
+    std::vector<uint32_t> indices;    // visible patch indices grouped by LOD (LOD 0 first)
+    std::vector<uint32_t> lodCounts;  // number of visible patches per LOD
+    std::vector<uint32_t> patchLods;  // LOD of every patch (PATCH_NOT_SELECTED if it was culled)
+    // Scratch (visible patches and their LOD in visit order)
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> lods;
+};
+
+bool IsPatchVisible(const PatchSelectInfo& info, const Patch& patch);
+uint32_t GetPatchLod(const PatchSelectInfo& info, const Patch& patch);
+// Fills "selection" with the visible patches. Grouping them by LOD lets each LOD be drawn as one range of instances.
+void SelectPatches(const PatchSelectInfo& info, const std::vector<Patch>& patches, PatchSelection& selection);
+// LODs of the patches across each edge (PATCH_EDGE order) of patch "index". The patches are a "countX" by "countZ" grid in
+// rows along x. Missing or culled neighbours report the patch's own LOD because there is nothing to stitch to.
+std::array<uint32_t, 4> GetNeighbourLods(const PatchSelection& selection, const uint32_t countX, const uint32_t countZ,
+                                         const uint32_t index);
+
+}  // namespace Ocean
+
+#endif  //! OCEAN_PATCHES_H
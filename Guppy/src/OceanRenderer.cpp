@@ -26,17 +26,10 @@ Renderer::Renderer(Scene::Handler& handler)
       surfaceInfo(),
       settings_(),
       dbgHeightmap_(),
-      instMgr_("Instance Cdlod Ocean Manager Data", 128) {}
-
-void Renderer::init() {
-    const auto& ctx = handler().shell().context();
-
-    instMgr_.init(ctx);
-
-    useDebugCamera_ = handler().uniformHandler().hasDebugCamera();
-
-    // Surface info
-    surfaceInfo = {};
+      instMgr_("Instance Cdlod Ocean Manager Data", 512) {
+    /* Surface info. This is set here instead of init() because the ocean compute pipelines are created before the scene
+     * handler is initialized, and they need the grid dimensions/local sizes for their specialization constants.
+     */
     surfaceInfo.l = 1.0f;
     surfaceInfo.A = 2e-6f;
     surfaceInfo.Lx = surfaceInfo.Lz = 500.0f;
@@ -45,6 +38,18 @@ void Renderer::init() {
     // surfaceInfo.Lx = surfaceInfo.Lz = 320.0f;
     // surfaceInfo.V = 12.8f;
     // surfaceInfo.omega = {0, 1};
+    // surfaceInfo.N = 512;
+    // surfaceInfo.M = 256;
+    // surfaceInfo.fftKernel = FFT_KERNEL::STOCKHAM_RADIX_4;  // needs the OCEAN_FFT_STOCKHAM build option
+    assert(IsValid(surfaceInfo));
+}
+
+void Renderer::init() {
+    const auto& ctx = handler().shell().context();
+
+    instMgr_.init(ctx);
+
+    useDebugCamera_ = handler().uniformHandler().hasDebugCamera();
 
     // Make the ocean resources owned by the texture handler.
     BufferView::Ocean::MakeResources(handler().textureHandler(), surfaceInfo);
@@ -106,6 +111,7 @@ void Renderer::init() {
         settings_.MinViewRange = 35000.0f;
         settings_.MaxViewRange = 100000.0f;
         settings_.LODLevelDistanceRatio = 2.0f;
+        settings_.IncrementalSelection = true;
         settings_.TextureWorldSize = {surfaceInfo.Lx, surfaceInfo.Lz};
         settings_.TextureSize = {surfaceInfo.N, surfaceInfo.M};
     }
@@ -123,6 +129,11 @@ void Renderer::reset() {
 
 void Renderer::tick() { pGraphicsWork->onTick(); }
 
+void Renderer::frame() {
+    Base::frame();
+    pGraphicsWork->onFrame();
+}
+
 bool Renderer::shouldDraw(const PIPELINE type) const {
     return false;
     return pGraphicsWork->shouldDraw(type);
@@ -147,6 +158,8 @@ std::shared_ptr<Instance::Cdlod::Ocean::Base>& Renderer::makeInstance(Instance::
     return pInstance;
 }
 
+void Renderer::updateInstance(const ::Buffer::Info& info) { instMgr_.updateData(handler().shell().context().dev, info); }
+
 void Renderer::bindDescSetData(const vk::CommandBuffer& cmd, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
                                const int lodLevel) const {
     const auto& descSetBindData = pGraphicsWork->getDescriptorSetBindData(pPipelineBindData->type);
@@ -59,12 +59,16 @@ class Renderer : public Cdlod::Renderer::Base {
     Renderer(Scene::Handler& handler);
 
     void tick() override;
+    void frame() override;
 
     bool shouldDraw(const PIPELINE type) const override;
     void record(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
                 const vk::CommandBuffer& cmd) override;
 
     std::shared_ptr<Instance::Cdlod::Ocean::Base>& makeInstance(Instance::Cdlod::Ocean::CreateInfo* pInfo);
+    void updateInstance(const ::Buffer::Info& info);
+
+    constexpr const auto& getSurfaceInfo() const { return surfaceInfo; }
 
     std::unique_ptr<GraphicsWork::OceanSurface> pGraphicsWork;
 
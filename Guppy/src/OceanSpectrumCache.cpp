@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "OceanSpectrumCache.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x4350534F;  // "OSPC"
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t dataSize;  // bytes per buffer (wave, then hTilde0)
+    Ocean::SpectrumCache::Key key;
+};
+
+uint64_t getDataSize(const Ocean::SpectrumCache::Key& key) {
+    return (static_cast<uint64_t>(key.N) * 4) * static_cast<uint64_t>(key.M) * sizeof(float);
+}
+
+std::string getPath(const std::string& directory, const Ocean::SpectrumCache::Key& key) {
+    return (std::filesystem::path(directory) / Ocean::SpectrumCache::GetFileName(key)).string();
+}
+
+// Checks the mapped file and copies out the buffers.
+bool copyMapped(const uint8_t* pData, const uint64_t size, const Ocean::SpectrumCache::Key& key, float* pWave,
+                float* pHTilde0) {
+    const auto dataSize = getDataSize(key);
+    if (size != sizeof(Header) + (2 * dataSize)) return false;
+
+    Header header;
+    std::memcpy(&header, pData, sizeof(Header));
+    if (header.magic != MAGIC || header.version != Ocean::SpectrumCache::VERSION || header.dataSize != dataSize ||
+        !Ocean::SpectrumCache::IsSameKey(header.key, key))
+        return false;
+
+    std::memcpy(pWave, pData + sizeof(Header), dataSize);
+    std::memcpy(pHTilde0, pData + sizeof(Header) + dataSize, dataSize);
+    return true;
+}
+
+}  // namespace
+
+namespace Ocean {
+namespace SpectrumCache {
+
+uint64_t GetHash(const Key& key) {
+    // FNV-1a (64 bit) over the key fields and the version.
+    uint64_t hash = 0xCBF29CE484222325;
+    const auto hashBytes = [&hash](const void* p, const size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<const uint8_t*>(p)[i];
+            hash *= 0x100000001B3;
+        }
+    };
+    hashBytes(&VERSION, sizeof(VERSION));
+    hashBytes(&key, sizeof(Key));
+    return hash;
+}
+
+std::string GetFileName(const Key& key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "ocean_%016llx.bin", static_cast<unsigned long long>(GetHash(key)));
+    return name;
+}
+
+bool IsSameKey(const Key& a, const Key& b) { return std::memcmp(&a, &b, sizeof(Key)) == 0; }
+
+bool Load(const std::string& directory, const Key& key, float* pWave, float* pHTilde0) {
+    assert(pWave != nullptr && pHTilde0 != nullptr);
+    const auto path = getPath(directory, key);
+    bool hit = false;
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(hFile, &size) && static_cast<uint64_t>(size.QuadPart) >= sizeof(Header)) {
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hMapping != nullptr) {
+            const void* pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (pData != nullptr) {
+                hit = copyMapped(static_cast<const uint8_t*>(pData), static_cast<uint64_t>(size.QuadPart), key, pWave,
+                                 pHTilde0);
+                UnmapViewOfFile(pData);
+            }
+            CloseHandle(hMapping);
+        }
+    }
+    CloseHandle(hFile);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) >= sizeof(Header)) {
+        void* pData = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (pData != MAP_FAILED) {
+            // The buffers are read through once front to back.
+            madvise(pData, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            hit = copyMapped(static_cast<const uint8_t*>(pData), static_cast<uint64_t>(st.st_size), key, pWave,
+                             pHTilde0);
+            munmap(pData, static_cast<size_t>(st.st_size));
+        }
+    }
+    close(fd);
+#endif
+
+    return hit;
+}
+
+bool Store(const std::string& directory, const Key& key, const float* pWave, const float* pHTilde0) {
+    assert(pWave != nullptr && pHTilde0 != nullptr);
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) return false;
+
+    const Header header = {MAGIC, VERSION, getDataSize(key), key};
+
+    // Write a temporary file and rename it, so a partly written file is never picked up by Load.
+    const auto path = getPath(directory, key);
+    const auto tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(pWave), header.dataSize);
+        file.write(reinterpret_cast<const char*>(pHTilde0), header.dataSize);
+        if (!file.good()) {
+            file.close();
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace SpectrumCache
+}  // namespace Ocean
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef OCEAN_SPECTRUM_CACHE_H
+#define OCEAN_SPECTRUM_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+namespace Ocean {
+namespace SpectrumCache {
+
+/**
+ * On-disk cache of the wave vector and Fourier domain amplitude data (MakeWaveFourierData), which is the initial data of
+ * the WAVE_FOURIER_ID texture. The file name is a hash of the key, and the header stores the key itself so a hash
+ * collision reads as a miss. Bump VERSION whenever the generator changes.
+ */
+constexpr uint32_t VERSION = 1;
+
+// Every create info field that the wave/Fourier data depends on (Ocean::GetSpectrumCacheKey). All of the members are 4
+// bytes, so there is no padding and the struct can be hashed and compared as bytes.
+struct Key {
+    float Lx, Lz;
+    uint32_t N, M;
+    float V;
+    float omegaX, omegaY;
+    float l, A, L, lambda;
+    uint32_t seed;
+};
+static_assert(sizeof(Key) == 12 * 4);
+
+uint64_t GetHash(const Key& key);
+std::string GetFileName(const Key& key);
+// True if the data for "a" and "b" is the same (every field the generator reads matches).
+bool IsSameKey(const Key& a, const Key& b);
+// Fills "pWave" and "pHTilde0" (N * M * 4 floats each) from the cache file in "directory". Returns false on a miss, or if
+// the file is from another version, is truncated, or was made for a different key.
+bool Load(const std::string& directory, const Key& key, float* pWave, float* pHTilde0);
+// Writes the cache file for "key" to "directory" (created if needed). Returns false if the file couldn't be written.
+bool Store(const std::string& directory, const Key& key, const float* pWave, const float* pHTilde0);
+
+}  // namespace SpectrumCache
+}  // namespace Ocean
+
+#endif  //! OCEAN_SPECTRUM_CACHE_H
@@ -225,30 +225,21 @@ void Base::loadBuffers() {
     pLdgRes_ = handler().loadingHandler().createLoadingResources();
 
     // Vertex buffer
-    BufferResource stgRes = {};
     if (vertices_.size()) {
-        ctx.createBuffer(pLdgRes_->transferCmd,
-                         vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-                         sizeof(Vertex::Color) * vertices_.size(), NAME + " vertex", stgRes, vertexRes_, vertices_.data());
-        pLdgRes_->stgResources.push_back(std::move(stgRes));
+        ctx.createBuffer(*pLdgRes_, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+                         sizeof(Vertex::Color) * vertices_.size(), NAME + " vertex", vertexRes_, vertices_.data());
     }
 
     // Index buffer
     if (indices_.size()) {
-        stgRes = {};
-        ctx.createBuffer(pLdgRes_->transferCmd,
-                         vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-                         sizeof(IndexBufferType) * indices_.size(), NAME + " index", stgRes, indexRes_, indices_.data());
-        pLdgRes_->stgResources.push_back(std::move(stgRes));
+        ctx.createBuffer(*pLdgRes_, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
+                         sizeof(IndexBufferType) * indices_.size(), NAME + " index", indexRes_, indices_.data());
     }
 
     // Texture coordinate buffer
     if (texCoords_.size()) {
-        stgRes = {};
-        ctx.createBuffer(
-            pLdgRes_->transferCmd, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-            sizeof(glm::vec2) * texCoords_.size(), NAME + " tex coords", stgRes, texCoordRes_, texCoords_.data());
-        pLdgRes_->stgResources.push_back(std::move(stgRes));
+        ctx.createBuffer(*pLdgRes_, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
+                         sizeof(glm::vec2) * texCoords_.size(), NAME + " tex coords", texCoordRes_, texCoords_.data());
     }
 }
 
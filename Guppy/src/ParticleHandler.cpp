@@ -26,15 +26,19 @@ const uint32_t NUM_PARTICLES_ATTR_TOTAL = NUM_PARTICLES_ATTR.x * NUM_PARTICLES_A
 
 Particle::Handler::Handler(Game* pGame)
     : Game::Handler(pGame),  //
-      prtclAttrMgr{"Particle Attractor", UNIFORM_DYNAMIC::PRTCL_ATTRACTOR, 3, true, "_UD_PRTCL_ATTR"},
-      prtclClthMgr{"Particle Cloth", UNIFORM_DYNAMIC::PRTCL_CLOTH, 5 * 3, true, "_UD_PRTCL_CLTH"},
-      prtclFntnMgr{"Particle Fountain", UNIFORM_DYNAMIC::PRTCL_FOUNTAIN, 30, true, "_UD_PRTCL_ATTR"},
-      mat4Mgr{"Matrix4 Data", UNIFORM_DYNAMIC::MATRIX_4, 30, true, "_UD_MAT4"},
-      vec4Mgr{"Particle Vector4 Data", STORAGE_BUFFER_DYNAMIC::VERTEX, 1000000, false, "_UD_VEC4"},
-      hffMgr{"Height Field Fluid Data", UNIFORM_DYNAMIC::HFF, 3, true, "_UD_HFF"},
+      // The per frame uniforms are flushed once a frame by the handler.
+      prtclAttrMgr{"Particle Attractor", UNIFORM_DYNAMIC::PRTCL_ATTRACTOR, 3, "_UD_PRTCL_ATTR",  //
+                   vk::SharingMode::eExclusive, {}, true},
+      prtclClthMgr{"Particle Cloth", UNIFORM_DYNAMIC::PRTCL_CLOTH, 5 * 3, "_UD_PRTCL_CLTH",  //
+                   vk::SharingMode::eExclusive, {}, true},
+      prtclFntnMgr{"Particle Fountain", UNIFORM_DYNAMIC::PRTCL_FOUNTAIN, 30, "_UD_PRTCL_ATTR",  //
+                   vk::SharingMode::eExclusive, {}, true},
+      mat4Mgr{"Matrix4 Data", UNIFORM_DYNAMIC::MATRIX_4, 30, "_UD_MAT4", vk::SharingMode::eExclusive, {}, true},
+      vec4Mgr{"Particle Vector4 Data", STORAGE_BUFFER_DYNAMIC::VERTEX, 250000, "_UD_VEC4"},
+      hffMgr{"Height Field Fluid Data", UNIFORM_DYNAMIC::HFF, 3, "_UD_HFF", vk::SharingMode::eExclusive, {}, true},
       waterOffset(Buffer::BAD_OFFSET),
       doUpdate_(false),
-      instFntnMgr_{"Particle Fountain Instance Data", 8000 * 5, false},
+      instFntnMgr_{"Particle Fountain Instance Data", 8000 * 5},
       pInstFntnEulerMgr_(nullptr) {}
 
 void Particle::Handler::init() {
@@ -76,6 +80,15 @@ void Particle::Handler::tick() {
     }
 }
 
+void Particle::Handler::flush() {
+    const auto frameIndex = passHandler().renderPassMgr().getFrameIndex();
+    prtclAttrMgr.flush(shell().context().dev, frameIndex);
+    prtclClthMgr.flush(shell().context().dev, frameIndex);
+    prtclFntnMgr.flush(shell().context().dev, frameIndex);
+    mat4Mgr.flush(shell().context().dev, frameIndex);
+    hffMgr.flush(shell().context().dev, frameIndex);
+}
+
 void Particle::Handler::frame() {
     if (!doUpdate_) return;
 
@@ -514,7 +527,7 @@ void Particle::Handler::reset() {
     if (pInstFntnEulerMgr_ == nullptr && shell().context().computeShadingEnabled) {
         pInstFntnEulerMgr_ =
             std::make_unique<Descriptor::Manager<Descriptor::Base, Particle::FountainEuler::Base, std::shared_ptr>>(
-                "Instance Particle Fountain Data", STORAGE_BUFFER_DYNAMIC::VERTEX, (4000 * 5) * 2, false);
+                "Instance Particle Fountain Data", STORAGE_BUFFER_DYNAMIC::VERTEX, (4000 * 5) * 2);
     } else if (pInstFntnEulerMgr_ != nullptr) {
         pInstFntnEulerMgr_->destroy(shell().context());
         if (!shell().context().computeShadingEnabled) pInstFntnEulerMgr_ = nullptr;
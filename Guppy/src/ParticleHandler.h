@@ -56,6 +56,8 @@ class Handler : public Game::Handler {
     void init() override;
     void tick() override;
     void frame() override;
+    // Copies the frame's uniform updates to the buffers. Called once a frame after all the updates.
+    void flush();
 
     void create();
     void startFountain(const uint32_t offset);
@@ -69,7 +69,11 @@ const std::vector<PIPELINE> ALL = {
     COMPUTE::FFT_ONE,
     COMPUTE::OCEAN_DISP,
     COMPUTE::OCEAN_FFT,
+#ifdef OCEAN_FFT_STOCKHAM
+    COMPUTE::OCEAN_FFT_STOCKHAM,
+#endif
     COMPUTE::OCEAN_VERT_INPUT,
+    COMPUTE::OCEAN_NORMAL,
     GRAPHICS::OCEAN_WF_DEFERRED,
     GRAPHICS::OCEAN_SURFACE_DEFERRED,
 #if !(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK))
@@ -80,6 +84,9 @@ const std::vector<PIPELINE> ALL = {
     GRAPHICS::OCEAN_SURFACE_CDLOD_DEFERRED,
     GRAPHICS::CDLOD_WF_DEFERRED,
     GRAPHICS::CDLOD_TEX_DEFERRED,
+#ifdef CDLOD_GPU_SELECTION
+    COMPUTE::CDLOD_SELECT,
+#endif
 #ifdef USE_VOLUMETRIC_LIGHTING
     // ...
 #endif
@@ -158,8 +165,14 @@ const std::map<VERTEX, std::set<PIPELINE>> VERTEX_MAP = {
             COMPUTE::FFT_ONE,
             COMPUTE::OCEAN_DISP,
             COMPUTE::OCEAN_FFT,
+#ifdef OCEAN_FFT_STOCKHAM
+            COMPUTE::OCEAN_FFT_STOCKHAM,
+#endif
             GRAPHICS::OCEAN_WF_DEFERRED,
             GRAPHICS::OCEAN_SURFACE_DEFERRED,
+#ifdef CDLOD_GPU_SELECTION
+            COMPUTE::CDLOD_SELECT,
+#endif
         },
     },
 };
@@ -140,7 +140,10 @@ Pipeline::Handler::Handler(Game* pGame) : Game::Handler(pGame), cache_(), maxPus
                 case COMPUTE::FFT_ONE:                  insertPair = pPipelines_.insert({type, std::make_unique<FFT::OneComponent>(std::ref(*this))}); break;
                 case COMPUTE::OCEAN_DISP:               insertPair = pPipelines_.insert({type, std::make_unique<Ocean::Dispersion>(std::ref(*this))}); break;
                 case COMPUTE::OCEAN_FFT:                insertPair = pPipelines_.insert({type, std::make_unique<Ocean::FFT>(std::ref(*this))}); break;
+                case COMPUTE::OCEAN_FFT_STOCKHAM:       insertPair = pPipelines_.insert({type, std::make_unique<Ocean::FFTStockham>(std::ref(*this))}); break;
                 case COMPUTE::OCEAN_VERT_INPUT:         insertPair = pPipelines_.insert({type, std::make_unique<Ocean::VertexInput>(std::ref(*this))}); break;
+                case COMPUTE::OCEAN_NORMAL:             insertPair = pPipelines_.insert({type, std::make_unique<Ocean::Normal>(std::ref(*this))}); break;
+                case COMPUTE::CDLOD_SELECT:             insertPair = pPipelines_.insert({type, std::make_unique<Cdlod::Select>(std::ref(*this))}); break;
 #ifdef USE_VOLUMETRIC_LIGHTING
                 // ...
 #endif
@@ -245,6 +248,8 @@ std::vector<vk::PushConstantRange> Pipeline::Handler::getPushConstantRanges(
             case PUSH_CONSTANT::HFF_COLUMN:         range.size = sizeof(HeightFieldFluid::Column::PushConstant); break;
             case PUSH_CONSTANT::FFT_ROW_COL_OFFSET: range.size = sizeof(::FFT::RowColumnOffset); break;
             case PUSH_CONSTANT::CDLOD:              range.size = sizeof(::Cdlod::PushConstant); break;
+            case PUSH_CONSTANT::CDLOD_SELECT:       range.size = sizeof(::Cdlod::SelectPushConstant); break;
+            case PUSH_CONSTANT::OCEAN_DISPERSION:   range.size = sizeof(Pipeline::Ocean::Dispersion::PushConstant); break;
             default: assert(false && "Unknown push constant"); exit(EXIT_FAILURE);
         }
         // clang-format on
@@ -505,12 +505,12 @@ void RenderPass::Base::createImageResources() {
 
         images_.push_back({});
 
-        helpers::createImage(ctx.dev, ctx.memProps,
+        helpers::createImage(ctx.dev, ctx.memAllocator,
                              handler().commandHandler().getUniqueQueueFamilies(true, false, true, false),
                              pipelineData_.samples, format_, vk::ImageTiling::eOptimal,
                              vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment,
                              vk::MemoryPropertyFlagBits::eDeviceLocal, extent_.width, extent_.height, 1, 1,
-                             images_.back().image, images_.back().memory, ctx.pAllocator);
+                             images_.back().image, images_.back().allocation, ctx.pAllocator);
 
         vk::ImageSubresourceRange range = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
         helpers::createImageView(ctx.dev, images_.back().image, format_, vk::ImageViewType::e2D, range, images_.back().view,
@@ -524,11 +524,11 @@ void RenderPass::Base::createDepthResource() {
     auto& ctx = handler().shell().context();
     if (pipelineData_.usesDepth) {
         vk::ImageTiling tiling = helpers::getDepthStencilImageTiling(ctx.physicalDev, depthFormat_);
-        helpers::createImage(ctx.dev, ctx.memProps,
+        helpers::createImage(ctx.dev, ctx.memAllocator,
                              handler().commandHandler().getUniqueQueueFamilies(true, false, true, false),
                              pipelineData_.samples, depthFormat_, tiling, vk::ImageUsageFlagBits::eDepthStencilAttachment,
                              vk::MemoryPropertyFlagBits::eDeviceLocal, extent_.width, extent_.height, 1, 1, depth_.image,
-                             depth_.memory, ctx.pAllocator);
+                             depth_.allocation, ctx.pAllocator);
 
         vk::ImageSubresourceRange range = {helpers::getDepthStencilAspectMask(depthFormat_), 0, 1, 0, 1};
         helpers::createImageView(ctx.dev, depth_.image, depthFormat_, vk::ImageViewType::e2D, range, depth_.view,
@@ -649,11 +649,11 @@ void RenderPass::Base::destroyTargetResources() {
     auto& ctx = handler().shell().context();
 
     // COLOR
-    for (auto& color : images_) helpers::destroyImageResource(ctx.dev, color, ctx.pAllocator);
+    for (auto& color : images_) helpers::destroyImageResource(ctx.dev, ctx.memAllocator, color, ctx.pAllocator);
     images_.clear();
 
     // DEPTH
-    helpers::destroyImageResource(ctx.dev, depth_, ctx.pAllocator);
+    helpers::destroyImageResource(ctx.dev, ctx.memAllocator, depth_, ctx.pAllocator);
 
     // FRAMEBUFFER
     for (auto& framebuffer : data.framebuffers) ctx.dev.destroyFramebuffer(framebuffer, ctx.pAllocator);
@@ -80,6 +80,9 @@ const CreateInfo DEFERRED_CREATE_INFO = {
         COMPUTE::PRTCL_CLOTH_NORM,
         COMPUTE::HFF_HGHT,
         COMPUTE::HFF_NORM,
+#ifdef CDLOD_GPU_SELECTION
+        COMPUTE::CDLOD_SELECT,
+#endif
     },
     (
         FLAG::SWAPCHAIN | FLAG::DEPTH | /*FLAG::DEPTH_INPUT_ATTACHMENT |*/
@@ -150,7 +153,9 @@ void Base::record(const uint8_t frameIndex) {
 
         // COMPUTE
         for (const auto& pPipelineBindData : pipelineBindDataList_.getValues()) {
-            if (std::visit(Pipeline::IsCompute{}, pPipelineBindData->type)) {
+            if (pPipelineBindData->type == PIPELINE{COMPUTE::CDLOD_SELECT}) {
+                handler().sceneHandler().recordDispatch(TYPE, pPipelineBindData, priCmd, frameIndex);
+            } else if (std::visit(Pipeline::IsCompute{}, pPipelineBindData->type)) {
                 handler().particleHandler().recordDispatch(TYPE, pPipelineBindData, priCmd, frameIndex);
             }
         }
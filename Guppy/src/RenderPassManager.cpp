@@ -133,6 +133,7 @@ void Manager::init() {
     createFences();
     // TODO: should this just be an array too???? Ugh
     submitInfos_.assign(RESOURCE_SIZE, {});
+    timelineSubmitInfos_.assign(RESOURCE_SIZE, {});
 
     // SCREEN QUAD
     Mesh::Plane::CreateInfo planeInfo = {};
@@ -333,6 +334,7 @@ void Manager::acquireBackBuffer() {
 }
 
 void Manager::submit(const uint8_t submitCount) {
+    const auto& ctx = handler().shell().context();
     const SubmitResource* pResource;
     vk::SubmitInfo* pInfo;
     for (uint8_t i = 0; i < submitCount; i++) {
@@ -347,6 +349,15 @@ void Manager::submit(const uint8_t submitCount) {
         pInfo->pCommandBuffers = pResource->commandBuffers.data();
         pInfo->signalSemaphoreCount = pResource->signalSemaphoreCount;
         pInfo->pSignalSemaphores = pResource->signalSemaphores.data();
+        // Timeline semaphore values (the values for binary semaphores are ignored)
+        if (ctx.timelineSemaphoreEnabled) {
+            auto& timelineInfo = timelineSubmitInfos_[i];
+            timelineInfo.waitSemaphoreValueCount = pResource->waitSemaphoreCount;
+            timelineInfo.pWaitSemaphoreValues = pResource->waitSemaphoreValues.data();
+            timelineInfo.signalSemaphoreValueCount = pResource->signalSemaphoreCount;
+            timelineInfo.pSignalSemaphoreValues = pResource->signalSemaphoreValues.data();
+            pInfo->pNext = &timelineInfo;
+        }
     }
 
     auto result =
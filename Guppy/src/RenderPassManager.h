@@ -99,6 +99,7 @@ class Manager : public Pass::Manager {
     void submit(const uint8_t submitCount);
     SubmitResources submitResources_;
     std::vector<vk::SubmitInfo> submitInfos_;
+    std::vector<vk::TimelineSemaphoreSubmitInfoKHR> timelineSubmitInfos_;
 
     std::vector<std::unique_ptr<Base>> pPasses_;
     std::set<std::pair<RENDER_PASS, index>> activeTypeOffsetPairs_;
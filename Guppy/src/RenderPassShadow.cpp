@@ -170,7 +170,8 @@ void Default::update(const std::vector<Descriptor::Base*> pDynamicItems) {
         std::array<GRAPHICS, 2> pipelineTypes = {GRAPHICS::SHADOW_COLOR, GRAPHICS::SHADOW_TEX};
 
         // As of now there should be a single basic camera for a single volumetric spot light.
-        assert(handler().uniformHandler().camPersBscMgr().pItems.size() == 1);
+        assert(handler().uniformHandler().camPersBscMgr().pItems.size() == 1 &&
+               handler().uniformHandler().camPersBscMgr().hasItem(0));
         auto& pCamera = handler().uniformHandler().camPersBscMgr().pItems.at(0);
 
         for (const auto pipelineType : pipelineTypes) {
@@ -233,7 +233,7 @@ void Sampler::Base::destroy(const Context& ctx) {
         ctx.dev.destroyImageView(layerResource.view, ctx.pAllocator);
     }
     ctx.dev.destroyImage(image, ctx.pAllocator);
-    ctx.dev.freeMemory(memory, ctx.pAllocator);
+    ctx.memAllocator.free(allocation);
 }
 
 // FUNCTIONS
@@ -54,7 +54,7 @@ class Base {
     vk::ImageViewType imageViewType;
 
     vk::Image image;
-    vk::DeviceMemory memory;
+    Memory::Allocation allocation;
 
     std::vector<void *> pPixels;
 
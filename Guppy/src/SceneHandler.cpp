@@ -224,6 +224,7 @@ void Scene::Handler::init() {
             axesInfo.showNegative = true;
             instObj3dInfo = {};
             for (uint32_t i = 0; i < static_cast<uint32_t>(uniformHandler().lgtShdwCubeMgr().pItems.size()); i++) {
+                if (!uniformHandler().lgtShdwCubeMgr().hasItem(i)) continue;
                 instObj3dInfo.data.push_back(
                     {helpers::affine(glm::vec3(0.5f), uniformHandler().lgtShdwCubeMgr().getTypedItem(i).getPosition())});
             }
@@ -1197,6 +1198,17 @@ void Scene::Handler::recordRenderer(const PASS passType, const std::shared_ptr<P
     }
 }
 
+void Scene::Handler::recordDispatch(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
+                                    const vk::CommandBuffer& cmd, const uint8_t frameIndex) {
+    if (pPipelineBindData->type == PIPELINE{COMPUTE::CDLOD_SELECT}) {
+        // Every CDLOD renderer selects with this pipeline. The ones that don't use the GPU selection record nothing.
+        cdlodDbgRenderer.recordDispatch(passType, pPipelineBindData, cmd, frameIndex);
+        ocnRenderer.recordDispatch(passType, pPipelineBindData, cmd, frameIndex);
+    } else {
+        assert(false);
+    }
+}
+
 void Scene::Handler::cleanup() {
     // There used to be something here...
 }
\ No newline at end of file
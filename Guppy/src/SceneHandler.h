@@ -49,6 +49,8 @@ class Handler : public Game::Handler {
 
     void recordRenderer(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
                         const vk::CommandBuffer& cmd);
+    void recordDispatch(const PASS passType, const std::shared_ptr<Pipeline::BindData>& pPipelineBindData,
+                        const vk::CommandBuffer& cmd, const uint8_t frameIndex);
 
     void cleanup();
 
@@ -368,13 +368,16 @@ const std::map<SHADER, Shader::CreateInfo> ALL = {
     // OCEAN
     {SHADER::OCEAN_DISP_COMP, Shader::Ocean::DISP_COMP_CREATE_INFO},
     {SHADER::OCEAN_FFT_COMP, Shader::Ocean::FFT_COMP_CREATE_INFO},
+    {SHADER::OCEAN_FFT_STOCKHAM_COMP, Shader::Ocean::FFT_STOCKHAM_COMP_CREATE_INFO},
     {SHADER::OCEAN_VERT_INPUT_COMP, Shader::Ocean::VERT_INPUT_COMP_CREATE_INFO},
+    {SHADER::OCEAN_NORMAL_COMP, Shader::Ocean::NORMAL_COMP_CREATE_INFO},
     {SHADER::OCEAN_VERT, Shader::Ocean::VERT_CREATE_INFO},
     {SHADER::OCEAN_CDLOD_VERT, Shader::Ocean::VERT_CDLOD_CREATE_INFO},
     {SHADER::OCEAN_DEFERRED_MRT_FRAG, Shader::Ocean::DEFERRED_MRT_FRAG_CREATE_INFO},
     // CDLOD
     {SHADER::CDLOD_VERT, Shader::Cdlod::VERT_CREATE_INFO},
     {SHADER::CDLOD_TEX_VERT, Shader::Cdlod::VERT_TEX_CREATE_INFO},
+    {SHADER::CDLOD_SELECT_COMP, Shader::Cdlod::SELECT_COMP_CREATE_INFO},
 #ifdef USE_VOLUMETRIC_LIGHTING
     // ...
 #endif
@@ -103,13 +103,16 @@ enum class SHADER {
     // OCEAN
     OCEAN_DISP_COMP,
     OCEAN_FFT_COMP,
+    OCEAN_FFT_STOCKHAM_COMP,
     OCEAN_VERT_INPUT_COMP,
+    OCEAN_NORMAL_COMP,
     OCEAN_VERT,
     OCEAN_CDLOD_VERT,
     OCEAN_DEFERRED_MRT_FRAG,
     // CDLOD
     CDLOD_VERT,
     CDLOD_TEX_VERT,
+    CDLOD_SELECT_COMP,
 #ifdef USE_VOLUMETRIC_LIGHTING
     // ...
 #endif
@@ -52,6 +52,8 @@ Shell::Shell(Game &game, Handlers &&handlers)
           {VK_EXT_DEBUG_MARKER_EXTENSION_NAME, false, settings_.tryDebugMarkers},
           {VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_EXTENSION_NAME, false, false},
           {VK_EXT_TRANSFORM_FEEDBACK_EXTENSION_NAME, false, false},
+          {VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, false, true},
+          {VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, false, true},
       },
       currentTime_(0.0),
       elapsedTime_(0.0),
@@ -215,6 +217,17 @@ void Shell::destroyContext() {
 
     ctx_.dev.waitIdle();
 
+    {  // Device memory usage at its most (before anything is destroyed).
+        const auto stats = ctx_.memAllocator.getStats();
+        std::stringstream ss;
+        ss << "Device memory: " << stats.blockCount << " blocks (" << stats.totalSize << " bytes), "
+           << stats.allocationCount << " allocations (" << stats.usedSize << " bytes), utilization "
+           << stats.utilization() << ", fragmentation " << stats.fragmentation() << " (" << stats.freeRangeCount
+           << " free ranges), " << stats.dedicatedAllocationCount << " dedicated allocations (" << stats.dedicatedSize
+           << " bytes)";
+        log(LogPriority::LOG_INFO, ss.str().c_str());
+    }
+
     destroySwapchain();
     game_.onDetachShell();
     destroyBackBuffers();
@@ -589,6 +602,30 @@ void Shell::enumeratePhysicalDevices(uint32_t physicalDevCount) {
                         }
                     }
 
+                } else if (strcmp(extInfo.name, (char *)VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0) {
+                    if (extInfo.tryToEnabled) {
+                        // Check features
+                        auto features = props.device.getFeatures2<vk::PhysicalDeviceFeatures2,
+                                                                  vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR>();
+                        props.featTimelineSemaphore = features.get<vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR>();
+                        props.featTimelineSemaphore.pNext = nullptr;
+                        if (props.featTimelineSemaphore.timelineSemaphore) {
+                            props.phyDevExtInfos.back().valid = true;
+                            continue;
+                        }
+                        if (extInfo.required) {
+                            assert(false && "Required extension feature not supported");
+                            exit(EXIT_FAILURE);
+                        }
+                    }
+
+                } else if (strcmp(extInfo.name, (char *)VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0) {
+                    // No features, only the commands.
+                    if (extInfo.tryToEnabled) {
+                        props.phyDevExtInfos.back().valid = true;
+                        continue;
+                    }
+
                 } else {
                     assert(false && "Unhandled physical device extension");
                     exit(EXIT_FAILURE);
@@ -636,6 +673,10 @@ void Shell::pickPhysicalDevice() {
                     ctx_.vertexAttributeDivisorEnabled = extInfo.valid;
                 if (strcmp(extInfo.name, (char *)VK_EXT_TRANSFORM_FEEDBACK_EXTENSION_NAME) == 0)
                     ctx_.transformFeedbackEnabled = extInfo.valid;
+                if (strcmp(extInfo.name, (char *)VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0)
+                    ctx_.timelineSemaphoreEnabled = extInfo.valid;
+                if (strcmp(extInfo.name, (char *)VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+                    ctx_.drawIndirectCountEnabled = extInfo.valid;
             }
 
             break;
@@ -13,7 +13,6 @@
 #include "ConstantsAll.h"
 #include "Deferred.h"
 #include "FFT.h"
-#include "Ocean.h"
 #include "ScreenSpace.h"
 #include "Shadow.h"
 #include "Shell.h"
@@ -38,7 +37,6 @@ void Texture::Handler::init() {
     auto shadowOffsetTexCreateInfo = Shadow::MakeOffsetTex();
     auto skyboxNightTexCreateInfo = Texture::MakeCubeMapTex(Texture::SKYBOX_NIGHT_ID, SAMPLER::DEFAULT_NEAREST, 1024);
     auto fftTestTexCreateInfo = Texture::FFT::MakeTestTex();
-    auto oceanBltTexInfo = Texture::Ocean::MakeCopyTexInfo(::Ocean::N, ::Ocean::M);
 
     // Transition storage images. I can't think of a better time to do this. Its
     // not great but oh well.
@@ -86,7 +84,6 @@ void Texture::Handler::init() {
         &shadowOffsetTexCreateInfo,
         &skyboxNightTexCreateInfo,
         &fftTestTexCreateInfo,
-        &oceanBltTexInfo,
 #ifdef USE_VOLUMETRIC_LIGHTING
         // ...
 #endif
@@ -128,8 +125,7 @@ void Texture::Handler::reset() {
     // BUFFER VIEWS
     for (auto& bv : bufferViews_) {
         ctx.dev.destroyBufferView(bv.view, ctx.pAllocator);
-        ctx.dev.destroyBuffer(bv.buffRes.buffer, ctx.pAllocator);
-        ctx.dev.freeMemory(bv.buffRes.memory, ctx.pAllocator);
+        ctx.destroyBuffer(bv.buffRes);
     }
     bufferViews_.clear();
 }
@@ -198,11 +194,9 @@ void Texture::Handler::makeBufferView(const std::string_view& id, const vk::Form
     bufferViews_.push_back({id});
     bufferViews_.back().pLdgRes = loadingHandler().createLoadingResources();
 
-    BufferResource stgRes = {};
-    ctx.createBuffer(bufferViews_.back().pLdgRes->transferCmd,
+    ctx.createBuffer(*bufferViews_.back().pLdgRes,
                      vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eUniformTexelBuffer, size,
-                     std::string(id) + " uniform texel buffer", stgRes, bufferViews_.back().buffRes, pData);
-    bufferViews_.back().pLdgRes->stgResources.push_back(stgRes);
+                     std::string(id) + " uniform texel buffer", bufferViews_.back().buffRes, pData);
 
     loadingHandler().loadSubmit(std::move(bufferViews_.back().pLdgRes));
 
@@ -439,35 +433,27 @@ void Texture::Handler::createImage(Sampler::Base& sampler, std::unique_ptr<Loadi
     }
 
     // Allocate memory
-    helpers::createImageMemory(shell().context().dev, shell().context().memProps, memFlags, sampler.image, sampler.memory,
-                               shell().context().pAllocator);
+    helpers::createImageMemory(shell().context().dev, shell().context().memAllocator, memFlags, sampler.imgCreateInfo.tiling,
+                               sampler.image, sampler.allocation);
 
     // If loading data create a staging buffer, and copy/transition the data to the image.
     if (pLdgRes != nullptr) {
-        BufferResource stgRes = {};
-        vk::DeviceSize memorySize = sampler.size();
-        auto memReqsSize =
-            helpers::createBuffer(shell().context().dev, memorySize, vk::BufferUsageFlagBits::eTransferSrc,
-                                  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                                  shell().context().memProps, stgRes.buffer, stgRes.memory, shell().context().pAllocator);
-
-        void* pData = shell().context().dev.mapMemory(stgRes.memory, 0, memReqsSize);
+        vk::Buffer stgBuffer;
+        vk::DeviceSize stgOffset;
+        void* pData =
+            shell().context().stage(*pLdgRes, sampler.size(), StagingRing::IMAGE_ALIGNMENT, stgBuffer, stgOffset);
         size_t offset = 0;
         // Copy data to memory
         sampler.copyData(pData, offset);
 
-        shell().context().dev.unmapMemory(stgRes.memory);
-
         helpers::transitionImageLayout(pLdgRes->transferCmd, sampler.image, sampler.imgCreateInfo.format,
                                        vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
                                        vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
                                        sampler.imgCreateInfo.mipLevels, sampler.imgCreateInfo.arrayLayers);
 
         helpers::copyBufferToImage(pLdgRes->graphicsCmd, sampler.imgCreateInfo.extent.width,
-                                   sampler.imgCreateInfo.extent.height, sampler.imgCreateInfo.arrayLayers, stgRes.buffer,
-                                   sampler.image);
-
-        pLdgRes->stgResources.push_back(stgRes);
+                                   sampler.imgCreateInfo.extent.height, sampler.imgCreateInfo.arrayLayers, stgBuffer,
+                                   sampler.image, stgOffset);
     }
 }
 
@@ -485,8 +471,9 @@ void Texture::Handler::createDepthImage(Sampler::Base& sampler, std::unique_ptr<
     sampler.image = shell().context().dev.createImage(sampler.imgCreateInfo, shell().context().pAllocator);
 
     // Allocate memory
-    helpers::createImageMemory(shell().context().dev, shell().context().memProps, vk::MemoryPropertyFlagBits::eDeviceLocal,
-                               sampler.image, sampler.memory, shell().context().pAllocator);
+    helpers::createImageMemory(shell().context().dev, shell().context().memAllocator,
+                               vk::MemoryPropertyFlagBits::eDeviceLocal, sampler.imgCreateInfo.tiling, sampler.image,
+                               sampler.allocation);
 }
 
 void Texture::Handler::generateMipmaps(Sampler::Base& sampler, std::unique_ptr<LoadingResource>& pLdgRes) {
@@ -79,18 +79,23 @@ Uniform::Handler::Handler(Game* pGame)
           {"Post Process Data", STORAGE_BUFFER::POST_PROCESS, 5, "_S_DEF_PSTPRC"},
           //
       },
+      // Flushed once a frame by the handler.
       managersDynamic_{
           // TESSELLATION
           UniformDynamic::Tessellation::Phong::Manager  //
-          {"Tessellation Phong Data", UNIFORM_DYNAMIC::TESS_PHONG, 10, true, "_UD_TESS_PHONG"},
+          {"Tessellation Phong Data", UNIFORM_DYNAMIC::TESS_PHONG, 10, "_UD_TESS_PHONG",  //
+           vk::SharingMode::eExclusive, {}, true},
           // OCEAN
           UniformDynamic::Ocean::SimulationDispatch::Manager  //
-          {"Ocean Simulation Dispatch Data", UNIFORM_DYNAMIC::OCEAN_DISPATCH, 2, true, "_UD_OCN_DISPATCH"},
+          {"Ocean Simulation Dispatch Data", UNIFORM_DYNAMIC::OCEAN_DISPATCH, 2, "_UD_OCN_DISPATCH",  //
+           vk::SharingMode::eExclusive, {}, true},
           UniformDynamic::Ocean::SimulationDraw::Manager  //
-          {"Ocean Simulation Draw Data", UNIFORM_DYNAMIC::OCEAN_DRAW, 6, true, "_UD_OCN_DRAW"},
+          {"Ocean Simulation Draw Data", UNIFORM_DYNAMIC::OCEAN_DRAW, 6, "_UD_OCN_DRAW",  //
+           vk::SharingMode::eExclusive, {}, true},
           // CDLOD
           UniformDynamic::Cdlod::QuadTree::Manager  //
-          {"CDLOD Quad Tree Data", UNIFORM_DYNAMIC::CDLOD_QUAD_TREE, 2, true, "_UD_CDLOD_QDTR"},
+          {"CDLOD Quad Tree Data", UNIFORM_DYNAMIC::CDLOD_QUAD_TREE, 2, "_UD_CDLOD_QDTR",  //
+           vk::SharingMode::eExclusive, {}, true},
           // CAMERA
           Uniform::Manager<Camera::Perspective::Basic::Base>  //
           {"Basic Perspective Camera", UNIFORM_DYNAMIC::CAMERA_PERSPECTIVE_BASIC, 1 * 3, "_U_CAM_BSC_PERS"},
@@ -232,6 +237,7 @@ void Uniform::Handler::frame() {
     // DEFAULT DIRECTIONAL
     assert(lgtDefDirMgr().pItems.size() == 1);  // At the moment the shaders/offset manager are setup to handle one.
     for (uint32_t i = 0; i < lgtDefDirMgr().pItems.size(); i++) {
+        if (!lgtDefDirMgr().hasItem(i)) continue;
         auto& lgt = lgtDefDirMgr().getTypedItem(i);
         lgt.update(camera.getCameraSpaceDirection(lgt.direction), frameIndex);
         update(lgt, static_cast<int>(frameIndex));
@@ -239,6 +245,7 @@ void Uniform::Handler::frame() {
 
     // DEFAULT POSITIONAL
     for (uint32_t i = 0; i < lgtDefPosMgr().pItems.size(); i++) {
+        if (!lgtDefPosMgr().hasItem(i)) continue;
         auto& lgt = lgtDefPosMgr().getTypedItem(i);
         lgt.update(camera.getCameraSpacePosition(lgt.getPosition()), frameIndex);
         // lgt.update(glm::vec3(lgt.getPosition()), frameIndex);
@@ -247,6 +254,7 @@ void Uniform::Handler::frame() {
     // lgtDefPosMgr().update(shell().context().dev);
     // PBR POSITIONAL
     for (uint32_t i = 0; i < lgtPbrPosMgr().pItems.size(); i++) {
+        if (!lgtPbrPosMgr().hasItem(i)) continue;
         auto& lgt = lgtPbrPosMgr().getTypedItem(i);
         lgt.update(camera.getCameraSpacePosition(lgt.getPosition()), frameIndex);
         update(lgt, static_cast<int>(frameIndex));
@@ -255,6 +263,7 @@ void Uniform::Handler::frame() {
 
     // DEFAULT SPOT
     for (uint32_t i = 0; i < lgtDefSptMgr().pItems.size(); i++) {
+        if (!lgtDefSptMgr().hasItem(i)) continue;
         auto& lgt = lgtDefSptMgr().getTypedItem(i);
         lgt.update(camera.getCameraSpaceDirection(lgt.getDirection()), camera.getCameraSpacePosition(lgt.getPosition()),
                    frameIndex);
@@ -298,6 +307,7 @@ void Uniform::Handler::frame() {
             bool rotate = false;
 
             for (uint32_t i = 0; i < static_cast<uint32_t>(lgtShdwCubeMgr().pItems.size()); i++) {
+                if (!lgtShdwCubeMgr().hasItem(i)) continue;
                 auto& lgtShdwCube = lgtShdwCubeMgr().getTypedItem(i);
                 Mesh::Line* pIndicator = (pScene->posLgtCubeShdwOffset != Mesh::BAD_OFFSET)
                                              ? meshHandler().getLineMesh(pScene->posLgtCubeShdwOffset).get()
@@ -326,6 +336,12 @@ void Uniform::Handler::frame() {
     }
 }
 
+void Uniform::Handler::flush() {
+    const Flush flush = {shell().context().dev, passHandler().renderPassMgr().getFrameIndex()};
+    for (auto& manager : managers_) std::visit(flush, manager);
+    for (auto& manager : managersDynamic_) std::visit(flush, manager);
+}
+
 void Uniform::Handler::createCameras() {
     const auto& ctx = shell().context();
 
@@ -600,18 +616,21 @@ void Uniform::Handler::createTessellationData() {
 void Uniform::Handler::createVisualHelpers() {
     // DEFAULT POSITIONAL
     for (uint32_t i = 0; i < lgtDefPosMgr().pItems.size(); i++) {
+        if (!lgtDefPosMgr().hasItem(i)) continue;
         auto& lgt = lgtDefPosMgr().getTypedItem(i);
         meshHandler().makeModelSpaceVisualHelper(lgt);
         hasVisualHelpers_ = true;
     }
     // PBR POSITIONAL
     for (uint32_t i = 0; i < lgtPbrPosMgr().pItems.size(); i++) {
+        if (!lgtPbrPosMgr().hasItem(i)) continue;
         auto& lgt = lgtPbrPosMgr().getTypedItem(i);
         meshHandler().makeModelSpaceVisualHelper(lgt);
         hasVisualHelpers_ = true;
     }
     // DEFAULT SPOT
     for (uint32_t i = 0; i < lgtDefSptMgr().pItems.size(); i++) {
+        if (!lgtDefSptMgr().hasItem(i)) continue;
         auto& lgt = lgtDefSptMgr().getTypedItem(i);
         meshHandler().makeModelSpaceVisualHelper(lgt);
         hasVisualHelpers_ = true;
@@ -675,17 +694,21 @@ std::set<uint32_t> Uniform::Handler::getBindingOffsets(const std::vector<ItemPoi
     const auto& lowest = *offsets.begin();
     if (lowest == Descriptor::Set::OFFSET_ALL) {
         std::set<uint32_t> resolvedOffsets;
-        for (int i = 0; i < pItems.size(); i++) resolvedOffsets.insert(i);
+        // Removed items are skipped.
+        for (int i = 0; i < pItems.size(); i++)
+            if (pItems[i]) resolvedOffsets.insert(i);
         assert(resolvedOffsets.size());
         return resolvedOffsets;
     }
     assert(lowest >= 0 && *offsets.rbegin() < pItems.size());
+    for (const auto& offset : offsets) assert(pItems[offset] && "Uniform was removed");
     return offsets;
 }
 
 bool Uniform::Handler::validateUniformOffsets(const std::pair<DESCRIPTOR, index>& pair) {
     if (std::visit(Descriptor::HasOffsets{}, pair.first)) {
-        return pair.second < getItems(pair.first).size();
+        const auto& pItems = getItems(pair.first);
+        return pair.second < pItems.size() && pItems[pair.second];
     }
     return true;
 }
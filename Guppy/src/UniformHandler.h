@@ -56,16 +56,16 @@ using ManagerType = Descriptor::Manager<Descriptor::Base, TDerived, ItemPointer>
 template <class TDerived>
 class Manager : public ManagerType<TDerived> {
    public:
-    Manager(const std::string&& name, const DESCRIPTOR&& descriptorType, const index&& maxSize,
+    Manager(const std::string&& name, const DESCRIPTOR&& descriptorType, const index&& pageSize,
             const std::string&& macroName)
         : ManagerType<TDerived>{
               std::forward<const std::string>(name),
               std::forward<const DESCRIPTOR>(descriptorType),
-              std::forward<const index>(maxSize),
-              true,
+              std::forward<const index>(pageSize),
               std::forward<const std::string>(macroName),
               vk::SharingMode::eExclusive,
               {},
+              true,  // Flushed once a frame by the handler.
           } {}
 };
 
@@ -168,6 +168,8 @@ class Handler : public Game::Handler {
 
     void init() override;
     void frame() override;
+    // Copies the frame's uniform updates to the buffers. Called once a frame after all the updates.
+    void flush();
 
     // DESCRIPTOR
     uint32_t getDescriptorCount(const DESCRIPTOR& descType, const Uniform::offsets& offsets);
@@ -183,22 +185,24 @@ class Handler : public Game::Handler {
     void moveToDebugCamera();
     // ACTIVE
     inline auto& getActiveCamera() {
+        assert(camPersDefMgr().hasItem(activeCameraOffset_));
         return *static_cast<Camera::Perspective::Default::Base*>(camPersDefMgr().pItems[activeCameraOffset_].get());
     }
     // MAIN
     inline auto& getMainCamera() {
+        assert(camPersDefMgr().hasItem(mainCameraOffset_));
         return *static_cast<Camera::Perspective::Default::Base*>(camPersDefMgr().pItems[mainCameraOffset_].get());
     }
     // DEBUG
     virtual_inline bool hasDebugCamera() const { return debugCameraOffset_ != BAD_OFFSET; }
     inline auto& getDebugCamera() {
-        assert(hasDebugCamera());
+        assert(hasDebugCamera() && camPersDefMgr().hasItem(debugCameraOffset_));
         return *static_cast<Camera::Perspective::Default::Base*>(camPersDefMgr().pItems[debugCameraOffset_].get());
     }
 
     // FIRST LIGHT
     inline auto& getDefPosLight(const uint32_t index = 0) {
-        assert(index < lgtDefPosMgr().pItems.size());
+        assert(lgtDefPosMgr().hasItem(index));
         return *static_cast<Light::Default::Positional::Base*>(lgtDefPosMgr().pItems[index].get());
     }
 
@@ -209,7 +213,7 @@ class Handler : public Game::Handler {
     template <typename T>
     inline T& getUniform(const DESCRIPTOR& type, const index& index) {
         auto& pItems = getItems(type);
-        assert(index < pItems.size());
+        assert(index < pItems.size() && pItems[index] && "Uniform was removed");
         return std::ref(*(T*)(pItems[index].get()));
     }
 
@@ -255,6 +259,15 @@ class Handler : public Game::Handler {
         }
     };
 
+    struct Flush {
+        template <typename TManager>
+        void operator()(TManager& manager) const {
+            manager.flush(dev, frameIndex);
+        }
+        const vk::Device& dev;
+        const uint8_t frameIndex;
+    };
+
     struct GetType {
         template <typename TManager>
         const auto& operator()(const TManager& manager) const {
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "FFTStockham.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <Common/Helpers.h>
+
+namespace {
+
+// Same as the shader macros.
+inline glm::vec2 complexMul(const glm::vec2& a, const glm::vec2& b) {
+    return {a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x};
+}
+inline glm::vec2 mulI(const glm::vec2& a) { return {-a.y, a.x}; }
+
+}  // namespace
+
+void FFT::Stockham(glm::vec2* pLine, glm::vec2* pScratch, const uint32_t n, const float* pTwiddleRe,
+                   const float* pTwiddleIm) {
+    assert(n >= 2 && helpers::isPowerOfTwo(n));
+    const uint32_t log2n = static_cast<uint32_t>(std::log2(n));
+    const uint32_t halfN = n >> 1;
+
+    // exp(i * 2 * PI * t / n) for t < n: the last stage of the radix-2 table (sTwiddle), negated for the second half.
+    const float* pRe = &pTwiddleRe[halfN - 1];
+    const float* pIm = &pTwiddleIm[halfN - 1];
+    const auto twiddle = [pRe, pIm, halfN](const uint32_t t) -> glm::vec2 {
+        return (t < halfN) ? glm::vec2{pRe[t], pIm[t]} : glm::vec2{-pRe[t - halfN], -pIm[t - halfN]};
+    };
+
+    // Radix-4 stages. "ns" is the size of the sub-transforms done so far.
+    const uint32_t q = n >> 2;
+    uint32_t ns = 1;
+    for (uint32_t s = 0; s < (log2n >> 1); s++) {
+        const uint32_t step = n / (ns << 2);
+        for (uint32_t lid = 0; lid < q; lid++) {
+            const uint32_t k = lid & (ns - 1);
+            for (uint32_t r = 0; r < 4; r++)
+                pScratch[(lid << 2) + r] = complexMul(twiddle(k * r * step), pLine[lid + (r * q)]);
+        }
+        // barrier()
+        for (uint32_t lid = 0; lid < q; lid++) {
+            const uint32_t k = lid & (ns - 1);
+            const uint32_t dst = ((lid - k) << 2) + k;
+            const glm::vec2* h = &pScratch[lid << 2];
+            pLine[dst + (0 * ns)] = (h[0] + h[2]) + (h[1] + h[3]);
+            pLine[dst + (1 * ns)] = (h[0] - h[2]) + mulI(h[1] - h[3]);
+            pLine[dst + (2 * ns)] = (h[0] + h[2]) - (h[1] + h[3]);
+            pLine[dst + (3 * ns)] = (h[0] - h[2]) - mulI(h[1] - h[3]);
+        }
+        ns <<= 2;
+    }
+
+    // Radix-2 tail for odd powers of two. Each butterfly writes back to the same two elements it reads.
+    if (log2n & 1) {
+        for (uint32_t j = 0; j < halfN; j++) {
+            const glm::vec2 h0 = pLine[j], h1 = complexMul(twiddle(j), pLine[j + halfN]);
+            pLine[j] = h0 + h1;
+            pLine[j + halfN] = h0 - h1;
+        }
+    }
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef FFT_STOCKHAM_H
+#define FFT_STOCKHAM_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace FFT {
+
+/**
+ * C++ port of the Stockham kernel (comp.ocean.fft.stockham.glsl). It does the same inverse, unnormalized transform of one
+ * line of "n" complex values, with the same indexing: radix-4 stages where invocation "lid" reads the values a quarter of
+ * the line apart and writes them out sorted, and a radix-2 tail for odd powers of two. The output is in natural order, so
+ * the input isn't bit reversed. Every invocation of a stage reads before any of them writes (the barrier in the shader), so
+ * the reads go to "pScratch" (n values). The twiddles are the split MakeTwiddleFactors table of any size >= n.
+ */
+void Stockham(glm::vec2* pLine, glm::vec2* pScratch, const uint32_t n, const float* pTwiddleRe, const float* pTwiddleIm);
+
+}  // namespace FFT
+
+#endif  // !FFT_STOCKHAM_H
@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef FFT_TABLES_H
+#define FFT_TABLES_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Lookup tables for the radix-2 fft. The compute shaders get them as buffer views (BufferView::Ocean), and the CPU
+ * simulation (Ocean::Simulation) uses the same ones.
+ */
+namespace FFT {
+// Bit reversed index of each of the N indices.
+std::vector<int16_t> MakeBitReversalOffsets(uint32_t N);
+// Interleaved (real, imaginary) twiddle factors for every stage (stage s starts at (2^(s - 1)) - 1).
+std::vector<float> MakeTwiddleFactors(uint32_t N);
+}  // namespace FFT
+
+#endif  // !FFT_TABLES_H
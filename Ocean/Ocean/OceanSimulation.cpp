@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "OceanSimulation.h"
+
+#include <Common/Parallel.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+#include "FFTStockham.h"
+#include "FFTTables.h"
+
+namespace {
+
+constexpr float EPSILON = 1e-6f;  // Same as the dispersion shader.
+
+/**
+ * Radix-2 butterflies over "count" contiguous elements starting at a and b. The row pass walks a run of twiddles, and the
+ * column pass uses the same twiddle for the whole run, so the twiddle pointers advance by "twiddleStride" (1 or 0).
+ */
+inline void butterflies(float* pRe, float* pIm, const uint32_t a, const uint32_t b, const uint32_t count,
+                        const float* pTwiddleRe, const float* pTwiddleIm, const uint32_t twiddleStride) {
+    for (uint32_t i = 0; i < count; i++) {
+        const float wRe = pTwiddleRe[i * twiddleStride], wIm = pTwiddleIm[i * twiddleStride];
+        // complexMul(w, b)
+        const float t0Re = wRe * pRe[b + i] - wIm * pIm[b + i];
+        const float t0Im = wRe * pIm[b + i] + wIm * pRe[b + i];
+        const float t1Re = pRe[a + i], t1Im = pIm[a + i];
+        pRe[b + i] = t1Re - t0Re;
+        pIm[b + i] = t1Im - t0Im;
+        pRe[a + i] = t1Re + t0Re;
+        pIm[a + i] = t1Im + t0Im;
+    }
+}
+
+}  // namespace
+
+namespace Ocean {
+
+Simulation::Simulation(const SurfaceCreateInfo& info)
+    : info_(info),
+      omega0_(2.0f * glm::pi<float>() / T),
+      wave_(info.N * info.M * 4),
+      hTilde0_(info.N * info.M * 4),
+      bitRevOffsetsN_(FFT::MakeBitReversalOffsets(info.N)),
+      bitRevOffsetsM_(FFT::MakeBitReversalOffsets(info.M)),
+      positions_(info.N * info.M),
+      normals_(info.N * info.M) {
+    assert(IsValid(info_));
+
+    // Same data as the WAVE_FOURIER_ID texture. The generator only depends on the create info (and seed).
+    MakeWaveFourierData(info_, wave_.data(), hTilde0_.data());
+
+    // Split the interleaved twiddle factors so the butterflies can read contiguous runs of them.
+    const auto twiddleFactors = FFT::MakeTwiddleFactors((std::max)(info_.N, info_.M));
+    twiddleRe_.reserve(twiddleFactors.size() / 2);
+    twiddleIm_.reserve(twiddleFactors.size() / 2);
+    for (size_t i = 0; i < twiddleFactors.size(); i += 2) {
+        twiddleRe_.push_back(twiddleFactors[i + 0]);
+        twiddleIm_.push_back(twiddleFactors[i + 1]);
+    }
+
+    for (auto& plane : planes_) {
+        plane.re.resize(info_.N * info_.M);
+        plane.im.resize(info_.N * info_.M);
+    }
+}
+
+void Simulation::update(const float time) {
+    // One tile of rows, or columns per hardware thread.
+    helpers::parallelFor(info_.M, 0, [this, time](uint32_t begin, uint32_t end) { dispersion(begin, end, time); });
+    helpers::parallelFor(info_.M, 0, [this](uint32_t begin, uint32_t end) { fftRows(begin, end); });
+    helpers::parallelFor(info_.N, 0, [this](uint32_t begin, uint32_t end) { fftColumns(begin, end); });
+    helpers::parallelFor(info_.M, 0, [this](uint32_t begin, uint32_t end) { vertexInput(begin, end); });
+    helpers::parallelFor(info_.M, 0, [this](uint32_t begin, uint32_t end) {
+        MakeNormals(info_, positions_.data(), normals_.data(), begin, end);
+    });
+}
+
+void Simulation::dispersion(const uint32_t rowBegin, const uint32_t rowEnd, const float time) {
+    // Do the bit reversal for the radix-2 fft here (same as the shader). The Stockham fft sorts its own output.
+    const bool bitReverse = info_.fftKernel == FFT_KERNEL::RADIX_2;
+    for (uint32_t y = rowBegin; y < rowEnd; y++) {
+        const uint32_t rowWrite = (bitReverse ? static_cast<uint32_t>(bitRevOffsetsM_[y]) : y) * info_.N;
+        for (uint32_t x = 0; x < info_.N; x++) {
+            const uint32_t idx = ((y * info_.N) + x) * 4;
+            const uint32_t write = rowWrite + (bitReverse ? static_cast<uint32_t>(bitRevOffsetsN_[x]) : x);
+
+            // Wave vector data (kx, kz, |k|, sqrt(g|k|)), and fourier domain data (hTilde0, hTilde0Conj)
+            const float kx = wave_[idx + 0], kz = wave_[idx + 1], k = wave_[idx + 2], w = wave_[idx + 3];
+            const float* pH0 = &hTilde0_[idx];
+
+            // Dispersion relation
+            const float omega_kt = std::floor(w / omega0_) * omega0_ * time;
+            const float c = std::cos(omega_kt), s = std::sin(omega_kt);
+
+            const float hRe = (pH0[0] * c - pH0[1] * s) + (pH0[2] * c - pH0[3] * -s);
+            const float hIm = (pH0[0] * s + pH0[1] * c) + (pH0[2] * -s + pH0[3] * c);
+
+            // Height
+            planes_[HEIGHT].re[write] = hRe;
+            planes_[HEIGHT].im[write] = hIm;
+
+            // Differentials (hTilde * -i * k / |k|)
+            const float dx = (k < EPSILON) ? 0.0f : (-kx / k);
+            const float dz = (k < EPSILON) ? 0.0f : (-kz / k);
+            planes_[DIFFERENTIAL_X].re[write] = -hIm * dx;
+            planes_[DIFFERENTIAL_X].im[write] = hRe * dx;
+            planes_[DIFFERENTIAL_Z].re[write] = -hIm * dz;
+            planes_[DIFFERENTIAL_Z].im[write] = hRe * dz;
+        }
+    }
+}
+
+void Simulation::fftRows(const uint32_t rowBegin, const uint32_t rowEnd) {
+    if (info_.fftKernel == FFT_KERNEL::STOCKHAM_RADIX_4) {
+        std::vector<glm::vec2> line(info_.N), scratch(info_.N);
+        for (auto& plane : planes_) {
+            for (uint32_t y = rowBegin; y < rowEnd; y++) {
+                const uint32_t row = y * info_.N;
+                for (uint32_t x = 0; x < info_.N; x++) line[x] = {plane.re[row + x], plane.im[row + x]};
+                FFT::Stockham(line.data(), scratch.data(), info_.N, twiddleRe_.data(), twiddleIm_.data());
+                for (uint32_t x = 0; x < info_.N; x++) {
+                    plane.re[row + x] = line[x].x;
+                    plane.im[row + x] = line[x].y;
+                }
+            }
+        }
+        return;
+    }
+
+    const uint32_t log2N = static_cast<uint32_t>(std::log2(info_.N));
+    for (auto& plane : planes_) {
+        for (uint32_t y = rowBegin; y < rowEnd; y++) {
+            const uint32_t row = y * info_.N;
+            for (uint32_t s = 1; s <= log2N; s++) {
+                const uint32_t m = 1 << s, m2 = m >> 1;
+                // The twiddles for a stage are contiguous (m2 - 1 + j), so each group of butterflies is one run.
+                for (uint32_t k = 0; k < info_.N; k += m)
+                    butterflies(plane.re.data(), plane.im.data(), row + k, row + k + m2, m2, &twiddleRe_[m2 - 1],
+                                &twiddleIm_[m2 - 1], 1);
+            }
+        }
+    }
+}
+
+void Simulation::fftColumns(const uint32_t columnBegin, const uint32_t columnEnd) {
+    if (info_.fftKernel == FFT_KERNEL::STOCKHAM_RADIX_4) {
+        std::vector<glm::vec2> line(info_.M), scratch(info_.M);
+        for (auto& plane : planes_) {
+            for (uint32_t x = columnBegin; x < columnEnd; x++) {
+                for (uint32_t y = 0; y < info_.M; y++) line[y] = {plane.re[(y * info_.N) + x], plane.im[(y * info_.N) + x]};
+                FFT::Stockham(line.data(), scratch.data(), info_.M, twiddleRe_.data(), twiddleIm_.data());
+                for (uint32_t y = 0; y < info_.M; y++) {
+                    plane.re[(y * info_.N) + x] = line[y].x;
+                    plane.im[(y * info_.N) + x] = line[y].y;
+                }
+            }
+        }
+        return;
+    }
+
+    const uint32_t log2M = static_cast<uint32_t>(std::log2(info_.M));
+    const uint32_t count = columnEnd - columnBegin;
+    for (auto& plane : planes_) {
+        for (uint32_t s = 1; s <= log2M; s++) {
+            const uint32_t m = 1 << s, m2 = m >> 1;
+            for (uint32_t j = 0; j < m2; j++) {
+                // Every column in the tile uses the same twiddle, so the butterflies run across the row segment.
+                for (uint32_t k = j; k < info_.M; k += m)
+                    butterflies(plane.re.data(), plane.im.data(), (k * info_.N) + columnBegin,
+                                ((k + m2) * info_.N) + columnBegin, count, &twiddleRe_[m2 - 1 + j],
+                                &twiddleIm_[m2 - 1 + j], 0);
+            }
+        }
+    }
+}
+
+void Simulation::vertexInput(const uint32_t rowBegin, const uint32_t rowEnd) {
+    for (uint32_t y = rowBegin; y < rowEnd; y++) {
+        for (uint32_t x = 0; x < info_.N; x++) {
+            const uint32_t idx = (y * info_.N) + x;
+            const float sign = ((x + y) & 1) ? -1.0f : 1.0f;
+
+            // Position (horizontal displacement (choppiness), height)
+            positions_[idx] = {
+                (sign * planes_[DIFFERENTIAL_X].re[idx]) * info_.lambda,
+                (sign * planes_[DIFFERENTIAL_Z].re[idx]) * info_.lambda,
+                sign * planes_[HEIGHT].re[idx],
+                1.0f,
+            };
+        }
+    }
+}
+
+void MakeNormals(const SurfaceCreateInfo& info, const glm::vec4* pPositions, glm::vec4* pNormals, const uint32_t rowBegin,
+                 const uint32_t rowEnd) {
+    const float scaleX = info.Lx / static_cast<float>(info.N);
+    const float scaleZ = info.Lz / static_cast<float>(info.M);
+    for (uint32_t y = rowBegin; y < rowEnd; y++) {
+        // The surface tiles, so the neighbors of the edge texels wrap around (same as the shader).
+        const uint32_t back = ((y + info.M - 1) % info.M) * info.N;
+        const uint32_t front = ((y + 1) % info.M) * info.N;
+        for (uint32_t x = 0; x < info.N; x++) {
+            const uint32_t row = y * info.N;
+            const auto& left = pPositions[row + ((x + info.N - 1) % info.N)];
+            const auto& right = pPositions[row + ((x + 1) % info.N)];
+
+            // Central differences of the displaced surface (x, height, z) across two grid cells.
+            const glm::vec3 dPdx = {(2.0f * scaleX) + (right.x - left.x), right.z - left.z, right.y - left.y};
+            const glm::vec3 dPdz = {pPositions[front + x].x - pPositions[back + x].x,
+                                    pPositions[front + x].z - pPositions[back + x].z,
+                                    (2.0f * scaleZ) + (pPositions[front + x].y - pPositions[back + x].y)};
+
+            // Jacobian determinant of the horizontal displacement
+            const float jacobian = ((dPdx.x * dPdz.z) - (dPdz.x * dPdx.z)) / (4.0f * scaleX * scaleZ);
+
+            pNormals[row + x] = {glm::normalize(glm::cross(dPdz, dPdx)), jacobian};
+        }
+    }
+}
+
+}  // namespace Ocean
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef OCEAN_SIMULATION_H
+#define OCEAN_SIMULATION_H
+
+#include <array>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "OceanSurface.h"
+
+namespace Ocean {
+
+/**
+ * CPU reference version of the ocean compute work (ComputeWork::Ocean). It runs the same math as the dispersion, fft,
+ * vertex input, and normal compute shaders on the same wave/Fourier data, so its output can be compared texel for texel with
+ * the VERT_INPUT_ID texture.
+ *
+ * The complex channels are stored as separate real/imaginary planes. The radix-2 fft butterflies run over contiguous runs
+ * of a plane (twiddle runs for the row pass, whole row segments for the column pass) so the inner loops vectorize. The
+ * Stockham kernel (SurfaceCreateInfo::fftKernel) runs its C++ port (FFT::Stockham) one line at a time instead. Each step is
+ * split into tiles of rows or columns that run on multiple threads.
+ */
+class Simulation {
+   public:
+    Simulation(const SurfaceCreateInfo& info);
+
+    // Run dispersion, the inverse fft, the vertex input assembly, and the normal pass for simulation time "time" (seconds).
+    void update(const float time);
+
+    constexpr const auto& getInfo() const { return info_; }
+    // Vertex input data laid out the same as the VERT_INPUT_ID texture layers (row major, N * M texels).
+    constexpr const auto& getPositions() const { return positions_; }  // (x displacement, z displacement, height, 1)
+    constexpr const auto& getNormals() const { return normals_; }      // (normal, jacobian determinant)
+
+   private:
+    // Same order as the dispersion relation image layers (height, differential).
+    enum CHANNEL : uint32_t {
+        HEIGHT = 0,
+        DIFFERENTIAL_X,
+        DIFFERENTIAL_Z,
+        CHANNEL_COUNT,
+    };
+    struct Plane {
+        std::vector<float> re;
+        std::vector<float> im;
+    };
+
+    void dispersion(const uint32_t rowBegin, const uint32_t rowEnd, const float time);
+    void fftRows(const uint32_t rowBegin, const uint32_t rowEnd);
+    void fftColumns(const uint32_t columnBegin, const uint32_t columnEnd);
+    void vertexInput(const uint32_t rowBegin, const uint32_t rowEnd);
+
+    const SurfaceCreateInfo info_;
+    const float omega0_;
+    // Inputs (same as the WAVE_FOURIER_ID texture layers)
+    std::vector<float> wave_;
+    std::vector<float> hTilde0_;
+    // FFT
+    std::vector<int16_t> bitRevOffsetsN_;
+    std::vector<int16_t> bitRevOffsetsM_;
+    std::vector<float> twiddleRe_;
+    std::vector<float> twiddleIm_;
+    std::array<Plane, CHANNEL_COUNT> planes_;
+    // Outputs
+    std::vector<glm::vec4> positions_;
+    std::vector<glm::vec4> normals_;
+};
+
+/**
+ * The normal pass on its own: normals and Jacobian determinants for rows [rowBegin, rowEnd) of a displaced grid laid out
+ * the same as Simulation::getPositions. Both buffers hold N * M texels.
+ */
+void MakeNormals(const SurfaceCreateInfo& info, const glm::vec4* pPositions, glm::vec4* pNormals, const uint32_t rowBegin,
+                 const uint32_t rowEnd);
+
+}  // namespace Ocean
+
+#endif  //! OCEAN_SIMULATION_H
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "OceanSurface.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+#include <Common/Helpers.h>
+#include <Common/Parallel.h>
+
+namespace {
+
+/**
+ * Phillips spectrum for the wave vector (kx, kz). Phillips(-k) == Phillips(k) because the cosine factor is squared, so this
+ * is only ever evaluated once per texel.
+ */
+float phillipsSpectrum(const float kx, const float kz, const float kMagnitude, const Ocean::SurfaceCreateInfo& info) {
+    if (kMagnitude < 1e-5f) return 0.0f;
+    const float kHatOmegaHat = (kx * info.omega.x + kz * info.omega.y) / kMagnitude;  // cosine factor
+    const float kMagnitude2 = kMagnitude * kMagnitude;
+    const float damp = std::exp(-kMagnitude2 * info.l * info.l);
+    return info.A * damp * (std::exp(-1.0f / (kMagnitude2 * info.L * info.L)) / (kMagnitude2 * kMagnitude2)) *
+           (kHatOmegaHat * kHatOmegaHat);
+}
+
+/**
+ * Counter-based gaussian pair. The 64-bit key (seed, counter) is run through the splitmix64 finalizer, and the two 32-bit
+ * halves are turned into a normal pair with the Box-Muller transform. There is no generator state, so any texel can be
+ * generated independently of the others.
+ */
+glm::vec2 gaussianPair(const uint32_t seed, const uint32_t counter) {
+    uint64_t z = ((static_cast<uint64_t>(seed) << 32) | counter) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z = z ^ (z >> 31);
+    // 24 bits of mantissa each. u1 is in (0, 1] so the log is always finite.
+    const float u1 = (static_cast<float>((z >> 40) & 0xFFFFFF) + 1.0f) * (1.0f / 16777216.0f);
+    const float u2 = static_cast<float>((z >> 8) & 0xFFFFFF) * (1.0f / 16777216.0f);
+    const float r = std::sqrt(-2.0f * std::log(u1));
+    const float theta = glm::two_pi<float>() * u2;
+    return {r * std::cos(theta), r * std::sin(theta)};
+}
+
+void makeWaveFourierRows(const Ocean::SurfaceCreateInfo& info, const uint32_t rowBegin, const uint32_t rowEnd, float* pWave,
+                         float* pHTilde0) {
+    const int halfN = info.N / 2, halfM = info.M / 2;
+
+    for (uint32_t i = rowBegin; i < rowEnd; i++) {
+        const float kz = 2.0f * glm::pi<float>() * (static_cast<int>(i) - halfM) / info.Lz;
+        for (uint32_t j = 0; j < info.N; j++) {
+            const uint32_t texel = (i * info.N) + j;
+            const uint32_t idx = texel * 4;
+
+            // Wave vector data
+            const float kx = 2.0f * glm::pi<float>() * (static_cast<int>(j) - halfN) / info.Lx;
+            const float kMagnitude = std::sqrt(kx * kx + kz * kz);
+            pWave[idx + 0] = kx;
+            pWave[idx + 1] = kz;
+            pWave[idx + 2] = kMagnitude;
+            pWave[idx + 3] = std::sqrt(::Ocean::g * kMagnitude);
+
+            // Fourier domain amplitude factor, and two independent draws per texel: one for h~0(k) and one for the
+            // conjugate term.
+            const float amplitude = std::sqrt(phillipsSpectrum(kx, kz, kMagnitude, info) / 2.0f);
+            const glm::vec2 xhi = gaussianPair(info.seed, texel * 2 + 0) * amplitude;
+            const glm::vec2 xhiConj = gaussianPair(info.seed, texel * 2 + 1) * amplitude;
+
+            pHTilde0[idx + 0] = xhi.x;
+            pHTilde0[idx + 1] = xhi.y;
+            pHTilde0[idx + 2] = xhiConj.x;
+            pHTilde0[idx + 3] = -xhiConj.y;  // conjugate
+        }
+    }
+}
+
+}  // namespace
+
+namespace Ocean {
+
+bool IsValid(const SurfaceCreateInfo& info) {
+    const auto minDim = (std::min)(info.N, info.M);
+    const auto maxDim = (std::max)(info.N, info.M);
+    return helpers::isPowerOfTwo(info.N) && helpers::isPowerOfTwo(info.M) &&  //
+           helpers::isPowerOfTwo(info.fftLocalSize) && info.fftLocalSize <= minDim &&
+           helpers::isPowerOfTwo(info.dispLocalSize) && info.dispLocalSize <= minDim &&
+           (info.fftKernel != FFT_KERNEL::STOCKHAM_RADIX_4 || (maxDim >= 4 && maxDim <= STOCKHAM_MAX_SIZE)) &&
+           (info.heightReadbackScale == 0 ||
+            (helpers::isPowerOfTwo(info.heightReadbackScale) && info.heightReadbackScale <= minDim));
+}
+
+void MakeWaveFourierData(const SurfaceCreateInfo& info, float* pWave, float* pHTilde0, const uint32_t threadCount) {
+    assert(helpers::isPowerOfTwo(info.N) && helpers::isPowerOfTwo(info.M));
+    assert(pWave != nullptr && pHTilde0 != nullptr);
+
+    // Split the rows into one tile per thread. The output doesn't depend on the split.
+    helpers::parallelFor(info.M, threadCount, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        makeWaveFourierRows(info, rowBegin, rowEnd, pWave, pHTilde0);
+    });
+}
+
+}  // namespace Ocean
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef OCEAN_SURFACE_H
+#define OCEAN_SURFACE_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * The ocean surface parameters, and the wave/Fourier data generated from them. This only depends on glm, so the CPU side of
+ * the simulation (Ocean::Simulation) can be driven without a device.
+ */
+
+namespace Ocean {
+
+/**
+ * Default ocean data sample dimensions and compute local sizes. These are only defaults. The values used are the ones on
+ * SurfaceCreateInfo, and they get to the compute shaders through specialization constants, so nothing needs to be
+ * recompiled to change them. The dimensions need to be powers of two (they can differ from each other), and the local
+ * sizes need to be powers of two that are no larger than the smallest dimension.
+ */
+constexpr uint32_t DEFAULT_N = 256;
+constexpr uint32_t DEFAULT_M = DEFAULT_N;
+constexpr uint32_t DEFAULT_FFT_LOCAL_SIZE = 64;
+constexpr uint32_t DEFAULT_DISP_LOCAL_SIZE = 32;
+// Every DEFAULT_HEIGHT_READBACK_SCALE-th texel along each dimension is read back for the cpu height queries.
+constexpr uint32_t DEFAULT_HEIGHT_READBACK_SCALE = 4;
+
+/**
+ * FFT kernels for the compute work. The radix-2 kernel runs the butterflies in place on the dispersion image, one invocation
+ * per row/column, and needs the dispersion pass to write its output in bit reversed order. The Stockham kernel runs a
+ * workgroup per row/column with the line in shared memory (radix-4 stages with a radix-2 tail for odd powers of two). It
+ * writes its output in natural order, so there is no bit reversal. Shared memory limits it to STOCKHAM_MAX_SIZE.
+ */
+enum class FFT_KERNEL : uint32_t {
+    RADIX_2 = 0,
+    STOCKHAM_RADIX_4,
+};
+constexpr uint32_t STOCKHAM_MAX_SIZE = 1024;
+
+constexpr float T = 200.0f;  // wave repeat time
+constexpr float g = 9.81f;   // gravity
+
+struct SurfaceCreateInfo {
+    SurfaceCreateInfo()
+        : Lx(1000.0f),  //
+          Lz(1000.0f),
+          N(DEFAULT_N),
+          M(DEFAULT_M),
+          fftLocalSize(DEFAULT_FFT_LOCAL_SIZE),
+          dispLocalSize(DEFAULT_DISP_LOCAL_SIZE),
+          fftKernel(FFT_KERNEL::RADIX_2),
+          heightReadbackScale(DEFAULT_HEIGHT_READBACK_SCALE),
+          V(31.0f),
+          omega(1.0f, 0.0f),
+          l(1.0f),
+          A(2e-5f),
+          L(),
+          lambda(-1.0f),
+          seed(0) {
+        L = (V * V) / g;
+    }
+    float Lx;                      // grid size (meters)
+    float Lz;                      // grid size (meters)
+    uint32_t N;                    // grid size (discrete Lx)
+    uint32_t M;                    // grid size (discrete Lz)
+    uint32_t fftLocalSize;         // fft compute local size
+    uint32_t dispLocalSize;        // dispersion/vertex input compute local size (x & y)
+    FFT_KERNEL fftKernel;          // fft compute kernel
+    uint32_t heightReadbackScale;  // downsample factor of the height readback (power of two, 0 disables it)
+    float V;                       // wind speed (meters/second)
+    glm::vec2 omega;               // wind direction (normalized)
+    float l;                       // small wave cutoff (meters)
+    float A;                       // Phillips spectrum constant (wave amplitude?)
+    float L;                       // largest possible waves from continuous wind speed V
+    float lambda;                  // horizontal displacement scale factor
+    uint32_t seed;                 // spectrum random seed
+};
+
+bool IsValid(const SurfaceCreateInfo& info);
+constexpr uint32_t GetWorkgroupCount(const uint32_t size, const uint32_t localSize) {
+    return (size + localSize - 1) / localSize;
+}
+
+/**
+ * Generates the wave vector data (kx, kz, |k|, sqrt(g|k|)) and the Fourier domain amplitudes (h~0(k), conj(h~0(-k))) for
+ * the WAVE_FOURIER_ID texture. Both buffers need room for N * M * 4 floats. Rows are generated in tiles on "threadCount"
+ * threads (0 is one per hardware thread). The gaussian draws come from a counter-based generator keyed on (seed, texel), so
+ * the output is the same no matter how many threads are used.
+ */
+void MakeWaveFourierData(const SurfaceCreateInfo& info, float* pWave, float* pHTilde0, const uint32_t threadCount = 0);
+
+}  // namespace Ocean
+
+#endif  // !OCEAN_SURFACE_H
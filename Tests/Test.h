@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/*  A tiny test runner for the code that doesn't need a device. Tests are grouped in suites that ctest runs one at a time
+    ("GuppyTests <suite>"). BENCH cases only run with "--bench" because they only report timings.
+*/
+namespace Test {
+
+struct Case {
+    const char *suite;
+    const char *name;
+    void (*pFunc)();
+    bool bench;
+};
+
+std::vector<Case> &getCases();
+
+struct Registrar {
+    Registrar(const char *suite, const char *name, void (*pFunc)(), const bool bench) {
+        getCases().push_back({suite, name, pFunc, bench});
+    }
+};
+
+void fail(const char *file, const int line, const char *expr);
+
+// Runs "func" "iterations" times and returns the average milliseconds.
+template <typename TFunc>
+double time(const uint32_t iterations, TFunc func);
+
+}  // namespace Test
+
+#define TEST_CASE_(suite, name, bench)                                                          \
+    static void suite##_##name();                                                               \
+    static Test::Registrar suite##_##name##_registrar(#suite, #name, suite##_##name, bench);    \
+    static void suite##_##name()
+
+#define TEST(suite, name) TEST_CASE_(suite, name, false)
+#define BENCH(suite, name) TEST_CASE_(suite, name, true)
+
+#define EXPECT(expr)                                                                            \
+    do {                                                                                        \
+        if (!(expr)) Test::fail(__FILE__, __LINE__, #expr);                                     \
+    } while (0)
+
+// Stops the test case on failure.
+#define REQUIRE(expr)                                                                           \
+    do {                                                                                        \
+        if (!(expr)) {                                                                          \
+            Test::fail(__FILE__, __LINE__, #expr);                                              \
+            return;                                                                             \
+        }                                                                                       \
+    } while (0)
+
+template <typename TFunc>
+double Test::time(const uint32_t iterations, TFunc func) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) func();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+#endif  // !TEST_H
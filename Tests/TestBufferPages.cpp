@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include "BufferPages.h"
+#include "Test.h"
+
+using Buffer::Manager::Pages;
+using Buffer::Manager::Ranges;
+
+namespace {
+bool Equals(const Ranges& ranges, const std::vector<Ranges::range>& expected) { return ranges.get() == expected; }
+}  // namespace
+
+// Dirty, and free ranges are kept sorted, and merged when they touch, overlap, or contain each other.
+TEST(BufferPages, RangesCoalesce) {
+    Ranges ranges;
+    // Adjacent
+    ranges.add(4, 2);
+    ranges.add(6, 2);
+    ranges.add(2, 2);
+    EXPECT(Equals(ranges, {{2, 6}}));
+    ranges.add(10, 1);
+    EXPECT(Equals(ranges, {{2, 6}, {10, 1}}));
+    // Fills the gap, and merges both sides.
+    ranges.add(8, 2);
+    EXPECT(Equals(ranges, {{2, 9}}));
+
+    // Overlapping
+    ranges.clear();
+    ranges.add(10, 5);
+    ranges.add(8, 4);
+    ranges.add(14, 4);
+    EXPECT(Equals(ranges, {{8, 10}}));
+    // Over several ranges
+    ranges.add(30, 2);
+    ranges.add(40, 2);
+    ranges.add(16, 25);
+    EXPECT(Equals(ranges, {{8, 34}}));
+
+    // Contained
+    ranges.clear();
+    ranges.add(0, 10);
+    ranges.add(3, 2);
+    ranges.add(0, 10);
+    ranges.add(9, 1);
+    EXPECT(Equals(ranges, {{0, 10}}));
+    ranges.add(20, 1);
+    ranges.add(24, 1);
+    ranges.add(18, 10);
+    EXPECT(Equals(ranges, {{0, 10}, {18, 10}}));
+
+    // Atom rounded: byte ranges are widened to the atom, and then merged where they share one.
+    ranges.clear();
+    ranges.addAligned(70, 10, 64);
+    EXPECT(Equals(ranges, {{64, 64}}));
+    ranges.addAligned(130, 4, 64);  // in the next atom, so it touches
+    EXPECT(Equals(ranges, {{64, 128}}));
+    ranges.addAligned(300, 40, 64);  // across two atoms, and away from the rest
+    EXPECT(Equals(ranges, {{64, 128}, {256, 128}}));
+    ranges.addAligned(200, 1, 64);  // shares an atom with neither, but touches both
+    EXPECT(Equals(ranges, {{64, 320}}));
+    ranges.addAligned(512, 64, 64);  // already aligned
+    EXPECT(Equals(ranges, {{64, 320}, {512, 64}}));
+    ranges.addAligned(7, 1, 1);
+    EXPECT(Equals(ranges, {{7, 1}, {64, 320}, {512, 64}}));
+
+    // Taking from the first range that fits
+    vk::DeviceSize offset;
+    REQUIRE(ranges.take(64, offset));
+    EXPECT(offset == 64);
+    REQUIRE(ranges.take(256, offset));
+    EXPECT(offset == 128);
+    EXPECT(Equals(ranges, {{7, 1}, {512, 64}}));
+    EXPECT(!ranges.take(65, offset));
+}
+
+// Slots come from the end of the last page until it's full. Then a page has to be added, bigger if the item doesn't
+// fit in a page.
+TEST(BufferPages, Allocate) {
+    Pages pages;
+    vk::DeviceSize page, offset;
+    EXPECT(!pages.allocate(1, page, offset));
+
+    pages.add(10);
+    REQUIRE(pages.allocate(4, page, offset));
+    EXPECT(page == 0 && offset == 0);
+    REQUIRE(pages.allocate(6, page, offset));
+    EXPECT(page == 0 && offset == 4);
+    EXPECT(pages[0].currentOffset == 10);
+    EXPECT(!pages.allocate(1, page, offset));
+
+    pages.add(10);
+    REQUIRE(pages.allocate(3, page, offset));
+    EXPECT(page == 1 && offset == 0);
+    EXPECT(!pages.allocate(8, page, offset));
+    pages.add(20);
+    REQUIRE(pages.allocate(20, page, offset));
+    EXPECT(page == 2 && offset == 0);
+    EXPECT(pages.size() == 3);
+
+    pages.clear();
+    EXPECT(pages.size() == 0);
+    EXPECT(!pages.allocate(1, page, offset));
+}
+
+// Freed slots wait for the frames in flight, and are handed out again after "frameCount" frames.
+TEST(BufferPages, DeferredReuse) {
+    Pages pages;
+    pages.setFrameCount(3);
+    pages.add(8);
+    vk::DeviceSize page, offset;
+    REQUIRE(pages.allocate(8, page, offset));
+
+    pages.free(0, 2, 2);
+    EXPECT(pages.getPendingCount() == 2);
+    EXPECT(!pages.allocate(1, page, offset));
+    pages.nextFrame();
+    pages.free(0, 6, 1);  // a frame later
+    pages.nextFrame();
+    EXPECT(!pages.allocate(1, page, offset));
+    EXPECT(pages.getPendingCount() == 3);
+
+    pages.nextFrame();
+    EXPECT(pages.getPendingCount() == 1);
+    REQUIRE(pages.allocate(2, page, offset));
+    EXPECT(page == 0 && offset == 2);
+    EXPECT(!pages.allocate(1, page, offset));
+
+    pages.nextFrame();
+    EXPECT(pages.getPendingCount() == 0);
+    REQUIRE(pages.allocate(1, page, offset));
+    EXPECT(page == 0 && offset == 6);
+
+    // A frame count of zero (no swapchain yet) still waits a frame.
+    pages.setFrameCount(0);
+    pages.free(0, 0, 1);
+    EXPECT(!pages.allocate(1, page, offset));
+    pages.nextFrame();
+    EXPECT(pages.allocate(1, page, offset) && offset == 0);
+}
+
+// Freed ranges that touch are merged, and the first page with a big enough range is used before the end of the last
+// page.
+TEST(BufferPages, FirstFit) {
+    Pages pages;
+    pages.add(8);
+    vk::DeviceSize page, offset;
+    REQUIRE(pages.allocate(8, page, offset));
+    pages.add(8);
+    REQUIRE(pages.allocate(4, page, offset));
+    EXPECT(page == 1 && offset == 0);
+
+    pages.free(0, 1, 1);
+    pages.free(0, 3, 2);
+    pages.free(0, 2, 1);
+    pages.free(1, 0, 2);
+    pages.nextFrame();
+    const auto& freeRanges = pages[0].freeRanges.get();
+    REQUIRE(freeRanges.size() == 1);
+    EXPECT(freeRanges[0].first == 1 && freeRanges[0].second == 4);
+
+    REQUIRE(pages.allocate(3, page, offset));
+    EXPECT(page == 0 && offset == 1);
+    // Too big for what is left of page 0's range.
+    REQUIRE(pages.allocate(2, page, offset));
+    EXPECT(page == 1 && offset == 0);
+    // Too big for any freed range, so it goes at the end of the last page.
+    REQUIRE(pages.allocate(2, page, offset));
+    EXPECT(page == 1 && offset == 4);
+    REQUIRE(pages.allocate(1, page, offset));
+    EXPECT(page == 0 && offset == 4);
+    EXPECT(pages[0].freeRanges.empty() && pages[1].freeRanges.empty());
+    REQUIRE(pages.allocate(2, page, offset));
+    EXPECT(page == 1 && offset == 6);
+    EXPECT(!pages.allocate(1, page, offset));
+}
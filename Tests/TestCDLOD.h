@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#ifndef TEST_CDLOD_H
+#define TEST_CDLOD_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <CDLOD/CDLODQuadTree.h>
+#include <CDLOD/TiledHeightmap.h>
+
+// Heightmaps, quadtree descs and cameras shared by the CDLOD tests.
+namespace Test {
+namespace Cdlod {
+
+// In-memory heightmap that only answers GetAreaMinMaxZ per call (the procedural source path of CreateLeaves).
+struct AreaHeightmap : IHeightmapSource {
+    AreaHeightmap(int sizeX, int sizeY, unsigned int seed) : sizeX(sizeX), sizeY(sizeY), heights(sizeX * sizeY) {
+        for (int y = 0; y < sizeY; y++)
+            for (int x = 0; x < sizeX; x++) heights[y * sizeX + x] = TiledHeightmap::SyntheticHeight(x, y, seed);
+    }
+    int GetSizeX() const override { return sizeX; }
+    int GetSizeY() const override { return sizeY; }
+    unsigned short GetHeightAt(int x, int y) const override { return heights[y * sizeX + x]; }
+    void GetAreaMinMaxZ(int x, int y, int areaX, int areaY, unsigned short& minZ, unsigned short& maxZ) const override {
+        minZ = 65535;
+        maxZ = 0;
+        for (int j = y; j < (std::min)(y + areaY, sizeY); j++)
+            for (int i = x; i < (std::min)(x + areaX, sizeX); i++) {
+                minZ = (std::min)(minZ, heights[j * sizeX + i]);
+                maxZ = (std::max)(maxZ, heights[j * sizeX + i]);
+            }
+    }
+    int sizeX, sizeY;
+    std::vector<unsigned short> heights;
+};
+
+inline CDLODQuadTree::CreateDesc makeDesc(const IHeightmapSource& heightmap, bool implicitStorage, int threadCount) {
+    CDLODQuadTree::CreateDesc desc = {};
+    desc.pHeightmap = &heightmap;
+    desc.LeafRenderNodeSize = 8;
+    desc.LODLevelCount = 7;
+    desc.MapDims = {-4000.0f, -3000.0f, -100.0f, 8000.0f, 6000.0f, 400.0f};
+    desc.ImplicitStorage = implicitStorage;
+    desc.ThreadCount = threadCount;
+    return desc;
+}
+
+// Frustum planes (inside is dot(plane, (p, 1)) >= 0) of a camera at "eye" looking along "forward" (z is up), with
+// "halfAngle" radians on every side and a far plane at "farDistance".
+inline void makeFrustum(const glm::vec3& eye, const glm::vec3& forward, float halfAngle, float farDistance,
+                        glm::vec4 planes[6]) {
+    const glm::vec3 f = glm::normalize(forward);
+    const glm::vec3 r = glm::normalize(glm::cross(f, glm::vec3(0.0f, 0.0f, 1.0f)));
+    const glm::vec3 u = glm::cross(r, f);
+    const float c = std::cos(halfAngle), s = std::sin(halfAngle);
+    const glm::vec3 normals[4] = {r * c + f * s, r * -c + f * s, u * c + f * s, u * -c + f * s};
+    for (int i = 0; i < 4; i++) planes[i] = glm::vec4(normals[i], -glm::dot(normals[i], eye));
+    // Near (at the eye) and far
+    planes[4] = glm::vec4(f, -glm::dot(f, eye));
+    planes[5] = glm::vec4(f * -1.0f, glm::dot(f, eye) + farDistance);
+}
+
+// A scripted camera path over the map: "frameCount" frames, moving "step" meters and turning "turn" radians per frame
+// 200m above the map's minimum height, looking a little down.
+struct Camera {
+    glm::vec3 eye;
+    glm::vec3 forward;
+};
+
+inline std::vector<Camera> makeCameraPath(const MapDimensions& dims, int frameCount, float step, float turn) {
+    std::vector<Camera> path(frameCount);
+    glm::vec3 eye = {dims.MinX + dims.SizeX * 0.25f, dims.MinY + dims.SizeY * 0.5f, dims.MinZ + 200.0f};
+    float yaw = 0.0f;
+    for (auto& camera : path) {
+        camera.forward = {std::cos(yaw) * 0.95f, std::sin(yaw) * 0.95f, -0.3f};
+        camera.eye = eye;
+        eye = eye + glm::vec3(std::cos(yaw), std::sin(yaw), 0.0f) * step;
+        yaw += turn;
+    }
+    return path;
+}
+
+// Selection parameters used with the camera paths.
+constexpr float VISIBILITY_DISTANCE = 5000.0f, LOD_DISTANCE_RATIO = 2.0f, HALF_ANGLE = 0.8f;
+
+inline void makeFrustum(const Camera& camera, glm::vec4 planes[6]) {
+    makeFrustum(camera.eye, camera.forward, HALF_ANGLE, VISIBILITY_DISTANCE, planes);
+}
+
+inline bool isSameNode(const CDLODQuadTree::SelectedNode& a, const CDLODQuadTree::SelectedNode& b) {
+    return a.X == b.X && a.Y == b.Y && a.Size == b.Size && a.MinZ == b.MinZ && a.MaxZ == b.MaxZ && a.TL == b.TL &&
+           a.TR == b.TR && a.BL == b.BL && a.BR == b.BR && a.LODLevel == b.LODLevel &&
+           a.MinDistToCamera == b.MinDistToCamera;
+}
+
+// Same selected nodes in the same order, and the same outputs besides the timings.
+inline bool isSameSelection(const CDLODQuadTree::LODSelection& a, const CDLODQuadTree::LODSelection& b) {
+    if (a.GetSelectionCount() != b.GetSelectionCount() || a.IsVisDistTooSmall() != b.IsVisDistTooSmall() ||
+        a.GetMinSelectedLevel() != b.GetMinSelectedLevel() || a.GetMaxSelectedLevel() != b.GetMaxSelectedLevel())
+        return false;
+    for (int i = 0; i < a.GetSelectionCount(); i++)
+        if (!isSameNode(a.GetSelection()[i], b.GetSelection()[i])) return false;
+    for (int level = 0; level < a.GetQuadTree()->GetLODLevelCount(); level++)
+        if (a.GetMorphingCount(level) != b.GetMorphingCount(level)) return false;
+    return true;
+}
+
+}  // namespace Cdlod
+}  // namespace Test
+
+#endif  // !TEST_CDLOD_H
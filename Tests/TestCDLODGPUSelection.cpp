@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <CDLOD/CDLODGPUSelection.h>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+constexpr int MAX_SELECTION_COUNT = 8192;
+
+// A work buffer the way the compute passes leave it: the header, the two queues, then "nodes" as selected entries in
+// reverse order (the GPU order is whatever the atomics made it).
+std::vector<glm::uvec4> makeWorkBuffer(const CDLODQuadTree& quadTree, const CDLODQuadTree::SelectedNode* nodes,
+                                       int count, uint32_t selectedCount) {
+    std::vector<glm::uvec4> work(CDLODGPUSelection::GetWorkBufferSize(MAX_SELECTION_COUNT) / sizeof(glm::uvec4));
+    auto* header = reinterpret_cast<CDLODGPUSelection::WorkHeader*>(work.data());
+    header->SelectedCount = selectedCount;
+
+    glm::uvec4* selected = reinterpret_cast<glm::uvec4*>(header + 1) +
+                           2 * CDLODGPUSelection::GetMaxQueueCount(MAX_SELECTION_COUNT);
+    for (int i = 0; i < count; i++) {
+        const auto& node = nodes[count - 1 - i];
+        const unsigned int level = quadTree.GetLODLevelCount() - 1 - node.LODLevel;
+        selected[i] = {node.X / node.Size, node.Y / node.Size, level,
+                       (node.TL ? 1u : 0u) | (node.TR ? 2u : 0u) | (node.BL ? 4u : 0u) | (node.BR ? 8u : 0u)};
+    }
+    return work;
+}
+
+}  // namespace
+
+// The traversal of the compute passes selects the same nodes with the same quadrants as LODSelect along a camera path.
+TEST(CDLODGPUSelection, MatchesLODSelect) {
+    const AreaHeightmap heightmap(1025, 769, 25);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+    REQUIRE(CDLODGPUSelection::IsSupported(quadTree));
+
+    std::vector<CDLODQuadTree::SelectedNode> nodes(MAX_SELECTION_COUNT), gpuNodes(MAX_SELECTION_COUNT);
+    int selectedCount = 0;
+    for (const auto& camera : makeCameraPath(quadTree.GetWorldMapDims(), 60, 100.0f, 0.05f)) {
+        glm::vec4 planes[6];
+        makeFrustum(camera, planes);
+        CDLODQuadTree::LODSelection selection(nodes.data(), MAX_SELECTION_COUNT, camera.eye, VISIBILITY_DISTANCE, planes,
+                                              LOD_DISTANCE_RATIO);
+        CDLODQuadTree::LODSelection gpuSelection(gpuNodes.data(), MAX_SELECTION_COUNT, camera.eye, VISIBILITY_DISTANCE,
+                                                 planes, LOD_DISTANCE_RATIO);
+        quadTree.LODSelect(&selection);
+        CDLODGPUSelection::Select(quadTree, &gpuSelection);
+
+        EXPECT(CDLODGPUSelection::IsSameSelection(selection.GetSelection(), selection.GetSelectionCount(),
+                                                  gpuSelection.GetSelection(), gpuSelection.GetSelectionCount()));
+        if (selection.GetSelectionCount() > 0) {
+            EXPECT(gpuSelection.GetMinSelectedLevel() == selection.GetMinSelectedLevel());
+            EXPECT(gpuSelection.GetMaxSelectedLevel() == selection.GetMaxSelectedLevel());
+        }
+        selectedCount += selection.GetSelectionCount();
+    }
+    EXPECT(selectedCount > 0);
+
+    // The pointer storage has no per level min/max heights to upload.
+    CDLODQuadTree pointerQuadTree;
+    REQUIRE(pointerQuadTree.Create(makeDesc(heightmap, false, 0)));
+    EXPECT(!CDLODGPUSelection::IsSupported(pointerQuadTree));
+}
+
+// Selected entries read back from a work buffer are the selection they were written from, and a different quadrant is a
+// different selection.
+TEST(CDLODGPUSelection, ReadSelection) {
+    const AreaHeightmap heightmap(513, 513, 27);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+    const auto camera = makeCameraPath(quadTree.GetWorldMapDims(), 1, 0.0f, 0.0f)[0];
+    glm::vec4 planes[6];
+    makeFrustum(camera, planes);
+
+    std::vector<CDLODQuadTree::SelectedNode> nodes(MAX_SELECTION_COUNT), readNodes(MAX_SELECTION_COUNT);
+    CDLODQuadTree::LODSelection selection(nodes.data(), MAX_SELECTION_COUNT, camera.eye, VISIBILITY_DISTANCE, planes,
+                                          LOD_DISTANCE_RATIO);
+    CDLODGPUSelection::Select(quadTree, &selection);
+    const int count = selection.GetSelectionCount();
+    REQUIRE(count > 1);
+
+    auto work = makeWorkBuffer(quadTree, nodes.data(), count, count);
+    EXPECT(CDLODGPUSelection::ReadSelection(quadTree, work.data(), MAX_SELECTION_COUNT, readNodes.data()) == count);
+    EXPECT(CDLODGPUSelection::IsSameSelection(nodes.data(), count, readNodes.data(), count));
+    for (int i = 0; i < count; i++) EXPECT(readNodes[i].MinZ <= readNodes[i].MaxZ);
+
+    nodes[count / 2].TL = !nodes[count / 2].TL;
+    EXPECT(!CDLODGPUSelection::IsSameSelection(nodes.data(), count, readNodes.data(), count));
+    EXPECT(!CDLODGPUSelection::IsSameSelection(nodes.data(), count - 1, readNodes.data(), count));
+
+    // The counter goes past the buffer when nodes were dropped.
+    work = makeWorkBuffer(quadTree, nodes.data(), count, MAX_SELECTION_COUNT + 100);
+    EXPECT(CDLODGPUSelection::ReadSelection(quadTree, work.data(), MAX_SELECTION_COUNT, readNodes.data()) ==
+           MAX_SELECTION_COUNT);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+constexpr int MAX_SELECTION_COUNT = 8192;
+
+struct Counts {
+    long long full = 0;
+    long long incremental = 0;
+    int frames = 0;
+};
+
+// Selects every frame of "path" with LODSelect and with LODSelectIncremental (one cache for the whole path), and checks
+// that they are the same. "visibilityDistance" is called per frame.
+template <typename TFunc>
+Counts selectPath(const CDLODQuadTree& quadTree, CDLODQuadTree::LODSelectionCache& cache,
+                  const std::vector<Camera>& path, TFunc&& visibilityDistance) {
+    std::vector<CDLODQuadTree::SelectedNode> nodes(MAX_SELECTION_COUNT), incrementalNodes(MAX_SELECTION_COUNT);
+    Counts counts;
+    for (size_t frame = 0; frame < path.size(); frame++) {
+        const float distance = visibilityDistance(frame);
+        glm::vec4 planes[6];
+        makeFrustum(path[frame].eye, path[frame].forward, HALF_ANGLE, distance, planes);
+        CDLODQuadTree::LODSelection selection(nodes.data(), MAX_SELECTION_COUNT, path[frame].eye, distance, planes,
+                                              LOD_DISTANCE_RATIO);
+        CDLODQuadTree::LODSelection incremental(incrementalNodes.data(), MAX_SELECTION_COUNT, path[frame].eye, distance,
+                                                planes, LOD_DISTANCE_RATIO);
+        quadTree.LODSelect(&selection);
+        quadTree.LODSelectIncremental(&incremental, &cache);
+        EXPECT(isSameSelection(selection, incremental));
+
+        // The first frame is a full selection either way.
+        if (frame == 0) continue;
+        counts.full += selection.GetTestedNodeCount();
+        counts.incremental += incremental.GetTestedNodeCount();
+        counts.frames++;
+    }
+    return counts;
+}
+
+float constantDistance(size_t) { return VISIBILITY_DISTANCE; }
+
+}  // namespace
+
+// Walking, turning in place, and both, with the share of node tests the incremental selection still makes.
+TEST(CDLODIncrementalSelection, MatchesLODSelect) {
+    const AreaHeightmap heightmap(1025, 769, 29);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+    const auto& dims = quadTree.GetWorldMapDims();
+
+    struct Path {
+        const char* name;
+        float step, turn;
+    };
+    for (const auto& path : {Path{"slow walk", 2.0f, 0.0f}, Path{"walk", 25.0f, 0.0f}, Path{"turn", 0.0f, 0.005f},
+                             Path{"walk and turn", 2.0f, 0.005f}}) {
+        CDLODQuadTree::LODSelectionCache cache;
+        const auto counts = selectPath(quadTree, cache, makeCameraPath(dims, 300, path.step, path.turn), constantDistance);
+        REQUIRE(counts.full > 0);
+        const double share = static_cast<double>(counts.incremental) / counts.full;
+        printf("  %s: %.1f%% of the node tests over %d frames\n", path.name, 100.0 * share, counts.frames);
+        EXPECT(counts.incremental <= counts.full);
+        EXPECT(cache.GetReusedSelectionCount() > 0);
+    }
+}
+
+// Moves past MaxMoveDistance, and visibility distance changes start from scratch, and still select the same nodes.
+TEST(CDLODIncrementalSelection, StartsOver) {
+    const AreaHeightmap heightmap(513, 513, 31);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+    const auto& dims = quadTree.GetWorldMapDims();
+
+    CDLODQuadTree::LODSelectionCache cache;
+    // Teleports
+    selectPath(quadTree, cache, makeCameraPath(dims, 40, 400.0f, 0.3f), constantDistance);
+    EXPECT(cache.WasFullSelection());
+    // Range changes every few frames
+    selectPath(quadTree, cache, makeCameraPath(dims, 60, 2.0f, 0.0f),
+               [](size_t frame) { return VISIBILITY_DISTANCE + 500.0f * static_cast<float>(frame / 10); });
+
+    // A new quadtree needs a reset cache.
+    CDLODQuadTree other;
+    REQUIRE(other.Create(makeDesc(AreaHeightmap(513, 513, 37), true, 0)));
+    cache.Reset();
+    selectPath(other, cache, makeCameraPath(dims, 20, 2.0f, 0.0f), constantDistance);
+
+    // The pointer storage falls back to LODSelect.
+    CDLODQuadTree pointers;
+    REQUIRE(pointers.Create(makeDesc(heightmap, false, 0)));
+    cache.Reset();
+    selectPath(pointers, cache, makeCameraPath(dims, 10, 2.0f, 0.0f), constantDistance);
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+// Procedural heightmap with rows (GetRow), for benchmarking sizes that don't fit in memory comfortably.
+struct RowHeightmap : IHeightmapSource {
+    RowHeightmap(int size) : size(size) {}
+    static unsigned short height(int x, int y) {
+        uint32_t h = static_cast<uint32_t>(x) * 0x8DA6B343u ^ static_cast<uint32_t>(y) * 0xD8163841u;
+        h ^= h >> 13;
+        return static_cast<unsigned short>(h * 0x85EBCA6Bu >> 16);
+    }
+    int GetSizeX() const override { return size; }
+    int GetSizeY() const override { return size; }
+    unsigned short GetHeightAt(int x, int y) const override { return height(x, y); }
+    void GetAreaMinMaxZ(int x, int y, int areaX, int areaY, unsigned short& minZ, unsigned short& maxZ) const override {
+        minZ = 65535;
+        maxZ = 0;
+        for (int j = y; j < (std::min)(y + areaY, size); j++)
+            for (int i = x; i < (std::min)(x + areaX, size); i++) {
+                minZ = (std::min)(minZ, height(i, j));
+                maxZ = (std::max)(maxZ, height(i, j));
+            }
+    }
+    bool GetRow(int x, int y, int count, unsigned short* pDst) const override {
+        for (int i = 0; i < count; i++) pDst[i] = height(x + i, y);
+        return true;
+    }
+    int size;
+};
+
+// Compares two trees through selections from a few observers and area min/max queries over the whole map.
+bool isSameTree(const CDLODQuadTree& a, const CDLODQuadTree& b) {
+    const auto& dims = a.GetWorldMapDims();
+    std::vector<CDLODQuadTree::SelectedNode> nodesA(8192), nodesB(8192);
+    glm::vec4 planes[6];
+    for (auto& plane : planes) plane = {0.0f, 0.0f, 1.0f, 1e6f};
+    for (int i = 0; i < 8; i++) {
+        const glm::vec3 eye = {dims.MinX + dims.SizeX * (i / 7.0f), dims.MinY + dims.SizeY * ((i * 3 % 8) / 7.0f), 150.0f};
+        CDLODQuadTree::LODSelection selectionA(nodesA.data(), 8192, eye, 6000.0f, planes, 2.0f);
+        CDLODQuadTree::LODSelection selectionB(nodesB.data(), 8192, eye, 6000.0f, planes, 2.0f);
+        a.LODSelect(&selectionA);
+        b.LODSelect(&selectionB);
+        if (selectionA.GetSelectionCount() != selectionB.GetSelectionCount()) return false;
+        for (int n = 0; n < selectionA.GetSelectionCount(); n++)
+            if (!isSameNode(nodesA[n], nodesB[n])) return false;
+    }
+    for (float size = dims.SizeX / 2.0f; size > dims.SizeX / 512.0f; size /= 4.0f) {
+        for (float y = dims.MinY; y < dims.MaxY(); y += size * 0.75f) {
+            for (float x = dims.MinX; x < dims.MaxX(); x += size * 0.75f) {
+                float minA, maxA, minB, maxB;
+                a.GetAreaMinMaxHeight(x, y, size, size, minA, maxA);
+                b.GetAreaMinMaxHeight(x, y, size, size, minB, maxB);
+                if (minA != minB || maxA != maxB) return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::string getTempPath(const char* name) { return (std::filesystem::temp_directory_path() / name).string(); }
+
+}  // namespace
+
+TEST(CDLODQuadTreeCreate, HeightmapMinMaxRow) {
+    std::vector<unsigned short> row(37);
+    for (size_t i = 0; i < row.size(); i++) row[i] = static_cast<unsigned short>(30000 + (i * 7919) % 5000);
+    row[5] = 0;       // in a SIMD block
+    row[35] = 65535;  // in the scalar tail
+    for (int count = 1; count <= static_cast<int>(row.size()); count++) {
+        unsigned short minZ = 65535, maxZ = 0, expectedMin = 65535, expectedMax = 0;
+        HeightmapMinMaxRow(row.data(), count, minZ, maxZ);
+        for (int i = 0; i < count; i++) {
+            expectedMin = (std::min)(expectedMin, row[i]);
+            expectedMax = (std::max)(expectedMax, row[i]);
+        }
+        EXPECT(minZ == expectedMin && maxZ == expectedMax);
+    }
+}
+
+// The tree has to come out the same on one thread and on many, with the rows read from a paging source (GetRow) or
+// with a GetAreaMinMaxZ call per leaf.
+TEST(CDLODQuadTreeCreate, SerialMatchesParallel) {
+    constexpr int SIZE_X = 1025, SIZE_Y = 769;
+    const auto path = getTempPath("GuppyTests_Create.thm");
+    REQUIRE(TiledHeightmap::Write(path.c_str(), SIZE_X, SIZE_Y, 128, [](int x, int y) {
+        return TiledHeightmap::SyntheticHeight(x, y, 3);
+    }));
+    const AreaHeightmap areaHeightmap(SIZE_X, SIZE_Y, 3);
+
+    {
+        // Fewer resident tiles than threads, so the readers have to wait on each other's pins.
+        TiledHeightmapSource tiledHeightmap;
+        REQUIRE(tiledHeightmap.Create({path.c_str(), 3}));
+
+        for (const bool implicitStorage : {true, false}) {
+            CDLODQuadTree serial, parallel, perLeaf;
+            REQUIRE(serial.Create(makeDesc(areaHeightmap, implicitStorage, 1)));
+            REQUIRE(parallel.Create(makeDesc(tiledHeightmap, implicitStorage, 8)));
+            REQUIRE(perLeaf.Create(makeDesc(areaHeightmap, implicitStorage, 8)));
+            EXPECT(isSameTree(serial, parallel));
+            EXPECT(isSameTree(serial, perLeaf));
+        }
+        EXPECT(tiledHeightmap.GetStats().ResidentTiles <= 3);
+    }
+    std::filesystem::remove(path);
+}
+
+BENCH(CDLODQuadTreeCreate, Create) {
+    for (const int size : {4097, 16385}) {
+        const RowHeightmap heightmap(size);
+        for (const int threadCount : {1, 0}) {
+            const auto ms = Test::time(1, [&]() {
+                CDLODQuadTree quadTree;
+                auto desc = makeDesc(heightmap, true, threadCount);
+                desc.LODLevelCount = 8;
+                quadTree.Create(desc);
+            });
+            printf("  %dx%d %s: %.1f ms\n", size, size, threadCount == 1 ? "1 thread" : "all threads", ms);
+        }
+    }
+}
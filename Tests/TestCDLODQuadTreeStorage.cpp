@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+constexpr int SIZE_X = 1025, SIZE_Y = 769;
+constexpr unsigned int SEED = 5;
+constexpr float PI = 3.14159265f;
+
+float random(std::mt19937& generator, float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(generator);
+}
+
+// The same heightmap in both storage modes.
+struct Trees {
+    Trees(bool exactRayIntersection) : heightmap(SIZE_X, SIZE_Y, SEED) {
+        auto desc = makeDesc(heightmap, true, 0);
+        desc.ExactRayIntersection = exactRayIntersection;
+        created = implicit.Create(desc);
+        desc.ImplicitStorage = false;
+        created &= pointers.Create(desc);
+    }
+    AreaHeightmap heightmap;
+    CDLODQuadTree implicit, pointers;
+    bool created;
+};
+
+}  // namespace
+
+// Random cameras over (and past the edges of) the map, with random selection parameters.
+TEST(CDLODQuadTreeStorage, SameSelection) {
+    const Trees trees(false);
+    REQUIRE(trees.created);
+    const auto& dims = trees.implicit.GetWorldMapDims();
+
+    std::mt19937 generator(17);
+    std::vector<CDLODQuadTree::SelectedNode> nodesImplicit(8192), nodesPointers(8192);
+    int selectedCount = 0;
+    for (int i = 0; i < 300; i++) {
+        const glm::vec3 eye = {random(generator, dims.MinX - 1000.0f, dims.MaxX() + 1000.0f),
+                               random(generator, dims.MinY - 1000.0f, dims.MaxY() + 1000.0f),
+                               random(generator, dims.MinZ, dims.MaxZ() + 800.0f)};
+        const float yaw = random(generator, -PI, PI), pitch = random(generator, -1.2f, 0.3f);
+        const glm::vec3 forward = {std::cos(yaw) * std::cos(pitch), std::sin(yaw) * std::cos(pitch), std::sin(pitch)};
+        const float visibilityDistance = random(generator, 1000.0f, 12000.0f);
+        glm::vec4 planes[6];
+        makeFrustum(eye, forward, random(generator, 0.3f, 1.1f), visibilityDistance, planes);
+
+        const int maxSelectionCount = static_cast<int>(nodesImplicit.size());
+        const float LODDistanceRatio = random(generator, 1.5f, 3.0f), morphStartRatio = random(generator, 0.5f, 0.8f);
+        const bool sortByDistance = i % 2 == 0;
+        CDLODQuadTree::LODSelection selectionImplicit(nodesImplicit.data(), maxSelectionCount, eye, visibilityDistance,
+                                                      planes, LODDistanceRatio, morphStartRatio, sortByDistance);
+        CDLODQuadTree::LODSelection selectionPointers(nodesPointers.data(), maxSelectionCount, eye, visibilityDistance,
+                                                      planes, LODDistanceRatio, morphStartRatio, sortByDistance);
+        trees.implicit.LODSelect(&selectionImplicit);
+        trees.pointers.LODSelect(&selectionPointers);
+        EXPECT(isSameSelection(selectionImplicit, selectionPointers));
+        selectedCount += selectionImplicit.GetSelectionCount();
+    }
+    // Not only empty selections
+    EXPECT(selectedCount > 1000);
+}
+
+TEST(CDLODQuadTreeStorage, SameAreaMinMaxHeight) {
+    const Trees trees(false);
+    REQUIRE(trees.created);
+    const auto& dims = trees.implicit.GetWorldMapDims();
+
+    std::mt19937 generator(19);
+    for (int i = 0; i < 2000; i++) {
+        const float x = random(generator, dims.MinX - 500.0f, dims.MaxX());
+        const float y = random(generator, dims.MinY - 500.0f, dims.MaxY());
+        const float sizeX = random(generator, 1.0f, dims.SizeX), sizeY = random(generator, 1.0f, dims.SizeY);
+        float minImplicit, maxImplicit, minPointers, maxPointers;
+        trees.implicit.GetAreaMinMaxHeight(x, y, sizeX, sizeY, minImplicit, maxImplicit);
+        trees.pointers.GetAreaMinMaxHeight(x, y, sizeX, sizeY, minPointers, maxPointers);
+        EXPECT(minImplicit == minPointers && maxImplicit == maxPointers);
+    }
+}
+
+// Rays from above the map down at it, and some grazing ones, with both leaf intersection modes.
+TEST(CDLODQuadTreeStorage, SameRayHits) {
+    for (const bool exactRayIntersection : {false, true}) {
+        const Trees trees(exactRayIntersection);
+        REQUIRE(trees.created);
+        const auto& dims = trees.implicit.GetWorldMapDims();
+
+        std::mt19937 generator(23);
+        int hitCount = 0;
+        for (int i = 0; i < 2000; i++) {
+            const glm::vec3 origin = {random(generator, dims.MinX, dims.MaxX()), random(generator, dims.MinY, dims.MaxY()),
+                                      random(generator, dims.MinZ, dims.MaxZ() + 500.0f)};
+            const float yaw = random(generator, -PI, PI), pitch = random(generator, -PI / 2.0f, 0.1f);
+            const glm::vec3 direction = {std::cos(yaw) * std::cos(pitch), std::sin(yaw) * std::cos(pitch),
+                                         std::sin(pitch)};
+            glm::vec3 hitImplicit, hitPointers;
+            const bool isHitImplicit = trees.implicit.IntersectRay(origin, direction, 10000.0f, hitImplicit);
+            const bool isHitPointers = trees.pointers.IntersectRay(origin, direction, 10000.0f, hitPointers);
+            EXPECT(isHitImplicit == isHitPointers);
+            if (isHitImplicit && isHitPointers) {
+                hitCount++;
+                EXPECT(glm::length(hitImplicit - hitPointers) < 0.01f);
+            }
+        }
+        // Most of the rays point down at the map.
+        EXPECT(hitCount > 1000);
+    }
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+constexpr float PI = 3.14159265f;
+constexpr float MAX_DISTANCE = 20000.0f;
+
+// Ray/triangle in double precision. Triangles are widened by "tolerance" (barycentric), or shrunk when it's negative.
+bool intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& v0, const glm::vec3& v1,
+                       const glm::vec3& v2, double tolerance, double& distance) {
+    const double e1[3] = {v1.x - v0.x, v1.y - v0.y, v1.z - v0.z};
+    const double e2[3] = {v2.x - v0.x, v2.y - v0.y, v2.z - v0.z};
+    const double d[3] = {direction.x, direction.y, direction.z};
+    const double p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+    const double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (std::abs(det) < 1e-12) return false;
+    const double t[3] = {origin.x - v0.x, origin.y - v0.y, origin.z - v0.z};
+    const double u = (t[0] * p[0] + t[1] * p[1] + t[2] * p[2]) / det;
+    if (u < -tolerance || u > 1.0 + tolerance) return false;
+    const double q[3] = {t[1] * e1[2] - t[2] * e1[1], t[2] * e1[0] - t[0] * e1[2], t[0] * e1[1] - t[1] * e1[0]};
+    const double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / det;
+    if (v < -tolerance || u + v > 1.0 + tolerance) return false;
+    distance = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+    return distance >= 0.0;
+}
+
+/* Closest hit of every triangle of the raster, two per "step" x "step" texel cell split like CDLODQuadTree's quads:
+ * (tl, tr, bl) and (tr, bl, br). A step of 1 is the exact raster (CreateDesc::ExactRayIntersection), and the leaf size
+ * is the two-triangle per leaf approximation. Like the leaf nodes, those cells start at every multiple of "step" inside
+ * the raster, and the heights past its edges are the edge's.
+ */
+bool bruteForce(const IHeightmapSource& heightmap, const MapDimensions& dims, int step, const glm::vec3& origin,
+                const glm::vec3& direction, double tolerance, double& closest) {
+    const int sizeX = heightmap.GetSizeX(), sizeY = heightmap.GetSizeY();
+    const auto vertex = [&](int x, int y) {
+        const auto height = heightmap.GetHeightAt((std::min)(x, sizeX - 1), (std::min)(y, sizeY - 1));
+        return glm::vec3(dims.MinX + x * dims.SizeX / (float)(sizeX - 1), dims.MinY + y * dims.SizeY / (float)(sizeY - 1),
+                         dims.MinZ + height * dims.SizeZ / 65535.0f);
+    };
+    const int endX = (step == 1) ? sizeX - 1 : sizeX, endY = (step == 1) ? sizeY - 1 : sizeY;
+    closest = std::numeric_limits<double>::max();
+    for (int y = 0; y < endY; y += step) {
+        for (int x = 0; x < endX; x += step) {
+            const auto tl = vertex(x, y), tr = vertex(x + step, y), bl = vertex(x, y + step);
+            const auto br = vertex(x + step, y + step);
+            double distance;
+            if (intersectTriangle(origin, direction, tl, tr, bl, tolerance, distance))
+                closest = (std::min)(closest, distance);
+            if (intersectTriangle(origin, direction, tr, bl, br, tolerance, distance))
+                closest = (std::min)(closest, distance);
+        }
+    }
+    return closest <= MAX_DISTANCE;
+}
+
+struct Rays {
+    std::vector<glm::vec3> origins, directions;
+};
+
+// Rays from above and inside the terrain's height range, mostly pointing down, some grazing and some straight down.
+Rays makeRays(const MapDimensions& dims, int count, unsigned int seed) {
+    std::mt19937 generator(seed);
+    const auto random = [&](float min, float max) { return std::uniform_real_distribution<float>(min, max)(generator); };
+    Rays rays;
+    for (int i = 0; i < count; i++) {
+        rays.origins.push_back({random(dims.MinX - 200.0f, dims.MaxX() + 200.0f),
+                                random(dims.MinY - 200.0f, dims.MaxY() + 200.0f), random(dims.MinZ, dims.MaxZ() + 300.0f)});
+        const float yaw = random(-PI, PI), pitch = (i % 50 == 0) ? -PI / 2.0f : random(-PI / 2.0f, 0.2f);
+        rays.directions.push_back({std::cos(yaw) * std::cos(pitch), std::sin(yaw) * std::cos(pitch), std::sin(pitch)});
+    }
+    return rays;
+}
+
+}  // namespace
+
+// Random rays in both storage modes and both leaf modes, against testing every triangle. Rays that graze a triangle edge
+// (they hit or miss depending on the tolerance) are skipped.
+TEST(CDLODRayIntersection, MatchesBruteForce) {
+    const AreaHeightmap heightmap(129, 97, 31);
+    for (const bool exactRayIntersection : {true, false}) {
+        for (const bool implicitStorage : {true, false}) {
+            auto desc = makeDesc(heightmap, implicitStorage, 0);
+            desc.MapDims = {-1000.0f, -800.0f, -50.0f, 2000.0f, 1500.0f, 300.0f};
+            desc.ExactRayIntersection = exactRayIntersection;
+            CDLODQuadTree quadTree;
+            REQUIRE(quadTree.Create(desc));
+            const int step = exactRayIntersection ? 1 : desc.LeafRenderNodeSize;
+
+            const auto rays = makeRays(desc.MapDims, 1000, 37);
+            int hitCount = 0, checkedCount = 0;
+            for (size_t i = 0; i < rays.origins.size(); i++) {
+                const auto &origin = rays.origins[i], &direction = rays.directions[i];
+                double wide, narrow;
+                const bool isWideHit = bruteForce(heightmap, desc.MapDims, step, origin, direction, 1e-4, wide);
+                const bool isNarrowHit = bruteForce(heightmap, desc.MapDims, step, origin, direction, -1e-4, narrow);
+                if (isWideHit != isNarrowHit || (isWideHit && std::abs(wide - narrow) > 0.01)) continue;
+                checkedCount++;
+
+                glm::vec3 hitPoint;
+                const bool isHit = quadTree.IntersectRay(origin, direction, MAX_DISTANCE, hitPoint);
+                EXPECT(isHit == isNarrowHit);
+                if (isHit && isNarrowHit) {
+                    hitCount++;
+                    EXPECT(std::abs(glm::length(hitPoint - origin) - narrow) < 0.01);
+                }
+            }
+            EXPECT(checkedCount > 950);
+            EXPECT(hitCount > 250);
+        }
+    }
+}
+
+// The batch API gives every ray the same answer as IntersectRay.
+TEST(CDLODRayIntersection, BatchMatchesSingle) {
+    const AreaHeightmap heightmap(513, 385, 33);
+    auto desc = makeDesc(heightmap, true, 0);
+    desc.ExactRayIntersection = true;
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(desc));
+
+    const auto rays = makeRays(desc.MapDims, 5000, 41);
+    std::vector<glm::vec3> hitPoints(rays.origins.size());
+    std::unique_ptr<bool[]> isHits(new bool[rays.origins.size()]);
+    const int hitCount = quadTree.IntersectRays(static_cast<int>(rays.origins.size()), rays.origins.data(),
+                                                rays.directions.data(), MAX_DISTANCE, hitPoints.data(),
+                                                isHits.get());
+    int expectedHitCount = 0;
+    for (size_t i = 0; i < rays.origins.size(); i++) {
+        glm::vec3 hitPoint;
+        const bool isHit = quadTree.IntersectRay(rays.origins[i], rays.directions[i], MAX_DISTANCE, hitPoint);
+        EXPECT(isHit == isHits[i]);
+        if (isHit) {
+            expectedHitCount++;
+            EXPECT(hitPoint == hitPoints[i]);
+        }
+    }
+    EXPECT(hitCount == expectedHitCount);
+    EXPECT(hitCount > 0);
+}
+
+BENCH(CDLODRayIntersection, Rays) {
+    const AreaHeightmap heightmap(4097, 4097, 43);
+    const auto rays = makeRays(makeDesc(heightmap, true, 0).MapDims, 100000, 47);
+    std::vector<glm::vec3> hitPoints(rays.origins.size());
+    std::unique_ptr<bool[]> isHits(new bool[rays.origins.size()]);
+    for (const bool exactRayIntersection : {false, true}) {
+        auto desc = makeDesc(heightmap, true, 0);
+        desc.LODLevelCount = 8;
+        desc.ExactRayIntersection = exactRayIntersection;
+        CDLODQuadTree quadTree;
+        quadTree.Create(desc);
+
+        const auto singleMs = Test::time(1, [&]() {
+            for (size_t i = 0; i < rays.origins.size(); i++)
+                quadTree.IntersectRay(rays.origins[i], rays.directions[i], MAX_DISTANCE, hitPoints[i]);
+        });
+        const auto batchMs = Test::time(1, [&]() {
+            quadTree.IntersectRays(static_cast<int>(rays.origins.size()), rays.origins.data(), rays.directions.data(),
+                                   MAX_DISTANCE, hitPoints.data(), isHits.get());
+        });
+        printf("  %zu rays, %s leaves: IntersectRay %.1f ms, IntersectRays %.1f ms\n", rays.origins.size(),
+               exactRayIntersection ? "exact" : "two-triangle", singleMs, batchMs);
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <CDLOD/CDLODRenderStatsHistory.h>
+#include <CDLOD/CDLODRenderer.h>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+// A 16x16 grid mesh (VkGridMesh): 8x8 quads per quadrant, two triangles each.
+constexpr int INDICES_PER_QUADRANT = 8 * 8 * 6;
+
+CDLODRenderStats makeStats(int frame) {
+    CDLODRenderStats stats;
+    stats.Reset();
+    stats.RenderedQuads[0] = frame;
+    stats.RenderedQuads[2] = 2 * frame;
+    stats.TotalRenderedQuads = 3 * frame;
+    stats.TotalRenderedTriangles = 100 * frame;
+    stats.DrawCalls = frame % 7;
+    stats.MorphingQuads = frame / 2;
+    stats.SelectionTime = 0.25f * frame;
+    return stats;
+}
+
+}  // namespace
+
+// The counters of real selections along a camera path, against counting the selected nodes' quadrants directly.
+TEST(CDLODRenderStats, CountsSelection) {
+    const AreaHeightmap heightmap(1025, 769, 21);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+
+    std::vector<CDLODQuadTree::SelectedNode> nodes(8192);
+    std::vector<CDLODInstanceBatches::PerInstanceData> instances(CDLODInstanceBatches::GetMaxInstanceCount(8192));
+    CDLODInstanceBatches batches;
+    int totalQuads = 0;
+    for (const auto& camera : makeCameraPath(quadTree.GetWorldMapDims(), 20, 150.0f, 0.1f)) {
+        glm::vec4 planes[6];
+        makeFrustum(camera, planes);
+        CDLODQuadTree::LODSelection selection(nodes.data(), 8192, camera.eye, VISIBILITY_DISTANCE, planes,
+                                              LOD_DISTANCE_RATIO);
+        quadTree.LODSelect(&selection);
+        CDLODRenderer::MakeInstanceBatches(selection, instances.data(), batches);
+
+        for (const int filterLODLevel : {-1, 0, 3}) {
+            int quads[CDLODQuadTree::c_maxLODLevels] = {}, quadrants = 0, morphing = 0;
+            for (int i = 0; i < selection.GetSelectionCount(); i++) {
+                const auto& node = selection.GetSelection()[i];
+                if (filterLODLevel != -1 && node.LODLevel != filterLODLevel) continue;
+                quads[node.LODLevel]++;
+                quadrants += node.TL + node.TR + node.BL + node.BR;
+            }
+            int drawCalls = 0;
+            for (int level = 0; level < quadTree.GetLODLevelCount(); level++) {
+                if (filterLODLevel != -1 && level != filterLODLevel) continue;
+                morphing += selection.GetMorphingCount(level);
+                for (const auto& batch : batches.Batches[level]) drawCalls += batch.InstanceCount > 0;
+            }
+
+            CDLODRenderStats stats;
+            CDLODRenderer::GetRenderStats(selection, batches, INDICES_PER_QUADRANT, filterLODLevel, false, stats);
+            int totalFilteredQuads = 0;
+            for (int level = 0; level < CDLODQuadTree::c_maxLODLevels; level++) {
+                EXPECT(stats.RenderedQuads[level] == quads[level]);
+                totalFilteredQuads += quads[level];
+            }
+            EXPECT(stats.TotalRenderedQuads == totalFilteredQuads);
+            EXPECT(stats.TotalRenderedTriangles == quadrants * INDICES_PER_QUADRANT / 3);
+            EXPECT(stats.DrawCalls == drawCalls);
+            EXPECT(stats.MorphingQuads == morphing);
+            EXPECT(stats.SelectionTime == 0.0f);
+            if (filterLODLevel == -1) totalQuads += stats.TotalRenderedQuads;
+
+            // One draw per instance: a node's quadrants split into at most two runs.
+            CDLODRenderStats perInstanceStats;
+            CDLODRenderer::GetRenderStats(selection, batches, INDICES_PER_QUADRANT, filterLODLevel, true,
+                                          perInstanceStats);
+            EXPECT(perInstanceStats.TotalRenderedTriangles == stats.TotalRenderedTriangles);
+            EXPECT(perInstanceStats.DrawCalls >= stats.TotalRenderedQuads);
+            EXPECT(perInstanceStats.DrawCalls <= 2 * stats.TotalRenderedQuads);
+        }
+    }
+    EXPECT(totalQuads > 0);
+}
+
+// The summary only covers the last window of frames.
+TEST(CDLODRenderStats, HistoryWindow) {
+    constexpr int WINDOW = 8;
+    CDLODRenderStatsHistory history(WINDOW);
+    CDLODRenderStatsHistory::Summary summary;
+    history.GetSummary(summary);
+    EXPECT(summary.FrameCount == 0 && summary.AvgTotalRenderedQuads == 0.0f);
+
+    for (int frame = 1; frame <= 3; frame++) history.Push(makeStats(frame));
+    history.GetSummary(summary);
+    EXPECT(summary.FrameCount == 3);
+    EXPECT(summary.AvgTotalRenderedQuads == 6.0f);  // (3 + 6 + 9) / 3
+    EXPECT(summary.MaxTotalRenderedTriangles == 300);
+
+    // Frames 13 to 20 are left.
+    for (int frame = 4; frame <= 20; frame++) history.Push(makeStats(frame));
+    EXPECT(history.GetFrameCount() == WINDOW);
+    EXPECT(history.GetLatest().TotalRenderedQuads == 60);
+    history.GetSummary(summary);
+    EXPECT(summary.FrameCount == WINDOW);
+    EXPECT(summary.AvgRenderedQuads[0] == 16.5f);
+    EXPECT(summary.AvgRenderedQuads[2] == 33.0f);
+    EXPECT(summary.AvgRenderedQuads[1] == 0.0f);
+    EXPECT(summary.AvgTotalRenderedQuads == 49.5f);
+    EXPECT(summary.AvgTotalRenderedTriangles == 1650.0f);
+    EXPECT(summary.AvgMorphingQuads == 8.0f);  // 6, 7, 7, 8, 8, 9, 9, 10
+    EXPECT(summary.AvgSelectionTime == 4.125f);
+    EXPECT(summary.MaxTotalRenderedQuads == 60);
+    EXPECT(summary.MaxTotalRenderedTriangles == 2000);
+    EXPECT(summary.MaxDrawCalls == 6);  // 13 % 7 and 20 % 7
+    EXPECT(summary.MaxSelectionTime == 5.0f);
+
+    history.Clear();
+    EXPECT(history.GetFrameCount() == 0);
+    history.Push(makeStats(2));
+    history.GetSummary(summary);
+    EXPECT(summary.FrameCount == 1 && summary.AvgTotalRenderedQuads == 6.0f);
+}
+
+// A header row, then one row per frame pushed while writing.
+TEST(CDLODRenderStats, CSV) {
+    const auto path = (std::filesystem::temp_directory_path() / "GuppyTests_RenderStats.csv").string();
+    {
+        CDLODRenderStatsHistory history(4);
+        history.Push(makeStats(1));  // before the file, not written
+        REQUIRE(history.StartCSV(path.c_str(), 3));
+        EXPECT(history.IsWritingCSV());
+        history.Push(makeStats(2));
+        history.Push(makeStats(4));
+        history.StopCSV();
+        EXPECT(!history.IsWritingCSV());
+        history.Push(makeStats(5));
+    }
+
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) lines.push_back(line);
+    file.close();
+    std::filesystem::remove(path);
+
+    REQUIRE(lines.size() == 3);
+    EXPECT(lines[0] == "frame,selection_ms,quads,triangles,draw_calls,morphing_quads,quads_lod0,quads_lod1,quads_lod2");
+    EXPECT(lines[1] == "1,0.5000,6,200,2,1,2,0,4");
+    EXPECT(lines[2] == "2,1.0000,12,400,4,2,4,0,8");
+
+    // No directory to write it in
+    const auto missingPath = (std::filesystem::temp_directory_path() / "GuppyTests_Missing" / "stats.csv").string();
+    CDLODRenderStatsHistory history;
+    EXPECT(!history.StartCSV(missingPath.c_str(), 3));
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+constexpr int MAX_SELECTION_COUNT = 8192;
+
+// A random box inside "dims" with sides from 1m up to a quarter of the map.
+AABB makeBox(const MapDimensions& dims, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const glm::vec3 mapMin = {dims.MinX, dims.MinY, dims.MinZ}, mapSize = {dims.SizeX, dims.SizeY, dims.SizeZ};
+    const glm::vec3 size = {1.0f + unit(rng) * mapSize.x * 0.25f, 1.0f + unit(rng) * mapSize.y * 0.25f,
+                            1.0f + unit(rng) * mapSize.z};
+    const glm::vec3 min = {mapMin.x + unit(rng) * (mapSize.x - size.x), mapMin.y + unit(rng) * (mapSize.y - size.y),
+                           mapMin.z + unit(rng) * (mapSize.z - size.z)};
+    return {min, min + size};
+}
+
+// The four quadrants of "box" (x/y), the way LODSelect splits a node into its children.
+void splitBox(const AABB& box, AABB subBoxes[4]) {
+    const glm::vec3 mid = {(box.Min.x + box.Max.x) * 0.5f, (box.Min.y + box.Max.y) * 0.5f, box.Max.z};
+    subBoxes[0] = {box.Min, mid};
+    subBoxes[1] = {{mid.x, box.Min.y, box.Min.z}, {box.Max.x, mid.y, box.Max.z}};
+    subBoxes[2] = {{box.Min.x, mid.y, box.Min.z}, {mid.x, box.Max.y, box.Max.z}};
+    subBoxes[3] = {{mid.x, mid.y, box.Min.z}, box.Max};
+}
+
+}  // namespace
+
+/*  CDLODQuadTree::LODSelectTestNodes gives the same frustum and range results as AABB::TestInBoundingPlanes and
+    AABB::IntersectSphereSq for random boxes, cameras, and levels, with 1 to 4 boxes at a time. The children of a box
+    skip the planes it is completely inside of and still match. This checks whichever path is built (SSE2, NEON, or the
+    scalar one with the CDLOD_QUADTREE_SCALAR CMake option).
+*/
+TEST(CDLODSelectTestNodes, MatchesAABB) {
+    const AreaHeightmap heightmap(513, 385, 31);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+    const auto& dims = quadTree.GetWorldMapDims();
+    const int stopAtLevel = quadTree.GetLODLevelCount() - 1;
+
+    std::mt19937 rng(53);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<CDLODQuadTree::SelectedNode> nodes(MAX_SELECTION_COUNT);
+    int insideCount = 0, intersectCount = 0, outsideCount = 0, inRangeCount = 0;
+    for (int cameraIndex = 0; cameraIndex < 64; cameraIndex++) {
+        const glm::vec3 eye = {dims.MinX + unit(rng) * dims.SizeX, dims.MinY + unit(rng) * dims.SizeY,
+                               dims.MinZ + unit(rng) * dims.SizeZ * 2.0f};
+        const glm::vec3 forward = {unit(rng) * 2.0f - 1.0f, unit(rng) * 2.0f - 1.0f, -unit(rng) * 0.5f};
+        glm::vec4 planes[6];
+        makeFrustum(eye, forward, 0.3f + unit(rng) * 0.5f, VISIBILITY_DISTANCE, planes);
+        CDLODQuadTree::LODSelection selection(nodes.data(), MAX_SELECTION_COUNT, eye, VISIBILITY_DISTANCE, planes,
+                                              LOD_DISTANCE_RATIO);
+        quadTree.LODSelectRanges(&selection);
+
+        CDLODQuadTree::Node::LODSelectInfo info = {};
+        info.SelectionObj = &selection;
+        info.StopAtLevel = stopAtLevel;
+        info.RasterSizeX = quadTree.GetRasterSizeX();
+        info.RasterSizeY = quadTree.GetRasterSizeY();
+        info.MapDims = dims;
+        info.Cache = NULL;
+
+        for (int boxIndex = 0; boxIndex < 64; boxIndex++) {
+            AABB parent = makeBox(dims, rng);
+            AABB subBoxes[4];
+            splitBox(parent, subBoxes);
+            const int level = static_cast<int>(rng() % stopAtLevel);
+            const int count = 1 + static_cast<int>(rng() % 4);
+
+            CDLODQuadTree::Node::LODSelectTest parentTest, tests[4];
+            CDLODQuadTree::LODSelectTestNodes(info, level, &parent, 1, 0, &parentTest);
+            CDLODQuadTree::LODSelectTestNodes(info, level + 1, subBoxes, count, parentTest.InsidePlaneMask, tests);
+
+            const auto check = [&](AABB box, int boxLevel, const CDLODQuadTree::Node::LODSelectTest& test) {
+                const IntersectType frustumIt = box.TestInBoundingPlanes(planes);
+                // The ranges are by LOD level, which counts up from the leaves.
+                const float range = selection.GetLODLevelRanges()[stopAtLevel - boxLevel];
+                EXPECT(test.FrustumIt == frustumIt);
+                EXPECT(test.InRange == box.IntersectSphereSq(eye, range * range));
+                if (boxLevel != stopAtLevel) {
+                    const float nextRange = selection.GetLODLevelRanges()[stopAtLevel - boxLevel - 1];
+                    EXPECT(test.InNextRange == box.IntersectSphereSq(eye, nextRange * nextRange));
+                }
+                insideCount += frustumIt == IT_Inside;
+                intersectCount += frustumIt == IT_Intersect;
+                outsideCount += frustumIt == IT_Outside;
+                inRangeCount += test.InRange;
+            };
+            check(parent, level, parentTest);
+            for (int i = 0; i < count; i++) check(subBoxes[i], level + 1, tests[i]);
+        }
+    }
+    // Every result is covered.
+    EXPECT(insideCount > 0 && intersectCount > 0 && outsideCount > 0);
+    EXPECT(inRangeCount > 0);
+}
+
+// LODSelect along a camera path, with the node test path that is built (see CDLOD_QUADTREE_SCALAR).
+BENCH(CDLODSelectTestNodes, LODSelect) {
+    const AreaHeightmap heightmap(4097, 4097, 59);
+    auto desc = makeDesc(heightmap, true, 0);
+    desc.LODLevelCount = 8;
+    CDLODQuadTree quadTree;
+    quadTree.Create(desc);
+    const auto path = makeCameraPath(quadTree.GetWorldMapDims(), 200, 20.0f, 0.02f);
+
+    std::vector<CDLODQuadTree::SelectedNode> nodes(MAX_SELECTION_COUNT);
+    int testedNodeCount = 0;
+    const auto ms = Test::time(5, [&]() {
+        testedNodeCount = 0;
+        for (const auto& camera : path) {
+            glm::vec4 planes[6];
+            makeFrustum(camera, planes);
+            CDLODQuadTree::LODSelection selection(nodes.data(), MAX_SELECTION_COUNT, camera.eye, VISIBILITY_DISTANCE,
+                                                  planes, LOD_DISTANCE_RATIO);
+            quadTree.LODSelect(&selection);
+            testedNodeCount += selection.GetTestedNodeCount();
+        }
+    });
+    printf("  %zu frames: %.3f ms and %d nodes tested per LODSelect\n", path.size(), ms / path.size(),
+           testedNodeCount / static_cast<int>(path.size()));
+}
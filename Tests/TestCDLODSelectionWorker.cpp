@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <optional>
+#include <vector>
+
+#include <CDLOD/CDLODSelectionWorker.h>
+
+#include "Test.h"
+#include "TestCDLOD.h"
+
+namespace {
+
+using namespace Test::Cdlod;
+
+constexpr int MAX_SELECTION_COUNT = 8192;
+
+// Synchronous selection for "camera".
+struct Selection {
+    Selection(const CDLODQuadTree& quadTree, const Camera& camera) : nodes(MAX_SELECTION_COUNT) {
+        glm::vec4 planes[6];
+        makeFrustum(camera, planes);
+        selection.emplace(nodes.data(), MAX_SELECTION_COUNT, camera.eye, VISIBILITY_DISTANCE, planes, LOD_DISTANCE_RATIO);
+        quadTree.LODSelect(&*selection);
+    }
+    std::vector<CDLODQuadTree::SelectedNode> nodes;
+    std::optional<CDLODQuadTree::LODSelection> selection;
+};
+
+void submit(CDLODSelectionWorker& worker, const Camera& camera) {
+    glm::vec4 planes[6];
+    makeFrustum(camera, planes);
+    worker.Submit(camera.eye, VISIBILITY_DISTANCE, planes, LOD_DISTANCE_RATIO);
+}
+
+}  // namespace
+
+// Drives the worker the way the renderer does (submit the next frame's camera, then record with the finished one) and
+// checks every frame against a synchronous selection. The front buffer must not change while the next one runs.
+TEST(CDLODSelectionWorker, MatchesSynchronous) {
+    const AreaHeightmap heightmap(1025, 769, 9);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+    const auto path = makeCameraPath(quadTree.GetWorldMapDims(), 120, 25.0f, 0.02f);
+
+    for (const bool incremental : {false, true}) {
+        CDLODSelectionWorker worker;
+        worker.Start(&quadTree, MAX_SELECTION_COUNT, incremental);
+        EXPECT(worker.Acquire() == NULL);
+
+        const CDLODQuadTree::LODSelection* pFront = NULL;
+        int selectedCount = 0;
+        for (size_t frame = 0; frame < path.size(); frame++) {
+            submit(worker, path[frame]);
+            // Compared while the worker selects into the back buffer.
+            if (pFront != NULL) EXPECT(isSameSelection(*pFront, *Selection(quadTree, path[frame - 1]).selection));
+
+            pFront = worker.Acquire();
+            REQUIRE(pFront != NULL);
+            EXPECT(isSameSelection(*pFront, *Selection(quadTree, path[frame]).selection));
+            selectedCount += pFront->GetSelectionCount();
+        }
+        EXPECT(selectedCount > 0);
+        worker.Stop();
+        EXPECT(!worker.IsStarted());
+    }
+}
+
+// A finished selection that was never acquired is dropped for the next one, and Acquire keeps returning the front buffer
+// when nothing new was submitted.
+TEST(CDLODSelectionWorker, LatestSelectionWins) {
+    const AreaHeightmap heightmap(513, 513, 13);
+    CDLODQuadTree quadTree;
+    REQUIRE(quadTree.Create(makeDesc(heightmap, true, 0)));
+    const auto path = makeCameraPath(quadTree.GetWorldMapDims(), 3, 1500.0f, 0.5f);
+
+    CDLODSelectionWorker worker;
+    worker.Start(&quadTree, MAX_SELECTION_COUNT);
+    submit(worker, path[0]);
+    submit(worker, path[1]);
+    const auto* pSelection = worker.Acquire();
+    REQUIRE(pSelection != NULL);
+    EXPECT(isSameSelection(*pSelection, *Selection(quadTree, path[1]).selection));
+    EXPECT(!isSameSelection(*pSelection, *Selection(quadTree, path[0]).selection));
+    EXPECT(worker.Acquire() == pSelection);
+
+    // Restarting drops everything.
+    worker.Stop();
+    worker.Start(&quadTree, MAX_SELECTION_COUNT);
+    EXPECT(worker.Acquire() == NULL);
+    submit(worker, path[2]);
+    EXPECT(isSameSelection(*worker.Acquire(), *Selection(quadTree, path[2]).selection));
+}
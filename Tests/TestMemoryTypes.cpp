@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <Common/MemoryAllocator.h>
+
+#include "Test.h"
+
+namespace {
+
+using Flags = vk::MemoryPropertyFlagBits;
+constexpr uint32_t ALL_TYPES = UINT32_MAX;
+
+vk::PhysicalDeviceMemoryProperties makeProperties(const std::vector<vk::MemoryType>& types,
+                                                  const std::vector<vk::DeviceSize>& heapSizes) {
+    vk::PhysicalDeviceMemoryProperties memProps = {};
+    memProps.memoryTypeCount = static_cast<uint32_t>(types.size());
+    for (uint32_t i = 0; i < memProps.memoryTypeCount; i++) memProps.memoryTypes[i] = types[i];
+    memProps.memoryHeapCount = static_cast<uint32_t>(heapSizes.size());
+    for (uint32_t i = 0; i < memProps.memoryHeapCount; i++) memProps.memoryHeaps[i] = vk::MemoryHeap{heapSizes[i]};
+    return memProps;
+}
+
+// A discrete card without resizable BAR: VRAM, system memory, and the 256MB BAR heap.
+vk::PhysicalDeviceMemoryProperties makeDiscrete() {
+    return makeProperties(
+        {
+            {Flags::eDeviceLocal, 0},
+            {Flags::eHostVisible | Flags::eHostCoherent, 1},
+            {Flags::eHostVisible | Flags::eHostCoherent | Flags::eHostCached, 1},
+            {Flags::eDeviceLocal | Flags::eHostVisible | Flags::eHostCoherent, 2},
+        },
+        {8ull << 30, 16ull << 30, 256ull << 20});
+}
+
+// Integrated: one heap, and everything is device local.
+vk::PhysicalDeviceMemoryProperties makeIntegrated() {
+    return makeProperties(
+        {
+            {Flags::eDeviceLocal, 0},
+            {Flags::eDeviceLocal | Flags::eHostVisible | Flags::eHostCoherent, 0},
+            {Flags::eDeviceLocal | Flags::eHostVisible | Flags::eHostCoherent | Flags::eHostCached, 0},
+        },
+        {8ull << 30});
+}
+
+// Host visible types for data the host writes.
+std::vector<uint32_t> getHostWriteTypes(const vk::PhysicalDeviceMemoryProperties& memProps, const bool deviceLocal,
+                                        const uint32_t typeBits = ALL_TYPES) {
+    return Memory::getMemoryTypes(memProps, typeBits, Flags::eHostVisible, Memory::getHostWritePreferences(deviceLocal));
+}
+
+bool Equals(const std::vector<uint32_t>& memoryTypes, const std::vector<uint32_t>& expected) {
+    return memoryTypes == expected;
+}
+
+}  // namespace
+
+// Small per frame data prefers the BAR heap, and falls back to host memory. Bigger data never prefers it, but can still
+// fall back to it.
+TEST(MemoryTypes, HostWritePreferences) {
+    const auto memProps = makeDiscrete();
+#if !(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK))
+    EXPECT(Equals(getHostWriteTypes(memProps, true), {3, 2, 1}));
+#else
+    EXPECT(Equals(getHostWriteTypes(memProps, true), {2, 1, 3}));
+#endif
+    EXPECT(Equals(getHostWriteTypes(memProps, false), {2, 1, 3}));
+
+    // Cached memory that isn't coherent still beats coherent memory that isn't cached (writes are flushed).
+    const auto nonCoherent = makeProperties(
+        {
+            {Flags::eHostVisible | Flags::eHostCoherent, 0},
+            {Flags::eHostVisible | Flags::eHostCached, 0},
+        },
+        {1ull << 30});
+    EXPECT(Equals(getHostWriteTypes(nonCoherent, false), {1, 0}));
+
+    // Everything is device local on an integrated GPU. Coherent wins the tie.
+    const auto integrated = makeIntegrated();
+#if !(defined(VK_USE_PLATFORM_IOS_MVK) || defined(VK_USE_PLATFORM_MACOS_MVK))
+    EXPECT(Equals(getHostWriteTypes(integrated, true), {1, 2}));
+#endif
+    EXPECT(Equals(getHostWriteTypes(integrated, false), {2, 1}));
+}
+
+// Only the types in "typeBits" that have every required flag are candidates. Without preferences they are in index order.
+TEST(MemoryTypes, Requirements) {
+    const auto memProps = makeDiscrete();
+    EXPECT(Equals(Memory::getMemoryTypes(memProps, ALL_TYPES, Flags::eDeviceLocal), {0, 3}));
+    EXPECT(Equals(Memory::getMemoryTypes(memProps, ALL_TYPES, Flags::eHostVisible | Flags::eHostCached), {2}));
+    EXPECT(Equals(Memory::getMemoryTypes(memProps, ALL_TYPES, {}), {0, 1, 2, 3}));
+
+    // The resource can't use type 3 or 2.
+    const uint32_t typeBits = 0b0011;
+    EXPECT(Equals(getHostWriteTypes(memProps, true, typeBits), {1}));
+    EXPECT(Memory::getMemoryTypes(memProps, typeBits, Flags::eHostVisible | Flags::eHostCached).empty());
+    EXPECT(Memory::getMemoryTypes(memProps, ALL_TYPES, Flags::eLazilyAllocated).empty());
+
+    // A preference no type has changes nothing.
+    EXPECT(Equals(Memory::getMemoryTypes(memProps, ALL_TYPES, Flags::eHostVisible, {Flags::eLazilyAllocated}),
+                  {1, 2, 3}));
+}
+
+// Flushed ranges are widened to "nonCoherentAtomSize", and clamped to the end of the memory.
+TEST(MemoryTypes, MappedRange) {
+    vk::PhysicalDeviceLimits limits = {};
+    limits.bufferImageGranularity = 1;
+    limits.nonCoherentAtomSize = 64;
+    Memory::Allocator allocator;
+    allocator.init(vk::Device(), makeDiscrete(), limits, nullptr);
+
+    // A dedicated allocation (no block), so the memory is the allocation.
+    Memory::Allocation allocation = {};
+    allocation.size = 1000;
+    auto range = allocator.getMappedRange(allocation, 10, 20);
+    EXPECT(range.offset == 0 && range.size == 64);
+    range = allocator.getMappedRange(allocation, 60, 10);
+    EXPECT(range.offset == 0 && range.size == 128);
+    range = allocator.getMappedRange(allocation, 128, 64);
+    EXPECT(range.offset == 128 && range.size == 64);
+    range = allocator.getMappedRange(allocation, 990, 5);
+    EXPECT(range.offset == 960 && range.size == 40);
+    range = allocator.getMappedRange(allocation);
+    EXPECT(range.offset == 0 && range.size == 1000);
+
+    allocator.destroy();
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "OceanHeightQuery.h"
+#include "Test.h"
+
+namespace {
+
+constexpr float EPSILON = 1e-4f;
+
+// 8x4 texels, 2m apart along x and 3m along z, starting at (10, -5).
+Ocean::HeightField makeField(const glm::vec2& displacement) {
+    Ocean::HeightField field;
+    field.reset({{10.0f, -5.0f}, {2.0f, 3.0f}, 8, 4});
+    auto* pTexel = field.data();
+    for (uint32_t z = 0; z < 4; z++)
+        for (uint32_t x = 0; x < 8; x++) *pTexel++ = {displacement.x, displacement.y, 0.5f * x - 0.25f * z};
+    return field;
+}
+
+// The height the texels above hold at grid position (x, z), away from the wrap-around.
+float getGridHeight(const float x, const float z) { return 0.5f * (x - 10.0f) / 2.0f - 0.25f * (z + 5.0f) / 3.0f; }
+
+}  // namespace
+
+TEST(OceanHeightQuery, Interpolation) {
+    const auto field = makeField({0.0f, 0.0f});
+    // The heights are linear between the texels, so the bilinear interpolation is exact inside the grid.
+    for (float z = -5.0f; z <= 4.0f; z += 0.7f) {
+        for (float x = 10.0f; x <= 24.0f; x += 0.9f) {
+            EXPECT(std::abs(field.sample({x, z}).z - getGridHeight(x, z)) < EPSILON);
+            EXPECT(std::abs(field.sampleHeight(x, z) - getGridHeight(x, z)) < EPSILON);
+        }
+    }
+    // Half way between the last column and the first one (wrapped).
+    EXPECT(std::abs(field.sample({25.0f, -5.0f}).z - 0.5f * 3.5f) < EPSILON);
+}
+
+TEST(OceanHeightQuery, WrapsAround) {
+    const auto field = makeField({0.0f, 0.0f});
+    const glm::vec2 period = {8 * 2.0f, 4 * 3.0f};
+    for (const glm::vec2 xz : {glm::vec2{11.3f, -4.1f}, glm::vec2{17.0f, 2.5f}, glm::vec2{23.9f, 6.9f}}) {
+        const float height = field.sample(xz).z;
+        EXPECT(std::abs(field.sample(xz + period).z - height) < EPSILON);
+        EXPECT(std::abs(field.sample(xz - 3.0f * period).z - height) < EPSILON);
+    }
+}
+
+TEST(OceanHeightQuery, UndoesDisplacement) {
+    // Everything is pushed by (1.5, -2): the surface drawn at (x, z) comes from grid position (x - 1.5, z + 2).
+    const glm::vec2 displacement = {1.5f, -2.0f};
+    const auto field = makeField(displacement);
+    std::vector<glm::vec2> positions;
+    for (float z = -3.0f; z <= 2.0f; z += 1.3f)
+        for (float x = 12.0f; x <= 24.0f; x += 1.7f) positions.push_back({x, z});
+
+    std::vector<float> heights(positions.size());
+    field.sampleHeights(positions.data(), heights.data(), positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        const auto gridPosition = positions[i] - displacement;
+        EXPECT(std::abs(heights[i] - getGridHeight(gridPosition.x, gridPosition.y)) < EPSILON);
+        EXPECT(heights[i] == field.sampleHeight(positions[i].x, positions[i].y));
+    }
+
+    // Sea level until there is data.
+    EXPECT(Ocean::HeightField().sampleHeight(12.0f, 3.0f) == 0.0f);
+}
+
+TEST(OceanHeightQuery, ReadbackRing) {
+    Ocean::ReadbackRing ring;
+    ring.reset(3);
+    EXPECT(ring.acquire(100) == Ocean::ReadbackRing::NONE);
+
+    ring.write(0, 1);
+    ring.write(1, 2);
+    ring.write(2, 3);
+    EXPECT(ring.acquire(0) == Ocean::ReadbackRing::NONE);
+    // The newest done slot wins, and the older done one is dropped.
+    EXPECT(ring.acquire(2) == 1);
+    EXPECT(ring.acquire(2) == Ocean::ReadbackRing::NONE);
+    EXPECT(ring.acquire(3) == 2);
+
+    // Rewriting a slot that wasn't read drops what it had.
+    ring.write(0, 4);
+    ring.write(0, 7);
+    ring.write(1, 5);
+    EXPECT(ring.acquire(6) == 1);
+    EXPECT(ring.acquire(6) == Ocean::ReadbackRing::NONE);
+    EXPECT(ring.acquire(7) == 0);
+    EXPECT(ring.acquire(UINT64_MAX) == Ocean::ReadbackRing::NONE);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cmath>
+#include <set>
+
+#include "OceanPatches.h"
+#include "Test.h"
+
+namespace {
+
+// A grid of "count" by "count" patches of "size" meters starting at the origin.
+std::vector<Ocean::Patch> makePatches(const uint32_t count, const float size) {
+    std::vector<Ocean::Patch> patches;
+    for (uint32_t z = 0; z < count; z++)
+        for (uint32_t x = 0; x < count; x++) patches.push_back({{x * size, z * size}, {size, size}});
+    return patches;
+}
+
+// Everything is inside unless "cullNegX" is set, then only x >= 0 is.
+Ocean::PatchSelectInfo makeInfo(const glm::vec3& eye, const bool cullNegX) {
+    Ocean::PatchSelectInfo info = {};
+    for (auto& plane : info.planes) plane = {0.0f, 0.0f, 0.0f, 1.0f};
+    if (cullNegX) info.planes[0] = {1.0f, 0.0f, 0.0f, 0.0f};
+    info.eye = eye;
+    info.maxHeight = 1.0f;
+    info.maxDisplacement = 0.5f;
+    info.lodDistance = 20.0f;
+    info.lodCount = 4;
+    return info;
+}
+
+// Same as snapToEdge in vert.ocean.glsl.
+float snapToEdge(const float v, const float spacing) { return (spacing > 0.0f) ? (std::floor(v / spacing) * spacing) : v; }
+
+}  // namespace
+
+TEST(OceanPatches, GroupsByLod) {
+    const auto patches = makePatches(16, 10.0f);
+    const auto info = makeInfo({5.0f, 2.0f, 5.0f}, false);
+    Ocean::PatchSelection selection;
+    Ocean::SelectPatches(info, patches, selection);
+
+    REQUIRE(selection.indices.size() == patches.size());
+    REQUIRE(selection.lodCounts.size() == info.lodCount);
+    // The patch under the eye is LOD 0 and the far corner is the last LOD.
+    EXPECT(selection.patchLods[0] == 0);
+    EXPECT(selection.patchLods.back() == info.lodCount - 1);
+
+    for (uint32_t lod = 0; lod < info.lodCount; lod++) {
+        const auto first = selection.getFirst(lod);
+        for (uint32_t i = first; i < first + selection.lodCounts[lod]; i++) {
+            EXPECT(selection.patchLods[selection.indices[i]] == lod);
+            EXPECT(Ocean::GetPatchLod(info, patches[selection.indices[i]]) == lod);
+        }
+    }
+}
+
+TEST(OceanPatches, Culling) {
+    // Shift the grid so the first half is at x < 0.
+    auto patches = makePatches(8, 10.0f);
+    for (auto& patch : patches) patch.offset.x -= 40.0f;
+    const auto info = makeInfo({5.0f, 2.0f, 5.0f}, true);
+    Ocean::PatchSelection selection;
+    Ocean::SelectPatches(info, patches, selection);
+
+    for (uint32_t i = 0; i < patches.size(); i++) {
+        // The displacement grows the bounds, so the column touching x = 0 from below is still visible.
+        const bool visible = patches[i].offset.x + patches[i].scale.x + info.maxDisplacement >= 0.0f;
+        EXPECT(Ocean::IsPatchVisible(info, patches[i]) == visible);
+        EXPECT((selection.patchLods[i] != Ocean::PATCH_NOT_SELECTED) == visible);
+    }
+    EXPECT(selection.indices.size() == 8 * 5);
+}
+
+TEST(OceanPatches, NeighbourLods) {
+    Ocean::PatchSelection selection;
+    // 3x2 grid
+    selection.patchLods = {
+        0, 1, Ocean::PATCH_NOT_SELECTED,  //
+        2, 0, 3,
+    };
+    auto lods = Ocean::GetNeighbourLods(selection, 3, 2, 0);
+    EXPECT(lods[Ocean::NEG_X] == 0);  // grid edge
+    EXPECT(lods[Ocean::POS_X] == 1);
+    EXPECT(lods[Ocean::NEG_Z] == 0);  // grid edge
+    EXPECT(lods[Ocean::POS_Z] == 2);
+
+    lods = Ocean::GetNeighbourLods(selection, 3, 2, 4);
+    EXPECT(lods[Ocean::NEG_X] == 2);
+    EXPECT(lods[Ocean::POS_X] == 3);
+    EXPECT(lods[Ocean::NEG_Z] == 1);
+    EXPECT(lods[Ocean::POS_Z] == 0);  // grid edge
+
+    // Culled neighbours report the patch's own LOD.
+    lods = Ocean::GetNeighbourLods(selection, 3, 2, 5);
+    EXPECT(lods[Ocean::NEG_Z] == 3);
+}
+
+// The snapped edge vertices of a finer patch must land exactly on the edge vertices of the coarser neighbour, or the
+// surface cracks.
+TEST(OceanPatches, EdgeSnapMatchesCoarserGrid) {
+    constexpr uint32_t MESH_DIM = 32;
+    for (uint32_t lod = 0; lod < 4; lod++) {
+        const uint32_t fineDim = MESH_DIM >> lod;
+        for (uint32_t neighbourLod = lod + 1; neighbourLod < 4; neighbourLod++) {
+            const uint32_t coarseDim = MESH_DIM >> neighbourLod;
+            std::set<float> coarse;
+            for (uint32_t i = 0; i <= coarseDim; i++) coarse.insert(i / static_cast<float>(coarseDim));
+
+            const float spacing = 1.0f / static_cast<float>(coarseDim);
+            for (uint32_t i = 0; i <= fineDim; i++) {
+                const float snapped = snapToEdge(i / static_cast<float>(fineDim), spacing);
+                EXPECT(coarse.count(snapped) == 1);
+            }
+        }
+    }
+}
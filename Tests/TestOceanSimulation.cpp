@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <Ocean/OceanSimulation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <glm/gtc/constants.hpp>
+
+#include "Test.h"
+
+using Ocean::SurfaceCreateInfo;
+
+namespace {
+
+SurfaceCreateInfo MakeInfo(const uint32_t N, const uint32_t M) {
+    SurfaceCreateInfo info;
+    info.Lx = 64.0f;
+    info.Lz = 128.0f;
+    info.N = N;
+    info.M = M;
+    info.fftLocalSize = (std::min)(N, M);
+    info.dispLocalSize = (std::min)(N, M);
+    info.heightReadbackScale = 0;
+    info.seed = 7;
+    return info;
+}
+
+/*  The surface straight from its definition: h(x, t) = sum over k of h~(k, t) * e^(i * k.x), and the horizontal
+    displacement D(x, t) = sum over k of -i * (k / |k|) * h~(k, t) * e^(i * k.x), at the grid points x = (x * Lx / N,
+    y * Lz / M). Only the real parts end up in the vertex input (same as Simulation::getPositions).
+*/
+std::vector<glm::dvec3> NaiveDFT(const SurfaceCreateInfo& info, const float time) {
+    std::vector<float> wave(info.N * info.M * 4), hTilde0(info.N * info.M * 4);
+    Ocean::MakeWaveFourierData(info, wave.data(), hTilde0.data());
+    const double omega0 = 2.0 * glm::pi<double>() / Ocean::T;
+
+    // h~(k, t) = h~0(k) * e^(i * w(k) * t) + conj(h~0(-k)) * e^(-i * w(k) * t), with w(k) quantized to the repeat time.
+    std::vector<std::complex<double>> hTilde(info.N * info.M);
+    for (size_t i = 0; i < hTilde.size(); i++) {
+        const double omegaKT = std::floor(wave[i * 4 + 3] / omega0) * omega0 * time;
+        const std::complex<double> h0 = {hTilde0[i * 4 + 0], hTilde0[i * 4 + 1]};
+        const std::complex<double> h0Conj = {hTilde0[i * 4 + 2], hTilde0[i * 4 + 3]};
+        hTilde[i] = h0 * std::polar(1.0, omegaKT) + h0Conj * std::polar(1.0, -omegaKT);
+    }
+
+    std::vector<glm::dvec3> surface(info.N * info.M);  // (x displacement, z displacement, height)
+    for (uint32_t y = 0; y < info.M; y++) {
+        for (uint32_t x = 0; x < info.N; x++) {
+            const double posX = x * static_cast<double>(info.Lx) / info.N;
+            const double posZ = y * static_cast<double>(info.Lz) / info.M;
+            std::complex<double> h, dx, dz;
+            for (size_t i = 0; i < hTilde.size(); i++) {
+                const double kx = wave[i * 4 + 0], kz = wave[i * 4 + 1], k = wave[i * 4 + 2];
+                const auto term = hTilde[i] * std::polar(1.0, kx * posX + kz * posZ);
+                h += term;
+                if (k < 1e-6) continue;
+                dx += std::complex<double>(0.0, -kx / k) * term;
+                dz += std::complex<double>(0.0, -kz / k) * term;
+            }
+            surface[y * info.N + x] = {dx.real() * info.lambda, dz.real() * info.lambda, h.real()};
+        }
+    }
+    return surface;
+}
+
+}  // namespace
+
+/*  The dispersion, inverse fft, and vertex input passes give the same surface as summing every wave directly. The
+    dimensions cover even and odd powers of two, so the Stockham kernel runs with and without its radix-2 tail.
+*/
+TEST(OceanSimulation, NaiveDFT) {
+    for (const auto& dims : {glm::uvec2{8, 16}, glm::uvec2{16, 4}, glm::uvec2{32, 2}}) {
+        for (const auto kernel : {Ocean::FFT_KERNEL::RADIX_2, Ocean::FFT_KERNEL::STOCKHAM_RADIX_4}) {
+            auto info = MakeInfo(dims.x, dims.y);
+            info.fftKernel = kernel;
+            REQUIRE(Ocean::IsValid(info));
+            Ocean::Simulation simulation(info);
+
+            for (const float time : {0.0f, 1.5f, 37.25f}) {
+                simulation.update(time);
+                const auto expected = NaiveDFT(info, time);
+                const auto& positions = simulation.getPositions();
+                REQUIRE(positions.size() == expected.size());
+
+                double maxValue = 0.0, maxError = 0.0;
+                for (size_t i = 0; i < expected.size(); i++) {
+                    const glm::dvec3 actual = {positions[i].x, positions[i].y, positions[i].z};
+                    const auto error = glm::abs(actual - expected[i]);
+                    maxError = (std::max)(maxError, (std::max)((std::max)(error.x, error.y), error.z));
+                    maxValue = (std::max)(maxValue, glm::length(expected[i]));
+                    EXPECT(positions[i].w == 1.0f);
+                }
+                // A flat surface would pass trivially.
+                EXPECT(maxValue > 1e-3);
+                // The float fft error grows with the magnitude of the data.
+                EXPECT(maxError <= 1e-5 * maxValue);
+            }
+        }
+    }
+}
+
+// The C++ port of the Stockham shader (FFT::Stockham) gives the same surface as the radix-2 fft up to its largest size.
+TEST(OceanSimulation, StockhamMatchesRadix2) {
+    for (const auto& dims : {glm::uvec2{4, 4}, glm::uvec2{64, 128}, glm::uvec2{512, 32}, glm::uvec2{1024, 1024}}) {
+        auto info = MakeInfo(dims.x, dims.y);
+        info.Lx = info.Lz = 1000.0f;
+        REQUIRE(Ocean::IsValid(info));
+        Ocean::Simulation radix2(info);
+        info.fftKernel = Ocean::FFT_KERNEL::STOCKHAM_RADIX_4;
+        REQUIRE(Ocean::IsValid(info));
+        Ocean::Simulation stockham(info);
+
+        radix2.update(12.5f);
+        stockham.update(12.5f);
+        // Only the positions are compared. The normals are central differences of them, which blow the float fft noise
+        // up on the fine grids.
+        float maxValue = 0.0f, maxError = 0.0f;
+        for (size_t i = 0; i < radix2.getPositions().size(); i++) {
+            const auto dp = glm::abs(radix2.getPositions()[i] - stockham.getPositions()[i]);
+            maxError = (std::max)(maxError, (std::max)((std::max)(dp.x, dp.y), dp.z));
+            maxValue = (std::max)(maxValue, std::abs(radix2.getPositions()[i].z));
+        }
+        EXPECT(maxValue > 1e-3f);
+        EXPECT(maxError <= 1e-4f * maxValue);
+    }
+}
+
+/*  The normal pass (Ocean::MakeNormals) on grids with a known displacement. A single wave along one axis,
+    P = (X + c * sin(k * X), a * cos(k * X)), has central differences across two cells (2 * s apart) of
+    dP = (2 * s + 2 * c * cos(k * X) * sin(k * s), -2 * a * sin(k * X) * sin(k * s)), so the normal is along
+    (-dP.y, dP.x) and the Jacobian determinant is dP.x / (2 * s). The waves fit the tile, so the edge texels check the
+    wrap around too. A large enough "c" folds the surface over and the Jacobian goes negative.
+*/
+TEST(OceanSimulation, NormalFiniteDifferences) {
+    auto info = MakeInfo(32, 16);
+    info.Lx = 64.0f;
+    info.Lz = 48.0f;
+    const uint32_t count = info.N * info.M;
+    std::vector<glm::vec4> positions(count), normals(count);
+
+    // Flat grid
+    std::fill(positions.begin(), positions.end(), glm::vec4{0.0f, 0.0f, 0.0f, 1.0f});
+    Ocean::MakeNormals(info, positions.data(), normals.data(), 0, info.M);
+    for (const auto& normal : normals) EXPECT(normal == glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+
+    for (const bool alongX : {true, false}) {
+        const float s = alongX ? info.Lx / info.N : info.Lz / info.M;  // grid spacing along the wave
+        const float k = 3.0f * glm::two_pi<float>() / (alongX ? info.Lx : info.Lz);
+        const float a = 1.25f;
+        for (const float c : {0.4f * s / std::sin(k * s), -1.5f * s / std::sin(k * s)}) {
+            for (uint32_t y = 0; y < info.M; y++) {
+                for (uint32_t x = 0; x < info.N; x++) {
+                    const float theta = k * (alongX ? x : y) * s;
+                    const float choppy = c * std::sin(theta), height = a * std::cos(theta);
+                    positions[y * info.N + x] = {alongX ? choppy : 0.0f, alongX ? 0.0f : choppy, height, 1.0f};
+                }
+            }
+            // Two row ranges, same as the tiles in Simulation::update.
+            Ocean::MakeNormals(info, positions.data(), normals.data(), 0, info.M / 2);
+            Ocean::MakeNormals(info, positions.data(), normals.data(), info.M / 2, info.M);
+
+            float minJacobian = 1.0f;
+            for (uint32_t y = 0; y < info.M; y++) {
+                for (uint32_t x = 0; x < info.N; x++) {
+                    const float theta = k * (alongX ? x : y) * s;
+                    const float dPAlong = 2.0f * s + 2.0f * c * std::cos(theta) * std::sin(k * s);
+                    const float dPHeight = -2.0f * a * std::sin(theta) * std::sin(k * s);
+                    const glm::vec3 expected = glm::normalize(alongX ? glm::vec3{-dPHeight, dPAlong, 0.0f}
+                                                                     : glm::vec3{0.0f, dPAlong, -dPHeight});
+                    const auto& normal = normals[y * info.N + x];
+                    const auto error = glm::abs(glm::vec3(normal) - expected);
+                    EXPECT((std::max)((std::max)(error.x, error.y), error.z) < 1e-5f);
+                    EXPECT(std::abs(normal.w - dPAlong / (2.0f * s)) < 1e-5f);
+                    minJacobian = (std::min)(minJacobian, normal.w);
+                }
+            }
+            // The folding case bottoms out at 1 - 1.5.
+            EXPECT(std::abs(minJacobian - (c > 0.0f ? 0.6f : -0.5f)) < 1e-5f);
+        }
+    }
+}
+
+BENCH(OceanSimulation, Update) {
+    for (const uint32_t size : {256u, 512u, 1024u}) {
+        auto info = MakeInfo(size, size);
+        info.Lx = info.Lz = 1000.0f;
+        info.fftLocalSize = info.dispLocalSize = 64;
+        Ocean::Simulation simulation(info);
+        float time = 0.0f;
+        const auto ms = Test::time(5, [&]() { simulation.update(time += 1.0f / 60.0f); });
+        printf("  %ux%u: %.1f ms\n", size, size, ms);
+    }
+}
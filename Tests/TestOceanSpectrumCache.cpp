@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "OceanSpectrumCache.h"
+#include "Test.h"
+
+namespace {
+
+using Ocean::SpectrumCache::Key;
+
+Key makeKey(const uint32_t seed) { return {1000.0f, 1000.0f, 16, 8, 31.0f, 1.0f, 0.0f, 1.0f, 2e-5f, 98.0f, -1.0f, seed}; }
+
+size_t getFloatCount(const Key& key) { return static_cast<size_t>(key.N) * key.M * 4; }
+
+// Data with the bit patterns a float round trip could lose: signed zero, denormals, infinities and NaN payloads.
+std::vector<float> makeData(const Key& key, const uint32_t salt) {
+    std::vector<float> data(getFloatCount(key));
+    for (size_t i = 0; i < data.size(); i++) data[i] = static_cast<float>(i * salt) * 0.37f - 100.0f;
+    const uint32_t nanBits = 0x7FC01234;
+    std::memcpy(&data[1], &nanBits, sizeof(nanBits));
+    data[2] = -0.0f;
+    data[3] = std::numeric_limits<float>::denorm_min();
+    data[4] = -std::numeric_limits<float>::infinity();
+    return data;
+}
+
+// A fresh directory per test, removed after.
+struct TempDirectory {
+    TempDirectory(const char* name) : path((std::filesystem::temp_directory_path() / name).string()) {
+        std::filesystem::remove_all(path);
+    }
+    ~TempDirectory() { std::filesystem::remove_all(path); }
+    std::string getFilePath(const Key& key) const {
+        return (std::filesystem::path(path) / Ocean::SpectrumCache::GetFileName(key)).string();
+    }
+    std::string path;
+};
+
+}  // namespace
+
+TEST(OceanSpectrumCache, HitIsByteIdentical) {
+    const TempDirectory directory("GuppyTests_SpectrumCacheHit");
+    const auto key = makeKey(3);
+    const auto wave = makeData(key, 1), hTilde0 = makeData(key, 7);
+    REQUIRE(Ocean::SpectrumCache::Store(directory.path, key, wave.data(), hTilde0.data()));
+    // The temporary file was renamed.
+    EXPECT(!std::filesystem::exists(directory.getFilePath(key) + ".tmp"));
+
+    std::vector<float> loadedWave(getFloatCount(key), 5.0f), loadedHTilde0(getFloatCount(key), 5.0f);
+    REQUIRE(Ocean::SpectrumCache::Load(directory.path, key, loadedWave.data(), loadedHTilde0.data()));
+    EXPECT(std::memcmp(loadedWave.data(), wave.data(), wave.size() * sizeof(float)) == 0);
+    EXPECT(std::memcmp(loadedHTilde0.data(), hTilde0.data(), hTilde0.size() * sizeof(float)) == 0);
+}
+
+TEST(OceanSpectrumCache, MissIsDetected) {
+    const TempDirectory directory("GuppyTests_SpectrumCacheMiss");
+    const auto key = makeKey(3), otherKey = makeKey(4);
+    const auto wave = makeData(key, 1), hTilde0 = makeData(key, 7);
+    std::vector<float> loadedWave(getFloatCount(key), 5.0f), loadedHTilde0(getFloatCount(key), 5.0f);
+    const auto isUntouched = [&]() {
+        for (size_t i = 0; i < loadedWave.size(); i++)
+            if (loadedWave[i] != 5.0f || loadedHTilde0[i] != 5.0f) return false;
+        return true;
+    };
+
+    // Nothing stored yet.
+    EXPECT(!Ocean::SpectrumCache::Load(directory.path, key, loadedWave.data(), loadedHTilde0.data()));
+    REQUIRE(Ocean::SpectrumCache::Store(directory.path, key, wave.data(), hTilde0.data()));
+
+    // Another seed (every field is checked in EveryKeyField).
+    EXPECT(!Ocean::SpectrumCache::IsSameKey(key, otherKey));
+    EXPECT(Ocean::SpectrumCache::GetHash(key) != Ocean::SpectrumCache::GetHash(otherKey));
+    EXPECT(!Ocean::SpectrumCache::Load(directory.path, otherKey, loadedWave.data(), loadedHTilde0.data()));
+
+    // A hash collision: the other key's file name holds this key's data.
+    std::filesystem::copy_file(directory.getFilePath(key), directory.getFilePath(otherKey));
+    EXPECT(!Ocean::SpectrumCache::Load(directory.path, otherKey, loadedWave.data(), loadedHTilde0.data()));
+    EXPECT(isUntouched());
+
+    // Another version (the second header field).
+    {
+        std::fstream file(directory.getFilePath(key), std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t version = Ocean::SpectrumCache::VERSION + 1;
+        file.seekp(sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    EXPECT(!Ocean::SpectrumCache::Load(directory.path, key, loadedWave.data(), loadedHTilde0.data()));
+    EXPECT(isUntouched());
+
+    // Truncated
+    REQUIRE(Ocean::SpectrumCache::Store(directory.path, key, wave.data(), hTilde0.data()));
+    std::filesystem::resize_file(directory.getFilePath(key), std::filesystem::file_size(directory.getFilePath(key)) - 4);
+    EXPECT(!Ocean::SpectrumCache::Load(directory.path, key, loadedWave.data(), loadedHTilde0.data()));
+    EXPECT(isUntouched());
+}
+
+// Changing any one key field gives another hash and a miss, even when that key's file name holds the original data.
+TEST(OceanSpectrumCache, EveryKeyField) {
+    const TempDirectory directory("GuppyTests_SpectrumCacheKeyFields");
+    const auto key = makeKey(3);
+    const auto wave = makeData(key, 1), hTilde0 = makeData(key, 7);
+    REQUIRE(Ocean::SpectrumCache::Store(directory.path, key, wave.data(), hTilde0.data()));
+
+    // One change per field, in the order of Key.
+    void (*const changes[])(Key&) = {
+        [](Key& k) { k.Lx *= 2.0f; },
+        [](Key& k) { k.Lz *= 2.0f; },
+        [](Key& k) { k.N *= 2; },
+        [](Key& k) { k.M *= 2; },
+        [](Key& k) { k.V += 1.0f; },
+        [](Key& k) { k.omegaX = 0.0f; },
+        [](Key& k) { k.omegaY = 1.0f; },
+        [](Key& k) { k.l *= 0.5f; },
+        [](Key& k) { k.A *= 2.0f; },
+        [](Key& k) { k.L += 1.0f; },
+        [](Key& k) { k.lambda = -0.5f; },
+        [](Key& k) { k.seed++; },
+    };
+    static_assert(sizeof(changes) / sizeof(changes[0]) == sizeof(Key) / 4);
+
+    // Room for the largest key (N or M doubled), filled with a value the data never has.
+    std::vector<float> loadedWave(getFloatCount(key) * 2, 5.0f), loadedHTilde0(getFloatCount(key) * 2, 5.0f);
+    for (size_t field = 0; field < sizeof(Key) / 4; field++) {
+        Key otherKey = key;
+        changes[field](otherKey);
+        // Only the one field changed.
+        for (size_t i = 0; i < sizeof(Key) / 4; i++) {
+            const bool isSame = std::memcmp(reinterpret_cast<const uint32_t*>(&key) + i,
+                                            reinterpret_cast<const uint32_t*>(&otherKey) + i, 4) == 0;
+            EXPECT(isSame == (i != field));
+        }
+        EXPECT(!Ocean::SpectrumCache::IsSameKey(key, otherKey));
+        EXPECT(Ocean::SpectrumCache::GetHash(key) != Ocean::SpectrumCache::GetHash(otherKey));
+        EXPECT(!Ocean::SpectrumCache::Load(directory.path, otherKey, loadedWave.data(), loadedHTilde0.data()));
+
+        // Same as a hash collision.
+        std::filesystem::copy_file(directory.getFilePath(key), directory.getFilePath(otherKey));
+        EXPECT(!Ocean::SpectrumCache::Load(directory.path, otherKey, loadedWave.data(), loadedHTilde0.data()));
+        std::filesystem::remove(directory.getFilePath(otherKey));
+    }
+    for (size_t i = 0; i < loadedWave.size(); i++) EXPECT(loadedWave[i] == 5.0f && loadedHTilde0[i] == 5.0f);
+
+    // The original key still hits.
+    EXPECT(Ocean::SpectrumCache::Load(directory.path, key, loadedWave.data(), loadedHTilde0.data()));
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <Ocean/OceanSurface.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Test.h"
+
+using Ocean::SurfaceCreateInfo;
+
+namespace {
+
+struct WaveFourierData {
+    WaveFourierData(const SurfaceCreateInfo& info, const uint32_t threadCount)
+        : wave(info.N * info.M * 4), hTilde0(info.N * info.M * 4) {
+        Ocean::MakeWaveFourierData(info, wave.data(), hTilde0.data(), threadCount);
+    }
+    std::vector<float> wave;
+    std::vector<float> hTilde0;
+};
+
+bool IsSameBits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+}  // namespace
+
+// The gaussian draws are keyed on the texel, so splitting the rows differently can't change a single bit.
+TEST(OceanSurface, ThreadCountBitIdentical) {
+    SurfaceCreateInfo info;
+    for (const auto& dims : {glm::uvec2{64, 64}, glm::uvec2{128, 32}, glm::uvec2{4, 256}}) {
+        info.N = dims.x;
+        info.M = dims.y;
+        const WaveFourierData single(info, 1);
+        for (const uint32_t threadCount : {2u, 3u, 7u, 0u}) {
+            const WaveFourierData multi(info, threadCount);
+            EXPECT(IsSameBits(single.wave, multi.wave));
+            EXPECT(IsSameBits(single.hTilde0, multi.hTilde0));
+        }
+    }
+}
+
+// The data only depends on the create info: the same seed gives the same spectrum, and another seed doesn't.
+TEST(OceanSurface, Seed) {
+    SurfaceCreateInfo info;
+    info.N = info.M = 32;
+    const WaveFourierData a(info, 0), b(info, 0);
+    EXPECT(IsSameBits(a.hTilde0, b.hTilde0));
+
+    info.seed = 1;
+    const WaveFourierData c(info, 0);
+    EXPECT(IsSameBits(a.wave, c.wave));
+    EXPECT(!IsSameBits(a.hTilde0, c.hTilde0));
+
+    // Every value is finite, and the k = 0 texel (the middle of the grid) has no amplitude.
+    bool finite = true;
+    for (const auto value : c.hTilde0) finite &= std::isfinite(value);
+    EXPECT(finite);
+    const uint32_t zero = ((info.M / 2) * info.N + (info.N / 2)) * 4;
+    EXPECT(c.wave[zero + 2] == 0.0f);
+    EXPECT(c.hTilde0[zero + 0] == 0.0f && c.hTilde0[zero + 1] == 0.0f);
+}
+
+BENCH(OceanSurface, MakeWaveFourierData) {
+    SurfaceCreateInfo info;
+    for (const uint32_t size : {256u, 512u, 1024u}) {
+        info.N = info.M = size;
+        std::vector<float> wave(size * size * 4), hTilde0(size * size * 4);
+        for (const uint32_t threadCount : {1u, 0u}) {
+            const auto ms =
+                Test::time(5, [&]() { Ocean::MakeWaveFourierData(info, wave.data(), hTilde0.data(), threadCount); });
+            printf("  %ux%u %s: %.2f ms\n", size, size, threadCount == 1 ? "1 thread" : "all threads", ms);
+        }
+    }
+}
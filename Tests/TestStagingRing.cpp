@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <Common/StagingRing.h>
+
+#include "Test.h"
+
+using Offsets = StagingRing::Offsets;
+
+// Offsets are aligned from the end of the newest allocation.
+TEST(StagingRing, Alignment) {
+    Offsets offsets;
+    offsets.reset(256);
+    vk::DeviceSize offset;
+    uint64_t ticket;
+    REQUIRE(offsets.allocate(10, StagingRing::BUFFER_ALIGNMENT, offset, ticket));
+    EXPECT(offset == 0 && ticket == 0);
+    REQUIRE(offsets.allocate(12, StagingRing::IMAGE_ALIGNMENT, offset, ticket));
+    EXPECT(offset == 48 && ticket == 1);
+    REQUIRE(offsets.allocate(1, StagingRing::BUFFER_ALIGNMENT, offset, ticket));
+    EXPECT(offset == 64 && ticket == 2);
+    REQUIRE(offsets.allocate(1, 1, offset, ticket));
+    EXPECT(offset == 65 && ticket == 3);
+    EXPECT(offsets.getPendingCount() == 4);
+}
+
+// Allocations that don't fit at the end wrap around to the front, and stop short of the oldest one in use.
+TEST(StagingRing, WrapAround) {
+    Offsets offsets;
+    offsets.reset(100);
+    vk::DeviceSize offset;
+    uint64_t a, b, ticket;
+    REQUIRE(offsets.allocate(40, 4, offset, a));
+    EXPECT(offset == 0);
+    REQUIRE(offsets.allocate(40, 4, offset, b));
+    EXPECT(offset == 40);
+    // Too big for the end, and the front is still in use.
+    EXPECT(!offsets.allocate(30, 4, offset, ticket));
+
+    offsets.release(a);
+    REQUIRE(offsets.allocate(30, 4, offset, ticket));
+    EXPECT(offset == 0);
+    // Aligned to 32, which would reach the tail at 40.
+    EXPECT(!offsets.allocate(8, 4, offset, ticket));
+    REQUIRE(offsets.allocate(4, 4, offset, ticket));
+    EXPECT(offset == 32);
+
+    // The tail moves to the end of "b", so the gap after the head grows.
+    offsets.release(b);
+    REQUIRE(offsets.allocate(40, 4, offset, ticket));
+    EXPECT(offset == 36);
+    EXPECT(!offsets.allocate(4, 4, offset, ticket));
+}
+
+// Space is only reclaimed in ticket order, so releasing out of order waits for the oldest ticket.
+TEST(StagingRing, TicketReclaim) {
+    Offsets offsets;
+    offsets.reset(64);
+    vk::DeviceSize offset;
+    uint64_t t0, t1, t2, t3, t4, ticket;
+    REQUIRE(offsets.allocate(16, 1, offset, t0));
+    REQUIRE(offsets.allocate(16, 1, offset, t1));
+    REQUIRE(offsets.allocate(16, 1, offset, t2));
+    EXPECT(t0 == 0 && t1 == 1 && t2 == 2);
+
+    offsets.release(t1);
+    EXPECT(offsets.getPendingCount() == 3);
+    REQUIRE(offsets.allocate(16, 1, offset, t3));
+    EXPECT(offset == 48 && t3 == 3);
+    // "t1" is released, but "t0" in front of it isn't.
+    EXPECT(!offsets.allocate(1, 1, offset, ticket));
+
+    offsets.release(t0);
+    EXPECT(offsets.getPendingCount() == 2);
+    EXPECT(!offsets.allocate(32, 1, offset, t4));
+    REQUIRE(offsets.allocate(16, 1, offset, t4));
+    EXPECT(offset == 0 && t4 == 4);
+
+    offsets.release(t3);
+    offsets.release(t2);
+    EXPECT(offsets.getPendingCount() == 1);
+    offsets.release(t4);
+    EXPECT(offsets.getPendingCount() == 0);
+    // Empty starts over at the front, and the tickets keep counting.
+    REQUIRE(offsets.allocate(8, 16, offset, ticket));
+    EXPECT(offset == 0 && ticket == 5);
+}
+
+// Allocations bigger than the ring, or than the space left, fail so the caller can fall back to a staging buffer.
+TEST(StagingRing, Overflow) {
+    Offsets offsets;
+    vk::DeviceSize offset;
+    uint64_t ticket;
+    // Not initialized
+    EXPECT(!offsets.allocate(1, 1, offset, ticket));
+
+    offsets.reset(64);
+    EXPECT(!offsets.allocate(65, 1, offset, ticket));
+    REQUIRE(offsets.allocate(64, 1, offset, ticket));
+    EXPECT(offset == 0);
+    EXPECT(!offsets.allocate(1, 1, offset, ticket));
+    offsets.release(ticket);
+    REQUIRE(offsets.allocate(64, 1, offset, ticket));
+
+    // Alignment past the end wraps, and then runs into the tail.
+    offsets.reset(64);
+    uint64_t first;
+    REQUIRE(offsets.allocate(8, 1, offset, first));
+    REQUIRE(offsets.allocate(40, 1, offset, ticket));
+    EXPECT(!offsets.allocate(8, 32, offset, ticket));
+    offsets.release(first);
+    EXPECT(!offsets.allocate(8, 32, offset, ticket));
+    REQUIRE(offsets.allocate(7, 32, offset, ticket));
+    EXPECT(offset == 0);
+    EXPECT(offsets.getSize() == 64);
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <CDLOD/TiledHeightmap.h>
+
+#include "Test.h"
+
+namespace {
+
+constexpr int SIZE_X = 2049, SIZE_Y = 1537, TILE_SIZE = 128;
+constexpr unsigned int SEED = 7;
+
+// Writes the synthetic raster once per test and removes it after.
+struct SyntheticFile {
+    SyntheticFile(const char* name) : path((std::filesystem::temp_directory_path() / name).string()) {
+        written = TiledHeightmap::Write(path.c_str(), SIZE_X, SIZE_Y, TILE_SIZE, [](int x, int y) {
+            return TiledHeightmap::SyntheticHeight(x, y, SEED);
+        });
+    }
+    ~SyntheticFile() { std::filesystem::remove(path); }
+    std::string path;
+    bool written;
+};
+
+}  // namespace
+
+// Sampling the whole raster through a few mapped tiles has to page tiles in and out, give the raster's heights, and
+// never map more than MaxResidentTiles.
+TEST(TiledHeightmap, PagingCeiling) {
+    constexpr int MAX_RESIDENT_TILES = 4;
+    const SyntheticFile file("GuppyTests_Paging.thm");
+    REQUIRE(file.written);
+    TiledHeightmapSource source;
+    REQUIRE(source.Create({file.path.c_str(), MAX_RESIDENT_TILES}));
+    REQUIRE(source.GetSizeX() == SIZE_X && source.GetSizeY() == SIZE_Y);
+    const auto& layout = source.GetLayout();
+
+    int maxResidentTiles = 0;
+    for (int y = 0; y < SIZE_Y; y += 37) {
+        for (int x = 0; x < SIZE_X; x += 29) {
+            EXPECT(source.GetHeightAt(x, y) == TiledHeightmap::SyntheticHeight(x, y, SEED));
+            const auto stats = source.GetStats();
+            maxResidentTiles = (std::max)(maxResidentTiles, stats.ResidentTiles);
+            EXPECT(stats.ResidentBytes <= MAX_RESIDENT_TILES * layout.TileBytes);
+        }
+    }
+    EXPECT(maxResidentTiles == MAX_RESIDENT_TILES);
+
+    // Every tile of mip 0 was visited, and all but the resident ones had to go again.
+    auto stats = source.GetStats();
+    EXPECT(stats.PageIns >= static_cast<uint64_t>(layout.TileCountX[0] * layout.TileCountY[0]));
+    EXPECT(stats.PageIns == stats.Evictions + stats.ResidentTiles);
+
+    // Areas that cut through tiles (mapped) and cover whole ones (from the min/max table).
+    std::mt19937 random(11);
+    for (int i = 0; i < 100; i++) {
+        const int x = std::uniform_int_distribution<int>(0, SIZE_X - 1)(random);
+        const int y = std::uniform_int_distribution<int>(0, SIZE_Y - 1)(random);
+        const int sizeX = std::uniform_int_distribution<int>(1, 400)(random);
+        const int sizeY = std::uniform_int_distribution<int>(1, 400)(random);
+        unsigned short minZ, maxZ, expectedMin = 65535, expectedMax = 0;
+        source.GetAreaMinMaxZ(x, y, sizeX, sizeY, minZ, maxZ);
+        for (int j = y; j < (std::min)(y + sizeY, SIZE_Y); j++) {
+            for (int k = x; k < (std::min)(x + sizeX, SIZE_X); k++) {
+                const auto height = TiledHeightmap::SyntheticHeight(k, j, SEED);
+                expectedMin = (std::min)(expectedMin, height);
+                expectedMax = (std::max)(expectedMax, height);
+            }
+        }
+        EXPECT(minZ == expectedMin && maxZ == expectedMax);
+    }
+    EXPECT(source.GetStats().ResidentTiles <= MAX_RESIDENT_TILES);
+}
+
+// A window moving over the raster: the slots hold the tiles' texels, stay within the slot count, evict what the window
+// left, and sampling falls back to coarser mips until the fine tiles are in.
+TEST(TiledHeightmap, Residency) {
+    constexpr int SLOT_COUNT = 16, MAX_UPLOADS = 4, WINDOW = 200;
+    const SyntheticFile file("GuppyTests_Residency.thm");
+    REQUIRE(file.written);
+    TiledHeightmapSource source;
+    REQUIRE(source.Create({file.path.c_str(), 2}));
+    const auto& layout = source.GetLayout();
+
+    TiledHeightmapResidency residency;
+    residency.Create(layout, SLOT_COUNT, MAX_UPLOADS);
+    EXPECT(residency.GetSlotBytes() == SLOT_COUNT * layout.TileBytes);
+
+    std::vector<TiledHeightmapResidency::Upload> uploads;
+    std::vector<unsigned short> tile(static_cast<size_t>(TILE_SIZE) * TILE_SIZE);
+    for (int step = 0; step < 40; step++) {
+        const int x = step * 45, y = step * 30;
+
+        bool allResident = false;
+        for (int frame = 0; frame < 8 && !allResident; frame++) {
+            uploads.clear();
+            residency.BeginFrame();
+            residency.RequestArea(0, x, y, WINDOW, WINDOW);
+            allResident = residency.Update(source, uploads);
+            EXPECT(static_cast<int>(uploads.size()) <= MAX_UPLOADS);
+            EXPECT(residency.GetResidentCount() <= SLOT_COUNT);
+
+            for (const auto& upload : uploads) {
+                source.CopyTile(upload.Mip, upload.TileX, upload.TileY, tile.data());
+                EXPECT(std::equal(tile.begin(), tile.end(), residency.GetSlotData(upload.Slot)));
+                EXPECT(residency.GetPageTable()[layout.GetTileIndex(upload.Mip, upload.TileX, upload.TileY)] ==
+                       upload.Slot);
+            }
+
+            // Whatever mip is resident gives that mip's point sample.
+            int mip;
+            const auto height = residency.GetHeightAt(x, y, mip);
+            const int sampleX = (std::min)((x >> mip) << mip, SIZE_X - 1);
+            const int sampleY = (std::min)((y >> mip) << mip, SIZE_Y - 1);
+            EXPECT(height == TiledHeightmap::SyntheticHeight(sampleX, sampleY, SEED));
+        }
+        REQUIRE(allResident);
+
+        int mip;
+        const int sampleX = x + WINDOW / 2, sampleY = y + WINDOW / 2;
+        EXPECT(residency.GetHeightAt(sampleX, sampleY, mip) == TiledHeightmap::SyntheticHeight(sampleX, sampleY, SEED));
+        EXPECT(mip == 0);
+    }
+    EXPECT(residency.GetEvictionCount() > 0);
+    EXPECT(source.GetStats().ResidentTiles <= 2);
+}
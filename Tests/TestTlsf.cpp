@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <Common/MemoryAllocator.h>
+
+#include "Test.h"
+
+using Memory::Tlsf;
+
+namespace {
+bool FreeRanges(const Tlsf& tlsf, const uint32_t count, const vk::DeviceSize largest) {
+    uint32_t freeCount;
+    vk::DeviceSize freeLargest;
+    tlsf.getFreeRanges(freeCount, freeLargest);
+    return freeCount == count && freeLargest == largest;
+}
+}  // namespace
+
+// The range found is split, and the rest stays free at the end.
+TEST(Tlsf, Split) {
+    Tlsf tlsf(1024);
+    vk::DeviceSize a, b, c;
+    REQUIRE(tlsf.allocate(100, 1, a));
+    REQUIRE(tlsf.allocate(200, 1, b));
+    REQUIRE(tlsf.allocate(24, 1, c));
+    EXPECT(a == 0 && b == 100 && c == 300);
+    EXPECT(tlsf.getUsedSize() == 324 && tlsf.getAllocationCount() == 3);
+    EXPECT(FreeRanges(tlsf, 1, 700));
+
+    // Exactly what is left.
+    vk::DeviceSize d;
+    REQUIRE(tlsf.allocate(700, 1, d));
+    EXPECT(d == 324 && tlsf.getUsedSize() == 1024);
+    EXPECT(FreeRanges(tlsf, 0, 0));
+    EXPECT(!tlsf.allocate(1, 1, d));
+    EXPECT(!tlsf.allocate(2048, 1, d));
+}
+
+/*  A resource aligned to "bufferImageGranularity" starts on the next page, and the padding in front of it goes back in
+    the free lists for smaller resources.
+*/
+TEST(Tlsf, GranularitySplit) {
+    constexpr vk::DeviceSize GRANULARITY = 1024;
+    Tlsf tlsf(8 * GRANULARITY);
+    vk::DeviceSize buffer, image, small;
+    REQUIRE(tlsf.allocate(100, 16, buffer));
+    REQUIRE(tlsf.allocate(GRANULARITY, GRANULARITY, image));
+    EXPECT(buffer == 0 && image == GRANULARITY);
+    EXPECT(image % GRANULARITY == 0);
+    EXPECT(FreeRanges(tlsf, 2, 6 * GRANULARITY));
+
+    // The padding between the two is used before the end.
+    REQUIRE(tlsf.allocate(512, 4, small));
+    EXPECT(small == 100);
+    EXPECT(FreeRanges(tlsf, 2, 6 * GRANULARITY));
+
+    // The padding merges back when the image is freed.
+    tlsf.free(small);
+    tlsf.free(image);
+    EXPECT(FreeRanges(tlsf, 1, 8 * GRANULARITY - 100));
+}
+
+// Offsets are multiples of the alignment (ex. "nonCoherentAtomSize", so flushed ranges don't touch a neighbour's atom).
+TEST(Tlsf, AtomAlignment) {
+    constexpr vk::DeviceSize ATOM_SIZE = 64;
+    Tlsf tlsf(4096);
+    vk::DeviceSize offset;
+    std::vector<vk::DeviceSize> offsets;
+    for (const vk::DeviceSize size : {1, 63, 64, 65, 3, 200}) {
+        REQUIRE(tlsf.allocate(size, ATOM_SIZE, offset));
+        EXPECT(offset % ATOM_SIZE == 0);
+        offsets.push_back(offset);
+    }
+    EXPECT(offsets == std::vector<vk::DeviceSize>({0, 64, 128, 192, 320, 384}));
+    // Only the sizes asked for are used, the padding is free.
+    EXPECT(tlsf.getUsedSize() == 1 + 63 + 64 + 65 + 3 + 200);
+
+    // The search allows for the worst case of padding, so a range that would fit aligned isn't found.
+    Tlsf exact(256);
+    EXPECT(!exact.allocate(256, ATOM_SIZE, offset));
+    REQUIRE(exact.allocate(256 - ATOM_SIZE + 1, ATOM_SIZE, offset));
+    EXPECT(offset == 0);
+}
+
+// Freed ranges merge with free neighbours on both sides, in any order, back to a single range.
+TEST(Tlsf, FreeCoalesce) {
+    Tlsf tlsf(1000);
+    std::vector<vk::DeviceSize> offsets(10);
+    for (auto& offset : offsets) REQUIRE(tlsf.allocate(100, 1, offset));
+    EXPECT(FreeRanges(tlsf, 0, 0));
+
+    // Every other one: nothing to merge with.
+    for (size_t i = 1; i < offsets.size(); i += 2) tlsf.free(offsets[i]);
+    EXPECT(FreeRanges(tlsf, 5, 100));
+    EXPECT(tlsf.getAllocationCount() == 5 && tlsf.getUsedSize() == 500);
+
+    // Merges with the range behind, and in front.
+    tlsf.free(offsets[4]);
+    EXPECT(FreeRanges(tlsf, 4, 300));
+    // The first range merges forward.
+    tlsf.free(offsets[0]);
+    EXPECT(FreeRanges(tlsf, 4, 300));
+
+    // The merged range can be allocated in one piece, and split again.
+    vk::DeviceSize offset;
+    REQUIRE(tlsf.allocate(300, 1, offset));
+    EXPECT(offset == 300);
+    tlsf.free(offset);
+
+    tlsf.free(offsets[8]);
+    tlsf.free(offsets[2]);
+    tlsf.free(offsets[6]);
+    EXPECT(tlsf.empty() && tlsf.getUsedSize() == 0);
+    EXPECT(FreeRanges(tlsf, 1, 1000));
+    REQUIRE(tlsf.allocate(1000, 1, offset));
+    EXPECT(offset == 0);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "Test.h"
+
+namespace {
+uint32_t failureCount = 0;
+}  // namespace
+
+std::vector<Test::Case> &Test::getCases() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void Test::fail(const char *file, const int line, const char *expr) {
+    failureCount++;
+    printf("  %s(%d): failed: %s\n", file, line, expr);
+}
+
+// Usage: GuppyTests [suite] [--bench]
+int main(int argc, char *argv[]) {
+    const char *suite = nullptr;
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else
+            suite = argv[i];
+    }
+
+    uint32_t runCount = 0, failedCount = 0;
+    for (const auto &testCase : Test::getCases()) {
+        if (testCase.bench != bench) continue;
+        if (suite && strcmp(suite, testCase.suite) != 0) continue;
+
+        printf("[ RUN  ] %s.%s\n", testCase.suite, testCase.name);
+        fflush(stdout);
+        const auto failuresBefore = failureCount;
+        testCase.pFunc();
+        runCount++;
+        if (failureCount != failuresBefore) {
+            failedCount++;
+            printf("[ FAIL ] %s.%s\n", testCase.suite, testCase.name);
+        } else {
+            printf("[  OK  ] %s.%s\n", testCase.suite, testCase.name);
+        }
+    }
+
+    if (runCount == 0) {
+        printf("No tests matched \"%s\"\n", suite ? suite : "");
+        return 1;
+    }
+    printf("%u of %u passed\n", runCount - failedCount, runCount);
+    return failedCount ? 1 : 0;
+}
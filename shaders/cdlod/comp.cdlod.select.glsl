@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#version 450
+
+#define _DS_CDLOD_SELECT 0
+
+// CDLOD LOD selection (see CDLODGPUSelection.h for the passes, and the layouts
+// of the buffers below). The node tests are the same operations in the same
+// order as CDLODQuadTree::LODSelectTestNodes.
+
+const uint PASS_CLEAR       = 0;
+const uint PASS_SEED        = 1;
+const uint PASS_TRAVERSE    = 2;
+const uint PASS_LAYOUT      = 3;
+const uint PASS_WRITE       = 4;
+
+const uint MAX_LOD_LEVELS = 15;
+const uint QUADRANT_RUN_COUNT = 10;
+const uint BATCH_COUNT = MAX_LOD_LEVELS * QUADRANT_RUN_COUNT;
+const uint QUADRANT_RUN_OFFSETS[4] = uint[4](0, 4, 7, 9);
+
+layout(push_constant) uniform PushBlock {
+    uint pass;
+    uint level;  // tree level (PASS_TRAVERSE)
+} pc;
+
+// BINDINGS
+layout(set=_DS_CDLOD_SELECT, binding=0) uniform CdlodSelection {
+    vec4 frustumPlanes[6];
+    vec4 observerPos;
+    vec4 mapMin;
+    vec4 mapSize;
+    ivec4 data0;                    // .x (raster size x), .y (raster size y), .z (LOD level count), .w (top node size)
+    ivec4 data1;                    // .x (top node count x), .y (top node count y), .z (max selection count)
+                                    // .w (max queue count)
+    ivec4 levels[MAX_LOD_LEVELS];   // .x (node data offset), .y (node count x), .z (node count y)
+    vec4 lodRanges[MAX_LOD_LEVELS]; // .x (visibility range)
+    uvec4 indices;                  // .x (indices per quadrant), .y (first index of TR), .z (of BL), .w (of BR)
+} sel;
+layout(set=_DS_CDLOD_SELECT, binding=1) buffer readonly CdlodNodes {
+    uint nodes[];  // MinZ | MaxZ << 16
+};
+layout(set=_DS_CDLOD_SELECT, binding=2, std430) buffer CdlodWork {
+    uint queueCounts[16];
+    uint selectedCount;
+    uint pad[3];
+    uint batchCounts[BATCH_COUNT];
+    uint batchCursors[BATCH_COUNT];
+    uvec4 entries[];  // queue 0, queue 1, selected
+} work;
+struct DrawIndexedIndirectCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+layout(set=_DS_CDLOD_SELECT, binding=3, std430) buffer writeonly CdlodIndirect {
+    DrawIndexedIndirectCommand commands[BATCH_COUNT];  // packed by LOD level
+    uint drawCounts[MAX_LOD_LEVELS];                   // by LOD level
+};
+struct Instance {
+    vec4 data0;
+    vec4 data1;
+};
+layout(set=_DS_CDLOD_SELECT, binding=4, std430) buffer writeonly CdlodInstances {
+    Instance instances[];
+};
+
+// IN
+layout(local_size_x=64) in;
+
+struct TestResult {
+    bool outside;
+    uint insidePlaneMask;
+    bool inRange;
+    bool inNextRange;
+};
+
+void getNodeAABB(const in uint level, const in uint x, const in uint y, out vec3 bMin, out vec3 bMax) {
+    int size = sel.data0.w >> level;
+    uint node = nodes[uint(sel.levels[level].x) + y * uint(sel.levels[level].y) + x];
+    int X = int(x) * size, Y = int(y) * size;
+    float rasterX = float(sel.data0.x - 1), rasterY = float(sel.data0.y - 1);
+    precise float minX = sel.mapMin.x + float(X) * sel.mapSize.x / rasterX;
+    precise float maxX = sel.mapMin.x + float(X + size) * sel.mapSize.x / rasterX;
+    precise float minY = sel.mapMin.y + float(Y) * sel.mapSize.y / rasterY;
+    precise float maxY = sel.mapMin.y + float(Y + size) * sel.mapSize.y / rasterY;
+    precise float minZ = sel.mapMin.z + float(node & 0xFFFF) * sel.mapSize.z / 65535.0;
+    precise float maxZ = sel.mapMin.z + float(node >> 16) * sel.mapSize.z / 65535.0;
+    bMin = vec3(minX, minY, minZ);
+    bMax = vec3(maxX, maxY, maxZ);
+}
+
+float planeDistance(const in vec4 plane, const in vec3 p) {
+    precise float d = (plane.x * p.x + plane.y * p.y) + (plane.z * p.z + plane.w);
+    return d;
+}
+
+TestResult testNode(const in uint level, const in vec3 b0, const in vec3 b1, const in uint parentInsidePlaneMask) {
+    TestResult result;
+    result.outside = false;
+    result.insidePlaneMask = parentInsidePlaneMask;
+
+    // Frustum
+    precise vec3 c = (b0 + b1) * 0.5;
+    precise vec3 s = b1 - b0;
+    precise float negHalfSize = (sqrt((s.x * s.x + s.y * s.y) + s.z * s.z) * -1.0) / 2.0;
+    for (uint p = 0; p < 6; p++) {
+        if ((parentInsidePlaneMask & (1u << p)) != 0) continue;
+
+        vec4 plane = sel.frustumPlanes[p];
+        float centDist = planeDistance(plane, c);
+        result.outside = result.outside || (centDist < negHalfSize);
+
+        // 8 corners and the center
+        float dists[9] = float[9](
+            planeDistance(plane, vec3(b0.x, b0.y, b0.z)), planeDistance(plane, vec3(b1.x, b0.y, b0.z)),
+            planeDistance(plane, vec3(b0.x, b1.y, b0.z)), planeDistance(plane, vec3(b1.x, b1.y, b0.z)),
+            planeDistance(plane, vec3(b0.x, b0.y, b1.z)), planeDistance(plane, vec3(b1.x, b0.y, b1.z)),
+            planeDistance(plane, vec3(b0.x, b1.y, b1.z)), planeDistance(plane, vec3(b1.x, b1.y, b1.z)),
+            centDist
+        );
+        bool anyOut = false, allOut = true;
+        for (uint i = 0; i < 9; i++) {
+            anyOut = anyOut || (dists[i] < 0.0);
+            allOut = allOut && (dists[i] < 0.0);
+        }
+        result.outside = result.outside || allOut;
+        if (!anyOut) result.insidePlaneMask |= 1u << p;
+    }
+
+    // Range
+    vec3 o = sel.observerPos.xyz;
+    precise vec3 d = max(max(b0 - o, o - b1), vec3(0.0));
+    precise float distSq = (d.x * d.x + d.y * d.y) + d.z * d.z;
+    precise float range = sel.lodRanges[level].x;
+    result.inRange = distSq <= range * range;
+    result.inNextRange = false;
+    if (level != uint(sel.data0.z - 1)) {
+        precise float nextRange = sel.lodRanges[level + 1].x;
+        result.inNextRange = distSq <= nextRange * nextRange;
+    }
+    return result;
+}
+
+void enqueue(const in uint level, const in uint x, const in uint y, const in TestResult result) {
+    uint maxQueueCount = uint(sel.data1.w);
+    uint index = atomicAdd(work.queueCounts[level], 1);
+    if (index >= maxQueueCount) return;  // dropped
+    work.entries[(level & 1) * maxQueueCount + index] =
+        uvec4(x, y, level, result.insidePlaneMask | (result.inNextRange ? 1u << 8 : 0u));
+}
+
+void selectNode(const in uvec4 entry, const in uint quadrantMask) {
+    uint maxSelectionCount = uint(sel.data1.z);
+    uint index = atomicAdd(work.selectedCount, 1);
+    if (index >= maxSelectionCount) return;  // dropped
+    work.entries[2 * uint(sel.data1.w) + index] = uvec4(entry.xyz, quadrantMask);
+
+    uint LODLevel = uint(sel.data0.z - 1) - entry.z;
+    for (uint q = 0; q < 4;) {
+        if ((quadrantMask & (1u << q)) == 0) {
+            q++;
+            continue;
+        }
+        uint count = 1;
+        while (q + count < 4 && (quadrantMask & (1u << (q + count))) != 0) count++;
+        atomicAdd(work.batchCounts[LODLevel * QUADRANT_RUN_COUNT + QUADRANT_RUN_OFFSETS[q] + count - 1], 1);
+        q += count;
+    }
+}
+
+void clear() {
+    uint i = gl_LocalInvocationIndex;
+    if (i < 16) work.queueCounts[i] = 0;
+    if (i == 0) work.selectedCount = 0;
+    for (; i < BATCH_COUNT; i += gl_WorkGroupSize.x) {
+        work.batchCounts[i] = 0;
+        work.batchCursors[i] = 0;
+    }
+}
+
+void seed() {
+    uint i = gl_GlobalInvocationID.x;
+    uint countX = uint(sel.data1.x);
+    if (i >= countX * uint(sel.data1.y)) return;
+
+    uint x = i % countX, y = i / countX;
+    vec3 b0, b1;
+    getNodeAABB(0, x, y, b0, b1);
+    TestResult result = testNode(0, b0, b1, 0);
+    if (!result.outside && result.inRange) enqueue(0, x, y, result);
+}
+
+void traverse() {
+    uint level = pc.level;
+    uint count = min(work.queueCounts[level], uint(sel.data1.w));
+    if (gl_GlobalInvocationID.x >= count) return;
+
+    uvec4 entry = work.entries[(level & 1) * uint(sel.data1.w) + gl_GlobalInvocationID.x];
+    uint quadrantMask = 0xF;  // TL, TR, BL, BR
+
+    if (level != uint(sel.data0.z - 1) && (entry.w & (1u << 8)) != 0) {
+        ivec4 next = sel.levels[level + 1];
+        for (uint i = 0; i < 4; i++) {
+            uint cx = 2 * entry.x + (i & 1), cy = 2 * entry.y + (i >> 1);
+            if (cx >= uint(next.y) || cy >= uint(next.z)) continue;
+
+            vec3 b0, b1;
+            getNodeAABB(level + 1, cx, cy, b0, b1);
+            TestResult result = testNode(level + 1, b0, b1, entry.w & 0x3F);
+            // Out of frustum, or in range so the child (or its children) draws it. Out of range is ours to draw.
+            if (result.outside) {
+                quadrantMask &= ~(1u << i);
+            } else if (result.inRange) {
+                quadrantMask &= ~(1u << i);
+                enqueue(level + 1, cx, cy, result);
+            }
+        }
+    }
+
+    if (quadrantMask != 0) selectNode(entry, quadrantMask);
+}
+
+// The instances are laid out by batch. The draws of the batches that have instances are packed at the front of their
+// LOD level's commands, and the rest of the level's commands draw nothing.
+void layoutBatches() {
+    if (gl_GlobalInvocationID.x != 0) return;
+
+    const uint firstIndices[4] = uint[4](0, sel.indices.y, sel.indices.z, sel.indices.w);
+    uint firstInstance = 0;
+    for (uint LODLevel = 0; LODLevel < MAX_LOD_LEVELS; LODLevel++) {
+        uint drawCount = 0;
+        for (uint q = 0; q < 4; q++) {
+            for (uint count = 1; q + count <= 4; count++) {
+                uint batch = LODLevel * QUADRANT_RUN_COUNT + QUADRANT_RUN_OFFSETS[q] + count - 1;
+                uint instanceCount = work.batchCounts[batch];
+                work.batchCursors[batch] = firstInstance;
+                if (instanceCount == 0) continue;
+
+                DrawIndexedIndirectCommand command;
+                command.indexCount = sel.indices.x * count;
+                command.instanceCount = instanceCount;
+                command.firstIndex = firstIndices[q];
+                command.vertexOffset = 0;
+                command.firstInstance = firstInstance;
+                commands[LODLevel * QUADRANT_RUN_COUNT + drawCount++] = command;
+                firstInstance += instanceCount;
+            }
+        }
+        for (uint i = drawCount; i < QUADRANT_RUN_COUNT; i++)
+            commands[LODLevel * QUADRANT_RUN_COUNT + i] = DrawIndexedIndirectCommand(0, 0, 0, 0, 0);
+        drawCounts[LODLevel] = drawCount;
+    }
+}
+
+void writeInstances() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= min(work.selectedCount, uint(sel.data1.z))) return;
+
+    uvec4 entry = work.entries[2 * uint(sel.data1.w) + i];
+    vec3 b0, b1;
+    getNodeAABB(entry.z, entry.x, entry.y, b0, b1);
+
+    Instance instance;
+    instance.data0 = vec4(b0.x, b0.y, b1.x - b0.x, b1.y - b0.y);
+    instance.data1 = vec4((b0.z + b1.z) * 0.5, float(entry.w), 0.0, 0.0);
+
+    uint LODLevel = uint(sel.data0.z - 1) - entry.z;
+    for (uint q = 0; q < 4;) {
+        if ((entry.w & (1u << q)) == 0) {
+            q++;
+            continue;
+        }
+        uint count = 1;
+        while (q + count < 4 && (entry.w & (1u << (q + count))) != 0) count++;
+        uint batch = LODLevel * QUADRANT_RUN_COUNT + QUADRANT_RUN_OFFSETS[q] + count - 1;
+        instances[atomicAdd(work.batchCursors[batch], 1)] = instance;
+        q += count;
+    }
+}
+
+void main() {
+    switch (pc.pass) {
+        case PASS_CLEAR:    clear();            break;
+        case PASS_SEED:     seed();             break;
+        case PASS_TRAVERSE: traverse();         break;
+        case PASS_LAYOUT:   layoutBatches();    break;
+        case PASS_WRITE:    writeInstances();   break;
+    }
+}
@@ -30,15 +30,19 @@ layout(push_constant) uniform PushBlock {
     vec4 data0;  // gridDim:         .x (dimension), .y (dimension/2), .z (2/dimension)
                  //                  .w (LODLevel)
     vec4 data1;  // morph constants: .x (start), .y (1/(end-start)), .z (end/(end-start))
-                 //                  .w ((aabb.minZ+aabb.maxZ)/2)
-    vec4 data2;  // quadOffset:      .x (aabb.minX), .y (aabb.minY)
-                 // quadScale:       .z (aabb.sizeX), .w (aabb.sizeY)
+    vec4 data2;  // unused (the quad offset/scale are per instance)
     vec4 data3;  // dbg camera:      .x (wpos.x), .y (wpos.y), .z (wpos.z)
 } pc;
 
-#define QUAD_OFFSET_V4 vec4(pc.data2.x, pc.data2.y, pc.data1.w, 0.0)
+// IN (per instance)
+layout(location=1) in vec4 inQuadData0;  // quadOffset:      .x (aabb.minX), .y (aabb.minY)
+                                         // quadScale:       .z (aabb.sizeX), .w (aabb.sizeY)
+layout(location=2) in vec4 inQuadData1;  // quadOffset:      .x ((aabb.minZ+aabb.maxZ)/2)
+                                         // quadrant mask:   .y (TL 1, TR 2, BL 4, BR 8)
+
+#define QUAD_OFFSET_V4 vec4(inQuadData0.x, inQuadData0.y, inQuadData1.x, 0.0)
 // I believe the zw components are always multiplied by 0 but I'll just make it the same as it was. CH
-#define QUAD_SCALE_V4  vec4(pc.data2.z, pc.data2.w, pc.data0.w, 0.0)
+#define QUAD_SCALE_V4  vec4(inQuadData0.z, inQuadData0.w, pc.data0.w, 0.0)
 
 // struct FixedVertexOutput
 // {
@@ -90,7 +94,7 @@ vec2 morphVertex( vec4 inPos, vec2 vertex, float morphLerpK )
     // vec2 fracPart = (frac( inPos.xy * vec2(g_gridDim.y, g_gridDim.y) ) * vec2(g_gridDim.z, g_gridDim.z) ) * g_quadScale.xy;
     vec2 fracPart = (fract( inPos.xy * vec2(pc.data0.y, pc.data0.y) ) *
                      vec2(pc.data0.z, pc.data0.z) ) *
-                    pc.data2.zw;
+                    inQuadData0.zw;
     return vertex.xy - fracPart * morphLerpK;
 }
 
@@ -6,10 +6,11 @@
 #version 450
 
 #define _DS_OCEAN 0
-#define _LS_X 1
 
 #define complexMul(a, b) vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x)
 
+// SPECIALIZATION
+// constant_id = 0: local_size_x
 // PUSH CONSTANTS
 layout(push_constant) uniform PushBlock {
     int rowColOffset;
@@ -17,7 +18,7 @@ layout(push_constant) uniform PushBlock {
 // BINDINGS
 layout(set=_DS_OCEAN, binding=0) uniform SimulationDispatch {
     vec4 data0;   // [0] horizontal displacement scale factor
-                  // [1] time
+                  // [1] unused (time is a dispersion push constant)
                   // [2] grid scale (Lx)
                   // [3] grid scale (Lz)
     uvec2 data1;  // [0] log2 of discrete dimension N
@@ -26,12 +27,11 @@ layout(set=_DS_OCEAN, binding=0) uniform SimulationDispatch {
 layout(set=_DS_OCEAN, binding=2, rgba32f) uniform image2DArray imgDisp;
 layout(set=_DS_OCEAN, binding=5) uniform samplerBuffer sampTwiddle;
 // IN
-layout(local_size_x=_LS_X) in;
+layout(local_size_x_id=0) in;
 
 const float PI = 3.14159265358979323846;
 const int LAYER_HEIGHT          = 0;
-const int LAYER_SLOPE           = 1;
-const int LAYER_DIFFERENTIAL    = 2;
+const int LAYER_DIFFERENTIAL    = 1;
 
 void transform2(const ivec2 pixA, const ivec2 pixB, const vec2 w, const in int layer) {
     vec2 t0 = complexMul(w, imageLoad(imgDisp, ivec3(pixB, layer)).rg);
@@ -68,7 +68,6 @@ void main() {
                 pixA[offset] = k;
                 pixB[offset] = k + m2;
                 transform2(pixA, pixB, twiddle, LAYER_HEIGHT);
-                transform4(pixA, pixB, twiddle, LAYER_SLOPE);
                 transform4(pixA, pixB, twiddle, LAYER_DIFFERENTIAL);
             }
         }
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#version 450
+
+#define _DS_OCEAN 0
+
+#define complexMul(a, b) vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x)
+#define complexMul2(w, b) vec4(complexMul(w, b.xy), complexMul(w, b.zw))
+// Multiply by i (the fourth root of unity for the inverse transform)
+#define mulI(a) vec2(-a.y, a.x)
+#define mulI2(a) vec4(-a.y, a.x, -a.w, a.z)
+
+// SPECIALIZATION
+// constant_id = 0: local_size_x (SIZE / 4)
+layout(constant_id = 1) const int SIZE = 256;  // largest dimension (max(N, M))
+// PUSH CONSTANTS
+layout(push_constant) uniform PushBlock {
+    int rowColOffset;
+} pc;
+// BINDINGS
+layout(set=_DS_OCEAN, binding=0) uniform SimulationDispatch {
+    vec4 data0;   // [0] horizontal displacement scale factor
+                  // [1] unused (time is a dispersion push constant)
+                  // [2] grid scale (Lx)
+                  // [3] grid scale (Lz)
+    uvec2 data1;  // [0] log2 of discrete dimension N
+                  // [1] log2 of discrete dimension M
+} sim;
+layout(set=_DS_OCEAN, binding=2, rgba32f) uniform image2DArray imgDisp;
+layout(set=_DS_OCEAN, binding=5) uniform samplerBuffer sampTwiddle;
+// IN
+layout(local_size_x_id=0) in;
+
+const int LAYER_HEIGHT          = 0;
+const int LAYER_DIFFERENTIAL    = 1;
+
+// One row/column of the height (one complex value) and the differentials (two complex values)
+shared vec2 sHeight[SIZE];
+shared vec4 sDiff[SIZE];
+// exp(i * 2 * PI * t / n) for t < n / 2
+shared vec2 sTwiddle[SIZE / 2];
+
+// exp(i * 2 * PI * t / n) for t < n. The second half of the circle is the negated first half.
+vec2 twiddle(const int t, const int n) {
+    const int halfN = n >> 1;
+    return (t < halfN) ? sTwiddle[t] : -sTwiddle[t - halfN];
+}
+
+void main() {
+    const int lid = int(gl_LocalInvocationID.x);
+    const int threads = int(gl_WorkGroupSize.x);
+
+    // Each workgroup transforms one row (or column). The push constant is the component that picks the line, so the
+    // transform runs along the other one.
+    const int axis = pc.rowColOffset ^ 1;
+    const int n = imageSize(imgDisp)[axis];
+    const int log2n = int(sim.data1[axis]);
+    ivec2 pix;
+    pix[pc.rowColOffset] = int(gl_WorkGroupID.x);
+
+    // Load the line, and the twiddles for its length (the last stage of the radix-2 twiddle table).
+    for (int i = lid; i < n; i += threads) {
+        pix[axis] = i;
+        sHeight[i] = imageLoad(imgDisp, ivec3(pix, LAYER_HEIGHT)).xy;
+        sDiff[i] = imageLoad(imgDisp, ivec3(pix, LAYER_DIFFERENTIAL));
+    }
+    for (int t = lid; t < (n >> 1); t += threads) sTwiddle[t] = texelFetch(sampTwiddle, (n >> 1) - 1 + t).rg;
+    barrier();
+
+    /* Radix-4 Stockham stages. Every stage reads its inputs a quarter of the line apart and writes them out sorted, so the
+     * input doesn't need a bit reversal and the output comes out in natural order. "ns" is the size of the sub-transforms
+     * done so far. The values are kept in registers across the barrier so the stage can write back to the same arrays.
+     */
+    const int q = n >> 2;
+    int ns = 1;
+    for (int s = 0; s < (log2n >> 1); s++) {
+        vec2 h[4];
+        vec4 d[4];
+        const int k = lid & (ns - 1);
+        if (lid < q) {
+            const int step = n / (ns << 2);
+            for (int r = 0; r < 4; r++) {
+                const vec2 w = twiddle(k * r * step, n);
+                h[r] = complexMul(w, sHeight[lid + (r * q)]);
+                d[r] = complexMul2(w, sDiff[lid + (r * q)]);
+            }
+        }
+        barrier();
+        if (lid < q) {
+            const int dst = ((lid - k) << 2) + k;
+            sHeight[dst + (0 * ns)] = (h[0] + h[2]) + (h[1] + h[3]);
+            sHeight[dst + (1 * ns)] = (h[0] - h[2]) + mulI(vec2(h[1] - h[3]));
+            sHeight[dst + (2 * ns)] = (h[0] + h[2]) - (h[1] + h[3]);
+            sHeight[dst + (3 * ns)] = (h[0] - h[2]) - mulI(vec2(h[1] - h[3]));
+            sDiff[dst + (0 * ns)] = (d[0] + d[2]) + (d[1] + d[3]);
+            sDiff[dst + (1 * ns)] = (d[0] - d[2]) + mulI2(vec4(d[1] - d[3]));
+            sDiff[dst + (2 * ns)] = (d[0] + d[2]) - (d[1] + d[3]);
+            sDiff[dst + (3 * ns)] = (d[0] - d[2]) - mulI2(vec4(d[1] - d[3]));
+        }
+        barrier();
+        ns <<= 2;
+    }
+
+    // Radix-2 tail for odd powers of two. The sub-transforms are half the line here, so each butterfly writes back to the
+    // same two elements it reads.
+    if ((log2n & 1) != 0) {
+        const int halfN = n >> 1;
+        for (int j = lid; j < halfN; j += threads) {
+            const vec2 w = sTwiddle[j];
+            const vec2 h0 = sHeight[j], h1 = complexMul(w, sHeight[j + halfN]);
+            const vec4 d0 = sDiff[j], d1 = complexMul2(w, sDiff[j + halfN]);
+            sHeight[j] = h0 + h1;
+            sHeight[j + halfN] = h0 - h1;
+            sDiff[j] = d0 + d1;
+            sDiff[j + halfN] = d0 - d1;
+        }
+        barrier();
+    }
+
+    for (int i = lid; i < n; i += threads) {
+        pix[axis] = i;
+        imageStore(imgDisp, ivec3(pix, LAYER_HEIGHT), vec4(sHeight[i], 0, 0));
+        imageStore(imgDisp, ivec3(pix, LAYER_DIFFERENTIAL), sDiff[i]);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 Colin Hughes <colin.s.hughes@gmail.com>
+ * All Rights Reserved
+ */
+
+#version 450
+
+#define _DS_OCEAN 0
+
+// SPECIALIZATION
+// constant_id = 0: local_size_x
+// constant_id = 1: local_size_y
+// BINDINGS
+layout(set=_DS_OCEAN, binding=0) uniform SimulationDispatch {
+    vec4 data0;   // [0] horizontal displacement scale factor
+                  // [1] unused (time is a dispersion push constant)
+                  // [2] grid scale (Lx)
+                  // [3] grid scale (Lz)
+    uvec2 data1;  // [0] log2 of discrete dimension N
+                  // [1] log2 of discrete dimension M
+} sim;
+layout(set=_DS_OCEAN, binding=6, rgba32f) uniform image2DArray imgVertInput;
+// IN
+layout(local_size_x_id=0, local_size_y_id=1) in;
+
+// Vertex shader input image layers
+const int INPUT_LAYER_POSITION       = 0;
+const int INPUT_LAYER_NORMAL         = 1;
+
+void main() {
+    const ivec2 pix = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 size = imageSize(imgVertInput).xy;
+
+    // The surface tiles, so the neighbors of the edge texels wrap around.
+    const int x0 = (pix.x + size.x - 1) % size.x, x1 = (pix.x + 1) % size.x;
+    const int z0 = (pix.y + size.y - 1) % size.y, z1 = (pix.y + 1) % size.y;
+
+    // Positions (.x: x displacement, .y: z displacement, .z: height)
+    const vec3 left  = imageLoad(imgVertInput, ivec3(x0, pix.y, INPUT_LAYER_POSITION)).xyz;
+    const vec3 right = imageLoad(imgVertInput, ivec3(x1, pix.y, INPUT_LAYER_POSITION)).xyz;
+    const vec3 back  = imageLoad(imgVertInput, ivec3(pix.x, z0, INPUT_LAYER_POSITION)).xyz;
+    const vec3 front = imageLoad(imgVertInput, ivec3(pix.x, z1, INPUT_LAYER_POSITION)).xyz;
+
+    // Central differences of the displaced surface (x, height, z) across two grid cells.
+    const vec3 dPdx = vec3((2.0 * sim.data0[2]) + (right.x - left.x), right.z - left.z, right.y - left.y);
+    const vec3 dPdz = vec3(front.x - back.x, front.z - back.z, (2.0 * sim.data0[3]) + (front.y - back.y));
+
+    // Normal of the displaced surface (y up)
+    const vec3 normal = normalize(cross(dPdz, dPdx));
+
+    // Jacobian determinant of the horizontal displacement. It is 1 for a flat surface, drops toward 0 where the choppy
+    // displacement squeezes the surface together, and goes negative where the surface folds over itself (whitecaps).
+    const float jacobian = ((dPdx.x * dPdz.z) - (dPdz.x * dPdx.z)) / (4.0 * sim.data0[2] * sim.data0[3]);
+
+    imageStore(imgVertInput, ivec3(pix, INPUT_LAYER_NORMAL), vec4(normal, jacobian));
+}
\ No newline at end of file
@@ -6,13 +6,14 @@
 #version 450
 
 #define _DS_OCEAN 0
-#define _LS_X 1
-#define _LS_Y 1
 
+// SPECIALIZATION
+// constant_id = 0: local_size_x
+// constant_id = 1: local_size_y
 // BINDINGS
 layout(set=_DS_OCEAN, binding=0) uniform SimulationDraw {
     vec4 data0;   // [0] horizontal displacement scale factor
-                  // [1] time
+                  // [1] unused (time is a dispersion push constant)
                   // [2] grid scale (Lx)
                   // [3] grid scale (Lz)
     uvec2 data1;  // [0] log2 of discrete dimension N
@@ -21,15 +22,13 @@ layout(set=_DS_OCEAN, binding=0) uniform SimulationDraw {
 layout(set=_DS_OCEAN, binding=2, rgba32f) uniform image2DArray imgDisp;
 layout(set=_DS_OCEAN, binding=6, rgba32f) uniform writeonly image2DArray imgVertInput;
 // IN
-layout(local_size_x=_LS_X, local_size_y=_LS_Y) in;
+layout(local_size_x_id=0, local_size_y_id=1) in;
 
 // Dispersion relation image layers
 const int DISP_LAYER_HEIGHT          = 0;
-const int DISP_LAYER_SLOPE           = 1;
-const int DISP_LAYER_DIFFERENTIAL    = 2;
-// Vertex shader input image layers
+const int DISP_LAYER_DIFFERENTIAL    = 1;
+// Vertex shader input image layers (the normal layer is written by the normal pass)
 const int INPUT_LAYER_POSITION       = 0;
-const int INPUT_LAYER_NORMAL         = 1;
 
 #define DEBUG 0
 
@@ -54,12 +53,6 @@ void main() {
     );
     position.z = flipSign ? -position.z : position.z;
 
-    // Normal
-    vec3 normal = imageLoad(imgDisp, ivec3(pix, DISP_LAYER_SLOPE)).xyz;
-    normal = flipSign ? -normal : normal;
-    normal = normalize(vec3(-normal.x, 1.0, -normal.z));
-
     imageStore(imgVertInput, ivec3(pix, INPUT_LAYER_POSITION), vec4(position, 1));
-    imageStore(imgVertInput, ivec3(pix, INPUT_LAYER_NORMAL),   vec4(normal, 0));
 #endif
 }
\ No newline at end of file
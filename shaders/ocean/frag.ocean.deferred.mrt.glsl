@@ -22,6 +22,7 @@ layout(set=_DS_OCEAN, binding=0) uniform CameraDefaultPerspective {
 
 // IN
 layout(location=0) in vec3 inPosition;
+layout(location=2) in vec4 inColor;  // .w: jacobian determinant (same declaration as link.color.frag)
 
 // OUT
 layout(location=0) out vec4 outPosition;
@@ -43,6 +44,8 @@ const vec3 sky = vec3(0.69, 0.84, 1.0);         // TODO: use material Ka? (This
 const vec3 air = vec3(0.1, 0.1, 0.1);           // TODO: use material Ks?
 const float nSnell = 1.34;                      // TODO: uniform
 const float Kdiffuse = 0.91;                    // TODO: uniform
+const vec3 foam = vec3(0.9, 0.95, 1.0);
+const float foamJacobian = 0.5;                 // jacobian determinant where foam starts (full foam at 0)
 
 void main() {
     setColorDefaults();
@@ -75,9 +78,13 @@ void main() {
     // float dist = length(dPE) * Kdiffuse * 0.01;
     // dist = exp(-dist);
     const float dist = Kdiffuse;
-    const vec3 Ci = dist * (reflectivity * sky + (1.0 - reflectivity) * upwelling)
+    vec3 Ci = dist * (reflectivity * sky + (1.0 - reflectivity) * upwelling)
         + (1.0 - dist) * air;
 
+    // Whitecaps where the choppy displacement squeezes the surface together or folds it over.
+    const float foamMask = clamp((foamJacobian - inColor.w) / foamJacobian, 0.0, 1.0);
+    Ci = mix(Ci, foam, foamMask);
+
     outDiffuse = vec4(Ci, opacity);
     outAmbient = vec4(Ci, 0.0);
     outSpecular = vec4(Ci, 0.0);
@@ -29,19 +29,22 @@ layout(push_constant) uniform PushBlock {
     vec4 data0;  // gridDim:         .x (dimension), .y (dimension/2), .z (2/dimension)
                  //                  .w (LODLevel)
     vec4 data1;  // morph constants: .x (start), .y (1/(end-start)), .z (end/(end-start))
-                 //                  .w ((aabb.minZ+aabb.maxZ)/2)
-    vec4 data2;  // quadOffset:      .x (aabb.minX), .y (aabb.minY)
-                 // quadScale:       .z (aabb.sizeX), .w (aabb.sizeY)
+    vec4 data2;  // unused (the quad offset/scale are per instance)
     vec4 data3;  // dbg camera:      .x (wpos.x), .y (wpos.y), .z (wpos.z)
 } pc;
 
 // IN
 layout(location=0) in vec2 inPosition;
+// IN (per instance)
+layout(location=1) in vec4 inQuadData0;  // quadOffset:      .x (aabb.minX), .y (aabb.minY)
+                                         // quadScale:       .z (aabb.sizeX), .w (aabb.sizeY)
+layout(location=2) in vec4 inQuadData1;  // quadOffset:      .x ((aabb.minZ+aabb.maxZ)/2)
+                                         // quadrant mask:   .y (TL 1, TR 2, BL 4, BR 8)
 
 // OUT
 layout(location=0) out vec3 outPosition; // (world space)
 layout(location=1) out vec3 outNormal;   // (world space)
-layout(location=2) out vec4 outColor;
+layout(location=2) out vec4 outColor;    // .w: jacobian determinant
 
 const int LAYER_POSITION  = 0;
 const int LAYER_NORMAL    = 1;
@@ -50,13 +53,13 @@ const int LAYER_NORMAL    = 1;
 vec2 morphVertex(vec2 inPos, vec2 vertex, float morphLerpK) {
     vec2 fracPart = (fract(inPos * vec2(pc.data0.y, pc.data0.y)) *
                      vec2(pc.data0.z, pc.data0.z)) *
-                    pc.data2.zw;
+                    inQuadData0.zw;
     return vertex.xy - fracPart * morphLerpK;
 }
 
 void main() {
     // getBaseVertexPos
-    vec4 vertex = vec4(((inPosition * pc.data2.zw) + pc.data2.xy), 0.0, 1.0);
+    vec4 vertex = vec4(((inPosition * inQuadData0.zw) + inQuadData0.xy), 0.0, 1.0);
     vertex.xy = min(vertex.xy, qTree.quadWorldMax); // !!!
 
     // calcGlobalUV
@@ -88,5 +91,8 @@ void main() {
     outPosition = vertex.xzy; // Swizzle z/y up.
     gl_Position = camera.viewProjection * vec4(outPosition, 1.0);
     // Normal
-    outNormal = texture(sampVertInput, vec3(uv, LAYER_NORMAL)).xyz;
+    const vec4 normalData = texture(sampVertInput, vec3(uv, LAYER_NORMAL));
+    outNormal = normalData.xyz;
+    // Jacobian determinant of the displacement for the foam mask
+    outColor = vec4(1.0, 1.0, 1.0, normalData.w);
 }
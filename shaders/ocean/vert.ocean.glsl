@@ -22,11 +22,14 @@ layout(location=1) in vec4 data0;      // quadOffset: .x.y
                                        // quadScale:  .z.w
 layout(location=2) in vec4 data1;      // uvOffset:   .x.y
                                        // uvScale:    .z.w
+layout(location=3) in vec4 data2;      // edge snap:  -x, +x, -z, +z (vertex spacing of a coarser neighbour, or 0)
+layout(location=4) in vec4 data3;      // meshDim:    .x
+                                       // morph:      .y start, .z end (distance)
 
 // OUT
 layout(location=0) out vec3 outPosition; // (world space)
 layout(location=1) out vec3 outNormal;   // (world space)
-layout(location=2) out vec4 outColor;
+layout(location=2) out vec4 outColor;    // .w: jacobian determinant
 
 const int LAYER_POSITION  = 0;
 const int LAYER_NORMAL    = 1;
@@ -35,17 +38,57 @@ const int LAYER_NORMAL    = 1;
 #define QUAD_SCALE_V2  data0.zw
 #define UV_OFFSET_V2   data1.xy
 #define UV_SCALE_V2    data1.zw
+#define MESH_DIM       data3.x
+#define MORPH_START    data3.y
+#define MORPH_END      data3.z
+
+// Moves the odd vertices onto the grid of the next LOD (half the dimensions) as "morphK" goes to 1.
+vec2 morphVertex(const vec2 gridPos, const float morphK) {
+    const vec2 fracPart = fract(gridPos * MESH_DIM * 0.5) * 2.0 / MESH_DIM;
+    return gridPos - (fracPart * morphK);
+}
+
+// Snaps to the vertices of a neighbour's coarser grid. The grid dimensions are powers of two, so this is exact and both
+// sides of the edge end up at the same positions.
+float snapToEdge(const float v, const float spacing) {
+    return (spacing > 0.0) ? (floor(v / spacing) * spacing) : v;
+}
 
 void main() {
-    const vec2 texCoord = (inPosition * UV_SCALE_V2) + (UV_OFFSET_V2);
+    vec2 gridPos = inPosition;
+
+    if (gridPos.x == 0.0) {
+        gridPos.y = snapToEdge(gridPos.y, data2.x);
+    } else if (gridPos.x == 1.0) {
+        gridPos.y = snapToEdge(gridPos.y, data2.y);
+    }
+    if (gridPos.y == 0.0) {
+        gridPos.x = snapToEdge(gridPos.x, data2.z);
+    } else if (gridPos.y == 1.0) {
+        gridPos.x = snapToEdge(gridPos.x, data2.w);
+    }
+
+    // Geomorph the interior only. The edge vertices are shared with the neighbours, so they stay on the grid.
+    const bool isEdge = any(equal(inPosition, vec2(0.0))) || any(equal(inPosition, vec2(1.0)));
+    if (!isEdge && MORPH_END > MORPH_START) {
+        const vec2 restXZ = (gridPos * QUAD_SCALE_V2) + QUAD_OFFSET_V2;
+        const float distance = length(camera.worldPosition - vec3(restXZ.x, 0.0, restXZ.y));
+        const float morphK = clamp((distance - MORPH_START) / (MORPH_END - MORPH_START), 0.0, 1.0);
+        gridPos = morphVertex(gridPos, morphK);
+    }
+
+    const vec2 texCoord = (gridPos * UV_SCALE_V2) + (UV_OFFSET_V2);
 
     // Position
     vec4 posData = texture(sampVertInput, vec3(texCoord, LAYER_POSITION));  // .xy: displacement
                                                                             // .z:  height
-    vec2 xz = (inPosition * QUAD_SCALE_V2) + (QUAD_OFFSET_V2 + posData.xy);
+    vec2 xz = (gridPos * QUAD_SCALE_V2) + (QUAD_OFFSET_V2 + posData.xy);
     outPosition = vec3(xz.x, posData.z, xz.y);
     gl_Position = camera.viewProjection * vec4(outPosition, 1.0);
 
     // Normal
-    outNormal = texture(sampVertInput, vec3(texCoord, LAYER_NORMAL)).xyz;
+    const vec4 normalData = texture(sampVertInput, vec3(texCoord, LAYER_NORMAL));
+    outNormal = normalData.xyz;
+    // Jacobian determinant of the displacement for the foam mask
+    outColor = vec4(1.0, 1.0, 1.0, normalData.w);
 }